@@ -0,0 +1,87 @@
+#pragma once
+
+/**
+ * @file AddressSpace.h
+ * @brief 预留地址空间定义
+ * @details 定义HCMP_RESERVE编译时，首次向系统申请内存前一次性预留一段连续虚拟地址（PROT_NONE，
+ *          不占物理内存和提交额度），此后所有SystemAlloc都从这段区域中切出并按需提交，
+ *          SystemFree解除提交并把地址区间留作复用。堆集中在一段区间内，判断指针是否属于本分配器
+ *          只需比较区间上下界，页号映射也可以用按偏移索引的数组（见FlatPageMap.h）。
+ *          区域用尽时抛出std::bad_alloc，不回退到区域外申请，保证归属判断没有漏判
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+/**
+ * @struct ReserveStats
+ * @brief 预留区域的使用统计
+ */
+struct ReserveStats
+{
+    size_t reservedBytes = 0;    // 预留的总字节数，未开启或尚未预留时为0
+    size_t committedBytes = 0;   // 当前已提交（可读写）的字节数
+    size_t topBytes = 0;         // 从区域起点按顺序切分到的位置
+    size_t freeExtents = 0;      // 已解除提交、可复用的地址区间数
+    size_t droppedBytes = 0;     // 区间表满时放弃复用的地址字节数
+};
+
+#ifdef HCMP_RESERVE
+
+#ifndef HCMP_RESERVE_BYTES
+#define HCMP_RESERVE_BYTES (64ULL << 30)   // 默认预留64GB虚拟地址
+#endif
+
+// 区域上下界，预留后不再改变；未预留时均为0，任何指针都不在区域内
+extern std::atomic<uintptr_t> gReserveBegin;
+extern std::atomic<uintptr_t> gReserveEnd;
+
+/**
+ * @brief 确保区域已预留
+ * @return 区域起始地址，按8K页对齐
+ * @details 多个线程同时首次调用时只预留一次；预留失败抛出std::bad_alloc
+ */
+char *ReserveRegion();
+
+/**
+ * @brief 区域的总字节数
+ */
+size_t ReserveRegionBytes();
+
+/**
+ * @brief 从区域中切出kpage页并提交
+ * @param kpage 页数
+ * @return 按8K对齐的起始地址
+ * @details 先在已解除提交的区间中首次适配，没有时从区域尾部顺序切分；区域用尽时抛出std::bad_alloc
+ */
+void *ReserveAlloc(size_t kpage);
+
+/**
+ * @brief 解除提交并把地址区间留作复用
+ * @param ptr 起始地址，须在区域内
+ * @param kpage 页数
+ * @details 与相邻的空闲区间合并，紧邻顺序切分位置时直接退回
+ */
+void ReserveFree(void *ptr, size_t kpage);
+
+/**
+ * @brief 判断指针是否落在预留区域内，不加锁
+ * @param ptr 任意指针
+ * @return 落在区域内返回true
+ */
+static inline bool ReserveOwns(const void *ptr)
+{
+    // 预留时先写起点再以release写终点，这里先读终点：终点非0时起点一定已可见
+    uintptr_t end = gReserveEnd.load(std::memory_order_acquire);
+    uintptr_t begin = gReserveBegin.load(std::memory_order_relaxed);
+    return (uintptr_t)ptr - begin < end - begin;
+}
+
+#endif
+
+/**
+ * @brief 获取预留区域的使用统计
+ * @return 统计信息；未定义HCMP_RESERVE时全为0
+ */
+ReserveStats ReserveGetStats();
@@ -0,0 +1,118 @@
+#pragma once
+
+/**
+ * @file AllocTrace.h
+ * @brief 申请/释放轨迹记录
+ * @details 定义HCMP_TRACE编译时，AllocTraceStart之后ConcurrencyAlloc/ConcurrencyFree等对外接口的每次调用
+ *          都记入调用线程自己的缓冲区（时间、线程、操作、大小、指针），AllocTraceDump把各线程的记录按时间
+ *          合并、把指针换成可复用的槽位号后写成紧凑的二进制文件。文件为定长文件头加定长记录，可以直接mmap读取，
+ *          不含任何地址信息，可以脱离原程序分享；tests/TraceReplay.cpp按同样的线程数重放。
+ *          未定义时HCMP_TRACE_ALLOC/HCMP_TRACE_FREE为空，没有任何额外开销
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+static const char TRACE_MAGIC[8] = {'H', 'C', 'M', 'P', 'T', 'R', 'C', '1'};
+static const uint32_t TRACE_VERSION = 1;
+
+/**
+ * @enum TraceOp
+ * @brief 记录的操作
+ */
+enum TraceOp
+{
+    TRACE_ALLOC = 1,   // 申请，size为申请的字节数
+    TRACE_FREE = 2,    // 释放，size为该对象申请时的字节数
+};
+
+/**
+ * @struct TraceFileHeader
+ * @brief 轨迹文件头，之后紧跟records条TraceRecord
+ */
+struct TraceFileHeader
+{
+    char magic[8];       // TRACE_MAGIC
+    uint32_t version;    // TRACE_VERSION
+    uint32_t threads;    // 记录到的线程数，记录中的线程号在[0, threads)内
+    uint64_t records;    // 记录条数
+    uint64_t slots;      // 槽位数，即同时存活的对象数的最大值
+};
+
+/**
+ * @struct TraceRecord
+ * @brief 一条申请或释放记录，按时间升序排列
+ * @details 同一对象的申请与释放使用同一个槽位号；对象释放后槽位号可以分配给之后申请的对象
+ */
+struct TraceRecord
+{
+    uint64_t time;      // 距AllocTraceStart的纳秒数
+    uint64_t size;      // 字节数
+    uint32_t slot;      // 槽位号，[0, slots)
+    uint16_t thread;    // 线程号
+    uint8_t op;         // TraceOp
+    uint8_t reserved;
+};
+
+static_assert(sizeof(TraceFileHeader) == 32, "TraceFileHeader must stay 32 bytes");
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must stay 24 bytes");
+
+#ifdef HCMP_TRACE
+
+#include <atomic>
+
+// 是否正在记录；关闭时记录点只有一次读取
+extern std::atomic<bool> gTraceEnabled;
+
+/**
+ * @brief 把一次申请或释放记入当前线程的缓冲区
+ * @param op 操作
+ * @param ptr 对象指针
+ * @param size 申请时为申请的字节数，释放时可为0
+ */
+void AllocTraceRecord(TraceOp op, const void *ptr, size_t size);
+
+#define HCMP_TRACE_ALLOC(ptr, size)                              \
+    do                                                           \
+    {                                                            \
+        if (gTraceEnabled.load(std::memory_order_relaxed))       \
+            AllocTraceRecord(TRACE_ALLOC, (ptr), (size));        \
+    } while (0)
+#define HCMP_TRACE_FREE(ptr)                                     \
+    do                                                           \
+    {                                                            \
+        if (gTraceEnabled.load(std::memory_order_relaxed))       \
+            AllocTraceRecord(TRACE_FREE, (ptr), 0);              \
+    } while (0)
+
+#else
+
+#define HCMP_TRACE_ALLOC(ptr, size) ((void)0)
+#define HCMP_TRACE_FREE(ptr) ((void)0)
+
+#endif
+
+/**
+ * @brief 清空已有记录并开始记录
+ * @details 应在业务线程静止时调用；未定义HCMP_TRACE时没有效果
+ */
+void AllocTraceStart();
+
+/**
+ * @brief 停止记录，已有记录保留到下一次AllocTraceStart
+ */
+void AllocTraceStop();
+
+/**
+ * @brief 已记录的条数
+ * @return 条数，未开启时为0
+ */
+size_t AllocTraceCount();
+
+/**
+ * @brief 把已有记录写成轨迹文件
+ * @param path 文件路径
+ * @return 写入成功返回true；未定义HCMP_TRACE或文件无法写入时返回false
+ * @details 应在业务线程静止时调用。开始记录前已存在的对象的释放记录被丢弃
+ */
+bool AllocTraceDump(const char *path);
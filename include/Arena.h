@@ -0,0 +1,103 @@
+#pragma once
+
+/**
+ * @file Arena.h
+ * @brief 作用域内存区（Arena）定义
+ * @details 直接从PageCache获取Span并进行指针递增（bump）分配，
+ *          不支持单个对象释放，只能通过Reset或析构一次性归还全部内存
+ */
+
+#include "Common.h"
+
+static const size_t ARENA_SPAN_PAGES = 16;     // Arena每次向PageCache申请的页数：128KB
+static const size_t ARENA_RETAIN_PAGES = 64;   // Reset时默认保留的页数上限：512KB
+
+/**
+ * @class Arena
+ * @brief 作用域内存区
+ * @details 适用于请求级别的临时数据：分配只需移动指针，释放在Reset时整体完成
+ *          Arena持有的Span都带有_isArena标记，对其内存调用ConcurrencyFree会被检测出来
+ *          注意：单个Arena实例不是线程安全的，应由一个线程独占使用
+ */
+class Arena
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param retainPages Reset时保留复用的最大页数，超出部分归还PageCache
+     */
+    explicit Arena(size_t retainPages = ARENA_RETAIN_PAGES)
+        : _retainPages(retainPages)
+    {}
+
+    /**
+     * @brief 析构函数，归还全部Span到PageCache
+     */
+    ~Arena()
+    {
+        Release(0);
+    }
+
+    /**
+     * @brief 从Arena中分配内存
+     * @param size 需要分配的字节数
+     * @param align 对齐数，必须是2的幂且不超过页大小
+     * @return 分配的内存指针
+     */
+    void *Allocate(size_t size, size_t align = sizeof(void *));
+
+    /**
+     * @brief 重置Arena
+     * @details 之前分配的所有内存失效；不超过保留阈值的标准Span留作复用，
+     *          其余Span在一次加锁中全部归还PageCache，无需逐个释放对象
+     */
+    void Reset()
+    {
+        Release(_retainPages);
+    }
+
+    /**
+     * @brief 获取Arena当前持有的Span数量
+     * @return Span数量
+     */
+    size_t SpanCount() const
+    {
+        return _spanCount;
+    }
+
+    /**
+     * @brief 获取自上次Reset以来分配出去的字节数
+     * @return 字节数
+     */
+    size_t BytesAllocated() const
+    {
+        return _bytesAllocated;
+    }
+
+private:
+    /**
+     * @brief 为Arena获取一个至少kpage页的Span
+     * @param kpage 需要的页数
+     * @return 新的Span指针
+     */
+    Span *AcquireSpan(size_t kpage);
+
+    /**
+     * @brief 归还Span到PageCache
+     * @param retainPages 保留的标准Span页数上限，0表示全部归还
+     */
+    void Release(size_t retainPages);
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+private:
+    Span *_spans = nullptr;        // 正在使用的Span单链表（通过_next串联）
+    Span *_freeSpans = nullptr;    // Reset后保留待复用的Span单链表
+    char *_ptr = nullptr;          // 当前Span中下一个可分配的位置
+    char *_end = nullptr;          // 当前Span的结束位置
+
+    size_t _retainPages;           // Reset时保留的页数上限
+    size_t _spanCount = 0;         // 持有的Span总数（含保留的）
+    size_t _bytesAllocated = 0;    // 已分配的字节数
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+/**
+ * @file Bitmap.h
+ * @brief 定长位图定义
+ * @details 记录一组桶是否非空，查找下一个非空桶时逐字用ctz定位，
+ *          代替逐个桶调用empty()的线性扫描
+ */
+
+#include "Common.h"
+
+/**
+ * @class Bitmap
+ * @brief 定长位图
+ * @tparam N 位数
+ * @details 第i位为1表示第i个桶非空，由桶的拥有者在每次插入/删除后同步更新；
+ *          本类不加锁，与被索引的桶共用同一把锁
+ */
+template<size_t N>
+class Bitmap
+{
+public:
+    static const size_t npos = N;   // 查找失败时的返回值
+
+    Bitmap()
+    {
+        for (size_t i = 0; i < WORDS; i++)
+            _words[i] = 0;
+    }
+
+    /**
+     * @brief 置位
+     * @param i 位下标
+     */
+    void Set(size_t i)
+    {
+        assert(i < N);
+        _words[i >> 6] |= (uint64_t)1 << (i & 63);
+    }
+
+    /**
+     * @brief 清位
+     * @param i 位下标
+     */
+    void Clear(size_t i)
+    {
+        assert(i < N);
+        _words[i >> 6] &= ~((uint64_t)1 << (i & 63));
+    }
+
+    /**
+     * @brief 检查某位是否为1
+     * @param i 位下标
+     * @return true表示为1
+     */
+    bool Test(size_t i) const
+    {
+        assert(i < N);
+        return (_words[i >> 6] >> (i & 63)) & 1;
+    }
+
+    /**
+     * @brief 查找下标不小于from的第一个为1的位
+     * @param from 起始下标
+     * @return 位下标，没有返回npos
+     */
+    size_t FindFirst(size_t from) const
+    {
+        if (from >= N)
+            return npos;
+
+        size_t w = from >> 6;
+        // 屏蔽掉起始字中from之前的位
+        uint64_t word = _words[w] & (~(uint64_t)0 << (from & 63));
+        while (true)
+        {
+            if (word)
+            {
+                size_t i = (w << 6) + __builtin_ctzll(word);
+                return i < N ? i : npos;
+            }
+            if (++w >= WORDS)
+                return npos;
+            word = _words[w];
+        }
+    }
+
+private:
+    static const size_t WORDS = (N + 63) / 64;
+
+    uint64_t _words[WORDS];
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * @file CarveKernel.h
+ * @brief 对象切分内核声明
+ * @details 把一段连续内存按固定大小切成对象并串成自由链表。8B/16B这类小对象
+ *          链接指针排得很密，用SSE2/AVX2一次写入多个对象的链接；运行时按CPU
+ *          支持情况选择实现，非x86平台或不支持时退回标量循环。
+ *          ConcurrencyCalloc清零回收对象的内核按同样的方式选择
+ */
+
+#include "Common.h"
+
+static const size_t CARVE_NT_BYTES = 256 * 1024;   // 一次切分超过该字节数时使用非临时存储，不污染缓存
+static const size_t CLEAR_NT_BYTES = 8 * 1024 * 1024;   // 清零超过该字节数时使用非临时存储：calloc的内存随即被使用，缓存放得下时不绕过
+
+/**
+ * @brief 把从start开始的n个大小为size的对象串成自由链表
+ * @param start 第一个对象的地址，至少按8字节对齐
+ * @param size 对象大小，8的倍数
+ * @param n 对象个数，大于0
+ * @return 最后一个对象，其NextObj已置空
+ */
+void *CarveObjects(char *start, size_t size, size_t n);
+
+/**
+ * @brief CarveObjects的标量实现，供对比测试使用
+ */
+void *CarveObjectsScalar(char *start, size_t size, size_t n);
+
+/**
+ * @brief 把对象清零
+ * @param ptr 对象地址，至少按8字节对齐
+ * @param bytes 字节数，8的倍数
+ * @details 对象已按尺寸类对齐，不需要处理零散的头尾字节；超过CLEAR_NT_BYTES时用非临时存储
+ */
+void ClearObject(void *ptr, size_t bytes);
+
+/**
+ * @brief ClearObject的标量实现，供对比测试使用
+ */
+void ClearObjectScalar(void *ptr, size_t bytes);
+
+/**
+ * @brief 获取当前CarveObjects选用的实现名称
+ * @return "avx2"、"sse2"或"scalar"，ClearObject选用同一种
+ */
+const char *CarveKernelName();
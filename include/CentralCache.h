@@ -2,24 +2,27 @@
 
 /**
  * @file CentralCache.h
- * @brief 뻺ඨ
- * @details ȫΨһ뻺棬ThreadCachePageCache֮ڴ潻
+ * @brief 中央缓存类定义
+ * @details 全局唯一的中央缓存，负责管理ThreadCache和PageCache之间的内存交换
  */
 
 #include "Common.h"
+#include "TransferCache.h"
 
 /**
  * @class CentralCache
- * @brief 뻺ࣨģʽ - ģʽ
- * @details ΪThreadCachePageCache֮н㣬Spanķͻ
- *          ʹͰƱ֤̰߳ȫ
+ * @brief 中央缓存类（单例模式 - 饿汉模式）
+ * @details 作为ThreadCache和PageCache之间的中介层，管理Span的分配和回收
+ *          使用桶锁机制保证线程安全，减少锁竞争。
+ *          对象全部归还的Span不立即还给PageCache，每个尺寸类按自适应上限保留几个，
+ *          下次需要新Span时直接复用，尺寸类空闲一段时间后再归还
  */
 class CentralCache
 {
 public:
 	/**
-	 * @brief ȡCentralCacheʵ
-	 * @return CentralCacheָ
+	 * @brief 获取CentralCache单例实例
+	 * @return CentralCache单例指针
 	 */
 	static CentralCache *GetInstance()
 	{
@@ -27,38 +30,251 @@ public:
 	}
 
 	/**
-	 * @brief CentralCacheȡڴ
-	 * @param start صĶʼָ
-	 * @param end صĶָ
-	 * @param n ȡĶ
-	 * @param size С
-	 * @return ʵʻȡĶ
+	 * @brief 从CentralCache中批量获取内存对象
+	 * @param start 返回的对象链表起始指针
+	 * @param end 返回的对象链表结束指针
+	 * @param n 期望获取的对象数量
+	 * @param size 对象大小
+	 * @return 实际获取到的对象数量，来自批次缓存时可能比n多一两个，但不超过n+2
 	 */
 	size_t FetchRangeObj(void *&start, void *&end, size_t n, size_t size);
 
 	/**
-	 * @brief ȡһǿյSpan
-	 * @param list ӦСSpanList
-	 * @param size С
-	 * @return ǿյSpanָ
+	 * @brief 从CentralCache中批量获取内存对象，存入指针数组
+	 * @param batch 接收对象指针的数组，至少能放下n+2个
+	 * @param n 期望获取的对象数量
+	 * @param size 对象大小
+	 * @return 实际获取到的对象数量
+	 * @details 供magazine模式的ThreadCache使用；从未切分区域取出的对象按地址直接算出，不写入对象内存
+	 */
+	size_t FetchRangeObj(void **batch, size_t n, size_t size);
+
+	/**
+	 * @brief 获取一个非空的Span
+	 * @param list 对应大小的SpanList
+	 * @param size 对象大小
+	 * @return 非空的Span指针
+	 * @details 没有可用的Span时先复用本尺寸类保留的空Span，再向PageCache申请
 	 */
 	Span *GetOneSpan(SpanList &list, size_t size);
 
 	/**
-	 * @brief 黹һڴCentralCacheĶӦSpan
-	 * @param start ڴʼָ
-	 * @param bytes_size ڴС
+	 * @brief 归还一段内存链表到CentralCache的对应Span
+	 * @param start 内存链表起始指针
+	 * @param bytes_size 内存块大小
 	 */
 	void ReleaseListToSpan(void *start, size_t bytes_size);
 
+	/**
+	 * @brief 归还指针数组中的对象到CentralCache的对应Span
+	 * @param objs 对象指针数组
+	 * @param n 对象数量
+	 * @param bytes_size 内存块大小
+	 * @details 与ReleaseListToSpan相同，但不需要沿链表读取对象
+	 */
+	void ReleaseArrayToSpan(void **objs, size_t n, size_t bytes_size);
+
+	/**
+	 * @brief 统计某个桶中的Span数
+	 * @param bytes_size 内存块大小
+	 * @return Span链表中的Span个数
+	 */
+	size_t SpanCount(size_t bytes_size);
+
+	/**
+	 * @brief 统计某个尺寸类保留的空Span数
+	 * @param bytes_size 内存块大小
+	 * @return 保留的空Span个数，不计入SpanCount
+	 */
+	size_t EmptySpanCount(size_t bytes_size);
+
+	/**
+	 * @brief 统计某个尺寸类批次缓存中的批次数，不加锁
+	 * @param bytes_size 内存块大小
+	 */
+	size_t TransferBatchCount(size_t bytes_size) const
+	{
+		return _transfer.Count(SizeClass::Index(bytes_size));
+	}
+
+	/**
+	 * @brief 所有尺寸类保留的空Span总数，不加锁
+	 */
+	size_t EmptySpanTotal() const
+	{
+		return _emptyTotal.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief 所有尺寸类保留的空Span总字节数，不加锁
+	 */
+	size_t EmptySpanBytes() const
+	{
+		return _emptyBytes.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief 是否保留着空Span或批次缓存中有批次，即清理还有事可做
+	 * @details 延迟释放的回收线程据此决定定时醒来还是无限期休眠
+	 */
+	bool IdleWorkPending() const
+	{
+		return _emptyTotal.load() > 0 || !_transfer.Empty();
+	}
+
+	/**
+	 * @brief 把所有尺寸类保留的空Span和批次缓存中的批次归还给PageCache
+	 * @details 调小运行参数empty_span_max或empty_span_bytes后调用，也可在进程转入空闲前主动调用
+	 */
+	void ReleaseEmptySpans();
+
+	/**
+	 * @brief 清理一轮：归还空闲超过empty_span_idle_ms的尺寸类缓存的批次和保留的空Span，并把空Span上限减半
+	 * @details 以清理轮次计算空闲时间，两轮之间应间隔empty_span_idle_ms的一半
+	 */
+	void ReleaseIdleSpans();
+
+	/**
+	 * @brief 距上一轮清理已过empty_span_idle_ms的一半时执行一轮清理
+	 * @details 调用方不能持有任何桶锁或页锁；由慢路径和后台回收线程调用，未到期时只读一次时钟
+	 */
+	void MaybeReleaseIdle();
+
+	/**
+	 * @brief 归还一批对象，优先放入无锁批次缓存
+	 * @param start 对象链表起始指针
+	 * @param end 对象链表结束指针
+	 * @param n 对象数量
+	 * @param bytes_size 内存块大小
+	 * @details 批次缓存已满或被关闭时退回ReleaseListToSpan
+	 */
+	void InsertRange(void *start, void *end, size_t n, size_t bytes_size);
+
+	/**
+	 * @brief 归还指针数组中的一批对象，优先放入无锁批次缓存
+	 * @param objs 对象指针数组
+	 * @param n 对象数量
+	 * @param bytes_size 内存块大小
+	 * @details 放入批次缓存时先把对象串成链表；批次缓存已满或被关闭时退回ReleaseArrayToSpan
+	 */
+	void InsertRange(void **objs, size_t n, size_t bytes_size);
+
+	/**
+	 * @brief 尝试把一批对象放入无锁批次缓存，不加锁
+	 * @param start 对象链表起始指针
+	 * @param end 对象链表结束指针
+	 * @param n 对象数量
+	 * @param bytes_size 内存块大小
+	 * @return 批次缓存已满或被关闭时返回false
+	 */
+	bool InsertTransfer(void *start, void *end, size_t n, size_t bytes_size);
+
+	/**
+	 * @brief 开启或关闭无锁批次缓存
+	 * @param enable 是否开启
+	 * @details 关闭时把已缓存的批次全部归还给Span，可在业务线程运行中调用；与关闭并发压入的批次
+	 *          由整批申请取走或在清理时归还。同时更新运行参数transfer_cache
+	 */
+	void SetTransferCacheEnabled(bool enable);
+
+	/**
+	 * @brief 无锁批次缓存是否开启
+	 */
+	bool TransferCacheEnabled() const
+	{
+		return _transferEnabled.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief 把无锁批次缓存中的所有批次归还给Span
+	 */
+	void DrainTransferCache();
+
+	/**
+	 * @brief 调整每个尺寸类批次缓存的字节上限，已缓存的批次超出新上限的部分归还给Span
+	 * @param bytes 字节上限，0为不缓存
+	 * @details 可在业务线程运行中调用，同时更新运行参数transfer_cache_bytes
+	 */
+	void SetTransferCacheBytes(size_t bytes);
+
 private:
-	SpanList _spanList[MAX_BUCKETSIZE]; // Span飬С
+	/**
+	 * @brief 把一组对象按Span分组后归还
+	 * @param index 桶索引
+	 * @param objs 对象指针数组
+	 * @param spans 每个对象所属的Span
+	 * @param n 对象个数，不超过RELEASE_GROUP_MAX
+	 */
+	void ReleaseGroup(size_t index, void **objs, Span **spans, size_t n);
+
+	/**
+	 * @brief 从无锁批次缓存取出一批对象，超过上限的部分归还给Span
+	 * @param index 桶索引
+	 * @param start 返回批次第一个对象
+	 * @param end 返回批次最后一个对象
+	 * @param maxNum 最多返回的对象数
+	 * @param size 对象大小
+	 * @return 对象数，缓存为空时返回0
+	 */
+	size_t RemoveTransfer(size_t index, void *&start, void *&end, size_t maxNum, size_t size);
+
+	/**
+	 * @brief 对象全部归还的Span未超过本尺寸类的上限时留下，调用方持有桶锁
+	 * @param index 桶索引
+	 * @param span 已从Span链表摘下的空Span
+	 * @return 留下时返回true，否则调用方把它还给PageCache
+	 * @details 所有尺寸类合计不超过运行参数empty_span_bytes
+	 */
+	bool KeepEmptySpan(size_t index, Span *span);
+
+	/**
+	 * @brief 摘下某个尺寸类保留的全部空Span，调用方持有桶锁
+	 * @return 以_next串起的Span链
+	 */
+	Span *DetachEmptySpans(size_t index);
+
+	/**
+	 * @brief 在一次页锁内把以_next串起的Span全部归还给PageCache
+	 */
+	void ReleaseSpanChain(Span *chain);
+
+	/**
+	 * @struct EmptySpans
+	 * @brief 一个尺寸类保留的空Span，由该尺寸类的桶锁保护
+	 * @details 上限从1开始，归还过空Span后又要向PageCache申请新Span时加一（不超过empty_span_max），
+	 *          空闲归还时减半
+	 */
+	struct EmptySpans
+	{
+		SpanList list;          // 已切分过、对象全部归还的Span，自由链表保持原样
+		size_t count = 0;       // list中的Span数
+		size_t limit = 1;       // 自适应上限
+		bool released = false;  // 上限已满、有空Span还给了PageCache
+		uint32_t lastUse = 0;   // 最近一次使用时的清理轮次
+	};
+
+private:
+	SpanList _spanList[MAX_BUCKETSIZE]; // Span链表数组，按对象大小分类管理
+	TransferCache _transfer;            // 无锁批次缓存，整批交换时绕过桶锁
+	std::atomic<bool> _transferEnabled{true};   // 初始值取自运行参数transfer_cache
+	EmptySpans _empty[MAX_BUCKETSIZE];           // 各尺寸类保留的空Span
+	std::atomic<size_t> _emptyTotal{0};          // 保留的空Span总数
+	std::atomic<size_t> _emptyBytes{0};          // 保留的空Span总字节数
+	std::atomic<uint32_t> _sweepGen{0};          // 清理轮次
+	std::atomic<int64_t> _lastSweepMs{0};        // 上一轮清理开始的时间（毫秒）
 
 private:
-	// ģʽֹⲿ졢͸ֵ
-	CentralCache() {}
+	// 单例模式：禁止外部构造、拷贝和赋值
+	CentralCache()
+	{
+		for (int i = 0; i < (int)MAX_BUCKETSIZE; i++)
+		{
+			HCMP_LOCK_NAME(_spanList[i]._mtx, "CentralCache bucket", i);
+		}
+		_transferEnabled.store(TuneGet(TUNE_TRANSFER_CACHE) != 0, std::memory_order_relaxed);
+	}
 	CentralCache(const CentralCache &) = delete;
 	CentralCache operator=(const CentralCache &) = delete;
 
-	static CentralCache _sInst; // ̬ʵ
+	static CentralCache _sInst; // 静态单例实例
 };
\ No newline at end of file
@@ -1,354 +1,405 @@
-#pragma once
-
-#include <iostream>
-#include <vector>
-#include <algorithm>
-#include <cassert>
-#include <ctime>
-#include <cstdint>
-#include <thread>
-#include <mutex>
-#include <unordered_map>
-
-#ifdef _WIN32
-#include <Windows.h>
-#else // Linux
-#include <sys/mman.h>
-#endif
-
-using std::cout;
-using std::endl;
-
-static const size_t MAX_MEMORYSIZE = 256 * 1024; // threadcacheڴС
-static const size_t MAX_BUCKETSIZE = 208;		 // threadcache CentralCache Ͱ
-static const size_t MAX_PAGESIZE = 129;			 // PageCacheҳ: 128
-static const size_t PAGE_SHIFT = 13;			 // 8Kһҳ
-
-#ifdef _WIN64
-typedef uint64_t PAGE_ID;
-#elif _WIN32
-typedef uint32_t PAGE_ID;
-#else // Linux
-typedef uint64_t PAGE_ID;
-#endif
-
-// ȡobjһָ
-static inline void *&NextObj(void *obj)
-{
-	return *(void **)obj;
-}
-
-inline static void *SystemAlloc(size_t kpage)
-{
-#ifdef _WIN32
-	void *ptr = VirtualAlloc(NULL, kpage << PAGE_SHIFT, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-#else
-	void *ptr = mmap(NULL, kpage << PAGE_SHIFT, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-#endif
-	if (ptr == nullptr)
-		throw std::bad_alloc();
-
-	return ptr;
-}
-
-inline static void SystemFree(void *ptr)
-{
-#ifdef _WIN32
-	VirtualFree(ptr, 0, MEM_RELEASE);
-#else
-
-#endif
-}
-
-// 
-class FreeList
-{
-public:
-	// 黹ڴ鵽
-	void push(void *obj)
-	{
-		NextObj(obj) = _freelist;
-		_freelist = obj;
-		++_size;
-	}
-
-	void PushRange(void *start, void *end, size_t n)
-	{
-		assert(start);
-		assert(end);
-		NextObj(end) = _freelist;
-		_freelist = start;
-
-		_size += n;
-	}
-
-	void PopRange(void *&start, void *&end, size_t n)
-	{
-		assert(n > 0 && n <= _size);
-		start = _freelist;
-		end = start;
-		for (size_t i = 0; i < n - 1; i++)
-			end = NextObj(end);
-		_freelist = NextObj(end);
-		NextObj(end) = nullptr; // ض
-		_size -= n;
-	}
-
-	// ȡڴ
-	void *pop()
-	{
-		void *obj = _freelist;
-		_freelist = NextObj(_freelist);
-		--_size;
-		return obj;
-	}
-
-	bool isEmpty()
-	{
-		return _freelist == nullptr;
-	}
-
-	size_t &maxSize()
-	{
-		return _maxSize;
-	}
-
-	size_t size()
-	{
-		return _size;
-	}
-
-private:
-	void *_freelist = nullptr;
-	size_t _maxSize = 1; //
-	size_t _size = 0;
-};
-
-class SizeClass
-{
-public:
-	// Bytes[1, 128]                  뵽8              indexΧ[0, 16)
-	// Bytes[128+1, 1024]             뵽16             indexΧ[16,72)
-	// Bytes[1024+1, 8*1024]          뵽128            indexΧ[72,128)
-	// Bytes[8*1024+1, 64*1024]       뵽1024           indexΧ[128,184)
-	// Bytes[64*1024+1, 256*1024]     뵽8*1024         indexΧ[184,208)
-	static size_t _RoundUp(size_t size, size_t alignNum)
-	{
-		return (size + alignNum - 1) & ~(alignNum - 1);
-	}
-	// ö֮ڴС
-	static size_t RoundUp(size_t size)
-	{
-		assert(size > 0);
-		if (size <= 8)
-			return _RoundUp(size, 8);
-		else if (size > 8 && size <= 16)
-			return _RoundUp(size, 16);
-		else if (size > 16 && size <= 128)
-			return _RoundUp(size, 128);
-		else if (size > 128 && size <= 1024)
-			return _RoundUp(size, 1024);
-		else if (size > 1024 && size <= 8 * 1024)
-			return _RoundUp(size, 8 * 1024);
-		else
-			return _RoundUp(size, 1 << PAGE_SHIFT);
-
-		return -1;
-	}
-
-	/**
-	 * @brief ڲ㺯
-	 * @param size ڴС
-	 * @param alignShifted λ
-	 * @return 
-	 */
-	static size_t _Index(size_t size, size_t alignShifted)
-	{
-		return ((size + ((long long)1 << alignShifted) - 1) >> alignShifted) - 1;
-	}
-
-	/**
-	 * @brief ڴСӦͰ
-	 * @param size ڴС
-	 * @return ӦͰ
-	 */
-	static size_t Index(size_t size)
-	{
-		assert(size < MAX_MEMORYSIZE);
-		static int CountArray[] = {16, 56, 56, 56};
-
-		if (size <= 128)
-			return _Index(size, 3);
-		else if (size > 128 && size <= 1024)
-			return _Index(size - 128, 4) + CountArray[0];
-		else if (size > 1024 && size <= 8 * 1024)
-			return _Index(size - 1024, 7) + CountArray[0] + CountArray[1];
-		else if (size > 8 * 1024 && size <= 64 * 1024)
-			return _Index(size - 8 * 1024, 10) + CountArray[0] + CountArray[1] + CountArray[2];
-		else if (size > 64 * 1024 && size <= 256 * 1024)
-			return _Index(size - 64 * 1024, 13) + CountArray[0] + CountArray[1] + CountArray[2] + CountArray[3];
-		else
-			assert(false);
-
-		return -1;
-	}
-
-	/**
-	 * @brief ThreadCacheCentralCacheһλȡĶ
-	 * @param size С
-	 * @return һλȡĶ
-	 */
-	static size_t NumMoveSize(size_t size)
-	{
-		assert(size > 0);
-		size_t num = MAX_MEMORYSIZE / size;
-		if (num < 2)
-			num = 2; // ٻȡ
-		if (num > 512)
-			num = 512; // СȡһЩȡһЩ
-		return num;
-	}
-
-	/**
-	 * @brief CentralCachePageCacheһλȡҳ
-	 * @param size С
-	 * @return Ҫȡҳ
-	 */
-	static size_t NumMovePage(size_t size)
-	{
-		size_t num = NumMoveSize(size);
-		size_t npage = num * size;
-
-		npage >>= PAGE_SHIFT;
-		if (npage == 0)
-			npage = 1;
-		return npage;
-	}
-};
-
-// ================================ Spanṹ ================================
-
-/**
- * @struct Span
- * @brief ҳȽṹ壬ڴҳ
- * @details SpanڴصĻԪڴҳصĹϢ
- */
-struct Span
-{
-	PAGE_ID _pageId = 0;       // ʼҳ
-	size_t _n = 0;             // ҳ
-
-	Span *_prev = nullptr;     // ˫еǰһSpan
-	Span *_next = nullptr;     // ˫еĺһSpan
-
-	size_t _useCount = 0;      // ѷȥСڴ
-	void *_freeList = nullptr; // зֺõСڴͷָ
-
-	bool _isUse = false;       // ǸSpanǷڱʹãҳϲжϣ
-
-	size_t _objSize = 0;       // SpanÿСĴС
-};
-
-// ================================ Span ================================
-
-/**
- * @class SpanList
- * @brief Span˫ѭ
- * @details ʹôͷڵ˫ѭSpan֧̰߳ȫ
- */
-class SpanList
-{
-public:
-	std::mutex _mtx; // Ͱ֤̰߳ȫ
-
-	/**
-	 * @brief 캯ʼͷڵ˫ѭ
-	 */
-	SpanList()
-	{
-		_head = new Span;
-		_head->_next = _head;
-		_head->_prev = _head;
-	}
-
-	/**
-	 * @brief ȡĵһЧڵ
-	 * @return һSpanָ
-	 */
-	Span *begin()
-	{
-		return _head->_next;
-	}
-
-	/**
-	 * @brief ȡĽǣͷڵ㣩
-	 * @return ͷڵָ
-	 */
-	Span *end()
-	{
-		return _head;
-	}
-
-	/**
-	 * @brief ǷΪ
-	 * @return trueʾΪգfalseʾǿ
-	 */
-	bool empty()
-	{
-		return begin() == end();
-	}
-
-	/**
-	 * @brief ͷĵһSpan
-	 * @return Spanָ
-	 */
-	Span *pop_front()
-	{
-		assert(!empty());
-		Span *first = begin();
-		erase(first);
-		return first;
-	}
-
-	/**
-	 * @brief ͷµSpan
-	 * @param newSpan ҪSpanָ
-	 */
-	void push_front(Span *newSpan)
-	{
-		insert(begin(), newSpan);
-	}
-
-	/**
-	 * @brief ָλǰµSpan
-	 * @param pos λ
-	 * @param newSpan ҪSpanָ
-	 */
-	void insert(Span *pos, Span *newSpan)
-	{
-		assert(pos);
-		assert(newSpan);
-		Span *prev = pos->_prev;
-		newSpan->_next = pos;
-		newSpan->_prev = prev;
-		prev->_next = newSpan;
-		pos->_prev = newSpan;
-	}
-
-	/**
-	 * @brief ɾָSpan
-	 * @param pos ҪɾSpanָ
-	 */
-	void erase(Span *pos)
-	{
-		assert(pos);
-		assert(pos != _head);
-		Span *prev = pos->_prev;
-		Span *next = pos->_next;
-		prev->_next = next;
-		next->_prev = prev;
-	}
-
-private:
-	Span *_head = nullptr;
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <ctime>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <unordered_map>
+
+#include "LockProfiler.h"
+#include "LatencyProfiler.h"
+#include "AddressSpace.h"
+#include "AllocTrace.h"
+#include "Tuning.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else // Linux
+#include <sys/mman.h>
+#endif
+
+using std::cout;
+using std::endl;
+
+static const size_t MAX_MEMORYSIZE = 256 * 1024; // threadcache最大的内存大小
+static const size_t MAX_BUCKETSIZE = 208;		 // threadcache CentralCache 最大桶数
+static const size_t MAX_PAGESIZE = 129;			 // PageCache最大页数: 128
+static const size_t PAGE_SHIFT = 13;			 // 8K一页
+
+#ifdef _WIN64
+typedef uint64_t PAGE_ID;
+#elif _WIN32
+typedef uint32_t PAGE_ID;
+#else // Linux
+typedef uint64_t PAGE_ID;
+#endif
+
+// 获取obj的下一个对象指针
+static inline void *&NextObj(void *obj)
+{
+	return *(void **)obj;
+}
+
+// 把指针数组中的n个对象依次串成链表，返回链表头，最后一个对象的NextObj置空；
+// 各次写入互不依赖，不需要沿链表读取对象
+static inline void *LinkObjects(void **objs, size_t n)
+{
+	assert(n > 0);
+	for (size_t i = 0; i + 1 < n; i++)
+		NextObj(objs[i]) = objs[i + 1];
+	NextObj(objs[n - 1]) = nullptr;
+	return objs[0];
+}
+
+inline static void *SystemAlloc(size_t kpage)
+{
+	HCMP_LATENCY_SCOPE(LAT_SYSTEM_ALLOC);
+#ifdef HCMP_RESERVE
+	// 从预留区域中切出并提交，区域用尽时抛出std::bad_alloc
+	void *ptr = ReserveAlloc(kpage);
+#elif defined(_WIN32)
+	void *ptr = VirtualAlloc(NULL, kpage << PAGE_SHIFT, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+#else
+	// mmap只保证系统页(4K)对齐，而Span按8K页号管理，多申请一页后裁掉首尾保证按8K对齐
+	size_t bytes = kpage << PAGE_SHIFT;
+	size_t pageSize = (size_t)1 << PAGE_SHIFT;
+	void *raw = mmap(NULL, bytes + pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+		throw std::bad_alloc();
+
+	char *ptr = (char *)(((size_t)raw + pageSize - 1) & ~(pageSize - 1));
+	size_t head = ptr - (char *)raw;
+	if (head > 0)
+		munmap(raw, head);
+	if (pageSize - head > 0)
+		munmap(ptr + bytes, pageSize - head);
+#endif
+
+	return ptr;
+}
+
+inline static void SystemFree(void *ptr, size_t kpage)
+{
+	HCMP_LATENCY_SCOPE(LAT_SYSTEM_FREE);
+#ifdef HCMP_RESERVE
+	// 只解除提交，地址区间留在预留区域内供之后的SystemAlloc复用
+	ReserveFree(ptr, kpage);
+#elif defined(_WIN32)
+	// 合并后的空闲区间可能跨越或只覆盖部分VirtualAlloc区域，只能按页解除提交
+	VirtualFree(ptr, kpage << PAGE_SHIFT, MEM_DECOMMIT);
+#else
+	munmap(ptr, kpage << PAGE_SHIFT);
+#endif
+}
+
+/**
+ * @brief 丢弃一段仍在使用的页的内容，之后读到全零
+ * @details 物理页归还系统，地址保持可读写，再次访问时由内核按需提供零页。
+ *          清零大块内存时代替memset，未被访问的页也不再占用物理内存
+ */
+inline static void SystemDecommit(void *ptr, size_t kpage)
+{
+	size_t bytes = kpage << PAGE_SHIFT;
+#ifdef _WIN32
+	VirtualFree(ptr, bytes, MEM_DECOMMIT);
+	if (VirtualAlloc(ptr, bytes, MEM_COMMIT, PAGE_READWRITE) == nullptr)
+		throw std::bad_alloc();
+#else
+	madvise(ptr, bytes, MADV_DONTNEED);
+#endif
+}
+
+class SizeClass
+{
+public:
+	// Bytes：[1, 128]                  对齐到8              index范围[0, 16)
+	// Bytes：[128+1, 1024]             对齐到16             index范围[16,72)
+	// Bytes：[1024+1, 8*1024]          对齐到128            index范围[72,128)
+	// Bytes：[8*1024+1, 64*1024]       对齐到1024           index范围[128,184)
+	// Bytes：[64*1024+1, 256*1024]     对齐到8*1024         index范围[184,208)
+	static constexpr size_t _RoundUp(size_t size, size_t alignNum)
+	{
+		return (size + alignNum - 1) & ~(alignNum - 1);
+	}
+	// 获得对齐之后的内存大小
+	static size_t RoundUp(size_t size)
+	{
+		assert(size > 0);
+		if (size <= 8)
+			return _RoundUp(size, 8);
+		else if (size > 8 && size <= 16)
+			return _RoundUp(size, 16);
+		else if (size > 16 && size <= 128)
+			return _RoundUp(size, 128);
+		else if (size > 128 && size <= 1024)
+			return _RoundUp(size, 1024);
+		else if (size > 1024 && size <= 8 * 1024)
+			return _RoundUp(size, 8 * 1024);
+		else
+			return _RoundUp(size, 1 << PAGE_SHIFT);
+
+		return -1;
+	}
+
+	/**
+	 * @brief 内部索引计算函数
+	 * @param size 内存大小
+	 * @param alignShifted 对齐位移量
+	 * @return 计算出的索引
+	 */
+	static constexpr size_t _Index(size_t size, size_t alignShifted)
+	{
+		return ((size + ((long long)1 << alignShifted) - 1) >> alignShifted) - 1;
+	}
+
+	/**
+	 * @brief 根据内存大小计算对应的桶索引
+	 * @param size 内存大小
+	 * @return 对应的桶索引
+	 */
+	static size_t Index(size_t size)
+	{
+		assert(size <= MAX_MEMORYSIZE);
+		static int CountArray[] = {16, 56, 56, 56};
+
+		if (size <= 128)
+			return _Index(size, 3);
+		else if (size > 128 && size <= 1024)
+			return _Index(size - 128, 4) + CountArray[0];
+		else if (size > 1024 && size <= 8 * 1024)
+			return _Index(size - 1024, 7) + CountArray[0] + CountArray[1];
+		else if (size > 8 * 1024 && size <= 64 * 1024)
+			return _Index(size - 8 * 1024, 10) + CountArray[0] + CountArray[1] + CountArray[2];
+		else if (size > 64 * 1024 && size <= 256 * 1024)
+			return _Index(size - 64 * 1024, 13) + CountArray[0] + CountArray[1] + CountArray[2] + CountArray[3];
+		else
+			assert(false);
+
+		return -1;
+	}
+
+	/**
+	 * @brief RoundUp的编译期版本，结果与RoundUp相同
+	 * @param size 内存大小，不超过MAX_MEMORYSIZE
+	 * @return 对齐之后的内存大小
+	 */
+	static constexpr size_t RoundUpConst(size_t size)
+	{
+		return size <= 8 ? _RoundUp(size, 8)
+			: size <= 16 ? _RoundUp(size, 16)
+			: size <= 128 ? _RoundUp(size, 128)
+			: size <= 1024 ? _RoundUp(size, 1024)
+			: size <= 8 * 1024 ? _RoundUp(size, 8 * 1024)
+			: _RoundUp(size, 1 << PAGE_SHIFT);
+	}
+
+	/**
+	 * @brief Index的编译期版本，结果与Index相同
+	 * @param size 内存大小，不超过MAX_MEMORYSIZE
+	 * @return 对应的桶索引
+	 */
+	static constexpr size_t IndexConst(size_t size)
+	{
+		return size <= 128 ? _Index(size, 3)
+			: size <= 1024 ? _Index(size - 128, 4) + 16
+			: size <= 8 * 1024 ? _Index(size - 1024, 7) + 16 + 56
+			: size <= 64 * 1024 ? _Index(size - 8 * 1024, 10) + 16 + 56 + 56
+			: _Index(size - 64 * 1024, 13) + 16 + 56 + 56 + 56;
+	}
+
+	/**
+	 * @brief 桶索引对应的最大对象大小，Index的逆运算
+	 * @param index 桶索引
+	 * @return 该桶容纳的最大对象大小
+	 */
+	static size_t ClassSize(size_t index)
+	{
+		assert(index < MAX_BUCKETSIZE);
+		if (index < 16)
+			return (index + 1) * 8;
+		else if (index < 72)
+			return 128 + (index - 16 + 1) * 16;
+		else if (index < 128)
+			return 1024 + (index - 72 + 1) * 128;
+		else if (index < 184)
+			return 8 * 1024 + (index - 128 + 1) * 1024;
+		else
+			return 64 * 1024 + (index - 184 + 1) * 8 * 1024;
+	}
+
+	/**
+	 * @brief 计算ThreadCache从CentralCache一次获取的对象数量
+	 * @param size 对象大小
+	 * @return 一次获取的对象数量
+	 * @details 上下限为运行参数batch_min/batch_max，默认2和512
+	 */
+	static size_t NumMoveSize(size_t size)
+	{
+		assert(size > 0);
+		size_t num = MAX_MEMORYSIZE / size;
+		size_t lo = TuneGet(TUNE_BATCH_MIN);
+		size_t hi = TuneGet(TUNE_BATCH_MAX);
+		if (num < lo)
+			num = lo; // 大对象至少获取batch_min个
+		if (num > hi)
+			num = hi; // 小对象获取多一些，但不超过batch_max个
+		return num;
+	}
+
+	/**
+	 * @brief 计算CentralCache从PageCache一次获取的页数
+	 * @param size 对象大小
+	 * @return 需要获取的页数
+	 */
+	static size_t NumMovePage(size_t size)
+	{
+		size_t num = NumMoveSize(size);
+		size_t npage = num * size;
+
+		npage >>= PAGE_SHIFT;
+		if (npage == 0)
+			npage = 1;
+		if (npage > MAX_PAGESIZE - 1)
+			npage = MAX_PAGESIZE - 1; // 调大批量下限后不超过PageCache的最大页数
+		return npage;
+	}
+};
+
+// ================================ Span结构体 ================================
+
+/**
+ * @struct Span
+ * @brief 页跨度结构体，管理连续的内存页
+ * @details Span是内存池的基本管理单元，包含连续的内存页和相关的管理信息
+ */
+struct Span
+{
+	PAGE_ID _pageId = 0;       // 起始页号
+	size_t _n = 0;             // 连续页的数量
+
+	Span *_prev = nullptr;     // 双向链表中的前一个Span
+	Span *_next = nullptr;     // 双向链表中的后一个Span
+
+	size_t _useCount = 0;      // 已分配出去的小块内存数量
+	void *_freeList = nullptr; // 已归还的小块内存的自由链表头指针
+	char *_carve = nullptr;    // 尚未切分区域的起始位置，FetchRangeObj按需从这里切出对象
+	char *_carveEnd = nullptr; // 尚未切分区域的结束位置
+
+	bool _isUse = false;       // 标记该Span是否正在被使用（用于页合并判断）
+	bool _isArena = false;     // 标记该Span归属于Arena（整体释放，禁止ConcurrencyFree）
+	bool _zeroed = false;      // 各页仍是全零：向系统申请或SystemDecommit之后未交出过，交出后表示交出时的状态
+
+	size_t _objSize = 0;       // 该Span中每个小对象的大小
+
+	uint64_t _freeTime = 0;    // 空闲超大Span挂入最佳适配树的时间（毫秒），用于按年龄归还系统
+};
+
+// ================================ Span链表类 ================================
+
+/**
+ * @class SpanList
+ * @brief Span双向循环链表管理类
+ * @details 使用带头节点的双向循环链表管理Span，支持线程安全操作
+ */
+class SpanList
+{
+public:
+	PoolMutex _mtx; // 桶锁，保证线程安全
+
+	/**
+	 * @brief 构造函数，初始化带头节点的双向循环链表
+	 */
+	SpanList()
+	{
+		_head = new Span;
+		_head->_next = _head;
+		_head->_prev = _head;
+	}
+
+	/**
+	 * @brief 获取链表的第一个有效节点
+	 * @return 第一个Span指针
+	 */
+	Span *begin()
+	{
+		return _head->_next;
+	}
+
+	/**
+	 * @brief 获取链表的结束标记（头节点）
+	 * @return 头节点指针
+	 */
+	Span *end()
+	{
+		return _head;
+	}
+
+	/**
+	 * @brief 检查链表是否为空
+	 * @return true表示为空，false表示非空
+	 */
+	bool empty()
+	{
+		return begin() == end();
+	}
+
+	/**
+	 * @brief 弹出链表头部的第一个Span
+	 * @return 被弹出的Span指针
+	 */
+	Span *pop_front()
+	{
+		assert(!empty());
+		Span *first = begin();
+		erase(first);
+		return first;
+	}
+
+	/**
+	 * @brief 在链表头部插入新的Span
+	 * @param newSpan 要插入的Span指针
+	 */
+	void push_front(Span *newSpan)
+	{
+		insert(begin(), newSpan);
+	}
+
+	/**
+	 * @brief 在指定位置前插入新的Span
+	 * @param pos 插入位置
+	 * @param newSpan 要插入的Span指针
+	 */
+	void insert(Span *pos, Span *newSpan)
+	{
+		assert(pos);
+		assert(newSpan);
+		Span *prev = pos->_prev;
+		newSpan->_next = pos;
+		newSpan->_prev = prev;
+		prev->_next = newSpan;
+		pos->_prev = newSpan;
+	}
+
+	/**
+	 * @brief 从链表中删除指定的Span
+	 * @param pos 要删除的Span指针
+	 */
+	void erase(Span *pos)
+	{
+		assert(pos);
+		assert(pos != _head);
+		Span *prev = pos->_prev;
+		Span *next = pos->_next;
+		prev->_next = next;
+		next->_prev = prev;
+	}
+
+private:
+	Span *_head = nullptr;
 };
\ No newline at end of file
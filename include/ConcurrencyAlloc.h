@@ -1,74 +1,426 @@
-#pragma once
-
-/**
- * @file ConcurrencyAlloc.h
- * @brief ߲ڴӿ
- * @details ṩͳһڴͷŽӿڣԶѡʵķ
- */
-
-#include "Common.h"
-#include "ThreadCache.h"
-#include "PageCache.h"
-#include "ObjectPool.h"
-
-/**
- * @brief ߲ڴ亯
- * @param size ҪڴС
- * @return ڴָ
- * @details ԣ
- *          - Сڵ256KBʹThreadCache䣨١
- *          - 256KBֱӴPageCache䣨ֱӷ䣩
- */
-static void *ConcurrencyAlloc(size_t size)
-{
-	if (size > MAX_MEMORYSIZE)
-	{
-		// ֱӴPageCache
-		size_t alignSize = SizeClass::RoundUp(size);
-		size_t npages = alignSize >> PAGE_SHIFT;
-
-		PageCache::GetInstance()->GetMutex().lock();
-		Span *span = PageCache::GetInstance()->NewSpan(npages);
-		span->_objSize = size;
-		PageCache::GetInstance()->GetMutex().unlock();
-
-		void *ptr = (void *)(span->_pageId << PAGE_SHIFT);
-		return ptr;
-	}
-	else
-	{
-		// СͨThreadCache
-		if (pTLSThreadCache == nullptr)
-		{
-			// ״ʹʱ̱߳صThreadCache
-			static ObjectPool<ThreadCache> tcPool;
-			pTLSThreadCache = tcPool.New();
-		}
-		return pTLSThreadCache->Allocate(size);
-	}
-}
-
-/**
- * @brief ߲ڴͷź
- * @param ptr Ҫͷŵڴָ
- * @details ͷŲԣ
- *          - С󣺹黹ThreadCache
- *          - ֱӹ黹PageCache
- */
-static void ConcurrencyFree(void *ptr)
-{
-	Span *span = PageCache::GetInstance()->MapObjectToSpan(ptr);
-	if (span->_objSize > MAX_MEMORYSIZE)
-	{
-		// ֱӹ黹PageCache
-		PageCache::GetInstance()->GetMutex().lock();
-		PageCache::GetInstance()->ReleaseSpanToPageCache(span);
-		PageCache::GetInstance()->GetMutex().unlock();
-	}
-	else
-	{
-		// С黹ThreadCache
-		assert(pTLSThreadCache);
-		pTLSThreadCache->Deallocate(ptr, span->_objSize);
-	}
-}
\ No newline at end of file
+#pragma once
+
+/**
+ * @file ConcurrencyAlloc.h
+ * @brief 高并发内存分配器对外接口
+ * @details 提供统一的内存分配和释放接口，自动选择合适的分配策略
+ */
+
+#include "Common.h"
+#include "ThreadCache.h"
+#include "CentralCache.h"
+#include "PageCache.h"
+#include "ObjectPool.h"
+#include "Arena.h"
+#include "DeferredFree.h"
+#include "CarveKernel.h"
+#include <cerrno>
+#include <cstring>
+
+/**
+ * @brief 获取当前线程的ThreadCache
+ * @return ThreadCache指针
+ * @details 首次使用时创建线程本地的ThreadCache，
+ *          释放路径也会调用，保证只释放不分配的线程同样可用
+ */
+static ThreadCache *GetThreadCache()
+{
+	if (pTLSThreadCache == nullptr)
+	{
+		// 多个线程可能同时首次进入这里，使用线程安全的对象池；
+		// 其他线程退出前仍会访问各自的ThreadCache，对象池不随静态对象析构
+		static ConcurrentObjectPool<ThreadCache> *tcPool = new ConcurrentObjectPool<ThreadCache>;
+		pTLSThreadCache = tcPool->New();
+	}
+	return pTLSThreadCache;
+}
+
+/**
+ * @brief 从PageCache申请大对象所在的Span
+ * @param size 需要分配的内存大小，大于256KB
+ * @return 已标记使用中的Span，可能比按size对齐的页数多出不超过128页
+ */
+static Span *ConcurrencyAllocLargeSpan(size_t size)
+{
+	size_t alignSize = SizeClass::RoundUp(size);
+	size_t npages = alignSize >> PAGE_SHIFT;
+
+	HCMP_LOCK_SITE(LOCK_SITE_LARGE_ALLOC);
+	PageCache::GetInstance()->GetMutex().lock();
+	Span *span = PageCache::GetInstance()->NewSpan(npages);
+	span->_isUse = true; // Span来自页堆，必须标记使用中，防止被相邻Span合并
+	span->_objSize = size;
+	PageCache::GetInstance()->GetMutex().unlock();
+	return span;
+}
+
+/**
+ * @brief 高并发内存分配函数
+ * @param size 需要分配的内存大小
+ * @return 分配的内存指针
+ * @details 分配策略：
+ *          - 小于等于256KB：使用ThreadCache分配（快速、无锁）
+ *          - 大于256KB：直接从PageCache分配（大对象直接分配）
+ */
+static void *ConcurrencyAlloc(size_t size)
+{
+	void *ptr;
+	if (size > MAX_MEMORYSIZE)
+	{
+		// 大对象直接从PageCache分配
+		Span *span = ConcurrencyAllocLargeSpan(size);
+		ptr = (void *)(span->_pageId << PAGE_SHIFT);
+	}
+	else
+	{
+		// 小对象通过ThreadCache分配
+		ptr = GetThreadCache()->Allocate(size);
+	}
+	HCMP_TRACE_ALLOC(ptr, size);
+	return ptr;
+}
+
+/**
+ * @brief 分配n个size字节的元素并清零
+ * @param n 元素个数
+ * @param size 元素大小
+ * @return 清零的内存，n*size溢出时返回nullptr并置errno为ENOMEM；n*size为0时返回最小的对象
+ * @details 清零策略：
+ *          - 小对象：可能是回收的对象，按尺寸类大小用向量化内核清零
+ *          - 大对象：Span的页自向系统申请或上次丢弃内容后未交出过时已是全零，不再清零；
+ *            否则整个Span不少于calloc_decommit_bytes时丢弃页内容，由内核在访问时提供零页，
+ *            更小的用清零内核。可用大小内的字节全部为零
+ */
+static inline void *ConcurrencyCalloc(size_t n, size_t size)
+{
+	if (size != 0 && n > SIZE_MAX / size)
+	{
+		errno = ENOMEM;
+		return nullptr;
+	}
+	size_t bytes = n * size;
+	if (bytes == 0)
+		bytes = 1;
+
+	void *ptr;
+	if (bytes > MAX_MEMORYSIZE)
+	{
+		Span *span = ConcurrencyAllocLargeSpan(bytes);
+		ptr = (void *)(span->_pageId << PAGE_SHIFT);
+		if (!span->_zeroed)
+		{
+			size_t spanBytes = span->_n << PAGE_SHIFT;
+			if (spanBytes >= TuneGet(TUNE_CALLOC_DECOMMIT_BYTES))
+				SystemDecommit(ptr, span->_n);
+			else
+				ClearObject(ptr, spanBytes);
+		}
+	}
+	else
+	{
+		ptr = GetThreadCache()->Allocate(bytes);
+		ClearObject(ptr, SizeClass::RoundUp(bytes));
+	}
+	HCMP_TRACE_ALLOC(ptr, bytes);
+	return ptr;
+}
+
+/**
+ * @brief 高并发内存释放函数
+ * @param ptr 要释放的内存指针
+ * @details 释放策略：
+ *          - 小对象：归还到ThreadCache
+ *          - 大对象：直接归还到PageCache
+ */
+static void ConcurrencyFree(void *ptr)
+{
+	HCMP_TRACE_FREE(ptr);
+
+	// 小对象由页号得到大小：本线程的页号缓存命中时不访问PageCache和Span，
+	// 未命中时读取不加锁的页号到尺寸类映射
+	PageCache *pc = PageCache::GetInstance();
+	ThreadCache *tc = GetThreadCache();
+	PAGE_ID id = (PAGE_ID)ptr >> PAGE_SHIFT;
+	uint64_t epoch = pc->ClassEpoch();
+	size_t size = tc->CachedObjectSize(id, epoch);
+	if (size == 0)
+	{
+		size = pc->PageObjectSize(id);
+		if (size)
+			tc->CacheObjectSize(id, epoch, size);
+	}
+	if (size)
+	{
+		tc->Deallocate(ptr, size);
+		return;
+	}
+
+	HCMP_LOCK_SITE(LOCK_SITE_FREE_LOOKUP);
+	Span *span = PageCache::GetInstance()->MapObjectToSpan(ptr);
+	if (span->_isArena)
+	{
+		// Arena的内存只能通过Arena::Reset/析构整体释放，逐个释放会破坏Span状态
+		assert(false);
+		return;
+	}
+	if (span->_objSize > MAX_MEMORYSIZE)
+	{
+		// 开启延迟释放的线程把Span交给回收线程，队列超过上限时同步归还
+		if (pTLSThreadCache && pTLSThreadCache->DeferredFreeEnabled() &&
+			DeferredFree::GetInstance()->PushSpan(span))
+			return;
+
+		// 大对象直接归还到PageCache
+		HCMP_LOCK_SITE(LOCK_SITE_LARGE_FREE);
+		PageCache::GetInstance()->GetMutex().lock();
+		PageCache::GetInstance()->ReleaseSpanToPageCache(span);
+		PageCache::GetInstance()->GetMutex().unlock();
+	}
+	else
+	{
+		// 小对象归还到ThreadCache
+		GetThreadCache()->Deallocate(ptr, span->_objSize);
+	}
+}
+
+/**
+ * @brief 带大小的高并发内存释放函数
+ * @param ptr 要释放的内存指针
+ * @param size 分配时传入的大小
+ * @details 小对象可直接由大小算出所在的桶，省去页号到Span的查找；
+ *          大对象仍需通过Span归还。调用者必须保证size与分配时一致，
+ *          并且ptr不是Arena的内存（此路径不做Arena检查）
+ */
+static inline void ConcurrencyFree(void *ptr, size_t size)
+{
+	if (size > MAX_MEMORYSIZE)
+	{
+		ConcurrencyFree(ptr);
+		return;
+	}
+	HCMP_TRACE_FREE(ptr);
+
+	size_t alignSize = SizeClass::RoundUp(size);
+	assert(PageCache::GetInstance()->MapObjectToSpan(ptr)->_objSize == alignSize);
+	GetThreadCache()->Deallocate(ptr, alignSize);
+}
+
+/**
+ * @struct ConcurrencyAllocResult
+ * @brief ConcurrencyAllocAtLeast的返回值
+ */
+struct ConcurrencyAllocResult
+{
+	void *ptr;     // 分配的内存指针
+	size_t size;   // 实际可用的字节数，不小于申请的大小
+};
+
+/**
+ * @brief 分配至少size字节的内存，并返回实际可用的大小
+ * @param size 需要分配的内存大小
+ * @return 指针与实际可用的字节数
+ * @details 语义同C++23的allocate_at_least：小对象为对齐后的尺寸类大小，大对象为所在Span的整页大小。
+ *          调用方可以使用全部可用字节，释放时传入[size, 返回的size]之间的任意大小均可
+ */
+static inline ConcurrencyAllocResult ConcurrencyAllocAtLeast(size_t size)
+{
+	ConcurrencyAllocResult result;
+	if (size > MAX_MEMORYSIZE)
+	{
+		Span *span = ConcurrencyAllocLargeSpan(size);
+		result.ptr = (void *)(span->_pageId << PAGE_SHIFT);
+		result.size = span->_n << PAGE_SHIFT;
+	}
+	else
+	{
+		result.ptr = GetThreadCache()->Allocate(size);
+		result.size = SizeClass::RoundUp(size);
+	}
+	HCMP_TRACE_ALLOC(result.ptr, size);
+	return result;
+}
+
+/**
+ * @brief 查询已分配内存实际可用的字节数
+ * @param ptr ConcurrencyAlloc/ConcurrencyAllocAtLeast返回的指针
+ * @return 可用字节数，不小于分配时申请的大小；Arena的内存返回0
+ * @details 小对象由不加锁的页号到尺寸类映射得到，查不到时加页锁查Span
+ */
+static inline size_t ConcurrencyUsableSize(const void *ptr)
+{
+	PageCache *pc = PageCache::GetInstance();
+	size_t size = pc->PageObjectSize((PAGE_ID)ptr >> PAGE_SHIFT);
+	if (size)
+		return size;
+
+	Span *span = pc->MapObjectToSpan(const_cast<void *>(ptr));
+	if (span->_isArena)
+		return 0;
+	if (span->_objSize > MAX_MEMORYSIZE)
+		return span->_n << PAGE_SHIFT;
+	return span->_objSize;
+}
+
+/**
+ * @brief 判断指针是否由本内存池分配
+ * @param ptr 任意指针，可以来自其他分配器或栈
+ * @return 属于本内存池时返回true
+ * @details 定义HCMP_RESERVE时所有内存都来自一段预留区域，只需一次区间比较，不加锁；
+ *          否则加页锁查页号映射，只能识别正在使用的小对象所在页和大对象的首尾页。
+ *          作为malloc替代时可用来区分外来指针
+ */
+static inline bool ConcurrencyOwns(const void *ptr)
+{
+#ifdef HCMP_RESERVE
+	return ReserveOwns(ptr);
+#else
+	return PageCache::GetInstance()->OwnsPage(ptr);
+#endif
+}
+
+/**
+ * @brief 开启或关闭当前线程的延迟释放
+ * @param enable 是否开启
+ * @details 开启后，本线程释放时需要加锁归还给CentralCache/PageCache的批次和大对象
+ *          改由后台回收线程处理，释放延迟不再受锁竞争影响；回收队列超过上限时
+ *          仍同步归还。适合对延迟敏感的请求处理线程
+ */
+static inline void ConcurrencySetDeferredFree(bool enable)
+{
+	GetThreadCache()->SetDeferredFree(enable);
+}
+
+/**
+ * @brief 按名称读取或修改运行参数，接口仿照mallctl
+ * @param name 参数名（见Tuning.h），或只读的统计项：stats.system_allocs、stats.system_frees、
+ *             stats.system_bytes、stats.large_cache_bytes、stats.deferred_pending_bytes、
+ *             stats.new_spans（PageCache分配Span的次数）、stats.empty_spans（CentralCache保留的空Span数）、
+ *             stats.empty_span_bytes（保留的空Span总字节数）
+ * @param oldValue 不为空时写入当前值，同时修改时为修改前的值
+ * @param newValue 不为空时修改为该值
+ * @return 0成功；ENOENT名称不存在；EPERM只读；EINVAL取值超出范围
+ * @details large_cache_bytes、deferred_free_bytes和transfer_cache修改后立即生效（关闭批次缓存应在业务线程静止时进行），
+ *          调小empty_span_max或empty_span_bytes时归还所有保留的空Span，其余参数在各线程下一次从CentralCache获取对象时生效
+ */
+static inline int ConcurrencyControl(const char *name, size_t *oldValue, const size_t *newValue = nullptr)
+{
+	TuneInit();
+	if (strncmp(name, "stats.", 6) == 0)
+	{
+		const char *stat = name + 6;
+		size_t value = 0;
+		if (strcmp(stat, "system_allocs") == 0)
+			value = PageCache::GetInstance()->GetStats().systemAllocs;
+		else if (strcmp(stat, "system_frees") == 0)
+			value = PageCache::GetInstance()->GetStats().systemFrees;
+		else if (strcmp(stat, "system_bytes") == 0)
+			value = PageCache::GetInstance()->GetStats().systemBytes;
+		else if (strcmp(stat, "large_cache_bytes") == 0)
+			value = PageCache::GetInstance()->GetStats().largeCacheBytes;
+		else if (strcmp(stat, "deferred_pending_bytes") == 0)
+			value = DeferredFree::GetInstance()->PendingBytes();
+		else if (strcmp(stat, "new_spans") == 0)
+			value = PageCache::GetInstance()->GetStats().spanAllocs;
+		else if (strcmp(stat, "empty_spans") == 0)
+			value = CentralCache::GetInstance()->EmptySpanTotal();
+		else if (strcmp(stat, "empty_span_bytes") == 0)
+			value = CentralCache::GetInstance()->EmptySpanBytes();
+		else
+			return ENOENT;
+		if (newValue)
+			return EPERM;
+		if (oldValue)
+			*oldValue = value;
+		return 0;
+	}
+
+	TuneParam param = TuneFind(name);
+	if (param == TUNE_COUNT)
+		return ENOENT;
+	size_t old = TuneGet(param);
+	if (newValue)
+	{
+		int err = TuneSet(param, *newValue);
+		if (err)
+			return err;
+		switch (param)
+		{
+		case TUNE_LARGE_CACHE_BYTES:
+			PageCache::GetInstance()->SetLargeCacheLimit(*newValue);
+			break;
+		case TUNE_DEFERRED_FREE_BYTES:
+			DeferredFree::GetInstance()->SetLimit(*newValue);
+			break;
+		case TUNE_TRANSFER_CACHE:
+			CentralCache::GetInstance()->SetTransferCacheEnabled(*newValue != 0);
+			break;
+		case TUNE_TRANSFER_CACHE_BYTES:
+			CentralCache::GetInstance()->SetTransferCacheBytes(*newValue);
+			break;
+		case TUNE_EMPTY_SPAN_MAX:
+		case TUNE_EMPTY_SPAN_BYTES:
+			if (*newValue < old)
+				CentralCache::GetInstance()->ReleaseEmptySpans();
+			break;
+		case TUNE_EMPTY_SPAN_IDLE_MS:
+			DeferredFree::GetInstance()->Wake(true);
+			break;
+		default:
+			break;
+		}
+	}
+	if (oldValue)
+		*oldValue = old;
+	return 0;
+}
+
+/**
+ * @brief 编译期确定大小的内存分配函数
+ * @tparam N 需要分配的内存大小
+ * @return 分配的内存指针
+ * @details 对齐大小和桶索引都在编译期算出，快路径只剩读取线程本地的
+ *          ThreadCache和一次自由链表弹出；超过256KB时退回ConcurrencyAlloc
+ */
+template<size_t N>
+static inline void *ConcurrencyAllocFixed()
+{
+	static_assert(N > 0, "ConcurrencyAllocFixed: N must be positive");
+	if (N > MAX_MEMORYSIZE)
+		return ConcurrencyAlloc(N);
+
+	constexpr size_t alignSize = N <= MAX_MEMORYSIZE ? SizeClass::RoundUpConst(N) : 0;
+	constexpr size_t index = N <= MAX_MEMORYSIZE ? SizeClass::IndexConst(alignSize) : 0;
+	ThreadCache *tc = pTLSThreadCache;
+	if (tc == nullptr)
+		tc = GetThreadCache();
+	void *ptr = tc->AllocateFixed(index, alignSize);
+	HCMP_TRACE_ALLOC(ptr, N);
+	return ptr;
+}
+
+/**
+ * @brief 编译期确定大小的内存释放函数
+ * @tparam N 分配时的大小
+ * @param ptr 要释放的内存指针
+ * @details 与ConcurrencyAllocFixed<N>或ConcurrencyAlloc(N)配对；同带大小的ConcurrencyFree一样，
+ *          调用者必须保证N与分配时一致，并且ptr不是Arena的内存
+ */
+template<size_t N>
+static inline void ConcurrencyFreeFixed(void *ptr)
+{
+	static_assert(N > 0, "ConcurrencyFreeFixed: N must be positive");
+	if (N > MAX_MEMORYSIZE)
+	{
+		ConcurrencyFree(ptr);
+		return;
+	}
+
+	constexpr size_t alignSize = N <= MAX_MEMORYSIZE ? SizeClass::RoundUpConst(N) : 0;
+	constexpr size_t index = N <= MAX_MEMORYSIZE ? SizeClass::IndexConst(alignSize) : 0;
+	assert(PageCache::GetInstance()->MapObjectToSpan(ptr)->_objSize == alignSize);
+	HCMP_TRACE_FREE(ptr);
+	ThreadCache *tc = pTLSThreadCache;
+	if (tc == nullptr)
+		tc = GetThreadCache();
+	tc->DeallocateFixed(ptr, index, alignSize);
+}
@@ -0,0 +1,270 @@
+#pragma once
+
+/**
+ * @file ConcurrencyAllocator.h
+ * @brief 标准库分配器适配
+ * @details 提供STL分配器、std::pmr::memory_resource适配以及智能指针辅助函数，
+ *          使标准容器无需在调用处包装即可使用高并发内存池
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <memory>
+#include <limits>
+#include <new>
+#include <utility>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define HCMP_HAS_PMR 1
+#endif
+#endif
+
+// ================================ STL分配器 ================================
+
+#if defined(__cpp_lib_allocate_at_least)
+template<class Pointer>
+using ConcurrencyAllocationResult = std::allocation_result<Pointer>;
+#else
+/**
+ * @struct ConcurrencyAllocationResult
+ * @brief 与C++23的std::allocation_result相同的返回值，标准库未提供时使用
+ */
+template<class Pointer>
+struct ConcurrencyAllocationResult
+{
+	Pointer ptr;     // 分配的内存指针
+	size_t count;    // 实际可容纳的元素个数
+};
+#endif
+
+/**
+ * @class ConcurrencyAllocator
+ * @brief 满足标准分配器要求的模板类
+ * @tparam T 元素类型
+ * @details 无状态分配器，所有实例等价；释放时使用带大小的ConcurrencyFree，
+ *          小对象无需查找Span即可定位桶
+ */
+template<class T>
+class ConcurrencyAllocator
+{
+public:
+	typedef T value_type;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<class U>
+	struct rebind
+	{
+		typedef ConcurrencyAllocator<U> other;
+	};
+
+	ConcurrencyAllocator() noexcept {}
+
+	template<class U>
+	ConcurrencyAllocator(const ConcurrencyAllocator<U> &) noexcept {}
+
+	/**
+	 * @brief 分配n个T的内存
+	 * @param n 元素个数
+	 * @return 内存指针
+	 */
+	T *allocate(size_t n)
+	{
+		if (n > max_size())
+			throw std::bad_alloc();
+		return static_cast<T *>(ConcurrencyAlloc(n * sizeof(T)));
+	}
+
+	/**
+	 * @brief 分配至少n个T的内存
+	 * @param n 元素个数
+	 * @return 指针与实际可容纳的元素个数，个数不小于n
+	 * @details 容器按返回的个数设置容量，可用上尺寸类对齐多出的空间，推迟下一次扩容
+	 */
+	ConcurrencyAllocationResult<T *> allocate_at_least(size_t n)
+	{
+		if (n > max_size())
+			throw std::bad_alloc();
+		ConcurrencyAllocResult result = ConcurrencyAllocAtLeast(n * sizeof(T));
+		return {static_cast<T *>(result.ptr), result.size / sizeof(T)};
+	}
+
+	/**
+	 * @brief 释放n个T的内存
+	 * @param p 内存指针
+	 * @param n 元素个数，必须与allocate时一致，或介于allocate_at_least申请的个数与返回的个数之间
+	 */
+	void deallocate(T *p, size_t n) noexcept
+	{
+		ConcurrencyFree(p, n * sizeof(T));
+	}
+
+	size_t max_size() const noexcept
+	{
+		return std::numeric_limits<size_t>::max() / sizeof(T);
+	}
+};
+
+template<class T, class U>
+inline bool operator==(const ConcurrencyAllocator<T> &, const ConcurrencyAllocator<U> &) noexcept
+{
+	return true;
+}
+
+template<class T, class U>
+inline bool operator!=(const ConcurrencyAllocator<T> &, const ConcurrencyAllocator<U> &) noexcept
+{
+	return false;
+}
+
+// ================================ 智能指针辅助 ================================
+
+/**
+ * @struct ConcurrencyDeleter
+ * @brief 配合unique_ptr使用的删除器：析构对象后按大小归还内存
+ */
+template<class T>
+struct ConcurrencyDeleter
+{
+	void operator()(T *obj) const
+	{
+		obj->~T();
+		ConcurrencyFree(obj, sizeof(T));
+	}
+};
+
+template<class T>
+using ConcurrencyUniquePtr = std::unique_ptr<T, ConcurrencyDeleter<T>>;
+
+/**
+ * @brief 从内存池创建对象并交给unique_ptr管理
+ * @param args 构造参数
+ * @return 管理该对象的unique_ptr
+ */
+template<class T, class... Args>
+ConcurrencyUniquePtr<T> ConcurrencyMakeUnique(Args &&...args)
+{
+	void *mem = ConcurrencyAlloc(sizeof(T));
+	try
+	{
+		return ConcurrencyUniquePtr<T>(new (mem) T(std::forward<Args>(args)...));
+	}
+	catch (...)
+	{
+		ConcurrencyFree(mem, sizeof(T));
+		throw;
+	}
+}
+
+/**
+ * @brief 从内存池创建shared_ptr，对象与控制块一次分配
+ * @param args 构造参数
+ * @return shared_ptr
+ */
+template<class T, class... Args>
+std::shared_ptr<T> ConcurrencyMakeShared(Args &&...args)
+{
+	return std::allocate_shared<T>(ConcurrencyAllocator<T>(), std::forward<Args>(args)...);
+}
+
+// ================================ 定长类型池 ================================
+
+/**
+ * @class TypedPool
+ * @brief 按类型分配对象的无状态对象池
+ * @tparam T 对象类型
+ * @details 内存来自ConcurrencyAllocFixed<sizeof(T)>，大小类在编译期确定；
+ *          所有实例等价，Delete可以释放任何实例New出的对象
+ */
+template<class T>
+class TypedPool
+{
+public:
+	static_assert(alignof(T) <= 16, "TypedPool: over-aligned types are not supported");
+
+	/**
+	 * @brief 创建对象
+	 * @param args 构造参数，完美转发给T的构造函数
+	 * @return 对象指针
+	 */
+	template<class... Args>
+	T *New(Args &&...args)
+	{
+		void *mem = ConcurrencyAllocFixed<sizeof(T)>();
+		try
+		{
+			return new (mem) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			ConcurrencyFreeFixed<sizeof(T)>(mem);
+			throw;
+		}
+	}
+
+	/**
+	 * @brief 析构对象并归还内存
+	 * @param obj 对象指针，可以为空
+	 */
+	void Delete(T *obj)
+	{
+		if (obj == nullptr)
+			return;
+		obj->~T();
+		ConcurrencyFreeFixed<sizeof(T)>(obj);
+	}
+};
+
+// ================================ pmr适配 ================================
+
+#ifdef HCMP_HAS_PMR
+
+/**
+ * @class ConcurrencyMemoryResource
+ * @brief 将std::pmr的分配请求转发到ConcurrencyAlloc
+ * @details 对齐要求通过放大请求大小满足：对象在Span内按对齐后的大小连续切分，
+ *          只要请求大小不小于对齐数（不超过一页），得到的地址就满足对齐
+ */
+class ConcurrencyMemoryResource : public std::pmr::memory_resource
+{
+protected:
+	void *do_allocate(size_t bytes, size_t alignment) override
+	{
+		if (alignment > ((size_t)1 << PAGE_SHIFT))
+			throw std::bad_alloc();
+		return ConcurrencyAlloc(AdjustSize(bytes, alignment));
+	}
+
+	void do_deallocate(void *p, size_t bytes, size_t alignment) override
+	{
+		ConcurrencyFree(p, AdjustSize(bytes, alignment));
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+	{
+		return dynamic_cast<const ConcurrencyMemoryResource *>(&other) != nullptr;
+	}
+
+private:
+	static size_t AdjustSize(size_t bytes, size_t alignment)
+	{
+		if (bytes == 0)
+			bytes = 1;
+		return bytes < alignment ? alignment : bytes;
+	}
+};
+
+/**
+ * @brief 获取全局的ConcurrencyMemoryResource实例
+ * @return memory_resource指针
+ */
+inline ConcurrencyMemoryResource *GetConcurrencyResource()
+{
+	static ConcurrencyMemoryResource resource;
+	return &resource;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#pragma once
+
+/**
+ * @file DeferredFree.h
+ * @brief 异步延迟释放
+ * @details 对延迟敏感的线程可以开启延迟释放：ThreadCache链表过长且无锁批次缓存已满时，
+ *          整批对象不再在当前线程里加锁归还给Span，而是压入一个无锁队列，由后台回收线程
+ *          归还给CentralCache/PageCache；大对象的Span也同样交给回收线程。待回收的字节数
+ *          超过上限时不再入队，由当前线程照常同步归还（反压）
+ */
+
+#include "Common.h"
+#include "ObjectPool.h"
+#include <atomic>
+#include <condition_variable>
+
+static const size_t DEFERRED_FREE_MAX_BYTES = 64 * 1024 * 1024;   // 待回收字节数的默认上限
+
+/**
+ * @struct DeferredFreeStats
+ * @brief 延迟释放的统计信息
+ */
+struct DeferredFreeStats
+{
+    size_t deferredBatches = 0;   // 入队的小对象批次数
+    size_t deferredSpans = 0;     // 入队的大对象Span数
+    size_t rejected = 0;          // 因反压改为同步归还的次数
+    size_t reclaimed = 0;         // 回收线程处理完的批次与Span总数
+};
+
+/**
+ * @class DeferredFree
+ * @brief 延迟释放队列与后台回收线程（单例）
+ * @details 队列是多生产者单消费者的无锁栈：生产者CAS压入，回收线程一次性摘下整个栈，
+ *          不存在ABA问题。回收线程在首次入队或CentralCache首次有清理工作时启动，未开启延迟释放的进程
+ *          也由它按时归还空闲的空Span和批次；CentralCache保留着空Span或批次缓存中有批次时
+ *          每隔empty_span_idle_ms的一半醒来清理一轮，否则无限期休眠直到有节点入队或被Wake唤醒。
+ *          进程退出时由atexit注册的Shutdown停止回收线程并归还剩余节点
+ */
+class DeferredFree
+{
+public:
+    /**
+     * @brief 获取DeferredFree单例实例
+     * @return DeferredFree单例指针
+     */
+    static DeferredFree *GetInstance()
+    {
+        return &_sInst;
+    }
+
+    /**
+     * @brief 提交一批待归还的小对象
+     * @param start 以NextObj串起、以空结尾的对象链表
+     * @param n 对象个数
+     * @param size 对象大小
+     * @return 队列超过上限或已停止时返回false，调用方需同步归还
+     */
+    bool PushList(void *start, size_t n, size_t size);
+
+    /**
+     * @brief 提交一个待归还的大对象Span
+     * @param span 大对象所在的Span
+     * @return 队列超过上限或已停止时返回false，调用方需同步归还
+     */
+    bool PushSpan(Span *span);
+
+    /**
+     * @brief 等待回收线程处理完当前队列中的所有批次
+     */
+    void Flush();
+
+    /**
+     * @brief 清理有了新工作时唤醒无限期休眠的回收线程，回收线程还没启动时启动它
+     * @param force 为true时回收线程在定时等待中也唤醒，使其按新的empty_span_idle_ms重新计时
+     * @details CentralCache保留空Span或向批次缓存压入批次后调用；回收线程不在无限期休眠时只读一个标志
+     */
+    void Wake(bool force = false);
+
+    /**
+     * @brief 设置待回收字节数的上限
+     * @param bytes 字节数，0表示不再入队
+     * @details 同时更新运行参数deferred_free_bytes
+     */
+    void SetLimit(size_t bytes)
+    {
+        _limit.store(bytes, std::memory_order_relaxed);
+        TuneSet(TUNE_DEFERRED_FREE_BYTES, bytes);
+    }
+
+    /**
+     * @brief 获取当前待回收的字节数
+     */
+    size_t PendingBytes() const
+    {
+        return _pendingBytes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取统计信息
+     */
+    DeferredFreeStats GetStats() const;
+
+private:
+    /**
+     * @struct DeferredBatch
+     * @brief 队列节点：一批小对象或一个大对象Span
+     */
+    struct DeferredBatch
+    {
+        void *start = nullptr;           // 小对象链表，大对象时为空
+        size_t size = 0;                 // 小对象大小
+        Span *span = nullptr;            // 大对象Span，小对象时为空
+        size_t bytes = 0;                // 计入待回收字节数的大小
+        DeferredBatch *next = nullptr;   // 队列中的下一个节点
+    };
+
+    bool Push(DeferredBatch *batch);
+    void EnsureStarted();
+    void Run();
+    void Reclaim(DeferredBatch *list);
+    void Stop();
+    static void Shutdown();
+
+    DeferredFree()
+    {
+        TuneInit();
+        _limit.store(TuneGet(TUNE_DEFERRED_FREE_BYTES), std::memory_order_relaxed);
+    }
+    ~DeferredFree();
+    DeferredFree(const DeferredFree &) = delete;
+    DeferredFree &operator=(const DeferredFree &) = delete;
+
+private:
+    std::atomic<DeferredBatch *> _head{nullptr};               // 待回收节点栈
+    std::atomic<size_t> _pendingBytes{0};                      // 已入队未处理的字节数
+    std::atomic<size_t> _limit{DEFERRED_FREE_MAX_BYTES};       // 反压阈值，初始值取自运行参数
+    std::atomic<size_t> _submitted{0};                         // 已入队的节点总数
+    std::atomic<size_t> _reclaimed{0};                         // 已处理的节点总数
+    std::atomic<size_t> _deferredBatches{0};
+    std::atomic<size_t> _deferredSpans{0};
+    std::atomic<size_t> _rejected{0};
+    std::atomic<bool> _started{false};
+    std::atomic<bool> _stop{false};
+    std::atomic<bool> _sleeping{false};                        // 回收线程准备无限期休眠
+    bool _wake = false;                                        // Wake请求，由_mtx保护
+
+    ConcurrentObjectPool<DeferredBatch> _batchPool;            // 队列节点池
+    std::mutex _mtx;                                           // 只用于回收线程的休眠与唤醒
+    std::condition_variable _cv;
+    std::thread _thread;
+
+    static DeferredFree _sInst;                                // 静态单例实例
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+/**
+ * @file FlatPageMap.h
+ * @brief 预留区域内按偏移索引的页号映射
+ * @details 定义HCMP_RESERVE时所有页都在一段连续区域内，页号减去区域起始页号即为数组下标，
+ *          查找是一次减法、一次比较和一次读取。数组本身以MAP_NORESERVE映射，只有写入过的部分占用物理内存，
+ *          默认64GB区域对应64MB虚拟地址
+ */
+
+#include "Common.h"
+
+#ifdef HCMP_RESERVE
+
+/**
+ * @class FlatPageMap
+ * @brief 页号到值指针的平坦数组，接口与RadixTree相同
+ * @details 本类不加锁，由PageCache的全局锁保护；区域外的页号查找返回nullptr
+ */
+template<typename T>
+class FlatPageMap
+{
+public:
+    FlatPageMap()
+        : _basePage((PAGE_ID)ReserveRegion() >> PAGE_SHIFT),
+          _pages(ReserveRegionBytes() >> PAGE_SHIFT)
+    {
+        size_t bytes = _pages * sizeof(T *);
+#ifdef _WIN32
+        _slots = (T **)VirtualAlloc(NULL, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (_slots == nullptr)
+            throw std::bad_alloc();
+#else
+        void *ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (ptr == MAP_FAILED)
+            throw std::bad_alloc();
+        _slots = (T **)ptr;
+#endif
+    }
+
+    FlatPageMap(const FlatPageMap &) = delete;
+    FlatPageMap &operator=(const FlatPageMap &) = delete;
+
+    /**
+     * @brief 插入键值对
+     * @param key 页号，须在区域内
+     * @param value 对应的值
+     * @return 总是true
+     */
+    bool insert(PAGE_ID key, T *value)
+    {
+        assert(key - _basePage < _pages);
+        _slots[key - _basePage] = value;
+        return true;
+    }
+
+    /**
+     * @brief 查找键对应的值
+     * @param key 页号
+     * @return 对应的值指针，未找到或不在区域内返回nullptr
+     */
+    T *lookup(PAGE_ID key) const
+    {
+        PAGE_ID idx = key - _basePage;
+        return idx < _pages ? _slots[idx] : nullptr;
+    }
+
+    /**
+     * @brief 删除键值对
+     * @param key 页号
+     * @return 被删除的值指针，未找到返回nullptr
+     */
+    T *remove(PAGE_ID key)
+    {
+        PAGE_ID idx = key - _basePage;
+        if (idx >= _pages)
+            return nullptr;
+        T *old = _slots[idx];
+        _slots[idx] = nullptr;
+        return old;
+    }
+
+private:
+    PAGE_ID _basePage;   // 区域起始页号
+    size_t _pages;       // 区域页数，即数组长度
+    T **_slots;          // 数组，未写入的项为nullptr
+};
+
+#endif
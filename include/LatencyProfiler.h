@@ -0,0 +1,165 @@
+#pragma once
+
+/**
+ * @file LatencyProfiler.h
+ * @brief 分层延迟直方图定义
+ * @details 定义HCMP_LATENCY_PROFILE编译时，在ThreadCache、CentralCache、PageCache和系统调用各层
+ *          记录耗时直方图：rdtsc计时，每个2的幂区间再分为4个子桶，每个线程写自己的直方图，
+ *          读取时合并。ThreadCache命中这类快路径每HCMP_LATENCY_SAMPLE_RATE次采样一次，
+ *          慢路径每次都计时。各路径是包含关系，例如FetchFromCentralCache的耗时包含其中的
+ *          GetOneSpan refill。未定义时HCMP_LATENCY_SCOPE/HCMP_LATENCY_SAMPLED为空，没有任何额外开销
+ */
+
+#include <iostream>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @enum LatencyPath
+ * @brief 计时的路径
+ */
+enum LatencyPath
+{
+    LAT_TC_ALLOC = 0,     // ThreadCache::Allocate命中（采样）
+    LAT_TC_FETCH,         // FetchFromCentralCache，ThreadCache未命中
+    LAT_SPAN_REFILL,      // GetOneSpan向PageCache申请新Span（含等待页锁）
+    LAT_NEW_SPAN,         // PageCache::NewSpan
+    LAT_SYSTEM_ALLOC,     // SystemAlloc
+    LAT_TC_FREE,          // ThreadCache::Deallocate放回自由链表（采样）
+    LAT_LIST_TOO_LONG,    // ListTooLong归还一批对象
+    LAT_RELEASE_LIST,     // ReleaseListToSpan
+    LAT_RELEASE_SPAN,     // PageCache::ReleaseSpanToPageCache
+    LAT_SYSTEM_FREE,      // SystemFree
+    LAT_PATH_COUNT
+};
+
+/**
+ * @struct LatencySummary
+ * @brief 一条路径的延迟汇总，单位纳秒，分位数取所在桶的上界
+ */
+struct LatencySummary
+{
+    uint64_t count = 0;   // 记录次数，采样路径为采样到的次数
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+};
+
+#ifdef HCMP_LATENCY_PROFILE
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HCMP_LATENCY_RDTSC
+#else
+#include <chrono>
+#endif
+
+#ifndef HCMP_LATENCY_SAMPLE_RATE
+#define HCMP_LATENCY_SAMPLE_RATE 64   // 快路径采样率，须为2的幂
+#endif
+
+static_assert((HCMP_LATENCY_SAMPLE_RATE & (HCMP_LATENCY_SAMPLE_RATE - 1)) == 0,
+              "HCMP_LATENCY_SAMPLE_RATE must be a power of two");
+
+/**
+ * @brief 读取计时器：x86上为TSC周期数，其他平台为纳秒
+ */
+static inline uint64_t LatencyTicks()
+{
+#ifdef HCMP_LATENCY_RDTSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief 把一次耗时记入当前线程的直方图
+ * @param path 路径
+ * @param ticks LatencyTicks的差值
+ */
+void LatencyRecord(LatencyPath path, uint64_t ticks);
+
+// 快路径按路径分别采样计数，每个编译单元各自计数
+static thread_local uint32_t tlsLatencySample[LAT_PATH_COUNT] = {};
+
+/**
+ * @class LatencyScope
+ * @brief 作用域计时，每次都记录
+ */
+class LatencyScope
+{
+public:
+    explicit LatencyScope(LatencyPath path)
+        : _path(path), _start(LatencyTicks())
+    {
+    }
+
+    ~LatencyScope()
+    {
+        LatencyRecord(_path, LatencyTicks() - _start);
+    }
+
+private:
+    LatencyPath _path;
+    uint64_t _start;
+};
+
+/**
+ * @class LatencySampledScope
+ * @brief 作用域计时，每HCMP_LATENCY_SAMPLE_RATE次记录一次
+ */
+class LatencySampledScope
+{
+public:
+    explicit LatencySampledScope(LatencyPath path)
+        : _path(path), _start(0)
+    {
+        if ((++tlsLatencySample[path] & (HCMP_LATENCY_SAMPLE_RATE - 1)) == 0)
+            _start = LatencyTicks();
+    }
+
+    ~LatencySampledScope()
+    {
+        if (_start)
+            LatencyRecord(_path, LatencyTicks() - _start);
+    }
+
+private:
+    LatencyPath _path;
+    uint64_t _start;
+};
+
+#define HCMP_LATENCY_CAT2(a, b) a##b
+#define HCMP_LATENCY_CAT(a, b) HCMP_LATENCY_CAT2(a, b)
+#define HCMP_LATENCY_SCOPE(path) LatencyScope HCMP_LATENCY_CAT(_latency, __LINE__)(path)
+#define HCMP_LATENCY_SAMPLED(path) LatencySampledScope HCMP_LATENCY_CAT(_latency, __LINE__)(path)
+
+#else
+
+#define HCMP_LATENCY_SCOPE(path) ((void)0)
+#define HCMP_LATENCY_SAMPLED(path) ((void)0)
+
+#endif
+
+/**
+ * @brief 打印每条路径的p50/p99/p99.9/max
+ * @param os 输出流
+ * @details 合并所有存活线程与已退出线程的直方图；未定义HCMP_LATENCY_PROFILE时只打印提示
+ */
+void LatencyProfileReport(std::ostream &os = std::cout);
+
+/**
+ * @brief 获取一条路径的延迟汇总
+ * @param path 路径
+ * @return 汇总，未开启时全为0
+ */
+LatencySummary LatencyProfileGet(LatencyPath path);
+
+/**
+ * @brief 清空所有线程的直方图
+ * @details 应在业务线程静止时调用
+ */
+void LatencyProfileReset();
@@ -0,0 +1,141 @@
+#pragma once
+
+/**
+ * @file LockProfiler.h
+ * @brief 锁竞争分析器定义
+ * @details 定义HCMP_LOCK_PROFILE编译时，桶锁和PageCache锁换成ProfiledMutex，
+ *          统计每把锁的获取次数、竞争次数、等待/持有时间直方图，并按调用路径归类；
+ *          未定义时PoolMutex就是std::mutex，HCMP_LOCK_SITE为空，没有任何额外开销
+ */
+
+#include <mutex>
+#include <iostream>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @enum LockSite
+ * @brief 加锁的调用路径
+ */
+enum LockSite
+{
+    LOCK_SITE_OTHER = 0,       // 未归类
+    LOCK_SITE_FETCH_RANGE,     // CentralCache::FetchRangeObj取对象
+    LOCK_SITE_SPAN_REFILL,     // GetOneSpan向PageCache申请新Span
+    LOCK_SITE_RELEASE_LIST,    // ReleaseListToSpan归还对象
+    LOCK_SITE_LARGE_ALLOC,     // 超过256KB的大对象申请
+    LOCK_SITE_LARGE_FREE,      // 超过256KB的大对象释放
+    LOCK_SITE_FREE_LOOKUP,     // ConcurrencyFree查找对象所属Span
+    LOCK_SITE_ARENA,           // Arena申请/归还Span
+    LOCK_SITE_COUNT
+};
+
+#ifdef HCMP_LOCK_PROFILE
+
+static const size_t LOCK_HIST_BUCKETS = 32;   // 直方图按2的幂分桶：第i桶为[2^i, 2^(i+1))纳秒
+
+/**
+ * @struct LockSiteStats
+ * @brief 一把锁在一条调用路径上的统计
+ */
+struct LockSiteStats
+{
+    uint64_t acquires = 0;                     // 获取次数
+    uint64_t contended = 0;                    // 获取时锁已被占用的次数
+    uint64_t waitNs = 0;                       // 总等待时间
+    uint64_t holdNs = 0;                       // 总持有时间
+    uint64_t waitHist[LOCK_HIST_BUCKETS] = {}; // 竞争时的等待时间直方图
+    uint64_t holdHist[LOCK_HIST_BUCKETS] = {}; // 持有时间直方图
+};
+
+/**
+ * @class ProfiledMutex
+ * @brief 带竞争统计的互斥锁，接口与std::mutex一致
+ * @details 先try_lock，失败才计为一次竞争并计时等待；统计数据只在持有该锁时写入，
+ *          不需要额外的原子操作。所有实例登记在全局链表中供LockProfileReport汇总
+ */
+class ProfiledMutex
+{
+public:
+    ProfiledMutex();
+    ~ProfiledMutex();
+
+    void lock();
+    void unlock();
+    bool try_lock();
+
+    /**
+     * @brief 设置报告中显示的锁名
+     * @param name 锁名，需为静态字符串
+     * @param index 同名锁的下标（如桶号），-1表示没有
+     */
+    void SetName(const char *name, int index = -1)
+    {
+        _name = name;
+        _index = index;
+    }
+
+private:
+    friend void LockProfileReport(std::ostream &os, size_t topN);
+    friend void LockProfileReset();
+
+    void OnAcquired(uint64_t waitNs, bool contended);
+
+    ProfiledMutex(const ProfiledMutex &) = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+private:
+    std::mutex _mtx;
+    const char *_name = "SpanList::_mtx";
+    int _index = -1;
+
+    LockSite _holdSite = LOCK_SITE_OTHER;      // 当前持有者的调用路径
+    uint64_t _holdStart = 0;                   // 当前持有者获得锁的时间
+    LockSiteStats _stats[LOCK_SITE_COUNT];
+
+    ProfiledMutex *_nextMutex = nullptr;       // 全局登记链表
+    ProfiledMutex *_prevMutex = nullptr;
+};
+
+/**
+ * @class LockSiteScope
+ * @brief 在作用域内把当前线程的加锁路径设为site，退出时恢复
+ */
+class LockSiteScope
+{
+public:
+    explicit LockSiteScope(LockSite site);
+    ~LockSiteScope();
+
+private:
+    LockSite _saved;
+};
+
+typedef ProfiledMutex PoolMutex;
+
+#define HCMP_LOCK_SITE_CAT2(a, b) a##b
+#define HCMP_LOCK_SITE_CAT(a, b) HCMP_LOCK_SITE_CAT2(a, b)
+#define HCMP_LOCK_SITE(site) LockSiteScope HCMP_LOCK_SITE_CAT(_lockSite, __LINE__)(site)
+#define HCMP_LOCK_NAME(mtx, name, index) (mtx).SetName(name, index)
+
+#else
+
+typedef std::mutex PoolMutex;
+
+#define HCMP_LOCK_SITE(site) ((void)0)
+#define HCMP_LOCK_NAME(mtx, name, index) ((void)0)
+
+#endif
+
+/**
+ * @brief 打印竞争最严重的若干把锁
+ * @param os 输出流
+ * @param topN 最多打印几把锁，按总等待时间排序
+ * @details 应在业务线程静止时调用；未定义HCMP_LOCK_PROFILE时只打印提示
+ */
+void LockProfileReport(std::ostream &os = std::cout, size_t topN = 10);
+
+/**
+ * @brief 清空所有锁的统计
+ */
+void LockProfileReset();
@@ -1,141 +1,512 @@
-#pragma once
-
-/**
- * @file ObjectPool.h
- * @brief ʵ
- * @details ЧĶڴƵnew/delete
- */
-
-#include "Common.h"
-
-static const size_t FIXED_BLOCK_SIZE = 128 * 1024; // ̶ڴС128KB
-
-/**
- * @class ObjectPool
- * @brief ģ
- * @tparam T 
- * @details ʹڴؼĴ٣ڴЧ
- *          յĶ󣬼ڴƬ
- */
-template<class T>
-class ObjectPool
-{
-public:
-	/**
-	 * @brief Ӷлȡһ
-	 * @return ָ
-	 * @details ȴиѻյĶ
-	 *          ûпɸöڴз¶
-	 */
-	T* New()
-	{
-		T* obj = nullptr;
-		// ȸûյĶ
-		if (_freeList)
-		{
-			void* next = *((void**)_freeList);
-			obj = (T*)_freeList;
-			_freeList = next;
-			return obj;
-		}
-		else
-		{
-			// ǰڴ鲻һʱµڴ
-			if (_leftBytes < sizeof(T))
-			{
-				_leftBytes = FIXED_BLOCK_SIZE;
-				_memory = (char*)malloc(_leftBytes);
-				if (_memory == nullptr)
-					throw std::bad_alloc();
-			}
-
-			obj = (T*)_memory;
-			size_t objSize = sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T);
-			_memory += objSize;
-			_leftBytes -= objSize;
-
-			// ʹplacement newʽù캯ʼ
-			new(obj)T;
-			return obj;
-		}
-	}
-
-	/**
-	 * @brief 黹󵽶
-	 * @param obj Ҫ黹Ķָ
-	 * @details ʽȻ󽫶
-	 *          ע⣺ﲢͷڴ棬ǽΪɸ
-	 */
-	void Delete(T* obj)
-	{
-		// ʽ
-		obj->~T();
-
-		// ͷͷ巨
-		*(void**)obj = _freeList;
-		_freeList = obj;
-	}
-
-private:
-	char* _memory = nullptr;    // ָǰڴָ
-	size_t _leftBytes = 0;      // ǰڴʣֽ
-	void* _freeList = nullptr;  // ͷָ룬ѻյĶ
-};
-
-struct TreeNode
-{
-	int _val;
-	TreeNode* _left;
-	TreeNode* _right;
-	TreeNode()
-		: _val(0)
-		, _left(nullptr)
-		, _right(nullptr)
-	{}
-};
-
-inline void TestObjectPool()
-{
-	//ͷŵִ
-	const size_t Rounds = 5;
-	//ÿͷŶٴ
-	const size_t N = 1000000;
-	size_t begin1 = clock();
-	std::vector<TreeNode*> v1;
-	v1.reserve(N);
-	for (size_t j = 0; j < Rounds; ++j)
-	{
-		for (int i = 0; i < N; ++i)
-		{
-			v1.push_back(new TreeNode);
-		}
-		for (int i = 0; i < N; ++i)
-		{
-			delete v1[i];
-		}
-
-		v1.clear();
-	}
-	size_t end1 = clock();
-
-	ObjectPool<TreeNode>TNPool;
-	size_t begin2 = clock();
-	std::vector<TreeNode*> v2;
-	v2.reserve(N);
-	for (size_t j = 0; j < Rounds; ++j)
-	{
-		for (int i = 0; i < N; ++i)
-		{
-			v2.push_back(TNPool.New());
-		}
-		for (int i = 0; i < N; ++i)
-		{
-			TNPool.Delete(v2[i]);
-		}
-		v2.clear();
-	}
-	size_t end2 = clock();
-
-	cout << "new cost time:" << end1 - begin1 << endl;
-	cout << "object pol cost time:" << end2 - begin2 << endl;
-}
\ No newline at end of file
+#pragma once
+
+/**
+ * @file ObjectPool.h
+ * @brief 定长对象池实现
+ * @details 高效的对象内存管理，避免频繁的new/delete操作；
+ *          ObjectPool供持锁的单线程场景使用，ConcurrentObjectPool可被多线程直接使用
+ */
+
+#include "Common.h"
+#include <atomic>
+#include <chrono>
+
+static const size_t FIXED_BLOCK_SIZE = 128 * 1024; // 固定内存块大小：128KB
+static const size_t POOL_MAGAZINE_BATCH = 32;      // magazine与共享链表之间一次移动的最多对象数
+
+/**
+ * @class ObjectPool
+ * @brief 定长对象池模板类
+ * @tparam T 对象类型
+ * @details 使用内存池技术管理对象的创建和销毁，提高内存分配效率
+ *          采用自由链表管理回收的对象，减少内存碎片
+ */
+template<class T>
+class ObjectPool
+{
+public:
+	/**
+	 * @brief 从对象池中获取一个对象
+	 * @return 对象指针
+	 * @details 优先从自由链表中复用已回收的对象，
+	 *          如果没有可复用对象则从内存块中分配新对象
+	 */
+	T* New()
+	{
+		T* obj = nullptr;
+		// 优先复用回收的对象
+		if (_freeList)
+		{
+			void* next = *((void**)_freeList);
+			obj = (T*)_freeList;
+			_freeList = next;
+			return obj;
+		}
+		else
+		{
+			// 当前内存块不够分配一个对象时，申请新的内存块
+			if (_leftBytes < sizeof(T))
+			{
+				// 直接向系统申请，不经过malloc；SystemAlloc失败时抛出bad_alloc
+				_leftBytes = FIXED_BLOCK_SIZE;
+				_memory = (char*)SystemAlloc(_leftBytes >> PAGE_SHIFT);
+			}
+
+			obj = (T*)_memory;
+			size_t objSize = sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T);
+			_memory += objSize;
+			_leftBytes -= objSize;
+
+			// 使用placement new显式调用构造函数初始化对象
+			new(obj)T;
+			return obj;
+		}
+	}
+
+	/**
+	 * @brief 归还对象到对象池
+	 * @param obj 要归还的对象指针
+	 * @details 显式调用析构函数清理对象，然后将对象加入自由链表
+	 *          注意：这里并不真正释放内存，而是将对象标记为可复用
+	 */
+	void Delete(T* obj)
+	{
+		// 显式调用析构函数清理对象
+		obj->~T();
+
+		// 将对象加入自由链表头部（头插法）
+		*(void**)obj = _freeList;
+		_freeList = obj;
+	}
+
+private:
+	char* _memory = nullptr;    // 指向当前内存块的指针
+	size_t _leftBytes = 0;      // 当前内存块剩余字节数
+	void* _freeList = nullptr;  // 自由链表头指针，管理已回收的对象
+};
+
+/**
+ * @class ConcurrentObjectPool
+ * @brief 线程安全的定长对象池
+ * @tparam T 对象类型
+ * @details 每个线程持有一个magazine（对象指针数组），New/Delete只访问本线程的magazine；
+ *          magazine空了从共享链表整批取，满了整批放回。共享链表是以批为元素的Treiber栈，
+ *          栈顶指针的高16位存放版本号防止ABA；共享链表也为空时才加锁从内存块中切出新对象。
+ *          内存块直接通过SystemAlloc向系统申请，ReleaseFreeBlocks可归还完全空闲的内存块。
+ *          magazine按类型T在线程间共享，同一线程交替使用同类型的多个池时会先把对象还给原来的池，
+ *          因此池的生命周期必须覆盖所有使用它的线程
+ */
+template<class T>
+class ConcurrentObjectPool
+{
+public:
+	ConcurrentObjectPool()
+	{
+		// 空闲对象的前两个字分别链接批内下一个对象和下一批
+		size_t align = alignof(T) < 16 ? 16 : alignof(T);
+		_objSize = sizeof(T) < 2 * sizeof(void*) ? 2 * sizeof(void*) : sizeof(T);
+		_objSize = (_objSize + alignof(T) - 1) & ~(alignof(T) - 1);
+		_headerSize = (sizeof(BlockHeader) + align - 1) & ~(align - 1);
+
+		size_t blockBytes = _headerSize + _objSize;
+		if (blockBytes < FIXED_BLOCK_SIZE)
+			blockBytes = FIXED_BLOCK_SIZE;
+		_blockPages = (blockBytes + (1 << PAGE_SHIFT) - 1) >> PAGE_SHIFT;
+
+		// 每批不超过一个内存块的1/4，大对象也至少一个
+		size_t perBlock = ((_blockPages << PAGE_SHIFT) - _headerSize) / _objSize;
+		_batch = perBlock / 4;
+		if (_batch < 1)
+			_batch = 1;
+		if (_batch > POOL_MAGAZINE_BATCH)
+			_batch = POOL_MAGAZINE_BATCH;
+	}
+
+	/**
+	 * @brief 析构时归还所有内存块，调用前所有对象都应已归还
+	 */
+	~ConcurrentObjectPool()
+	{
+		Magazine& mag = LocalMagazine();
+		if (mag.owner == this)
+		{
+			mag.owner = nullptr;
+			mag.count = 0;
+		}
+
+		while (_blocks)
+		{
+			BlockHeader* next = _blocks->next;
+			SystemFree(_blocks, _blockPages);
+			_blocks = next;
+		}
+	}
+
+	/**
+	 * @brief 获取一个对象
+	 * @return 已构造的对象指针
+	 */
+	T* New()
+	{
+		Magazine& mag = LocalMagazine();
+		if (mag.owner != this)
+			mag.Attach(this);
+		if (mag.count == 0)
+			Refill(mag);
+
+		void* obj = mag.objs[--mag.count];
+		return new(obj)T;
+	}
+
+	/**
+	 * @brief 归还对象
+	 * @param obj 要归还的对象指针
+	 */
+	void Delete(T* obj)
+	{
+		obj->~T();
+
+		Magazine& mag = LocalMagazine();
+		if (mag.owner != this)
+			mag.Attach(this);
+		if (mag.count == 2 * _batch)
+			Flush(mag, _batch);
+		mag.objs[mag.count++] = obj;
+	}
+
+	/**
+	 * @brief 归还完全空闲的内存块
+	 * @return 归还的内存块数
+	 * @details 先把当前线程的magazine放回共享链表，再取下整个共享链表按内存块统计；
+	 *          其他线程magazine中的对象不计入，所在内存块不会被归还。
+	 *          调用期间其他线程不能使用该池
+	 */
+	size_t ReleaseFreeBlocks()
+	{
+		std::lock_guard<std::mutex> guard(_growMtx);
+
+		Magazine& mag = LocalMagazine();
+		if (mag.owner == this)
+			FlushAll(mag);
+
+		std::vector<void*> objs;
+		for (void* batch = PopAll(); batch; batch = BatchNext(batch))
+		{
+			for (void* obj = batch; obj; obj = NextObj(obj))
+				objs.push_back(obj);
+		}
+		std::sort(objs.begin(), objs.end());
+
+		size_t released = 0;
+		BlockHeader** link = &_blocks;
+		while (*link)
+		{
+			BlockHeader* block = *link;
+			char* first = (char*)block + _headerSize;
+			char* last = (char*)block + (_blockPages << PAGE_SHIFT);
+			auto lo = std::lower_bound(objs.begin(), objs.end(), (void*)first);
+			auto hi = std::lower_bound(objs.begin(), objs.end(), (void*)last);
+			if ((size_t)(hi - lo) == block->carved)
+			{
+				if (_memory >= first && _memory <= last)
+				{
+					_memory = nullptr;
+					_leftBytes = 0;
+				}
+				*link = block->next;
+				SystemFree(block, _blockPages);
+				++released;
+				continue;
+			}
+
+			// 未归还的内存块中的空闲对象按批放回共享链表
+			void* batch = nullptr;
+			size_t n = 0;
+			for (auto it = lo; it != hi; ++it)
+			{
+				NextObj(*it) = batch;
+				batch = *it;
+				if (++n == _batch)
+				{
+					PushBatch(batch);
+					batch = nullptr;
+					n = 0;
+				}
+			}
+			if (batch)
+				PushBatch(batch);
+			link = &block->next;
+		}
+
+		return released;
+	}
+
+	/**
+	 * @brief 获取当前持有的内存块数
+	 */
+	size_t BlockCount()
+	{
+		std::lock_guard<std::mutex> guard(_growMtx);
+		size_t n = 0;
+		for (BlockHeader* block = _blocks; block; block = block->next)
+			++n;
+		return n;
+	}
+
+	/**
+	 * @brief 获取每批移动的对象数
+	 */
+	size_t BatchSize() const
+	{
+		return _batch;
+	}
+
+private:
+	/**
+	 * @struct BlockHeader
+	 * @brief 内存块头部，位于每个内存块起始处
+	 */
+	struct BlockHeader
+	{
+		BlockHeader* next;   // 下一个内存块
+		size_t carved;       // 已从本块切出的对象数
+	};
+
+	/**
+	 * @struct Magazine
+	 * @brief 线程本地的对象缓存
+	 */
+	struct Magazine
+	{
+		ConcurrentObjectPool* owner = nullptr;       // 当前对象所属的池
+		size_t count = 0;
+		void* objs[2 * POOL_MAGAZINE_BATCH];
+
+		/**
+		 * @brief 线程退出时把缓存的对象还给所属的池
+		 */
+		~Magazine()
+		{
+			if (owner)
+				owner->FlushAll(*this);
+		}
+
+		/**
+		 * @brief 切换到另一个池，先把缓存的对象还给原来的池
+		 */
+		void Attach(ConcurrentObjectPool* pool)
+		{
+			if (owner)
+				owner->FlushAll(*this);
+			owner = pool;
+		}
+	};
+
+	static Magazine& LocalMagazine()
+	{
+		static thread_local Magazine mag;
+		return mag;
+	}
+
+	// 栈顶字：低48位为批的首对象地址，高16位为版本号
+	static const int TAG_SHIFT = 48;
+
+	static void* HeadPtr(uint64_t head)
+	{
+		return (void*)(uintptr_t)(head & (((uint64_t)1 << TAG_SHIFT) - 1));
+	}
+
+	static uint64_t NextHead(uint64_t head, void* ptr)
+	{
+		assert(((uint64_t)(uintptr_t)ptr >> TAG_SHIFT) == 0);
+		return (((head >> TAG_SHIFT) + 1) << TAG_SHIFT) | (uint64_t)(uintptr_t)ptr;
+	}
+
+	static void*& BatchNext(void* batch)
+	{
+		return ((void**)batch)[1];
+	}
+
+	void PushBatch(void* batch)
+	{
+		uint64_t head = _batches.load(std::memory_order_relaxed);
+		uint64_t newHead;
+		do
+		{
+			BatchNext(batch) = HeadPtr(head);
+			newHead = NextHead(head, batch);
+		} while (!_batches.compare_exchange_weak(head, newHead, std::memory_order_release,
+			std::memory_order_relaxed));
+	}
+
+	void* PopBatch()
+	{
+		uint64_t head = _batches.load(std::memory_order_acquire);
+		for (;;)
+		{
+			void* top = HeadPtr(head);
+			if (top == nullptr)
+				return nullptr;
+			// top可能已被其他线程取走，读到的next无效时版本号也已变化，CAS会失败
+			void* next = BatchNext(top);
+			if (_batches.compare_exchange_weak(head, NextHead(head, next), std::memory_order_acquire,
+				std::memory_order_acquire))
+				return top;
+		}
+	}
+
+	void* PopAll()
+	{
+		uint64_t head = _batches.load(std::memory_order_acquire);
+		while (HeadPtr(head) && !_batches.compare_exchange_weak(head, NextHead(head, nullptr),
+			std::memory_order_acquire, std::memory_order_acquire))
+		{
+		}
+		return HeadPtr(head);
+	}
+
+	/**
+	 * @brief 把magazine顶部n个对象串成一批放回共享链表
+	 */
+	void Flush(Magazine& mag, size_t n)
+	{
+		assert(n > 0 && n <= mag.count);
+		void* batch = nullptr;
+		for (size_t i = 0; i < n; i++)
+		{
+			void* obj = mag.objs[--mag.count];
+			NextObj(obj) = batch;
+			batch = obj;
+		}
+		PushBatch(batch);
+	}
+
+	void FlushAll(Magazine& mag)
+	{
+		while (mag.count > 0)
+			Flush(mag, mag.count < _batch ? mag.count : _batch);
+	}
+
+	/**
+	 * @brief magazine为空时补充对象，优先从共享链表取一批，否则加锁切出新对象
+	 */
+	void Refill(Magazine& mag)
+	{
+		void* batch = PopBatch();
+		if (batch)
+		{
+			for (void* obj = batch; obj; obj = NextObj(obj))
+				mag.objs[mag.count++] = obj;
+			return;
+		}
+
+		std::lock_guard<std::mutex> guard(_growMtx);
+		for (size_t i = 0; i < _batch; i++)
+		{
+			if (_leftBytes < _objSize)
+			{
+				BlockHeader* block = (BlockHeader*)SystemAlloc(_blockPages);
+				block->next = _blocks;
+				block->carved = 0;
+				_blocks = block;
+				_memory = (char*)block + _headerSize;
+				_leftBytes = (_blockPages << PAGE_SHIFT) - _headerSize;
+			}
+			mag.objs[mag.count++] = _memory;
+			_memory += _objSize;
+			_leftBytes -= _objSize;
+			++_blocks->carved;
+		}
+	}
+
+	ConcurrentObjectPool(const ConcurrentObjectPool&) = delete;
+	ConcurrentObjectPool& operator=(const ConcurrentObjectPool&) = delete;
+
+private:
+	std::atomic<uint64_t> _batches{0};   // 共享链表栈顶（带版本号）
+	size_t _objSize = 0;                 // 每个对象占用的字节数
+	size_t _headerSize = 0;              // 内存块头部占用的字节数
+	size_t _blockPages = 0;              // 每个内存块的页数
+	size_t _batch = 0;                   // 每批移动的对象数
+
+	std::mutex _growMtx;                 // 保护内存块的申请、切分和归还
+	BlockHeader* _blocks = nullptr;      // 内存块链表
+	char* _memory = nullptr;             // 当前内存块中下一个可切分的位置
+	size_t _leftBytes = 0;               // 当前内存块剩余字节数
+};
+
+struct TreeNode
+{
+	int _val;
+	TreeNode* _left;
+	TreeNode* _right;
+	TreeNode()
+		: _val(0)
+		, _left(nullptr)
+		, _right(nullptr)
+	{}
+};
+
+/**
+ * @brief 多个线程反复整批申请、整批释放TreeNode
+ * @return 总耗时（毫秒）
+ */
+template<class Alloc, class Dealloc>
+inline long long RunObjectPoolRounds(size_t nthreads, size_t rounds, size_t n, Alloc alloc, Dealloc dealloc)
+{
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < nthreads; ++t)
+	{
+		threads.emplace_back([&]() {
+			std::vector<TreeNode*> v;
+			v.reserve(n);
+			for (size_t j = 0; j < rounds; ++j)
+			{
+				for (size_t i = 0; i < n; ++i)
+					v.push_back(alloc());
+				for (size_t i = 0; i < n; ++i)
+					dealloc(v[i]);
+				v.clear();
+			}
+		});
+	}
+	for (auto& th : threads)
+		th.join();
+	auto end = std::chrono::steady_clock::now();
+	return (long long)std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+}
+
+/**
+ * @brief 对象池多线程性能测试
+ * @param nthreads 线程数
+ * @details 每个线程反复整批申请、整批释放TreeNode，对比new/delete、
+ *          加锁的ObjectPool和ConcurrentObjectPool的总耗时
+ */
+inline void TestObjectPool(size_t nthreads = 4)
+{
+	//申请释放的轮次
+	const size_t Rounds = 5;
+	//每个线程每轮申请释放多少次
+	const size_t N = 1000000 / nthreads;
+
+	long long newCost = RunObjectPoolRounds(nthreads, Rounds, N,
+		[]() { return new TreeNode; },
+		[](TreeNode* p) { delete p; });
+
+	ObjectPool<TreeNode> lockedPool;
+	std::mutex mtx;
+	long long lockedCost = RunObjectPoolRounds(nthreads, Rounds, N,
+		[&]() { std::lock_guard<std::mutex> guard(mtx); return lockedPool.New(); },
+		[&](TreeNode* p) { std::lock_guard<std::mutex> guard(mtx); lockedPool.Delete(p); });
+
+	ConcurrentObjectPool<TreeNode> concurrentPool;
+	long long concurrentCost = RunObjectPoolRounds(nthreads, Rounds, N,
+		[&]() { return concurrentPool.New(); },
+		[&](TreeNode* p) { concurrentPool.Delete(p); });
+
+	cout << nthreads << " threads:" << endl;
+	cout << "new cost time:" << newCost << " ms" << endl;
+	cout << "object pool + mutex cost time:" << lockedCost << " ms" << endl;
+	cout << "concurrent object pool cost time:" << concurrentCost << " ms" << endl;
+}
@@ -2,27 +2,55 @@
 
 /**
  * @file PageCache.h
- * @brief ҳඨ
- * @details ڴҳķ䡢պͺϲϵͳڴֱӽ
- *          ʹûŻҳŵSpanӳ䣬ܺڴЧ
+ * @brief 页缓存类定义
+ * @details 管理大块内存页的分配、回收和合并，与系统内存直接交互
+ *          使用基数树优化页号到Span的映射，提升查找性能和内存效率；
+ *          定义HCMP_RESERVE时改用按区域偏移索引的数组
  */
 
 #include "Common.h"
 #include "ObjectPool.h"
 #include "RadixTree.h"
+#include "Bitmap.h"
+#include "SpanTree.h"
+#include "PageClassMap.h"
+#include "FlatPageMap.h"
+
+#ifdef HCMP_RESERVE
+using SpanPageMap = FlatPageMap<Span>;    // 所有页都在预留区域内，按偏移索引
+#else
+using SpanPageMap = SpanRadixTree;
+#endif
+
+static const size_t LARGE_CACHE_MAX_BYTES = 64 * 1024 * 1024;   // 空闲超大Span保留的默认字节上限：64MB
+static const uint64_t LARGE_CACHE_MAX_AGE_MS = 5000;            // 空闲超大Span最长保留时间：5秒
+
+/**
+ * @struct PageCacheStats
+ * @brief PageCache与系统交互的统计信息
+ */
+struct PageCacheStats
+{
+    size_t systemAllocs = 0;      // SystemAlloc（mmap）调用次数
+    size_t systemFrees = 0;       // SystemFree（munmap）调用次数
+    size_t systemBytes = 0;       // 当前向系统申请且尚未归还的字节数
+    size_t spanAllocs = 0;        // NewSpan调用次数
+    size_t largeCacheHits = 0;    // 超大申请从已释放区域切分满足的次数
+    size_t largeCacheBytes = 0;   // 当前空闲超大Span（>128页）的总字节数
+};
 
 /**
  * @class PageCache
- * @brief ҳࣨģʽ
- * @details ڴҳ֧ҳķ䡢պҳĺϲ
- *          ʹȫ֤̰߳ȫڴصײ
+ * @brief 页缓存管理类（单例模式）
+ * @details 负责管理大块内存页，支持页的分配、回收和相邻页的合并
+ *          使用全局锁保证线程安全，是内存池的最底层
  */
 class PageCache
 {
 public:
     /**
-     * @brief ȡPageCacheʵ
-     * @return PageCacheָ
+     * @brief 获取PageCache单例实例
+     * @return PageCache单例指针
      */
     static PageCache *GetInstance()
     {
@@ -30,46 +58,151 @@ public:
     }
 
     /**
-     * @brief kҳڴ
-     * @param k Ҫҳ
-     * @return Spanָ
+     * @brief 分配k页的连续内存
+     * @param k 需要分配的页数
+     * @return 分配的Span指针
      */
     Span *NewSpan(size_t k);
 
     /**
-     * @brief ڴַӳ䵽ӦSpan
-     * @param obj ڴָ
-     * @return ӦSpanָ
+     * @brief 根据内存地址映射到对应的Span
+     * @param obj 内存对象指针
+     * @return 对应的Span指针
      */
     Span *MapObjectToSpan(void *obj);
 
     /**
-     * @brief ͷSpanPageCacheԺϲҳ
-     * @param span ҪͷŵSpanָ
+     * @brief 根据内存地址查找对应的Span，不加锁
+     * @param obj 内存对象指针
+     * @return 对应的Span指针
+     * @details 调用方需已持有页锁，用于在一次加锁中查找多个对象
+     */
+    Span *MapObjectToSpanLocked(void *obj);
+
+    /**
+     * @brief 判断指针是否指向正在使用的Span的某一页，加页锁查页号映射
+     * @param ptr 任意指针
+     * @return 小对象Span的任意页、大对象Span的首尾页返回true
+     * @details 未定义HCMP_RESERVE时ConcurrencyOwns使用此方法
+     */
+    bool OwnsPage(const void *ptr);
+
+    /**
+     * @brief 释放Span回PageCache，并尝试合并相邻页
+     * @param span 要释放的Span指针
      */
     void ReleaseSpanToPageCache(Span *span);
 
     /**
-     * @brief ȡPageCacheĻ
-     * @return 
+     * @brief 记录小对象Span各页的尺寸类
+     * @param span 刚交给CentralCache的Span，_objSize已设置
+     * @details 调用方持有页锁；_objSize不是所在桶的对齐大小时不记录，释放时仍经Span查找
+     */
+    void SetSpanClass(Span *span);
+
+    /**
+     * @brief 由页号得到小对象的对齐大小，不加锁
+     * @param id 对象所在的页号，对象须仍在使用中
+     * @return 对象大小，该页不属于小对象Span时返回0
+     */
+    size_t PageObjectSize(PAGE_ID id) const
+    {
+        uint8_t cls = _classMap.Get(id);
+        return cls ? SizeClass::RoundUp(SizeClass::ClassSize(cls - 1)) : 0;
+    }
+
+    /**
+     * @brief 尺寸类映射的纪元，线程缓存的页号到大小的映射在纪元改变后失效
      */
-    std::mutex &GetMutex()
+    uint64_t ClassEpoch() const
+    {
+        return _classMap.Epoch();
+    }
+
+    /**
+     * @brief 获取PageCache的互斥锁引用
+     * @return 互斥锁引用
+     */
+    PoolMutex &GetMutex()
     {
         return _pageMtx;
     }
 
+    /**
+     * @brief 设置空闲超大Span保留的总字节上限，超出部分归还系统，0表示不保留
+     * @param bytes 字节数
+     * @details 同时更新运行参数large_cache_bytes
+     */
+    void SetLargeCacheLimit(size_t bytes);
+
+    /**
+     * @brief 获取与系统交互的统计信息
+     * @return 统计信息
+     */
+    PageCacheStats GetStats();
+
+private:
+    /**
+     * @brief 将空闲Span归还系统
+     * @param span 要归还的Span，已从桶/树中摘除
+     */
+    void ReleaseSpanToSystem(Span *span);
+
+    /**
+     * @brief 归还超龄的空闲超大Span，超过字节上限时再从最小的开始归还系统
+     */
+    void TrimLargeSpans();
+
+    /**
+     * @brief 从空闲Span的头部切出k页
+     * @param span 空闲Span，已从桶/树中摘除，页数不小于k
+     * @param k 需要的页数
+     * @return 切出的Span，剩余部分重新挂回
+     */
+    Span *CarveSpan(Span *span, size_t k);
+
+    /**
+     * @brief 将空闲Span挂入对应的桶，超过128页的放入最佳适配树
+     * @param span 要挂入的Span
+     */
+    void PushSpan(Span *span);
+
+    /**
+     * @brief 从k号桶弹出一个Span
+     * @param k 桶下标（页数）
+     * @return 弹出的Span
+     */
+    Span *PopSpan(size_t k);
+
+    /**
+     * @brief 将空闲Span从其所在的桶或最佳适配树中摘除
+     * @param span 要摘除的Span
+     */
+    void EraseSpan(Span *span);
+
 private:
-    SpanList _pageList[MAX_PAGESIZE];               // ҳSpan
-    ObjectPool<Span> _spanPool;                     // SpanأƵnew/delete
+    SpanList _pageList[MAX_PAGESIZE];               // 按页数分类的Span链表数组
+    Bitmap<MAX_PAGESIZE> _pageBitmap;               // 非空桶位图，须经PushSpan/PopSpan/EraseSpan与_pageList同步
+    ObjectPool<Span> _spanPool;                     // Span对象池，避免频繁new/delete
 
-    SpanRadixTree _idSpanMap;                       // ҳŵSpanӳ䣬Ż
+    SpanPageMap _idSpanMap;                         // 页号到Span的映射：基数树，预留区域模式下为平坦数组
+    PageClassMap _classMap;                         // 页号到尺寸类的映射，释放小对象时不加锁读取
+    SpanTree _largeTree;                            // 超过128页的空闲Span，按（页数，地址）最佳适配
+    size_t _largeLimit = LARGE_CACHE_MAX_BYTES;     // 空闲超大Span保留的字节上限，初始值取自运行参数
+    uint64_t _largeExpire = UINT64_MAX;             // 树中最早可能超龄的时间（毫秒），未到时不遍历树
+    PageCacheStats _stats;                          // 统计信息
 
-    std::mutex _pageMtx;                            // ȫ֤PageCachḛ߳ȫ
+    PoolMutex _pageMtx;                             // 全局锁，保证PageCache线程安全
 
 private:
-    // ģʽֹⲿͿ
-    PageCache() {}
+    // 单例模式：禁止外部构造和拷贝
+    PageCache()
+    {
+        HCMP_LOCK_NAME(_pageMtx, "PageCache::_pageMtx", -1);
+        TuneInit();
+        _largeLimit = TuneGet(TUNE_LARGE_CACHE_BYTES);
+    }
     PageCache(const PageCache &) = delete;
 
-    static PageCache _sInst;                        // ̬ʵ
+    static PageCache _sInst;                        // 静态单例实例
 };
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+/**
+ * @file PageClassMap.h
+ * @brief 页号到尺寸类的映射
+ * @details 与页号到Span的基数树并存，每页只存一个字节的尺寸类。释放小对象时由页号直接得到桶，
+ *          不需要访问Span。两级数组：根数组的每一项指向覆盖2^CLASS_LEAF_BITS页的叶子，
+ *          叶子首次写入时分配且不再释放，因此读取不需要加锁
+ */
+
+#include "Common.h"
+#include <atomic>
+#include <cstring>
+
+static const size_t CLASS_LEAF_BITS = 18;                                  // 每个叶子覆盖的页号位数，叶子256KB
+static const size_t CLASS_ADDRESS_BITS = 48;                               // 覆盖的虚拟地址位数
+static const size_t CLASS_ROOT_BITS = CLASS_ADDRESS_BITS - PAGE_SHIFT - CLASS_LEAF_BITS;
+
+/**
+ * @class PageClassMap
+ * @brief 每页一个字节的尺寸类映射
+ * @details 字节值为桶索引+1，0表示该页不属于小对象Span（空闲、大对象或Arena）。
+ *          写入由调用方持有页锁；读取不加锁，只对仍在使用的对象所在的页读取，
+ *          这些页的值在对象归还前不会改变。每次清除一段页的映射都把纪元加一，
+ *          线程缓存的映射以纪元判断是否过期
+ */
+class PageClassMap
+{
+public:
+    /**
+     * @brief 读取页的尺寸类，不加锁
+     * @param id 页号
+     * @return 桶索引+1，未设置时为0
+     */
+    uint8_t Get(PAGE_ID id) const
+    {
+        size_t root = (size_t)(id >> CLASS_LEAF_BITS);
+        if (root >= ((size_t)1 << CLASS_ROOT_BITS))
+            return 0;
+        uint8_t *leaf = _root[root].load(std::memory_order_acquire);
+        return leaf ? leaf[id & (((PAGE_ID)1 << CLASS_LEAF_BITS) - 1)] : 0;
+    }
+
+    /**
+     * @brief 设置一段连续页的尺寸类，调用方持有页锁
+     * @param id 起始页号
+     * @param n 页数
+     * @param cls 桶索引+1
+     * @return 页号超出覆盖范围时返回false，这些页保持未设置
+     */
+    bool Set(PAGE_ID id, size_t n, uint8_t cls)
+    {
+        if ((size_t)((id + n - 1) >> CLASS_LEAF_BITS) >= ((size_t)1 << CLASS_ROOT_BITS))
+            return false;
+        Fill(id, n, cls);
+        return true;
+    }
+
+    /**
+     * @brief 清除一段连续页的尺寸类并推进纪元，调用方持有页锁
+     * @param id 起始页号
+     * @param n 页数
+     */
+    void Clear(PAGE_ID id, size_t n)
+    {
+        Fill(id, n, 0);
+        _epoch.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 当前纪元，任何一页的映射被清除后都会改变
+     */
+    uint64_t Epoch() const
+    {
+        return _epoch.load(std::memory_order_acquire);
+    }
+
+private:
+    /**
+     * @brief 逐个叶子写入，缺少的叶子向系统申请
+     */
+    void Fill(PAGE_ID id, size_t n, uint8_t cls)
+    {
+        const PAGE_ID leafPages = (PAGE_ID)1 << CLASS_LEAF_BITS;
+        while (n > 0)
+        {
+            size_t root = (size_t)(id >> CLASS_LEAF_BITS);
+            size_t offset = (size_t)(id & (leafPages - 1));
+            size_t count = std::min(n, (size_t)leafPages - offset);
+
+            uint8_t *leaf = _root[root].load(std::memory_order_relaxed);
+            if (leaf == nullptr)
+            {
+                if (cls == 0)
+                {
+                    // 没有叶子的页本来就是0
+                    id += count;
+                    n -= count;
+                    continue;
+                }
+                leaf = (uint8_t *)SystemAlloc(leafPages >> PAGE_SHIFT);
+                _root[root].store(leaf, std::memory_order_release);
+            }
+            memset(leaf + offset, cls, count);
+            id += count;
+            n -= count;
+        }
+    }
+
+private:
+    std::atomic<uint8_t *> _root[(size_t)1 << CLASS_ROOT_BITS] = {};   // 叶子指针，未分配时为空
+    std::atomic<uint64_t> _epoch{0};                                     // 清除次数
+};
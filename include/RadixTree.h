@@ -2,36 +2,36 @@
 
 /**
  * @file RadixTree.h
- * @brief ʵ֣ڸЧҳŵSpanӳ
- * @details Radix Treeһѹǰ׺رʺϡֵӳ
- *          ȹϣڴʹúͻѺԷ
+ * @brief 基数树实现，用于高效的页号到Span映射
+ * @details 基数树（Radix Tree）是一种压缩的前缀树，特别适合用于稀疏的整数键值映射
+ *          相比哈希表，基数树在内存使用和缓存友好性方面有显著优势
  */
 
 #include "Common.h"
 #include "ObjectPool.h"
 #include <array>
 
-// ================================  ================================
+// ================================ 基数树配置 ================================
 
-// 64λϵͳ£ҳʹ52λַƣ
-static const int RADIX_TREE_MAP_SHIFT = 6;  // ÿ6λ64ӽڵ
+// 64位系统下，页号最多使用52位（物理地址限制）
+static const int RADIX_TREE_MAP_SHIFT = 6;  // 每层6位，64个子节点
 static const int RADIX_TREE_MAP_SIZE = 1 << RADIX_TREE_MAP_SHIFT;  // 64
 static const int RADIX_TREE_MAP_MASK = RADIX_TREE_MAP_SIZE - 1;    // 63
-static const int RADIX_TREE_MAX_PATH = (64 + RADIX_TREE_MAP_SHIFT - 1) / RADIX_TREE_MAP_SHIFT;  // 
+static const int RADIX_TREE_MAX_PATH = (64 + RADIX_TREE_MAP_SHIFT - 1) / RADIX_TREE_MAP_SHIFT;  // 最大深度
 
-// ================================ ڵ ================================
+// ================================ 基数树节点 ================================
 
 /**
  * @struct RadixTreeNode
- * @brief ڵṹ
- * @details ÿڵ64ӽڵָ룬ʹϡ洢Żڴʹ
+ * @brief 基数树节点结构
+ * @details 每个节点包含64个子节点指针，使用稀疏存储优化内存使用
  */
 struct RadixTreeNode
 {
-    void* slots[RADIX_TREE_MAP_SIZE];  // ӽڵҶֵָ
-    unsigned long tags;                 // λͼǣָʾЩλʹ
-    int count;                         // ǰڵӽڵ
-    int shift;                         // ǰڵеĲ㼶λ
+    void* slots[RADIX_TREE_MAP_SIZE];  // 子节点或叶子值的指针数组
+    unsigned long tags;                 // 位图标记，指示哪些槽位被使用
+    int count;                         // 当前节点的子节点数量
+    int shift;                         // 当前节点在树中的层级（位移量）
 
     RadixTreeNode(int level_shift = 0) 
         : tags(0), count(0), shift(level_shift)
@@ -44,24 +44,24 @@ struct RadixTreeNode
     ~RadixTreeNode() = default;
 };
 
-// ================================  ================================
+// ================================ 基数树类 ================================
 
 /**
  * @class RadixTree
- * @brief ʵ
- * @details ṩЧĲ롢ҡɾרŻҳŵSpanӳ
+ * @brief 基数树实现类
+ * @details 提供高效的插入、查找、删除操作，专门优化用于页号到Span的映射
  */
 template<typename T>
 class RadixTree
 {
 public:
     /**
-     * @brief 캯
+     * @brief 构造函数
      */
     RadixTree() : _root(nullptr), _height(0), _count(0) {}
 
     /**
-     * @brief 
+     * @brief 析构函数
      */
     ~RadixTree() 
     {
@@ -71,69 +71,69 @@ public:
     }
 
     /**
-     * @brief ֵ
-     * @param key ҳż
-     * @param value ӦֵSpanָ룩
-     * @return Ƿɹ
+     * @brief 插入键值对
+     * @param key 页号键
+     * @param value 对应的值（Span指针）
+     * @return 插入是否成功
      */
     bool insert(PAGE_ID key, T* value);
 
     /**
-     * @brief ҼӦֵ
-     * @param key ҳż
-     * @return Ӧֵָ룬δҵnullptr
+     * @brief 查找键对应的值
+     * @param key 页号键
+     * @return 对应的值指针，未找到返回nullptr
      */
     T* lookup(PAGE_ID key) const;
 
     /**
-     * @brief ɾֵ
-     * @param key ҳż
-     * @return ɾֵָ룬δҵnullptr
+     * @brief 删除键值对
+     * @param key 页号键
+     * @return 被删除的值指针，未找到返回nullptr
      */
     T* remove(PAGE_ID key);
 
     /**
-     * @brief ǷΪ
-     * @return trueʾΪ
+     * @brief 检查树是否为空
+     * @return true表示为空
      */
     bool empty() const { return _count == 0; }
 
     /**
-     * @brief ȡԪ
-     * @return Ԫ
+     * @brief 获取树中元素数量
+     * @return 元素数量
      */
     size_t size() const { return _count; }
 
     /**
-     * @brief 
+     * @brief 清空整个树
      */
     void clear();
 
     /**
-     * @brief ȡĸ߶
-     * @return ĸ߶
+     * @brief 获取树的高度
+     * @return 树的高度
      */
     int height() const { return _height; }
 
 private:
-    RadixTreeNode* _root;                    // ڵ
-    int _height;                             // ĸ߶
-    size_t _count;                           // Ԫ
-    ObjectPool<RadixTreeNode> _nodePool;     // ڵأŻڴ
+    RadixTreeNode* _root;                    // 根节点
+    int _height;                             // 树的高度
+    size_t _count;                           // 元素数量
+    ObjectPool<RadixTreeNode> _nodePool;     // 节点对象池，优化内存分配
 
     /**
-     * @brief չĸ߶µļ
-     * @param key Ҫļ
-     * @return չ¸߶
+     * @brief 扩展树的高度以容纳新的键
+     * @param key 要插入的键
+     * @return 扩展后的新高度
      */
     int _extendTree(PAGE_ID key);
 
     /**
-     * @brief ָ߶µ
-     * @param key ֵ
-     * @param height ĸ߶
-     * @param shift λ
-     * @return ֵ
+     * @brief 计算键在指定高度下的索引
+     * @param key 键值
+     * @param height 树的高度
+     * @param shift 位移量
+     * @return 索引值
      */
     static unsigned int _getIndex(PAGE_ID key, int height, int shift)
     {
@@ -141,9 +141,9 @@ private:
     }
 
     /**
-     * @brief ָ߶ȶӦλ
-     * @param height ߶
-     * @return λ
+     * @brief 计算指定高度对应的位移量
+     * @param height 高度
+     * @return 位移量
      */
     static int _getShift(int height)
     {
@@ -151,16 +151,16 @@ private:
     }
 
     /**
-     * @brief ݹٽڵ
-     * @param node ҪٵĽڵ
-     * @param height ڵ߶
+     * @brief 递归销毁节点
+     * @param node 要销毁的节点
+     * @param height 节点高度
      */
     void _destroyNode(RadixTreeNode* node, int height);
 
     /**
-     * @brief ڵǷΪ
-     * @param node ҪĽڵ
-     * @return trueʾڵΪ
+     * @brief 检查节点是否为空
+     * @param node 要检查的节点
+     * @return true表示节点为空
      */
     bool _isNodeEmpty(RadixTreeNode* node) const
     {
@@ -168,9 +168,9 @@ private:
     }
 
     /**
-     * @brief ½ڵ
-     * @param shift ڵλ
-     * @return ·Ľڵָ
+     * @brief 分配新节点
+     * @param shift 节点的位移量
+     * @return 新分配的节点指针
      */
     RadixTreeNode* _allocNode(int shift)
     {
@@ -185,8 +185,8 @@ private:
     }
 
     /**
-     * @brief ͷŽڵ
-     * @param node ҪͷŵĽڵ
+     * @brief 释放节点
+     * @param node 要释放的节点
      */
     void _freeNode(RadixTreeNode* node)
     {
@@ -194,14 +194,14 @@ private:
     }
 };
 
-// ================================ ģʵ ================================
+// ================================ 模板实现 ================================
 
 template<typename T>
 bool RadixTree<T>::insert(PAGE_ID key, T* value)
 {
     if (!value) return false;
 
-    // ΪջҪչ߶
+    // 如果树为空或需要扩展高度
     if (!_root || key >= (1ULL << _getShift(_height + 1))) {
         _height = _extendTree(key);
     }
@@ -209,12 +209,12 @@ bool RadixTree<T>::insert(PAGE_ID key, T* value)
     RadixTreeNode* node = _root;
     int shift = _getShift(_height);
 
-    // Ӹڵ±Ҷӽڵ
+    // 从根节点向下遍历到叶子节点
     for (int level = _height; level > 0; level--) {
         unsigned int index = _getIndex(key, level, shift);
         
         if (!node->slots[index]) {
-            // µмڵ
+            // 创建新的中间节点
             RadixTreeNode* newNode = _allocNode(shift - RADIX_TREE_MAP_SHIFT);
             node->slots[index] = newNode;
             node->tags |= (1UL << index);
@@ -225,7 +225,7 @@ bool RadixTree<T>::insert(PAGE_ID key, T* value)
         shift -= RADIX_TREE_MAP_SHIFT;
     }
 
-    // Ҷӽڵֵ
+    // 在叶子节点插入值
     unsigned int index = _getIndex(key, 0, 0);
     if (!node->slots[index]) {
         node->count++;
@@ -248,18 +248,18 @@ T* RadixTree<T>::lookup(PAGE_ID key) const
     RadixTreeNode* node = _root;
     int shift = _getShift(_height);
 
-    // ŻĲ·ٷ֧Ԥʧ
+    // 优化的查找路径：减少分支预测失败
     for (int level = _height; level > 0; level--) {
         unsigned int index = _getIndex(key, level, shift);
         unsigned long mask = 1UL << index;
         
-        // ʹλټ飬ٷ֧
+        // 使用位运算快速检查，减少分支
         if (!(node->tags & mask)) {
-            return nullptr;  // ·
+            return nullptr;  // 路径不存在
         }
         
         node = static_cast<RadixTreeNode*>(node->slots[index]);
-        // Ԥȡһڵ㣬߻
+        // 预取下一级节点，提高缓存命中率
         if (level > 1 && node) {
             __builtin_prefetch(node, 0, 3);
         }
@@ -267,11 +267,11 @@ T* RadixTree<T>::lookup(PAGE_ID key) const
         shift -= RADIX_TREE_MAP_SHIFT;
     }
 
-    // Ҷӽڵֵ
+    // 在叶子节点查找值
     unsigned int index = _getIndex(key, 0, 0);
     unsigned long mask = 1UL << index;
     
-    // ʹƶٷ֧
+    // 使用条件移动减少分支
     return (node->tags & mask) ? static_cast<T*>(node->slots[index]) : nullptr;
 }
 
@@ -282,7 +282,7 @@ T* RadixTree<T>::remove(PAGE_ID key)
         return nullptr;
     }
 
-    // ¼·Ասڵ
+    // 记录路径以便回溯清理空节点
     RadixTreeNode* path[RADIX_TREE_MAX_PATH];
     unsigned int indices[RADIX_TREE_MAX_PATH];
     int pathLen = 0;
@@ -290,12 +290,12 @@ T* RadixTree<T>::remove(PAGE_ID key)
     RadixTreeNode* node = _root;
     int shift = _getShift(_height);
 
-    // ¼·
+    // 记录查找路径
     for (int level = _height; level > 0; level--) {
         unsigned int index = _getIndex(key, level, shift);
         
         if (!(node->tags & (1UL << index))) {
-            return nullptr;  // ·
+            return nullptr;  // 路径不存在
         }
         
         path[pathLen] = node;
@@ -308,10 +308,10 @@ T* RadixTree<T>::remove(PAGE_ID key)
         shift -= RADIX_TREE_MAP_SHIFT;
     }
 
-    // Ҷӽڵɾֵ
+    // 在叶子节点删除值
     unsigned int index = _getIndex(key, 0, 0);
     if (!(node->tags & (1UL << index))) {
-        return nullptr;  // ֵ
+        return nullptr;  // 值不存在
     }
 
     T* value = static_cast<T*>(node->slots[index]);
@@ -320,7 +320,7 @@ T* RadixTree<T>::remove(PAGE_ID key)
     node->count--;
     _count--;
 
-    // սڵ
+    // 回溯清理空节点
     if (_isNodeEmpty(node) && pathLen > 0) {
         _freeNode(node);
         
@@ -333,7 +333,7 @@ T* RadixTree<T>::remove(PAGE_ID key)
             parent->count--;
             
             if (!_isNodeEmpty(parent) || i == 0) {
-                break;  // ڵ㲻Ϊջѵڵ
+                break;  // 父节点不为空或已到根节点
             }
             
             _freeNode(parent);
@@ -348,13 +348,13 @@ int RadixTree<T>::_extendTree(PAGE_ID key)
 {
     int newHeight = 0;
     
-    // ҪС߶
+    // 计算需要的最小高度
     PAGE_ID maxKey = key;
     while (maxKey >= (1ULL << _getShift(newHeight + 1))) {
         newHeight++;
     }
 
-    // ҪӸ߶
+    // 如果需要增加高度
     while (_height < newHeight) {
         RadixTreeNode* newRoot = _allocNode(_getShift(_height + 1));
         
@@ -368,7 +368,7 @@ int RadixTree<T>::_extendTree(PAGE_ID key)
         _height++;
     }
 
-    // Ϊգڵ
+    // 如果树为空，创建根节点
     if (!_root) {
         _root = _allocNode(_getShift(newHeight));
         _height = newHeight;
@@ -383,7 +383,7 @@ void RadixTree<T>::_destroyNode(RadixTreeNode* node, int height)
     if (!node) return;
 
     if (height > 0) {
-        // ݹӽڵ
+        // 递归销毁子节点
         for (int i = 0; i < RADIX_TREE_MAP_SIZE; i++) {
             if (node->tags & (1UL << i)) {
                 _destroyNode(static_cast<RadixTreeNode*>(node->slots[i]), height - 1);
@@ -405,5 +405,5 @@ void RadixTree<T>::clear()
     }
 }
 
-// ΪSpanػĻͶ
+// 为Span特化的基数树类型定义
 using SpanRadixTree = RadixTree<Span>;
\ No newline at end of file
@@ -0,0 +1,223 @@
+#pragma once
+
+/**
+ * @file SpanTree.h
+ * @brief 空闲超大Span的最佳适配树定义
+ * @details 超过128页的空闲Span按（页数，起始页号）排序存放在一棵侵入式Treap中，
+ *          申请时取不小于k页的最小Span（同样大小取低地址），切分后剩余部分放回，
+ *          释放时与相邻空闲页合并不再受128页上限约束
+ */
+
+#include "Common.h"
+
+/**
+ * @class SpanTree
+ * @brief 按（页数，起始页号）排序的侵入式Treap
+ * @details 树中的Span不在任何SpanList中，借用_prev/_next作为左右孩子，不额外分配节点；
+ *          优先级由起始页号哈希得到，Span在树中时不得修改_pageId和_n。
+ *          本类不加锁，由PageCache的全局锁保护
+ */
+class SpanTree
+{
+public:
+    /**
+     * @brief 插入一个空闲Span
+     * @param span 要插入的Span
+     */
+    void Insert(Span *span)
+    {
+        Left(span) = nullptr;
+        Right(span) = nullptr;
+        _root = InsertAt(_root, span);
+        _bytes += span->_n << PAGE_SHIFT;
+        ++_count;
+    }
+
+    /**
+     * @brief 从树中摘除一个Span
+     * @param span 要摘除的Span，必须在树中
+     */
+    void Erase(Span *span)
+    {
+        _root = EraseAt(_root, span);
+        Left(span) = nullptr;
+        Right(span) = nullptr;
+        _bytes -= span->_n << PAGE_SHIFT;
+        --_count;
+    }
+
+    /**
+     * @brief 最佳适配：查找不小于k页的最小Span，同样大小取地址最低的
+     * @param k 需要的页数
+     * @return 找到的Span（仍在树中），没有返回nullptr
+     */
+    Span *BestFit(size_t k) const
+    {
+        Span *best = nullptr;
+        Span *node = _root;
+        while (node)
+        {
+            if (node->_n >= k)
+            {
+                best = node;
+                node = Left(node);
+            }
+            else
+            {
+                node = Right(node);
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief 查找挂入时间最早的Span
+     * @return 找到的Span（仍在树中），树为空返回nullptr
+     * @details 遍历整棵树；树中的Span受字节上限约束，个数不多
+     */
+    Span *Oldest() const
+    {
+        return OldestAt(_root);
+    }
+
+    /**
+     * @brief 获取树中空闲Span的总字节数
+     * @return 字节数
+     */
+    size_t Bytes() const
+    {
+        return _bytes;
+    }
+
+    /**
+     * @brief 获取树中Span的个数
+     * @return Span个数
+     */
+    size_t Count() const
+    {
+        return _count;
+    }
+
+private:
+    static Span *&Left(Span *span)
+    {
+        return span->_prev;
+    }
+
+    static Span *&Right(Span *span)
+    {
+        return span->_next;
+    }
+
+    static Span *Left(const Span *span)
+    {
+        return span->_prev;
+    }
+
+    static Span *Right(const Span *span)
+    {
+        return span->_next;
+    }
+
+    /**
+     * @brief 排序关系：先比页数，再比起始页号
+     */
+    static bool Less(const Span *a, const Span *b)
+    {
+        return a->_n < b->_n || (a->_n == b->_n && a->_pageId < b->_pageId);
+    }
+
+    /**
+     * @brief 由起始页号哈希得到的堆优先级
+     */
+    static uint32_t Priority(const Span *span)
+    {
+        return (uint32_t)(((uint64_t)span->_pageId * 0x9E3779B97F4A7C15ULL) >> 32);
+    }
+
+    /**
+     * @brief 把以node为根的子树按key拆成小于key和不小于key的两部分
+     */
+    static void Split(Span *node, const Span *key, Span *&less, Span *&greater)
+    {
+        if (!node)
+        {
+            less = greater = nullptr;
+        }
+        else if (Less(node, key))
+        {
+            Split(Right(node), key, Right(node), greater);
+            less = node;
+        }
+        else
+        {
+            Split(Left(node), key, less, Left(node));
+            greater = node;
+        }
+    }
+
+    /**
+     * @brief 合并两棵子树，要求a中所有节点都小于b中所有节点
+     */
+    static Span *Merge(Span *a, Span *b)
+    {
+        if (!a)
+            return b;
+        if (!b)
+            return a;
+        if (Priority(a) > Priority(b))
+        {
+            Right(a) = Merge(Right(a), b);
+            return a;
+        }
+        Left(b) = Merge(a, Left(b));
+        return b;
+    }
+
+    static Span *InsertAt(Span *node, Span *span)
+    {
+        if (!node)
+            return span;
+        if (Priority(span) > Priority(node))
+        {
+            Split(node, span, Left(span), Right(span));
+            return span;
+        }
+        if (Less(span, node))
+            Left(node) = InsertAt(Left(node), span);
+        else
+            Right(node) = InsertAt(Right(node), span);
+        return node;
+    }
+
+    static Span *OldestAt(Span *node)
+    {
+        if (!node)
+            return nullptr;
+        Span *oldest = node;
+        Span *left = OldestAt(Left(node));
+        Span *right = OldestAt(Right(node));
+        if (left && left->_freeTime < oldest->_freeTime)
+            oldest = left;
+        if (right && right->_freeTime < oldest->_freeTime)
+            oldest = right;
+        return oldest;
+    }
+
+    static Span *EraseAt(Span *node, Span *span)
+    {
+        assert(node); // span必须在树中
+        if (node == span)
+            return Merge(Left(node), Right(node));
+        if (Less(span, node))
+            Left(node) = EraseAt(Left(node), span);
+        else
+            Right(node) = EraseAt(Right(node), span);
+        return node;
+    }
+
+private:
+    Span *_root = nullptr;     // 树根
+    size_t _bytes = 0;         // 树中空闲Span总字节数
+    size_t _count = 0;         // 树中Span个数
+};
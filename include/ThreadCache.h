@@ -1,59 +1,271 @@
-#pragma once
-
-/**
- * @file ThreadCache.h
- * @brief ̻߳ඨ
- * @details ÿ߳˽еڴ滺棬ṩĿڴͷ
- */
-
-#include "Common.h"
-
-/**
- * @class ThreadCache
- * @brief ̱߳ڴ滺
- * @details ÿ߳ӵһThreadCacheʵͨϣͰͬСڴ
- *          ʵ̱߳صĿڴ䣬
- */
-class ThreadCache
-{
-public:
-	/**
-	 * @brief ָ̻߳Сڴ
-	 * @param size ҪڴС
-	 * @return ڴָ
-	 */
-	void *Allocate(size_t size);
-
-	/**
-	 * @brief 黹ڴ浽̻߳
-	 * @param ptr Ҫ黹ڴָ
-	 * @param size ڴС
-	 */
-	void Deallocate(void *ptr, size_t size);
-
-	/**
-	 * @brief 뻺ȡڴ
-	 * @param index Ͱ
-	 * @param size С
-	 * @return ȡڴָ
-	 */
-	void *FetchFromCentralCache(size_t index, size_t size);
-
-	/**
-	 * @brief 
-	 * @param list 
-	 * @param size С
-	 */
-	void ListTooLong(FreeList &list, size_t size);
-
-private:
-	FreeList _freeList[MAX_BUCKETSIZE]; // ϣͰ飬ÿͰһִСڴ
-};
-
-// ================================ ̱߳ش洢 ================================
-
-/**
- * @brief ̱߳ش洢ThreadCacheָ
- * @details ʹC++11thread_localؼ֣ÿ߳ӵжThreadCacheʵ
- */
+#pragma once
+
+/**
+ * @file ThreadCache.h
+ * @brief 线程缓存类定义
+ * @details 每个线程私有的内存缓存，提供无锁的快速内存分配和释放。
+ *          定义HCMP_MAGAZINE编译时，每个桶改用指针数组（magazine）缓存对象，
+ *          申请、释放和整批交给CentralCache都不读写对象内存；未定义时使用对象内嵌的自由链表
+ */
+
+#include "Common.h"
+
+static const size_t PAGE_SIZE_CACHE = 64;        // 每线程页号到对象大小缓存的槽位数，须为2的幂
+static const size_t PAGE_SIZE_BITS = 20;         // 缓存项中对象大小占用的低位数
+
+/**
+ * @class ThreadCache
+ * @brief 线程本地内存缓存类
+ * @details 每个线程拥有一个ThreadCache实例，通过哈希桶管理不同大小的内存块
+ *          实现线程本地的快速内存分配，避免锁竞争。
+ *          各桶的状态按访问频率分开存放：快路径只读写链表头和剩余容量，两者各自是一个连续数组，
+ *          相邻的桶共用缓存行；慢启动上限等只在与CentralCache交互时才访问的字段放在单独的冷区。
+ *          对象按缓存行对齐，热区不会与其他对象共享缓存行
+ */
+class alignas(64) ThreadCache
+{
+public:
+	ThreadCache()
+	{
+		for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+		{
+#ifdef HCMP_MAGAZINE
+			_mags[i] = &_firstSlot[i];
+			_lengths[i] = 0;
+			_capacity[i] = 1;
+#else
+			_heads[i] = nullptr;
+#endif
+			_room[i] = 1;
+			_maxSize[i] = 1;
+		}
+	}
+
+	/**
+	 * @brief 从线程缓存分配指定大小的内存
+	 * @param size 需要分配的内存大小
+	 * @return 分配的内存指针
+	 */
+	void *Allocate(size_t size);
+
+	/**
+	 * @brief 归还内存到线程缓存
+	 * @param ptr 要归还的内存指针
+	 * @param size 内存块大小
+	 */
+	void Deallocate(void *ptr, size_t size);
+
+	/**
+	 * @brief 从中央缓存获取内存对象
+	 * @param index 桶索引
+	 * @param size 对象大小
+	 * @return 获取到的内存指针
+	 */
+	void *FetchFromCentralCache(size_t index, size_t size);
+
+	/**
+	 * @brief 从中央缓存获取内存对象，批量上限由调用方给出
+	 * @param index 桶索引
+	 * @param size 对象大小
+	 * @param numMove 一次最多获取的对象数量，即NumMoveSize(size)
+	 * @return 获取到的内存指针
+	 */
+	void *FetchFromCentralCache(size_t index, size_t size, size_t numMove);
+
+	/**
+	 * @brief 按编译期确定的桶分配
+	 * @param index 对齐后大小的桶索引
+	 * @param alignSize 对齐后的大小
+	 * @return 分配的内存指针
+	 * @details 定义在头文件中，供ConcurrencyAllocFixed内联；与Deallocate使用同一个桶。
+	 *          批量上限可在运行时调整，慢路径按当前参数计算
+	 */
+	void *AllocateFixed(size_t index, size_t alignSize)
+	{
+		void *obj = PopLocal(index);
+		if (obj)
+			return obj;
+		return FetchFromCentralCache(index, alignSize);
+	}
+
+	/**
+	 * @brief 按编译期确定的桶释放
+	 * @param ptr 要归还的内存指针
+	 * @param index 对齐后大小的桶索引
+	 * @param alignSize 对齐后的大小
+	 */
+	void DeallocateFixed(void *ptr, size_t index, size_t alignSize)
+	{
+		if (PushLocal(index, ptr))
+			ListTooLong(index, alignSize);
+	}
+
+	/**
+	 * @brief 处理自由链表过长的情况
+	 * @param index 过长的自由链表所在的桶索引
+	 * @param size 对象大小
+	 */
+	void ListTooLong(size_t index, size_t size);
+
+	/**
+	 * @brief 桶中自由链表的当前长度
+	 * @param index 桶索引
+	 */
+	size_t ListLength(size_t index) const
+	{
+#ifdef HCMP_MAGAZINE
+		return _lengths[index];
+#else
+		return _maxSize[index] - _room[index];
+#endif
+	}
+
+	/**
+	 * @brief 桶的慢启动上限，链表长度达到该值时整批归还
+	 * @param index 桶索引
+	 */
+	size_t MaxSize(size_t index) const
+	{
+		return _maxSize[index];
+	}
+
+	/**
+	 * @brief 从本线程最近释放过的页中查找对象大小
+	 * @param id 对象所在的页号
+	 * @param epoch PageCache::ClassEpoch()
+	 * @return 对象的对齐大小，未命中或缓存项已过期时返回0
+	 */
+	size_t CachedObjectSize(PAGE_ID id, uint64_t epoch) const
+	{
+		const PageSizeEntry &e = _pageSizes[id & (PAGE_SIZE_CACHE - 1)];
+		if (e.page != id || (e.tag >> PAGE_SIZE_BITS) != epoch)
+			return 0;
+		return (size_t)(e.tag & (((uint64_t)1 << PAGE_SIZE_BITS) - 1));
+	}
+
+	/**
+	 * @brief 记录页号到对象大小的映射
+	 * @param id 对象所在的页号
+	 * @param epoch 读取映射前的PageCache::ClassEpoch()，纪元改变后该项失效
+	 * @param size 对象的对齐大小
+	 */
+	void CacheObjectSize(PAGE_ID id, uint64_t epoch, size_t size)
+	{
+		PageSizeEntry &e = _pageSizes[id & (PAGE_SIZE_CACHE - 1)];
+		e.page = id;
+		e.tag = (epoch << PAGE_SIZE_BITS) | size;
+	}
+
+	/**
+	 * @brief 开启或关闭本线程的延迟释放
+	 * @param enable 是否开启
+	 * @details 开启后，需要加锁归还的批次和大对象交给后台回收线程处理
+	 */
+	void SetDeferredFree(bool enable)
+	{
+		_deferFree = enable;
+	}
+
+	/**
+	 * @brief 本线程是否开启了延迟释放
+	 */
+	bool DeferredFreeEnabled() const
+	{
+		return _deferFree;
+	}
+
+private:
+	/**
+	 * @brief 从桶中取出一个对象
+	 * @param index 桶索引
+	 * @return 对象指针，桶为空时返回nullptr
+	 */
+	void *PopLocal(size_t index)
+	{
+#ifdef HCMP_MAGAZINE
+		uint32_t len = _lengths[index];
+		if (len == 0)
+			return nullptr;
+		HCMP_LATENCY_SAMPLED(LAT_TC_ALLOC);
+		_lengths[index] = --len;
+		++_room[index];
+		return _mags[index][len];
+#else
+		void *obj = _heads[index];
+		if (obj == nullptr)
+			return nullptr;
+		HCMP_LATENCY_SAMPLED(LAT_TC_ALLOC);
+		_heads[index] = NextObj(obj);
+		++_room[index];
+		return obj;
+#endif
+	}
+
+	/**
+	 * @brief 把一个对象放回桶中
+	 * @param index 桶索引
+	 * @param ptr 对象指针
+	 * @return 放回后桶中对象数达到慢启动上限时返回true，调用方应调用ListTooLong
+	 */
+	bool PushLocal(size_t index, void *ptr)
+	{
+		HCMP_LATENCY_SAMPLED(LAT_TC_FREE);
+#ifdef HCMP_MAGAZINE
+		uint32_t len = _lengths[index];
+		_mags[index][len] = ptr;
+		_lengths[index] = len + 1;
+#else
+		NextObj(ptr) = _heads[index];
+		_heads[index] = ptr;
+#endif
+		return --_room[index] == 0;
+	}
+
+#ifdef HCMP_MAGAZINE
+	/**
+	 * @brief 为桶分配能容纳capacity个指针的magazine
+	 * @details 桶为空时调用；magazine从本线程的内存块中顺序切出，随ThreadCache常驻
+	 */
+	void GrowMagazine(size_t index, size_t capacity);
+#endif
+
+private:
+	// 热区：每次申请、释放都会访问
+#ifdef HCMP_MAGAZINE
+	void **_mags[MAX_BUCKETSIZE];      // 每个桶的magazine，[0, _lengths)为缓存的对象
+	uint32_t _lengths[MAX_BUCKETSIZE]; // 每个桶缓存的对象数
+#else
+	void *_heads[MAX_BUCKETSIZE];    // 每个桶自由链表的头
+#endif
+	uint32_t _room[MAX_BUCKETSIZE];  // 每个桶还能放回的对象数，即慢启动上限减去链表长度，减到0时整批归还
+
+	/**
+	 * @struct PageSizeEntry
+	 * @brief 页号到对象大小的缓存项，页号0不会出现，全0即空项
+	 */
+	struct PageSizeEntry
+	{
+		PAGE_ID page;
+		uint64_t tag;   // 高位为纪元，低PAGE_SIZE_BITS位为对象大小
+	};
+	alignas(64) PageSizeEntry _pageSizes[PAGE_SIZE_CACHE] = {}; // 直接映射，释放时按页号查找
+
+	// 冷区：只在从CentralCache获取或向其归还一批对象时访问
+	alignas(64) uint32_t _maxSize[MAX_BUCKETSIZE]; // 每个桶的慢启动上限
+	size_t _grownBytes = 0;                        // 各桶慢启动上限累计增长的字节数，受thread_cache_bytes约束
+	bool _deferFree = false;                       // 是否把需要加锁的归还交给回收线程
+#ifdef HCMP_MAGAZINE
+	uint32_t _capacity[MAX_BUCKETSIZE];  // 每个桶magazine的容量
+	void *_firstSlot[MAX_BUCKETSIZE];    // 第一次从CentralCache获取之前使用的单个槽位
+	char *_magMemory = nullptr;          // 当前切分magazine的内存块
+	size_t _magLeft = 0;                 // 内存块剩余字节数
+#endif
+};
+
+// ================================ 线程本地存储 ================================
+
+/**
+ * @brief 线程本地存储的ThreadCache指针
+ * @details 使用C++11的thread_local关键字，每个线程拥有独立的ThreadCache实例
+ */
 thread_local static ThreadCache *pTLSThreadCache = nullptr;
\ No newline at end of file
@@ -0,0 +1,289 @@
+#pragma once
+
+/**
+ * @file TransferCache.h
+ * @brief CentralCache前端的无锁批次缓存
+ * @details ThreadCache与CentralCache之间交换的是整批对象。每个尺寸类维护两个
+ *          Treiber栈：一个存放完整的批次，一个存放空闲的批次描述节点。ListTooLong
+ *          归还的批次直接压栈，FetchRangeObj优先弹出整批，两者都不需要桶锁；
+ *          栈满或栈空时才退回到桶锁保护的Span路径
+ */
+
+#include "Common.h"
+#include <atomic>
+
+static const size_t TRANSFER_MAX_BATCHES = 64;                // 每个尺寸类最多缓存的批次数
+static const size_t TRANSFER_MAX_BYTES = 1024 * 1024;         // 每个尺寸类缓存批次的默认字节上限
+
+/**
+ * @struct TransferBatch
+ * @brief 批次描述节点，节点常驻于所属尺寸类，不会被释放
+ */
+struct TransferBatch
+{
+    void *start = nullptr;                 // 批次第一个对象
+    void *end = nullptr;                   // 批次最后一个对象，NextObj(end)为空
+    size_t count = 0;                      // 批次中的对象数
+    std::atomic<uint32_t> next{0};         // 栈中下一个节点的下标+1，0表示栈底
+};
+
+/**
+ * @class BatchStack
+ * @brief 以节点下标为元素的Treiber栈
+ * @details 栈顶是64位字：高32位为版本号，低32位为节点下标+1。每次修改版本号加一，
+ *          节点被弹出又压回时CAS也会失败，避免ABA问题；节点常驻，读取已被弹出
+ *          节点的next是安全的，只会导致CAS失败重试
+ */
+class BatchStack
+{
+public:
+    /**
+     * @brief 压入节点
+     * @param nodes 节点数组
+     * @param idx 节点下标
+     */
+    void Push(TransferBatch *nodes, uint32_t idx)
+    {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        uint64_t newHead;
+        do
+        {
+            nodes[idx].next.store((uint32_t)head, std::memory_order_relaxed);
+            newHead = (((head >> 32) + 1) << 32) | (idx + 1);
+        } while (!_head.compare_exchange_weak(head, newHead, std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief 弹出节点
+     * @param nodes 节点数组
+     * @return 节点下标+1，栈空时返回0
+     */
+    uint32_t Pop(TransferBatch *nodes)
+    {
+        uint64_t head = _head.load(std::memory_order_acquire);
+        for (;;)
+        {
+            uint32_t top = (uint32_t)head;
+            if (top == 0)
+                return 0;
+            uint32_t next = nodes[top - 1].next.load(std::memory_order_relaxed);
+            uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+            if (_head.compare_exchange_weak(head, newHead, std::memory_order_acquire,
+                                            std::memory_order_acquire))
+                return top;
+        }
+    }
+
+private:
+    std::atomic<uint64_t> _head{0};
+};
+
+/**
+ * @class TransferCache
+ * @brief 按尺寸类组织的无锁批次缓存
+ * @details 每个尺寸类的批次节点在构造时全部压入空闲栈，可缓存的批次数由capacity在压入时约束，
+ *          运行中可以调整；每次压入、弹出都记下当前清理轮次，供CentralCache清理时找出空闲的尺寸类
+ */
+class TransferCache
+{
+public:
+    TransferCache()
+    {
+        TuneInit();
+        for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+        {
+            TransferClass &tc = _classes[i];
+            for (size_t k = 0; k < TRANSFER_MAX_BATCHES; k++)
+                tc.free.Push(tc.nodes, (uint32_t)k);
+        }
+        SetBytes(TuneGet(TUNE_TRANSFER_CACHE_BYTES));
+    }
+
+    /**
+     * @brief 按字节上限（运行参数transfer_cache_bytes）重新折算每个尺寸类可缓存的批次数
+     * @param maxBytes 每个尺寸类缓存批次的字节上限
+     * @details 大对象也至少缓存两批，0表示不缓存；已缓存的批次超过新上限时由调用方弹出
+     */
+    void SetBytes(size_t maxBytes)
+    {
+        for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+        {
+            size_t size = SizeClass::ClassSize(i);
+            size_t batches = maxBytes / (SizeClass::NumMoveSize(size) * size);
+            SetCapacity(i, maxBytes == 0 ? 0 : std::max(batches, (size_t)2));
+        }
+    }
+
+    /**
+     * @brief 设置某个尺寸类可缓存的批次数
+     * @param index 桶索引
+     * @param batches 批次数，不超过TRANSFER_MAX_BATCHES
+     * @details 可与压入、弹出并发调用；调小后多出的批次留在栈中，直到被取走或由调用方弹出
+     */
+    void SetCapacity(size_t index, size_t batches)
+    {
+        if (batches > TRANSFER_MAX_BATCHES)
+            batches = TRANSFER_MAX_BATCHES;
+        _classes[index].capacity.store((uint32_t)batches, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取某个尺寸类可缓存的批次数
+     */
+    size_t Capacity(size_t index) const
+    {
+        return _classes[index].capacity.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取某个尺寸类已缓存的批次数，包括正在压入、弹出的批次
+     */
+    size_t Count(size_t index) const
+    {
+        return _classes[index].count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 缓存一批对象
+     * @param index 桶索引
+     * @param start 批次第一个对象
+     * @param end 批次最后一个对象
+     * @param n 对象数
+     * @return 缓存已满时返回false，调用方需自行归还这批对象
+     * @details 先占用一个批次额度再检查上限，并发压入时合计也不会超过capacity；
+     *          占用额度是seq_cst操作，与回收线程休眠前检查Empty相配合
+     */
+    bool Insert(size_t index, void *start, void *end, size_t n)
+    {
+        TransferClass &tc = _classes[index];
+        if (tc.count.fetch_add(1) >= tc.capacity.load(std::memory_order_relaxed))
+        {
+            tc.count.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint32_t slot = tc.free.Pop(tc.nodes);
+        if (slot == 0)
+        {
+            tc.count.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        TransferBatch &batch = tc.nodes[slot - 1];
+        NextObj(end) = nullptr;
+        batch.start = start;
+        batch.end = end;
+        batch.count = n;
+        tc.full.Push(tc.nodes, slot - 1);
+        Touch(tc);
+        return true;
+    }
+
+    /**
+     * @brief 取出一批对象
+     * @param index 桶索引
+     * @param start 返回批次第一个对象
+     * @param end 返回批次最后一个对象
+     * @return 对象数，缓存为空时返回0
+     */
+    size_t Remove(size_t index, void *&start, void *&end)
+    {
+        size_t n = Pop(_classes[index], start, end);
+        if (n > 0)
+            Touch(_classes[index]);
+        return n;
+    }
+
+    /**
+     * @brief 取出一批对象用于归还给Span，不算作该尺寸类被使用
+     * @param index 桶索引
+     * @param start 返回批次第一个对象
+     * @param end 返回批次最后一个对象
+     * @return 对象数，缓存为空时返回0
+     */
+    size_t Drain(size_t index, void *&start, void *&end)
+    {
+        return Pop(_classes[index], start, end);
+    }
+
+    /**
+     * @brief 进入下一轮清理
+     * @return 新的清理轮次
+     */
+    uint32_t Tick()
+    {
+        return _gen.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    /**
+     * @brief 某个尺寸类是否缓存着批次、且连续gens轮清理都没有被压入或弹出
+     * @param index 桶索引
+     * @param gen 当前清理轮次
+     * @param gens 空闲轮数
+     */
+    bool Idle(size_t index, uint32_t gen, uint32_t gens) const
+    {
+        const TransferClass &tc = _classes[index];
+        return tc.count.load(std::memory_order_relaxed) > 0 &&
+               gen - tc.lastUse.load(std::memory_order_relaxed) >= gens;
+    }
+
+    /**
+     * @brief 所有尺寸类都没有缓存批次时返回true，只读各尺寸类的计数
+     */
+    bool Empty() const
+    {
+        for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+        {
+            if (_classes[i].count.load() > 0)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    /**
+     * @struct TransferClass
+     * @brief 单个尺寸类的批次栈，独占缓存行避免伪共享
+     */
+    struct alignas(64) TransferClass
+    {
+        BatchStack full;                                // 存放完整批次的栈
+        BatchStack free;                                // 空闲节点栈
+        std::atomic<uint32_t> capacity{0};              // 可缓存的批次数
+        std::atomic<uint32_t> count{0};                 // 已占用的批次数，可能暂时超过capacity
+        std::atomic<uint32_t> lastUse{0};               // 最近一次压入或弹出时的清理轮次
+        TransferBatch nodes[TRANSFER_MAX_BATCHES];      // 本尺寸类的批次节点
+    };
+
+    /**
+     * @brief 弹出一批对象并归还节点
+     */
+    static size_t Pop(TransferClass &tc, void *&start, void *&end)
+    {
+        uint32_t slot = tc.full.Pop(tc.nodes);
+        if (slot == 0)
+            return 0;
+
+        TransferBatch &batch = tc.nodes[slot - 1];
+        start = batch.start;
+        end = batch.end;
+        size_t n = batch.count;
+        tc.free.Push(tc.nodes, slot - 1);
+        tc.count.fetch_sub(1, std::memory_order_relaxed);
+        return n;
+    }
+
+    /**
+     * @brief 记下尺寸类的使用轮次，轮次没变时只读不写
+     */
+    void Touch(TransferClass &tc)
+    {
+        uint32_t gen = _gen.load(std::memory_order_relaxed);
+        if (tc.lastUse.load(std::memory_order_relaxed) != gen)
+            tc.lastUse.store(gen, std::memory_order_relaxed);
+    }
+
+    TransferClass _classes[MAX_BUCKETSIZE];
+    std::atomic<uint32_t> _gen{0};                      // 清理轮次
+};
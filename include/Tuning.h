@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * @file Tuning.h
+ * @brief 运行参数
+ * @details 批量上下限、慢启动曲线、线程缓存预算以及各级缓存的保留上限原先都是编译期常量，
+ *          这里改为一张参数表：首次使用内存池时从HCMP_*环境变量读取（可带K/M/G后缀），
+ *          之后可经ConcurrencyControl按名称读取或修改。读取是一次relaxed原子读，只在慢路径上使用
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+
+/**
+ * @enum TuneParam
+ * @brief 参数编号
+ */
+enum TuneParam
+{
+    TUNE_BATCH_MIN,              // ThreadCache与CentralCache之间一批对象数的下限
+    TUNE_BATCH_MAX,              // 一批对象数的上限
+    TUNE_SLOW_START_INIT,        // 新建ThreadCache各桶慢启动上限的初始值
+    TUNE_SLOW_START_STEP,        // 每次整批获取后慢启动上限的增量
+    TUNE_THREAD_CACHE_BYTES,     // 每个ThreadCache慢启动上限增长的字节预算，0为不限
+    TUNE_LARGE_CACHE_BYTES,      // 空闲超大Span保留的字节上限，超出部分归还系统
+    TUNE_DEFERRED_FREE_BYTES,    // 延迟释放队列待回收字节数的上限
+    TUNE_TRANSFER_CACHE,         // 是否开启无锁批次缓存
+    TUNE_TRANSFER_CACHE_BYTES,   // 每个尺寸类批次缓存的字节上限
+    TUNE_EMPTY_SPAN_MAX,         // CentralCache每个尺寸类最多保留的空Span数，0为不保留
+    TUNE_EMPTY_SPAN_IDLE_MS,     // 尺寸类空闲多久后归还保留的空Span（毫秒）
+    TUNE_EMPTY_SPAN_BYTES,       // 所有尺寸类保留的空Span合计的字节上限，0为不保留
+    TUNE_CALLOC_DECOMMIT_BYTES,  // ConcurrencyCalloc拿到的旧页不少于该字节数时丢弃页内容代替清零
+    TUNE_COUNT
+};
+
+/**
+ * @struct TuneInfo
+ * @brief 参数的描述
+ */
+struct TuneInfo
+{
+    const char *name;      // ConcurrencyControl使用的名称
+    const char *env;       // 环境变量名
+    size_t def;            // 默认值
+    size_t min;            // 允许的最小值
+    size_t max;            // 允许的最大值
+    bool writable;         // 运行时能否修改，否则只能由环境变量设置
+    const char *desc;      // 说明
+};
+
+// 参数当前值，常量初始化为默认值
+extern std::atomic<size_t> gTuneValues[TUNE_COUNT];
+
+/**
+ * @brief 读取参数当前值
+ */
+inline size_t TuneGet(TuneParam param)
+{
+    return gTuneValues[param].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 从环境变量加载参数，只在第一次调用时生效
+ * @details 由各单例的构造函数和ThreadCache的构造函数调用；非法或超出范围的值被忽略并在stderr给出提示
+ */
+void TuneInit();
+
+/**
+ * @brief 获取参数描述
+ */
+const TuneInfo &TuneDescribe(TuneParam param);
+
+/**
+ * @brief 按名称查找参数
+ * @param name 参数名
+ * @return 参数编号，找不到时返回TUNE_COUNT
+ */
+TuneParam TuneFind(const char *name);
+
+/**
+ * @brief 检查并设置参数值，不负责让其生效
+ * @param param 参数编号
+ * @param value 新值
+ * @return 0成功；EPERM只读；EINVAL超出范围或批量下限大于上限
+ * @details 需要立即生效的参数由ConcurrencyControl在设置后通知对应的模块
+ */
+int TuneSet(TuneParam param, size_t value);
+
+/**
+ * @brief 打印所有参数的当前值、默认值和环境变量名
+ * @param os 输出流
+ */
+void TuneReport(std::ostream &os = std::cout);
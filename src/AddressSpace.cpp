@@ -0,0 +1,246 @@
+/**
+ * @file AddressSpace.cpp
+ * @brief 预留地址空间的实现
+ * @details 区域的一次性预留、顺序切分、按需提交/解除提交，以及已解除提交区间的合并与首次适配复用
+ */
+
+#include "Common.h"
+
+#ifdef HCMP_RESERVE
+
+#include <new>
+
+static const size_t RESERVE_MAX_EXTENTS = 1024;   // 可复用区间表的容量
+
+std::atomic<uintptr_t> gReserveBegin{0};
+std::atomic<uintptr_t> gReserveEnd{0};
+
+/**
+ * @struct ReserveExtent
+ * @brief 一段已解除提交的地址区间，单位为页
+ */
+struct ReserveExtent
+{
+    size_t offset;   // 相对区域起点的页偏移
+    size_t pages;    // 页数
+};
+
+// 区间表按偏移升序排列，相邻区间不连续；均为常量初始化，不受静态对象构造顺序影响
+static ReserveExtent gExtents[RESERVE_MAX_EXTENTS];
+static size_t gExtentCount = 0;
+static size_t gTopPages = 0;          // 顺序切分到的页偏移，其后的区域从未提交过
+static size_t gCommittedPages = 0;
+static size_t gDroppedPages = 0;
+
+static std::mutex &ReserveMutex()
+{
+    static std::mutex mtx;
+    return mtx;
+}
+
+static inline char *RegionBase()
+{
+    return (char *)gReserveBegin.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 提交一段区域内的页，使其可读写
+ */
+static void CommitPages(char *ptr, size_t kpage)
+{
+    size_t bytes = kpage << PAGE_SHIFT;
+#ifdef _WIN32
+    if (VirtualAlloc(ptr, bytes, MEM_COMMIT, PAGE_READWRITE) == nullptr)
+        throw std::bad_alloc();
+#else
+    if (mprotect(ptr, bytes, PROT_READ | PROT_WRITE) != 0)
+        throw std::bad_alloc();
+#endif
+}
+
+/**
+ * @brief 解除提交：归还物理内存并恢复为不可访问，地址仍保留在区域内
+ */
+static void DecommitPages(char *ptr, size_t kpage)
+{
+    size_t bytes = kpage << PAGE_SHIFT;
+#ifdef _WIN32
+    VirtualFree(ptr, bytes, MEM_DECOMMIT);
+#else
+    // 以MAP_FIXED覆盖原映射，原有的页被丢弃，且不会产生可被其他mmap占用的空洞
+    mmap(ptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+#endif
+}
+
+char *ReserveRegion()
+{
+    char *base = (char *)gReserveBegin.load(std::memory_order_acquire);
+    if (gReserveEnd.load(std::memory_order_acquire))
+        return base;
+
+    std::lock_guard<std::mutex> guard(ReserveMutex());
+    if (gReserveEnd.load(std::memory_order_relaxed))
+        return RegionBase();
+
+    size_t bytes = (size_t)HCMP_RESERVE_BYTES;
+    size_t pageSize = (size_t)1 << PAGE_SHIFT;
+#ifdef _WIN32
+    // VirtualAlloc按64K对齐，满足8K页对齐
+    void *raw = VirtualAlloc(NULL, bytes, MEM_RESERVE, PAGE_NOACCESS);
+    if (raw == nullptr)
+        throw std::bad_alloc();
+    base = (char *)raw;
+#else
+    // 与SystemAlloc相同，多预留一页后裁掉首尾保证按8K对齐
+    void *raw = mmap(NULL, bytes + pageSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED)
+        throw std::bad_alloc();
+    base = (char *)(((size_t)raw + pageSize - 1) & ~(pageSize - 1));
+    size_t head = base - (char *)raw;
+    if (head > 0)
+        munmap(raw, head);
+    if (pageSize - head > 0)
+        munmap(base + bytes, pageSize - head);
+#endif
+
+    gReserveBegin.store((uintptr_t)base, std::memory_order_relaxed);
+    gReserveEnd.store((uintptr_t)base + bytes, std::memory_order_release);
+    return base;
+}
+
+size_t ReserveRegionBytes()
+{
+    return (size_t)HCMP_RESERVE_BYTES;
+}
+
+void *ReserveAlloc(size_t kpage)
+{
+    char *base = ReserveRegion();
+    size_t offset = 0;
+    {
+        std::lock_guard<std::mutex> guard(ReserveMutex());
+        size_t i = 0;
+        while (i < gExtentCount && gExtents[i].pages < kpage)
+            i++;
+        if (i < gExtentCount)
+        {
+            // 首次适配：低地址优先，从区间头部切出
+            offset = gExtents[i].offset;
+            gExtents[i].offset += kpage;
+            gExtents[i].pages -= kpage;
+            if (gExtents[i].pages == 0)
+            {
+                for (size_t j = i + 1; j < gExtentCount; j++)
+                    gExtents[j - 1] = gExtents[j];
+                --gExtentCount;
+            }
+        }
+        else
+        {
+            if (kpage > (ReserveRegionBytes() >> PAGE_SHIFT) - gTopPages)
+                throw std::bad_alloc();
+            offset = gTopPages;
+            gTopPages += kpage;
+        }
+        gCommittedPages += kpage;
+    }
+
+    char *ptr = base + (offset << PAGE_SHIFT);
+    CommitPages(ptr, kpage);
+    return ptr;
+}
+
+void ReserveFree(void *ptr, size_t kpage)
+{
+    char *base = RegionBase();
+    assert(ReserveOwns(ptr) && ReserveOwns((char *)ptr + (kpage << PAGE_SHIFT) - 1));
+    DecommitPages((char *)ptr, kpage);
+
+    size_t offset = (size_t)((char *)ptr - base) >> PAGE_SHIFT;
+    std::lock_guard<std::mutex> guard(ReserveMutex());
+    gCommittedPages -= kpage;
+
+    // 找到第一个偏移大于offset的区间，尝试与前后合并
+    size_t i = 0;
+    while (i < gExtentCount && gExtents[i].offset < offset)
+        i++;
+    bool mergePrev = i > 0 && gExtents[i - 1].offset + gExtents[i - 1].pages == offset;
+    bool mergeNext = i < gExtentCount && offset + kpage == gExtents[i].offset;
+    if (mergePrev)
+    {
+        gExtents[i - 1].pages += kpage;
+        if (mergeNext)
+        {
+            gExtents[i - 1].pages += gExtents[i].pages;
+            for (size_t j = i + 1; j < gExtentCount; j++)
+                gExtents[j - 1] = gExtents[j];
+            --gExtentCount;
+        }
+        --i;
+    }
+    else if (mergeNext)
+    {
+        gExtents[i].offset = offset;
+        gExtents[i].pages += kpage;
+    }
+    else
+    {
+        if (gExtentCount == RESERVE_MAX_EXTENTS)
+        {
+            // 区间表已满：放弃最小的区间（包括本次释放的），其地址不再复用
+            size_t victim = 0;
+            for (size_t j = 1; j < gExtentCount; j++)
+            {
+                if (gExtents[j].pages < gExtents[victim].pages)
+                    victim = j;
+            }
+            if (gExtents[victim].pages >= kpage)
+            {
+                gDroppedPages += kpage;
+                return;
+            }
+            gDroppedPages += gExtents[victim].pages;
+            for (size_t j = victim + 1; j < gExtentCount; j++)
+                gExtents[j - 1] = gExtents[j];
+            --gExtentCount;
+            if (victim < i)
+                --i;
+        }
+        for (size_t j = gExtentCount; j > i; j--)
+            gExtents[j] = gExtents[j - 1];
+        gExtents[i].offset = offset;
+        gExtents[i].pages = kpage;
+        ++gExtentCount;
+    }
+
+    // 紧邻顺序切分位置的区间直接退回，尾部区域保持连续
+    if (gExtents[i].offset + gExtents[i].pages == gTopPages)
+    {
+        gTopPages = gExtents[i].offset;
+        assert(i == gExtentCount - 1);
+        --gExtentCount;
+    }
+}
+
+ReserveStats ReserveGetStats()
+{
+    ReserveStats stats;
+    if (!gReserveEnd.load(std::memory_order_acquire))
+        return stats;
+    std::lock_guard<std::mutex> guard(ReserveMutex());
+    stats.reservedBytes = ReserveRegionBytes();
+    stats.committedBytes = gCommittedPages << PAGE_SHIFT;
+    stats.topBytes = gTopPages << PAGE_SHIFT;
+    stats.freeExtents = gExtentCount;
+    stats.droppedBytes = gDroppedPages << PAGE_SHIFT;
+    return stats;
+}
+
+#else
+
+ReserveStats ReserveGetStats()
+{
+    return ReserveStats();
+}
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * @file AllocTrace.cpp
+ * @brief 申请/释放轨迹记录的实现
+ * @details 每线程记录块的分配与登记、按时间合并、指针到槽位号的转换和文件写出
+ */
+
+#include "Common.h"
+
+#ifdef HCMP_TRACE
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HCMP_TRACE_RDTSC
+#endif
+
+static const size_t TRACE_CHUNK_PAGES = 32;   // 每个记录块256KB
+
+/**
+ * @struct TraceRawRecord
+ * @brief 记录块中的原始记录，时间为计时单位数，指针在写出时才换成槽位号
+ */
+struct TraceRawRecord
+{
+    uint64_t time;
+    uint64_t ptr;
+    uint64_t size;
+    uint64_t op;
+};
+
+/**
+ * @struct TraceChunk
+ * @brief 一个线程的一块记录，创建时即登记到全局链表
+ * @details 只有所属线程写入；读取（计数、写出）要求业务线程静止
+ */
+struct TraceChunk
+{
+    TraceChunk *next;
+    uint32_t thread;
+    uint32_t count;
+    TraceRawRecord records[1];
+};
+
+static const size_t TRACE_CHUNK_RECORDS =
+    ((TRACE_CHUNK_PAGES << PAGE_SHIFT) - offsetof(TraceChunk, records)) / sizeof(TraceRawRecord);
+
+std::atomic<bool> gTraceEnabled{false};
+
+// 全局块链表与会话信息，均为常量初始化，不受静态对象构造顺序影响
+static TraceChunk *gChunks = nullptr;
+static std::atomic<uint32_t> gSession{0};   // 每次AllocTraceStart加一，使各线程旧的块失效
+static uint32_t gThreadCount = 0;           // 本次会话中已记录过的线程数
+static int64_t gStartNs = 0;                // 开始与停止时的时钟，写出时据此把计时单位换算为纳秒
+static uint64_t gStartTicks = 0;
+static int64_t gStopNs = 0;
+static uint64_t gStopTicks = 0;
+
+static thread_local TraceChunk *tlsChunk = nullptr;
+static thread_local uint32_t tlsSession = 0;
+static thread_local uint32_t tlsThread = 0;
+
+static std::mutex &TraceMutex()
+{
+    static std::mutex mtx;
+    return mtx;
+}
+
+static inline int64_t TraceNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 读取计时器：x86上为TSC周期数（比steady_clock快一个数量级），其他平台为纳秒
+ */
+static inline uint64_t TraceTicks()
+{
+#ifdef HCMP_TRACE_RDTSC
+    return __rdtsc();
+#else
+    return (uint64_t)TraceNowNs();
+#endif
+}
+
+/**
+ * @brief 为当前线程登记一个新的记录块
+ * @details 本次会话第一次记录时分配线程号，块写满时沿用线程号
+ */
+static TraceChunk *NewChunk()
+{
+    TraceChunk *chunk = (TraceChunk *)SystemAlloc(TRACE_CHUNK_PAGES);
+    chunk->count = 0;
+    std::lock_guard<std::mutex> guard(TraceMutex());
+    uint32_t session = gSession.load(std::memory_order_relaxed);
+    if (tlsSession != session || tlsChunk == nullptr)
+    {
+        tlsSession = session;
+        tlsThread = gThreadCount++;
+    }
+    chunk->thread = tlsThread;
+    chunk->next = gChunks;
+    gChunks = chunk;
+    tlsChunk = chunk;
+    return chunk;
+}
+
+void AllocTraceRecord(TraceOp op, const void *ptr, size_t size)
+{
+    uint64_t now = TraceTicks();
+    TraceChunk *chunk = tlsChunk;
+    bool stale = tlsSession != gSession.load(std::memory_order_relaxed);
+    if (chunk == nullptr || stale || chunk->count == TRACE_CHUNK_RECORDS)
+    {
+        if (stale)
+            tlsChunk = nullptr;   // 上一次会话的块已被释放
+        chunk = NewChunk();
+    }
+    TraceRawRecord &r = chunk->records[chunk->count];
+    r.time = now;
+    r.ptr = (uint64_t)(uintptr_t)ptr;
+    r.size = size;
+    r.op = op;
+    ++chunk->count;
+}
+
+void AllocTraceStart()
+{
+    gTraceEnabled.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> guard(TraceMutex());
+        while (gChunks)
+        {
+            TraceChunk *next = gChunks->next;
+            SystemFree(gChunks, TRACE_CHUNK_PAGES);
+            gChunks = next;
+        }
+        gSession.fetch_add(1, std::memory_order_relaxed);
+        gThreadCount = 0;
+        gStartNs = TraceNowNs();
+        gStartTicks = TraceTicks();
+        gStopNs = 0;
+    }
+    gTraceEnabled.store(true, std::memory_order_release);
+}
+
+void AllocTraceStop()
+{
+    gTraceEnabled.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> guard(TraceMutex());
+    gStopNs = TraceNowNs();
+    gStopTicks = TraceTicks();
+}
+
+size_t AllocTraceCount()
+{
+    std::lock_guard<std::mutex> guard(TraceMutex());
+    size_t count = 0;
+    for (TraceChunk *c = gChunks; c; c = c->next)
+        count += c->count;
+    return count;
+}
+
+bool AllocTraceDump(const char *path)
+{
+    std::lock_guard<std::mutex> guard(TraceMutex());
+
+    // 用开始到停止（未停止时为现在）的时长校准计时单位
+    int64_t endNs = gStopNs ? gStopNs : TraceNowNs();
+    uint64_t endTicks = gStopNs ? gStopTicks : TraceTicks();
+    double nsPerTick = endTicks > gStartTicks ? (double)(endNs - gStartNs) / (double)(endTicks - gStartTicks) : 1.0;
+
+    // 各线程的记录本身按时间有序；链表中新块在前，反向收集后稳定排序，同一时间按线程号、线程内顺序排列
+    struct Ref
+    {
+        uint64_t time;
+        uint32_t thread;
+        const TraceRawRecord *rec;
+    };
+    std::vector<TraceChunk *> chunks;
+    for (TraceChunk *c = gChunks; c; c = c->next)
+        chunks.push_back(c);
+    std::vector<Ref> refs;
+    for (auto it = chunks.rbegin(); it != chunks.rend(); ++it)
+    {
+        for (uint32_t i = 0; i < (*it)->count; i++)
+            refs.push_back(Ref{(*it)->records[i].time, (*it)->thread, &(*it)->records[i]});
+    }
+    std::stable_sort(refs.begin(), refs.end(), [](const Ref &a, const Ref &b) {
+        return a.time != b.time ? a.time < b.time : a.thread < b.thread;
+    });
+
+    // 指针换成槽位号：申请时取最小的空闲槽位，释放时归还
+    struct Live
+    {
+        uint32_t slot;
+        uint64_t size;
+    };
+    std::unordered_map<uint64_t, Live> live;
+    std::vector<uint32_t> freeSlots;
+    uint32_t slots = 0;
+    std::vector<TraceRecord> out;
+    out.reserve(refs.size());
+    for (const Ref &ref : refs)
+    {
+        TraceRecord r;
+        memset(&r, 0, sizeof(r));
+        r.time = ref.time > gStartTicks ? (uint64_t)((double)(ref.time - gStartTicks) * nsPerTick) : 0;
+        r.thread = (uint16_t)ref.thread;
+        r.op = (uint8_t)ref.rec->op;
+        if (ref.rec->op == TRACE_ALLOC)
+        {
+            uint32_t slot;
+            if (freeSlots.empty())
+            {
+                slot = slots++;
+            }
+            else
+            {
+                std::pop_heap(freeSlots.begin(), freeSlots.end(), std::greater<uint32_t>());
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            live[ref.rec->ptr] = Live{slot, ref.rec->size};
+            r.slot = slot;
+            r.size = ref.rec->size;
+        }
+        else
+        {
+            auto it = live.find(ref.rec->ptr);
+            if (it == live.end())
+                continue;   // 开始记录前申请的对象
+            r.slot = it->second.slot;
+            r.size = it->second.size;
+            freeSlots.push_back(it->second.slot);
+            std::push_heap(freeSlots.begin(), freeSlots.end(), std::greater<uint32_t>());
+            live.erase(it);
+        }
+        out.push_back(r);
+    }
+
+    TraceFileHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.threads = gThreadCount;
+    header.records = out.size();
+    header.slots = slots;
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == nullptr)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (ok && !out.empty())
+        ok = fwrite(out.data(), sizeof(TraceRecord), out.size(), fp) == out.size();
+    ok = fclose(fp) == 0 && ok;
+    return ok;
+}
+
+#else
+
+void AllocTraceStart()
+{
+}
+
+void AllocTraceStop()
+{
+}
+
+size_t AllocTraceCount()
+{
+    return 0;
+}
+
+bool AllocTraceDump(const char *path)
+{
+    (void)path;
+    return false;
+}
+
+#endif
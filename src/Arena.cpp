@@ -0,0 +1,141 @@
+/**
+ * @file Arena.cpp
+ * @brief Arena类的实现
+ * @details 实现作用域内存区的指针递增分配和整体释放
+ */
+
+#include "Arena.h"
+#include "PageCache.h"
+
+/**
+ * @brief 从Arena中分配内存
+ * @param size 需要分配的字节数
+ * @param align 对齐数
+ * @return 分配的内存指针
+ * @details 分配策略：
+ *          1. 当前Span剩余空间足够时，直接移动指针
+ *          2. 超过标准Span大小的请求，单独申请一个专用Span，不影响当前Span
+ *          3. 否则优先复用Reset时保留的Span，没有再向PageCache申请
+ */
+void *Arena::Allocate(size_t size, size_t align)
+{
+    assert(size > 0);
+    assert(align > 0 && (align & (align - 1)) == 0);
+    assert(align <= ((size_t)1 << PAGE_SHIFT));
+
+    char *ptr = (char *)SizeClass::_RoundUp((size_t)_ptr, align);
+    if (_ptr && ptr + size <= _end)
+    {
+        _ptr = ptr + size;
+        _bytesAllocated += size;
+        return ptr;
+    }
+
+    size_t kpage = SizeClass::_RoundUp(size, (size_t)1 << PAGE_SHIFT) >> PAGE_SHIFT;
+    if (kpage > ARENA_SPAN_PAGES)
+    {
+        // 大请求使用专用Span，Span起始地址按页对齐，天然满足对齐要求
+        Span *span = AcquireSpan(kpage);
+        span->_next = _spans;
+        _spans = span;
+        _bytesAllocated += size;
+        return (void *)(span->_pageId << PAGE_SHIFT);
+    }
+
+    Span *span = nullptr;
+    if (_freeSpans)
+    {
+        span = _freeSpans;
+        _freeSpans = _freeSpans->_next;
+    }
+    else
+    {
+        span = AcquireSpan(ARENA_SPAN_PAGES);
+    }
+    span->_next = _spans;
+    _spans = span;
+
+    ptr = (char *)(span->_pageId << PAGE_SHIFT);
+    _end = ptr + (span->_n << PAGE_SHIFT);
+    _ptr = ptr + size;
+    _bytesAllocated += size;
+    return ptr;
+}
+
+/**
+ * @brief 为Arena获取一个kpage页的Span
+ * @param kpage 需要的页数
+ * @return 新的Span指针
+ */
+Span *Arena::AcquireSpan(size_t kpage)
+{
+    HCMP_LOCK_SITE(LOCK_SITE_ARENA);
+    PageCache::GetInstance()->GetMutex().lock();
+    Span *span = PageCache::GetInstance()->NewSpan(kpage);
+    span->_isUse = true;    // 防止被PageCache合并
+    span->_isArena = true;  // ConcurrencyFree据此识别误释放
+    span->_objSize = 0;
+    span->_freeList = nullptr;
+    span->_useCount = 0;
+    PageCache::GetInstance()->GetMutex().unlock();
+
+    ++_spanCount;
+    return span;
+}
+
+/**
+ * @brief 归还Span到PageCache
+ * @param retainPages 保留的标准Span页数上限
+ * @details 标准大小的Span在阈值内保留复用，其余Span在一次加锁中全部归还，
+ *          归还时PageCache会照常进行相邻页合并
+ */
+void Arena::Release(size_t retainPages)
+{
+    Span *keep = nullptr;
+    Span *release = nullptr;
+    size_t keepPages = 0;
+    size_t keepCount = 0;
+
+    Span *lists[2] = {_spans, _freeSpans};
+    for (Span *span : lists)
+    {
+        while (span)
+        {
+            Span *next = span->_next;
+            if (span->_n == ARENA_SPAN_PAGES && keepPages + span->_n <= retainPages)
+            {
+                span->_next = keep;
+                keep = span;
+                keepPages += span->_n;
+                ++keepCount;
+            }
+            else
+            {
+                span->_next = release;
+                release = span;
+            }
+            span = next;
+        }
+    }
+
+    if (release)
+    {
+        HCMP_LOCK_SITE(LOCK_SITE_ARENA);
+        PageCache::GetInstance()->GetMutex().lock();
+        while (release)
+        {
+            Span *next = release->_next;
+            release->_next = nullptr;
+            PageCache::GetInstance()->ReleaseSpanToPageCache(release);
+            release = next;
+        }
+        PageCache::GetInstance()->GetMutex().unlock();
+    }
+
+    _spans = nullptr;
+    _freeSpans = keep;
+    _ptr = nullptr;
+    _end = nullptr;
+    _spanCount = keepCount;
+    _bytesAllocated = 0;
+}
@@ -0,0 +1,303 @@
+/**
+ * @file CarveKernel.cpp
+ * @brief 对象切分内核的实现
+ * @details 切分与清零各有标量、SSE2、AVX2三种实现，首次调用时按CPU支持情况选定
+ */
+
+#include "CarveKernel.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HCMP_CARVE_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief 标量实现：逐个对象写入链接
+ */
+void *CarveObjectsScalar(char *start, size_t size, size_t n)
+{
+    assert(n > 0);
+    char *obj = start;
+    for (size_t i = 1; i < n; i++)
+    {
+        NextObj(obj) = obj + size;
+        obj += size;
+    }
+    NextObj(obj) = nullptr;
+    return obj;
+}
+
+/**
+ * @brief 标量实现：逐个8字节写零
+ */
+void ClearObjectScalar(void *ptr, size_t bytes)
+{
+    uint64_t *words = (uint64_t *)ptr;
+    for (size_t i = 0; i < bytes / 8; i++)
+        words[i] = 0;
+}
+
+#ifdef HCMP_CARVE_X86
+
+/**
+ * @brief SSE2清零：每轮4次128位存储
+ */
+__attribute__((target("sse2")))
+static void ClearSse2(void *ptr, size_t bytes)
+{
+    char *p = (char *)ptr;
+    char *end = p + bytes;
+    __m128i zero = _mm_setzero_si128();
+    if (((uintptr_t)p & 15) && p < end)
+    {
+        *(uint64_t *)p = 0;
+        p += 8;
+    }
+
+    if (bytes >= CLEAR_NT_BYTES)
+    {
+        for (; p + 64 <= end; p += 64)
+        {
+            _mm_stream_si128((__m128i *)p, zero);
+            _mm_stream_si128((__m128i *)(p + 16), zero);
+            _mm_stream_si128((__m128i *)(p + 32), zero);
+            _mm_stream_si128((__m128i *)(p + 48), zero);
+        }
+        _mm_sfence();
+    }
+    else
+    {
+        for (; p + 64 <= end; p += 64)
+        {
+            _mm_store_si128((__m128i *)p, zero);
+            _mm_store_si128((__m128i *)(p + 16), zero);
+            _mm_store_si128((__m128i *)(p + 32), zero);
+            _mm_store_si128((__m128i *)(p + 48), zero);
+        }
+    }
+    for (; p + 16 <= end; p += 16)
+        _mm_store_si128((__m128i *)p, zero);
+    if (p < end)
+        *(uint64_t *)p = 0;
+}
+
+/**
+ * @brief AVX2清零：每轮4次256位存储
+ */
+__attribute__((target("avx2")))
+static void ClearAvx2(void *ptr, size_t bytes)
+{
+    char *p = (char *)ptr;
+    char *end = p + bytes;
+    // 先用8字节存储对齐到32字节
+    while (((uintptr_t)p & 31) && p < end)
+    {
+        *(uint64_t *)p = 0;
+        p += 8;
+    }
+
+    __m256i zero = _mm256_setzero_si256();
+    if (bytes >= CLEAR_NT_BYTES)
+    {
+        for (; p + 128 <= end; p += 128)
+        {
+            _mm256_stream_si256((__m256i *)p, zero);
+            _mm256_stream_si256((__m256i *)(p + 32), zero);
+            _mm256_stream_si256((__m256i *)(p + 64), zero);
+            _mm256_stream_si256((__m256i *)(p + 96), zero);
+        }
+        _mm_sfence();
+    }
+    else
+    {
+        for (; p + 128 <= end; p += 128)
+        {
+            _mm256_store_si256((__m256i *)p, zero);
+            _mm256_store_si256((__m256i *)(p + 32), zero);
+            _mm256_store_si256((__m256i *)(p + 64), zero);
+            _mm256_store_si256((__m256i *)(p + 96), zero);
+        }
+    }
+    for (; p + 32 <= end; p += 32)
+        _mm256_store_si256((__m256i *)p, zero);
+    for (; p < end; p += 8)
+        *(uint64_t *)p = 0;
+}
+
+/**
+ * @brief SSE2实现
+ * @details 8B对象一次写2个链接，16B对象一次写1个对象（链接+8字节0）；
+ *          其他大小的对象链接间隔太大，向量存储没有收益，走标量
+ */
+__attribute__((target("sse2")))
+static void *CarveSse2(char *start, size_t size, size_t n)
+{
+    if (size != 8 && size != 16)
+        return CarveObjectsScalar(start, size, n);
+
+    uint64_t *words = (uint64_t *)start;
+    uint64_t base = (uint64_t)(uintptr_t)start;
+    size_t stride = size / 8;      // 每个对象占几个8字节
+    size_t perStore = 2 / stride;  // 每次128位存储覆盖几个对象
+    size_t links = n - 1;          // 需要写入的链接数，最后一个对象置空
+    bool nt = n * size >= CARVE_NT_BYTES;
+
+    size_t i = 0;
+    // 非临时存储要求16字节对齐，先用标量处理开头
+    while (nt && i < links && ((uintptr_t)(words + i * stride) & 15))
+    {
+        words[i * stride] = base + (i + 1) * size;
+        ++i;
+    }
+
+    __m128i cur = size == 8 ? _mm_set_epi64x((long long)(base + (i + 2) * 8), (long long)(base + (i + 1) * 8))
+                            : _mm_set_epi64x(0, (long long)(base + (i + 1) * 16));
+    __m128i step = size == 8 ? _mm_set1_epi64x(16) : _mm_set_epi64x(0, 16);
+    if (nt)
+    {
+        for (; i + perStore <= links; i += perStore)
+        {
+            _mm_stream_si128((__m128i *)(words + i * stride), cur);
+            cur = _mm_add_epi64(cur, step);
+        }
+        _mm_sfence();
+    }
+    else
+    {
+        for (; i + perStore <= links; i += perStore)
+        {
+            _mm_storeu_si128((__m128i *)(words + i * stride), cur);
+            cur = _mm_add_epi64(cur, step);
+        }
+    }
+
+    for (; i < links; i++)
+        words[i * stride] = base + (i + 1) * size;
+
+    void *last = start + links * size;
+    NextObj(last) = nullptr;
+    return last;
+}
+
+/**
+ * @brief AVX2实现
+ * @details 8B对象一次写4个链接，16B对象一次写2个对象；其他大小走标量
+ */
+__attribute__((target("avx2")))
+static void *CarveAvx2(char *start, size_t size, size_t n)
+{
+    if (size != 8 && size != 16)
+        return CarveObjectsScalar(start, size, n);
+
+    uint64_t *words = (uint64_t *)start;
+    uint64_t base = (uint64_t)(uintptr_t)start;
+    size_t stride = size / 8;
+    size_t perStore = 4 / stride;  // 每次256位存储覆盖几个对象
+    size_t links = n - 1;
+    bool nt = n * size >= CARVE_NT_BYTES;
+
+    size_t i = 0;
+    // 非临时存储要求32字节对齐，先用标量处理开头
+    while (nt && i < links && ((uintptr_t)(words + i * stride) & 31))
+    {
+        words[i * stride] = base + (i + 1) * size;
+        ++i;
+    }
+
+    __m256i cur;
+    __m256i step;
+    if (size == 8)
+    {
+        cur = _mm256_set_epi64x((long long)(base + (i + 4) * 8), (long long)(base + (i + 3) * 8),
+                                (long long)(base + (i + 2) * 8), (long long)(base + (i + 1) * 8));
+        step = _mm256_set1_epi64x(32);
+    }
+    else
+    {
+        cur = _mm256_set_epi64x(0, (long long)(base + (i + 2) * 16), 0, (long long)(base + (i + 1) * 16));
+        step = _mm256_set_epi64x(0, 32, 0, 32);
+    }
+
+    if (nt)
+    {
+        for (; i + perStore <= links; i += perStore)
+        {
+            _mm256_stream_si256((__m256i *)(words + i * stride), cur);
+            cur = _mm256_add_epi64(cur, step);
+        }
+        _mm_sfence();
+    }
+    else
+    {
+        for (; i + perStore <= links; i += perStore)
+        {
+            _mm256_storeu_si256((__m256i *)(words + i * stride), cur);
+            cur = _mm256_add_epi64(cur, step);
+        }
+    }
+
+    for (; i < links; i++)
+        words[i * stride] = base + (i + 1) * size;
+
+    void *last = start + links * size;
+    NextObj(last) = nullptr;
+    return last;
+}
+
+#endif
+
+typedef void *(*CarveFunc)(char *, size_t, size_t);
+typedef void (*ClearFunc)(void *, size_t);
+
+/**
+ * @struct CarveImpl
+ * @brief 选定的切分、清零实现及其名称
+ */
+struct CarveImpl
+{
+    CarveFunc func;
+    ClearFunc clear;
+    const char *name;
+};
+
+/**
+ * @brief 按CPU支持情况选择切分实现
+ */
+static CarveImpl SelectCarveImpl()
+{
+#ifdef HCMP_CARVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return CarveImpl{CarveAvx2, ClearAvx2, "avx2"};
+    if (__builtin_cpu_supports("sse2"))
+        return CarveImpl{CarveSse2, ClearSse2, "sse2"};
+#endif
+    return CarveImpl{CarveObjectsScalar, ClearObjectScalar, "scalar"};
+}
+
+/**
+ * @brief 获取选定的切分实现，只在首次调用时检测一次CPU
+ */
+static const CarveImpl &GetCarveImpl()
+{
+    static const CarveImpl impl = SelectCarveImpl();
+    return impl;
+}
+
+void *CarveObjects(char *start, size_t size, size_t n)
+{
+    assert(n > 0);
+    assert(size % 8 == 0 && ((uintptr_t)start & 7) == 0);
+    return GetCarveImpl().func(start, size, n);
+}
+
+void ClearObject(void *ptr, size_t bytes)
+{
+    assert(bytes % 8 == 0 && ((uintptr_t)ptr & 7) == 0);
+    GetCarveImpl().clear(ptr, bytes);
+}
+
+const char *CarveKernelName()
+{
+    return GetCarveImpl().name;
+}
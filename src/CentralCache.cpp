@@ -1,167 +1,729 @@
-/**
- * @file CentralCache.cpp
- * @brief CentralCacheʵ
- * @details ʵ뻺Spanͻչ
- */
-
-#include "CentralCache.h"
-#include "PageCache.h"
-
-// 
-CentralCache CentralCache::_sInst;
-
-/**
- * @brief ȡһжSpan
- * @param list ӦСSpanList
- * @param size С
- * @return жSpanָ
- * @details ȡ̣
- *          1. SpanListпжSpan
- *          2. ûҵPageCacheµSpan
- *          3. SpanзֳָСĶ
- *          4. зֺõSpanSpanList
- */
-Span *CentralCache::GetOneSpan(SpanList &list, size_t size)
-{
-	// SpanListпжSpan
-	Span *it = list.begin();
-	while (it != list.end())
-	{
-		if (it->_freeList)
-			return it;
-		else
-			it = it->_next;
-	}
-
-	// ûҵSpanҪPageCacheµSpan
-	list._mtx.unlock(); // ͷͰ
-
-	// PageCacheµSpan
-	PageCache::GetInstance()->GetMutex().lock();
-	Span *span = PageCache::GetInstance()->NewSpan(SizeClass::NumMovePage(size));
-	span->_isUse = true; // SpanΪʹ״̬
-	span->_objSize = size;
-	PageCache::GetInstance()->GetMutex().unlock();
-
-	// SpanзֳָСĶ
-	// ʱҪΪ̻߳ʲSpan
-	
-	// Spanڴʼַͽַ
-	char *start = (char *)(span->_pageId << PAGE_SHIFT);
-	size_t bytes = span->_n << PAGE_SHIFT;
-	char *end = start + bytes;
-
-	// SpanڴзֳsizeСĶ󣬲
-	span->_freeList = start;
-	start += size;
-	void *tail = span->_freeList;
-	while (start < end)
-	{
-		NextObj(tail) = start;
-		tail = start;
-		start += size;
-	}
-	NextObj(tail) = nullptr; // βÿ
-
-	// зֺõSpanSpanList
-	list._mtx.lock(); // ¼
-	list.push_front(span);
-	return span;
-}
-
-/**
- * @brief CentralCacheȡڴ
- * @param start صĶʼָ
- * @param end صĶָ
- * @param batchNum ȡĶ
- * @param size С
- * @return ʵʻȡĶ
- * @details ȡ̣
- *          1. ݶСͰ
- *          2. ȡжSpan
- *          3. SpanȡָĶжȡ٣
- *          4. Spanʹü
- */
-size_t CentralCache::FetchRangeObj(void *&start, void *&end, size_t batchNum, size_t size)
-{
-	size_t index = SizeClass::Index(size);
-
-	_spanList[index]._mtx.lock();
-
-	Span *span = GetOneSpan(_spanList[index], size);
-	assert(span);
-	assert(span->_freeList);
-
-	// SpanлȡbatchNum
-	// SpanеĶ󲻹batchNumжȡ
-	start = span->_freeList;
-	end = start;
-	size_t i = 0;
-	size_t actualNum = 1;
-	while ((i < batchNum - 1) && NextObj(end))
-	{
-		end = NextObj(end);
-		++i, ++actualNum;
-	}
-	
-	// Spanͷָ
-	span->_freeList = NextObj(end);
-	NextObj(end) = nullptr; // ض
-	
-	// Spanʹü
-	span->_useCount += actualNum;
-
-	_spanList[index]._mtx.unlock();
-
-	return actualNum;
-}
-
-/**
- * @brief ڴ黹CentralCacheĶӦSpan
- * @param start ڴʼָ
- * @param bytes_size ڴĴС
- * @details 黹̣
- *          1. ݶСͰ
- *          2. ÿ黹ӦSpan
- *          3. Spanʹü
- *          4. Spanж󶼹黹ˣSpan黹PageCache
- */
-void CentralCache::ReleaseListToSpan(void *start, size_t bytes_size)
-{
-	size_t index = SizeClass::Index(bytes_size);
-	_spanList[index]._mtx.lock();
-
-	while (start)
-	{
-		void *next = NextObj(start);
-
-		// ڴַҵӦSpan
-		Span *span = PageCache::GetInstance()->MapObjectToSpan(start);
-		
-		// 黹Span
-		NextObj(start) = span->_freeList;
-		span->_freeList = start;
-		span->_useCount--;
-		
-		// Spanж󶼹黹ˣSpan黹PageCache
-		if (span->_useCount == 0)
-		{
-			// SpanListƳSpan
-			_spanList[index].erase(span);
-			span->_freeList = nullptr;
-			span->_next = nullptr;
-			span->_prev = nullptr;
-
-			// Span黹PageCacheҪͷͰٻȡPageCache
-			_spanList[index]._mtx.unlock();
-			PageCache::GetInstance()->GetMutex().lock();
-			PageCache::GetInstance()->ReleaseSpanToPageCache(span);
-			PageCache::GetInstance()->GetMutex().unlock();
-			_spanList[index]._mtx.lock(); // »ȡͰ
-		}
-
-		start = next;
-	}
-
-	_spanList[index]._mtx.unlock();
-}
\ No newline at end of file
+/**
+ * @file CentralCache.cpp
+ * @brief CentralCache类的实现
+ * @details 实现中央缓存的Span管理、对象分配和回收功能
+ */
+
+#include "CentralCache.h"
+#include "PageCache.h"
+#include "CarveKernel.h"
+#include "DeferredFree.h"
+#include <chrono>
+#include <cstring>
+
+// 单例对象定义
+CentralCache CentralCache::_sInst;
+
+// ReleaseGroup一次分组的最大对象数；分组用的数组都在栈上，一次归还合计约6.5KB，
+// 更大的批次分几组归还，每组仍只取一次页锁和桶锁
+static const size_t RELEASE_GROUP_MAX = 128;
+// ReleaseGroup查找Span时页号缓存的槽位数，须为2的幂
+static const size_t RELEASE_PAGE_CACHE = 64;
+// 每个尺寸类保留的空Span总字节数上限，大对象尺寸类因此最多只留一两个
+static const size_t EMPTY_SPAN_CLASS_BYTES = 2 * 1024 * 1024;
+// 尺寸类连续这么多轮清理都没有用到保留的空Span或缓存的批次时归还它们
+static const uint32_t EMPTY_SPAN_IDLE_GENS = 3;
+
+/**
+ * @brief 当前时间（毫秒）
+ */
+static int64_t NowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @struct PageSpanCache
+ * @brief 查找对象所属Span时使用的直接映射页号缓存，同一页上的对象只查一次页号映射
+ * @details 调用方持有页锁；页号0不会出现，可作空标记
+ */
+struct PageSpanCache
+{
+	PAGE_ID ids[RELEASE_PAGE_CACHE] = {0};
+	Span *spans[RELEASE_PAGE_CACHE];
+
+	Span *Lookup(void *obj)
+	{
+		PAGE_ID id = (PAGE_ID)obj >> PAGE_SHIFT;
+		size_t slot = id & (RELEASE_PAGE_CACHE - 1);
+		if (ids[slot] != id)
+		{
+			ids[slot] = id;
+			spans[slot] = PageCache::GetInstance()->MapObjectToSpanLocked(obj);
+		}
+		return spans[slot];
+	}
+};
+
+/**
+ * @brief 获取一个包含空闲对象的Span
+ * @param list 对应大小的SpanList
+ * @param size 对象大小
+ * @return 包含空闲对象的Span指针
+ * @details 获取流程：
+ *          1. 遍历SpanList查找有空闲对象的Span
+ *          2. 如果没有找到，复用本尺寸类保留的空Span
+ *          3. 仍没有则从PageCache申请新的Span；之前因上限已满归还过空Span时先把上限加一
+ *          4. 记录新Span的未切分区域，对象留到FetchRangeObj中按需切出
+ *          5. 将新Span加入SpanList
+ */
+Span *CentralCache::GetOneSpan(SpanList &list, size_t size)
+{
+	// 遍历SpanList查找有空闲对象的Span
+	Span *it = list.begin();
+	while (it != list.end())
+	{
+		if (it->_freeList || it->_carve + size <= it->_carveEnd)
+			return it;
+		else
+			it = it->_next;
+	}
+
+	// 先复用保留的空Span，自由链表和未切分区域保持原样
+	size_t index = &list - _spanList;
+	EmptySpans &empty = _empty[index];
+	empty.lastUse = _sweepGen.load(std::memory_order_relaxed);
+	if (empty.count > 0)
+	{
+		Span *span = empty.list.pop_front();
+		empty.count--;
+		_emptyTotal.fetch_sub(1, std::memory_order_relaxed);
+		_emptyBytes.fetch_sub(span->_n << PAGE_SHIFT, std::memory_order_relaxed);
+		list.push_front(span);
+		return span;
+	}
+	if (empty.released)
+	{
+		// 上限不够用：刚归还过空Span又要申请新Span
+		if (empty.limit < TuneGet(TUNE_EMPTY_SPAN_MAX))
+			empty.limit++;
+		empty.released = false;
+	}
+
+	// 没有找到空闲Span，需要从PageCache申请新的Span
+	list._mtx.unlock(); // 先释放桶锁，避免死锁
+	HCMP_LATENCY_SCOPE(LAT_SPAN_REFILL);
+
+	// 向PageCache申请新的Span
+	HCMP_LOCK_SITE(LOCK_SITE_SPAN_REFILL);
+	PageCache::GetInstance()->GetMutex().lock();
+	Span *span = PageCache::GetInstance()->NewSpan(SizeClass::NumMovePage(size));
+	span->_isUse = true; // 标记Span为使用状态
+	span->_objSize = size;
+	PageCache::GetInstance()->SetSpanClass(span);
+	PageCache::GetInstance()->GetMutex().unlock();
+	MaybeReleaseIdle();
+
+	// 只记录未切分区域的范围，对象在FetchRangeObj中按需切出，
+	// 不预先遍历整个Span写入链接，避免提前触碰每一页
+	char *start = (char *)(span->_pageId << PAGE_SHIFT);
+	span->_freeList = nullptr;
+	span->_carve = start;
+	span->_carveEnd = start + (span->_n << PAGE_SHIFT);
+
+	// 将新Span加入SpanList
+	list._mtx.lock(); // 重新加锁
+	list.push_front(span);
+	return span;
+}
+
+/**
+ * @brief 从CentralCache中批量获取内存对象
+ * @param start 返回的对象链表起始指针
+ * @param end 返回的对象链表结束指针
+ * @param batchNum 期望获取的对象数量
+ * @param size 对象大小
+ * @return 实际获取到的对象数量
+ * @details 获取流程：
+ *          1. 根据对象大小计算桶索引
+ *          2. 获取包含空闲对象的Span
+ *          3. 先取Span自由链表中已归还的对象，不够再从未切分区域切出
+ *             （如果总数不够则有多少取多少）
+ *          4. 更新Span的使用计数
+ */
+size_t CentralCache::FetchRangeObj(void *&start, void *&end, size_t batchNum, size_t size)
+{
+	size_t index = SizeClass::Index(size);
+
+	// 慢启动结束后ThreadCache按整批申请，先尝试无锁批次缓存；
+	// 缓存中的批次来自ListTooLong，对象数可能比batchNum多一两个。
+	// 批次缓存关闭后也照常弹出，关闭前后并发压入的批次不会滞留
+	if (batchNum == SizeClass::NumMoveSize(size))
+	{
+		size_t n = RemoveTransfer(index, start, end, batchNum + 2, size);
+		if (n > 0)
+			return n;
+	}
+
+	HCMP_LOCK_SITE(LOCK_SITE_FETCH_RANGE);
+	_spanList[index]._mtx.lock();
+
+	Span *span = GetOneSpan(_spanList[index], size);
+	assert(span);
+
+	// 先从Span的自由链表中获取已归还的对象
+	// 如果Span中的对象不够batchNum个，则有多少取多少
+	start = nullptr;
+	end = nullptr;
+	size_t actualNum = 0;
+	if (span->_freeList)
+	{
+		start = span->_freeList;
+		end = start;
+		actualNum = 1;
+		while (actualNum < batchNum && NextObj(end))
+		{
+			end = NextObj(end);
+			++actualNum;
+		}
+		// 更新Span的自由链表头指针
+		span->_freeList = NextObj(end);
+	}
+
+	// 不足的部分从未切分区域切出，只触碰本批对象所在的页
+	size_t carveNum = (size_t)(span->_carveEnd - span->_carve) / size;
+	if (carveNum > batchNum - actualNum)
+		carveNum = batchNum - actualNum;
+	if (carveNum > 0)
+	{
+		char *first = span->_carve;
+		void *last = CarveObjects(first, size, carveNum);
+		span->_carve += carveNum * size;
+		if (end)
+			NextObj(end) = first;
+		else
+			start = first;
+		end = last;
+	}
+	actualNum += carveNum;
+	assert(actualNum > 0);
+
+	NextObj(end) = nullptr; // 截断链表
+	
+	// 更新Span的使用计数
+	span->_useCount += actualNum;
+
+	_spanList[index]._mtx.unlock();
+
+	return actualNum;
+}
+
+/**
+ * @brief 从无锁批次缓存取出一批对象，超过上限的部分归还给Span
+ * @param index 桶索引
+ * @param start 返回批次第一个对象
+ * @param end 返回批次最后一个对象
+ * @param maxNum 最多返回的对象数
+ * @param size 对象大小
+ * @return 对象数，缓存为空时返回0
+ * @details 批次由ListTooLong按归还线程的慢启动上限压入，调小批量上限或慢启动增量之前压入的批次
+ *          可能超过取用方能容纳的数量，多出的对象在这里归还
+ */
+size_t CentralCache::RemoveTransfer(size_t index, void *&start, void *&end, size_t maxNum, size_t size)
+{
+	size_t n = _transfer.Remove(index, start, end);
+	if (n <= maxNum)
+		return n;
+
+	end = start;
+	for (size_t i = 1; i < maxNum; i++)
+		end = NextObj(end);
+	void *rest = NextObj(end);
+	NextObj(end) = nullptr;
+	ReleaseListToSpan(rest, size);
+	return maxNum;
+}
+
+/**
+ * @brief 从CentralCache中批量获取内存对象，存入指针数组
+ * @param batch 接收对象指针的数组，至少能放下NumMoveSize(size)+2个
+ * @param batchNum 期望获取的对象数量
+ * @param size 对象大小
+ * @return 实际获取到的对象数量
+ * @details 与链表版本的区别：从未切分区域取出的对象按地址直接算出，不写入链接，
+ *          对象所在的页留到使用时才第一次被触碰
+ */
+size_t CentralCache::FetchRangeObj(void **batch, size_t batchNum, size_t size)
+{
+	size_t index = SizeClass::Index(size);
+
+	if (batchNum == SizeClass::NumMoveSize(size))
+	{
+		void *start = nullptr, *end = nullptr;
+		size_t n = RemoveTransfer(index, start, end, batchNum + 2, size);
+		for (size_t i = 0; i < n; i++)
+		{
+			batch[i] = start;
+			start = NextObj(start);
+		}
+		if (n > 0)
+			return n;
+	}
+
+	HCMP_LOCK_SITE(LOCK_SITE_FETCH_RANGE);
+	_spanList[index]._mtx.lock();
+
+	Span *span = GetOneSpan(_spanList[index], size);
+	assert(span);
+
+	// 先取Span自由链表中已归还的对象
+	size_t actualNum = 0;
+	void *obj = span->_freeList;
+	while (obj && actualNum < batchNum)
+	{
+		batch[actualNum++] = obj;
+		obj = NextObj(obj);
+	}
+	span->_freeList = obj;
+
+	// 不足的部分从未切分区域按地址算出
+	size_t carveNum = (size_t)(span->_carveEnd - span->_carve) / size;
+	if (carveNum > batchNum - actualNum)
+		carveNum = batchNum - actualNum;
+	for (size_t i = 0; i < carveNum; i++)
+		batch[actualNum++] = span->_carve + i * size;
+	span->_carve += carveNum * size;
+	assert(actualNum > 0);
+
+	span->_useCount += actualNum;
+
+	_spanList[index]._mtx.unlock();
+
+	return actualNum;
+}
+
+/**
+ * @brief 将内存对象链表归还到CentralCache的对应Span
+ * @param start 内存对象链表的起始指针
+ * @param bytes_size 内存对象的大小
+ * @details 链表按RELEASE_GROUP_MAX个对象一组拆开。每组先不持锁沿链表读出对象指针，
+ *          再在一次页锁内查出各对象所属的Span，同一页上的对象只查一次页号映射。随后交给ReleaseGroup归还
+ */
+void CentralCache::ReleaseListToSpan(void *start, size_t bytes_size)
+{
+	HCMP_LATENCY_SCOPE(LAT_RELEASE_LIST);
+	size_t index = SizeClass::Index(bytes_size);
+	void *objs[RELEASE_GROUP_MAX];
+	Span *spans[RELEASE_GROUP_MAX];
+
+	while (start)
+	{
+		// 遍历链表的缓存缺失不占用页锁；ReleaseGroup会改写NextObj，必须先读完本组
+		size_t n = 0;
+		while (start && n < RELEASE_GROUP_MAX)
+		{
+			objs[n++] = start;
+			start = NextObj(start);
+		}
+
+		// 对象仍归调用方所有，所属Span不会被释放，查找不需要桶锁
+		{
+			HCMP_LOCK_SITE(LOCK_SITE_RELEASE_LIST);
+			std::lock_guard<PoolMutex> guard(PageCache::GetInstance()->GetMutex());
+			PageSpanCache cache;
+			for (size_t i = 0; i < n; i++)
+				spans[i] = cache.Lookup(objs[i]);
+		}
+		ReleaseGroup(index, objs, spans, n);
+	}
+}
+
+/**
+ * @brief 归还指针数组中的对象到CentralCache的对应Span
+ * @param objs 对象指针数组
+ * @param n 对象数量
+ * @param bytes_size 内存块大小
+ * @details 按RELEASE_GROUP_MAX个对象一组，在一次页锁内查出各对象所属的Span后交给ReleaseGroup
+ */
+void CentralCache::ReleaseArrayToSpan(void **objs, size_t n, size_t bytes_size)
+{
+	HCMP_LATENCY_SCOPE(LAT_RELEASE_LIST);
+	size_t index = SizeClass::Index(bytes_size);
+	Span *spans[RELEASE_GROUP_MAX];
+
+	for (size_t base = 0; base < n; base += RELEASE_GROUP_MAX)
+	{
+		size_t m = std::min(n - base, RELEASE_GROUP_MAX);
+		{
+			HCMP_LOCK_SITE(LOCK_SITE_RELEASE_LIST);
+			std::lock_guard<PoolMutex> guard(PageCache::GetInstance()->GetMutex());
+			PageSpanCache cache;
+			for (size_t i = 0; i < m; i++)
+				spans[i] = cache.Lookup(objs[base + i]);
+		}
+		ReleaseGroup(index, objs + base, spans, m);
+	}
+}
+
+/**
+ * @brief 把一组对象按Span分组后归还
+ * @param index 桶索引
+ * @param objs 对象指针数组
+ * @param spans 每个对象所属的Span
+ * @param n 对象个数
+ * @details 归还流程：
+ *          1. 不持锁：以Span地址为键用开放寻址哈希表分组，组内对象串成链表
+ *          2. 持桶锁：每组整段接到Span自由链表头部并一次减去计数，同时预取下一组的Span头；
+ *             变空的Span从链表摘下，未超过本尺寸类上限的留下
+ *          3. 释放桶锁后，在一次页锁内把其余变空的Span归还给PageCache
+ */
+void CentralCache::ReleaseGroup(size_t index, void **objs, Span **spans, size_t n)
+{
+	struct Group
+	{
+		Span *span;   // 组内对象所属的Span
+		void *head;   // 组内对象链表
+		void *tail;
+		size_t count; // 组内对象个数
+	};
+	Group groups[RELEASE_GROUP_MAX];
+	size_t ngroups = 0;
+
+	// 槽位存组下标+1，0表示空；表长取不小于2n的2的幂
+	uint16_t slots[2 * RELEASE_GROUP_MAX];
+	size_t bits = 1;
+	while (((size_t)1 << bits) < 2 * n)
+		bits++;
+	size_t mask = ((size_t)1 << bits) - 1;
+	memset(slots, 0, (mask + 1) * sizeof(uint16_t));
+
+	Span *lastSpan = nullptr;
+	Group *g = nullptr;
+	for (size_t i = 0; i < n; i++)
+	{
+		Span *span = spans[i];
+		if (span != lastSpan)
+		{
+			// 以Span地址为键，分组时不访问Span头
+			size_t slot = (size_t)(((uint64_t)(uintptr_t)span * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+			while (slots[slot] && groups[slots[slot] - 1].span != span)
+				slot = (slot + 1) & mask;
+			if (slots[slot] == 0)
+			{
+				groups[ngroups].span = span;
+				groups[ngroups].head = nullptr;
+				groups[ngroups].tail = objs[i];
+				groups[ngroups].count = 0;
+				slots[slot] = (uint16_t)++ngroups;
+			}
+			g = &groups[slots[slot] - 1];
+			lastSpan = span;
+		}
+		NextObj(objs[i]) = g->head;
+		g->head = objs[i];
+		g->count++;
+	}
+
+	// 不保留的空Span依次放到groups前部，释放桶锁后统一归还
+	size_t nempty = 0;
+	bool emptied = false;
+	{
+		HCMP_LOCK_SITE(LOCK_SITE_RELEASE_LIST);
+		std::lock_guard<PoolMutex> guard(_spanList[index]._mtx);
+		for (size_t k = 0; k < ngroups; k++)
+		{
+			if (k + 1 < ngroups)
+				__builtin_prefetch(groups[k + 1].span, 1, 3);
+
+			Span *span = groups[k].span;
+			NextObj(groups[k].tail) = span->_freeList;
+			span->_freeList = groups[k].head;
+			span->_useCount -= groups[k].count;
+
+			if (span->_useCount == 0)
+			{
+				_spanList[index].erase(span);
+				emptied = true;
+				if (!KeepEmptySpan(index, span))
+					groups[nempty++].span = span;
+			}
+		}
+	}
+
+	if (nempty > 0)
+	{
+		for (size_t k = 0; k + 1 < nempty; k++)
+			groups[k].span->_next = groups[k + 1].span;
+		groups[nempty - 1].span->_next = nullptr;
+		ReleaseSpanChain(groups[0].span);
+	}
+	if (emptied)
+	{
+		MaybeReleaseIdle();
+		DeferredFree::GetInstance()->Wake();
+	}
+}
+
+/**
+ * @brief 对象全部归还的Span未超过本尺寸类的上限时留下，调用方持有桶锁
+ * @param index 桶索引
+ * @param span 已从Span链表摘下的空Span
+ * @return 留下时返回true，否则调用方把它还给PageCache
+ * @details 上限取自适应上限、运行参数empty_span_max和EMPTY_SPAN_CLASS_BYTES折算的个数三者中最小的；
+ *          此外所有尺寸类合计不超过empty_span_bytes，其他尺寸类占满时不算本尺寸类的上限不够，不置released
+ */
+bool CentralCache::KeepEmptySpan(size_t index, Span *span)
+{
+	EmptySpans &empty = _empty[index];
+	empty.lastUse = _sweepGen.load(std::memory_order_relaxed);
+
+	size_t cap = std::min(empty.limit, TuneGet(TUNE_EMPTY_SPAN_MAX));
+	size_t byBytes = EMPTY_SPAN_CLASS_BYTES / (span->_n << PAGE_SHIFT);
+	cap = std::min(cap, std::max(byBytes, (size_t)1));
+	if (empty.count >= cap)
+	{
+		empty.released = true;
+		return false;
+	}
+
+	// 先占用字节额度再检查，多个桶并发保留时合计也不会超过上限
+	size_t bytes = span->_n << PAGE_SHIFT;
+	if (_emptyBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes > TuneGet(TUNE_EMPTY_SPAN_BYTES))
+	{
+		_emptyBytes.fetch_sub(bytes, std::memory_order_relaxed);
+		return false;
+	}
+
+	empty.list.push_front(span);
+	empty.count++;
+	_emptyTotal.fetch_add(1);   // seq_cst，与回收线程休眠前检查IdleWorkPending相配合
+	return true;
+}
+
+/**
+ * @brief 摘下某个尺寸类保留的全部空Span，调用方持有桶锁
+ * @param index 桶索引
+ * @return 以_next串起的Span链
+ */
+Span *CentralCache::DetachEmptySpans(size_t index)
+{
+	EmptySpans &empty = _empty[index];
+	Span *chain = nullptr;
+	size_t bytes = 0;
+	while (!empty.list.empty())
+	{
+		Span *span = empty.list.pop_front();
+		bytes += span->_n << PAGE_SHIFT;
+		span->_next = chain;
+		chain = span;
+	}
+	_emptyTotal.fetch_sub(empty.count, std::memory_order_relaxed);
+	_emptyBytes.fetch_sub(bytes, std::memory_order_relaxed);
+	empty.count = 0;
+	return chain;
+}
+
+/**
+ * @brief 在一次页锁内把以_next串起的Span全部归还给PageCache
+ * @param chain Span链，调用方不持有桶锁
+ */
+void CentralCache::ReleaseSpanChain(Span *chain)
+{
+	if (chain == nullptr)
+		return;
+	HCMP_LOCK_SITE(LOCK_SITE_RELEASE_LIST);
+	std::lock_guard<PoolMutex> guard(PageCache::GetInstance()->GetMutex());
+	while (chain)
+	{
+		Span *span = chain;
+		chain = span->_next;
+		span->_freeList = nullptr;
+		span->_carve = nullptr;
+		span->_carveEnd = nullptr;
+		span->_next = nullptr;
+		span->_prev = nullptr;
+		PageCache::GetInstance()->ReleaseSpanToPageCache(span);
+	}
+}
+
+/**
+ * @brief 统计某个尺寸类保留的空Span数
+ * @param bytes_size 内存块大小
+ * @return 保留的空Span个数，不计入SpanCount
+ */
+size_t CentralCache::EmptySpanCount(size_t bytes_size)
+{
+	size_t index = SizeClass::Index(bytes_size);
+	std::lock_guard<PoolMutex> guard(_spanList[index]._mtx);
+	return _empty[index].count;
+}
+
+/**
+ * @brief 把所有尺寸类保留的空Span归还给PageCache
+ * @details 先清空批次缓存，由此变空的Span一并归还
+ */
+void CentralCache::ReleaseEmptySpans()
+{
+	DrainTransferCache();
+	for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+	{
+		Span *chain = nullptr;
+		{
+			std::lock_guard<PoolMutex> guard(_spanList[i]._mtx);
+			chain = DetachEmptySpans(i);
+		}
+		ReleaseSpanChain(chain);
+	}
+}
+
+/**
+ * @brief 清理一轮：归还空闲超过EMPTY_SPAN_IDLE_GENS轮的尺寸类缓存的批次和保留的空Span，并把空Span上限减半
+ * @details 上限减半而不是归一，周期性的突发负载在两次突发之间只损失一部分保留量。
+ *          批次缓存关闭后残留的批次不论空闲与否都在这里归还
+ */
+void CentralCache::ReleaseIdleSpans()
+{
+	// 归还批次时Span变空会再次触发清理检查，先记下本轮时间
+	_lastSweepMs.store(NowMs(), std::memory_order_relaxed);
+
+	uint32_t transferGen = _transfer.Tick();
+	bool drainAll = !TransferCacheEnabled();
+	for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+	{
+		void *start = nullptr, *end = nullptr;
+		while ((drainAll ? _transfer.Count(i) > 0 : _transfer.Idle(i, transferGen, EMPTY_SPAN_IDLE_GENS)) &&
+			   _transfer.Drain(i, start, end) > 0)
+			ReleaseListToSpan(start, SizeClass::ClassSize(i));
+	}
+
+	uint32_t gen = _sweepGen.fetch_add(1, std::memory_order_relaxed) + 1;
+	for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+	{
+		Span *chain = nullptr;
+		{
+			std::lock_guard<PoolMutex> guard(_spanList[i]._mtx);
+			EmptySpans &empty = _empty[i];
+			if (empty.count == 0 || gen - empty.lastUse < EMPTY_SPAN_IDLE_GENS)
+				continue;
+			chain = DetachEmptySpans(i);
+			empty.limit = std::max(empty.limit / 2, (size_t)1);
+			empty.released = false;
+		}
+		ReleaseSpanChain(chain);
+	}
+}
+
+/**
+ * @brief 距上一轮清理已过empty_span_idle_ms的一半时执行一轮清理
+ * @details 未到期时只读一次时钟；多个线程同时到期时只有CAS成功的一个执行清理
+ */
+void CentralCache::MaybeReleaseIdle()
+{
+	int64_t now = NowMs();
+	int64_t last = _lastSweepMs.load(std::memory_order_relaxed);
+	int64_t interval = (int64_t)std::max(TuneGet(TUNE_EMPTY_SPAN_IDLE_MS) / 2, (size_t)1);
+	if (now - last < interval)
+		return;
+	if (!_lastSweepMs.compare_exchange_strong(last, now, std::memory_order_relaxed))
+		return;
+	ReleaseIdleSpans();
+}
+
+/**
+ * @brief 统计某个桶中的Span数
+ * @param bytes_size 内存块大小
+ * @return Span链表中的Span个数
+ */
+size_t CentralCache::SpanCount(size_t bytes_size)
+{
+	SpanList &list = _spanList[SizeClass::Index(bytes_size)];
+	std::lock_guard<PoolMutex> guard(list._mtx);
+	size_t count = 0;
+	for (Span *it = list.begin(); it != list.end(); it = it->_next)
+		count++;
+	return count;
+}
+
+/**
+ * @brief 归还一批对象，优先放入无锁批次缓存
+ * @param start 对象链表起始指针
+ * @param end 对象链表结束指针
+ * @param n 对象数量
+ * @param bytes_size 内存块大小
+ */
+void CentralCache::InsertRange(void *start, void *end, size_t n, size_t bytes_size)
+{
+	if (!InsertTransfer(start, end, n, bytes_size))
+		ReleaseListToSpan(start, bytes_size);
+}
+
+/**
+ * @brief 归还指针数组中的一批对象，优先放入无锁批次缓存
+ * @param objs 对象指针数组
+ * @param n 对象数量
+ * @param bytes_size 内存块大小
+ */
+void CentralCache::InsertRange(void **objs, size_t n, size_t bytes_size)
+{
+	if (TransferCacheEnabled() && InsertTransfer(LinkObjects(objs, n), objs[n - 1], n, bytes_size))
+		return;
+	ReleaseArrayToSpan(objs, n, bytes_size);
+}
+
+/**
+ * @brief 尝试把一批对象放入无锁批次缓存
+ * @param start 对象链表起始指针
+ * @param end 对象链表结束指针
+ * @param n 对象数量
+ * @param bytes_size 内存块大小
+ * @return 是否放入
+ */
+bool CentralCache::InsertTransfer(void *start, void *end, size_t n, size_t bytes_size)
+{
+	size_t index = SizeClass::Index(bytes_size);
+	if (!TransferCacheEnabled() || !_transfer.Insert(index, start, end, n))
+		return false;
+	DeferredFree::GetInstance()->Wake();
+
+	// 检查开关之后、压入之前批次缓存被关闭：关闭时的清空可能已经结束，由本线程把这个尺寸类清空；
+	// 仍然漏掉的批次由整批申请取走，或在下一轮清理时归还
+	if (!TransferCacheEnabled())
+	{
+		while (_transfer.Drain(index, start, end) > 0)
+			ReleaseListToSpan(start, bytes_size);
+	}
+	return true;
+}
+
+/**
+ * @brief 开启或关闭无锁批次缓存
+ * @param enable 是否开启
+ * @details 关闭后整批申请仍会弹出批次缓存，清理也会归还残留的批次，与并发的压入交错时不会丢失对象
+ */
+void CentralCache::SetTransferCacheEnabled(bool enable)
+{
+	_transferEnabled.store(enable, std::memory_order_relaxed);
+	TuneSet(TUNE_TRANSFER_CACHE, enable ? 1 : 0);
+	if (!enable)
+		DrainTransferCache();
+}
+
+/**
+ * @brief 把无锁批次缓存中的所有批次归还给Span
+ */
+void CentralCache::DrainTransferCache()
+{
+	for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+	{
+		void *start = nullptr, *end = nullptr;
+		while (_transfer.Drain(i, start, end) > 0)
+			ReleaseListToSpan(start, SizeClass::ClassSize(i));
+	}
+}
+
+/**
+ * @brief 调整每个尺寸类批次缓存的字节上限
+ * @param bytes 字节上限
+ */
+void CentralCache::SetTransferCacheBytes(size_t bytes)
+{
+	TuneSet(TUNE_TRANSFER_CACHE_BYTES, bytes);
+	_transfer.SetBytes(bytes);
+	for (size_t i = 0; i < MAX_BUCKETSIZE; i++)
+	{
+		void *start = nullptr, *end = nullptr;
+		while (_transfer.Count(i) > _transfer.Capacity(i) && _transfer.Drain(i, start, end) > 0)
+			ReleaseListToSpan(start, SizeClass::ClassSize(i));
+	}
+}
@@ -0,0 +1,259 @@
+/**
+ * @file DeferredFree.cpp
+ * @brief 异步延迟释放的实现
+ * @details 入队、反压判断，以及后台回收线程把批次归还给CentralCache/PageCache
+ */
+
+#include "DeferredFree.h"
+#include "CentralCache.h"
+#include "PageCache.h"
+#include <chrono>
+#include <cstdlib>
+
+DeferredFree DeferredFree::_sInst;
+
+/**
+ * @brief 回收线程已由Shutdown在atexit中停止，这里只处理从未入队过的情况
+ */
+DeferredFree::~DeferredFree()
+{
+    Stop();
+}
+
+/**
+ * @brief 进程退出时停止回收线程，由EnsureStarted用atexit注册
+ * @details 注册发生在各单例构造完成之后，因此先于它们析构执行，剩余节点可以照常归还
+ */
+void DeferredFree::Shutdown()
+{
+    _sInst.Stop();
+}
+
+/**
+ * @brief 停止回收线程并由当前线程归还它没处理的节点，重复调用时直接返回
+ */
+void DeferredFree::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(_mtx);
+        if (_stop.exchange(true))
+            return;
+    }
+    _cv.notify_one();
+    if (_thread.joinable())
+        _thread.join();
+
+    // 停止后新的入队被拒绝
+    DeferredBatch *list = _head.exchange(nullptr, std::memory_order_acquire);
+    if (list)
+        Reclaim(list);
+}
+
+bool DeferredFree::PushList(void *start, size_t n, size_t size)
+{
+    size_t bytes = n * size;
+    if (_stop.load(std::memory_order_relaxed) ||
+        _pendingBytes.load(std::memory_order_relaxed) + bytes > _limit.load(std::memory_order_relaxed))
+    {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        _cv.notify_one();
+        return false;
+    }
+
+    DeferredBatch *batch = _batchPool.New();
+    batch->start = start;
+    batch->size = size;
+    batch->bytes = bytes;
+    _deferredBatches.fetch_add(1, std::memory_order_relaxed);
+    return Push(batch);
+}
+
+bool DeferredFree::PushSpan(Span *span)
+{
+    size_t bytes = span->_n << PAGE_SHIFT;
+    if (_stop.load(std::memory_order_relaxed) ||
+        _pendingBytes.load(std::memory_order_relaxed) + bytes > _limit.load(std::memory_order_relaxed))
+    {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        _cv.notify_one();
+        return false;
+    }
+
+    DeferredBatch *batch = _batchPool.New();
+    batch->span = span;
+    batch->bytes = bytes;
+    _deferredSpans.fetch_add(1, std::memory_order_relaxed);
+    return Push(batch);
+}
+
+/**
+ * @brief 把节点压入待回收栈，栈由空变为非空时唤醒回收线程
+ */
+bool DeferredFree::Push(DeferredBatch *batch)
+{
+    EnsureStarted();
+    _pendingBytes.fetch_add(batch->bytes, std::memory_order_relaxed);
+    _submitted.fetch_add(1, std::memory_order_relaxed);
+
+    DeferredBatch *head = _head.load(std::memory_order_relaxed);
+    do
+    {
+        batch->next = head;
+    } while (!_head.compare_exchange_weak(head, batch, std::memory_order_release,
+                                          std::memory_order_relaxed));
+
+    // 先取一次锁再通知：回收线程检查条件之后、进入等待之前的这次唤醒不会丢失
+    if (head == nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> guard(_mtx);
+        }
+        _cv.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief 首次入队或首次有清理工作时启动回收线程，并注册进程退出时的Shutdown
+ */
+void DeferredFree::EnsureStarted()
+{
+    if (_started.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> guard(_mtx);
+    if (!_started.load(std::memory_order_relaxed) && !_stop.load())
+    {
+        _thread = std::thread(&DeferredFree::Run, this);
+        std::atexit(Shutdown);
+        _started.store(true, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief 清理有了新工作时唤醒无限期休眠的回收线程，回收线程还没启动时启动它
+ * @param force 定时等待中也唤醒
+ * @details 调用方先修改空Span数或批次数再读_sleeping，回收线程先写_sleeping再读这些计数，
+ *          都是seq_cst操作，两边至少有一方看到对方的修改
+ */
+void DeferredFree::Wake(bool force)
+{
+    if (!_started.load(std::memory_order_acquire))
+    {
+        // 只是调整参数时不必为此启动线程
+        if (!force)
+            EnsureStarted();
+        return;
+    }
+    if (!force && !_sleeping.load())
+        return;
+    {
+        std::lock_guard<std::mutex> guard(_mtx);
+        _wake = true;
+    }
+    _cv.notify_one();
+}
+
+/**
+ * @brief 回收线程主循环：摘下整个待回收栈处理，栈空时休眠
+ * @details 有空Span或批次可清理时按empty_span_idle_ms的一半定时醒来执行一轮清理，否则无限期等待
+ */
+void DeferredFree::Run()
+{
+    while (!_stop.load())
+    {
+        DeferredBatch *list = _head.exchange(nullptr, std::memory_order_acquire);
+        if (list)
+        {
+            Reclaim(list);
+            continue;
+        }
+
+        _sleeping.store(true);
+        bool idleWork = CentralCache::GetInstance()->IdleWorkPending();
+        if (idleWork)
+            _sleeping.store(false, std::memory_order_relaxed);
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            auto ready = [this]() {
+                return _head.load(std::memory_order_relaxed) != nullptr || _stop.load() || _wake;
+            };
+            if (idleWork)
+            {
+                size_t ms = std::max(TuneGet(TUNE_EMPTY_SPAN_IDLE_MS) / 2, (size_t)1);
+                _cv.wait_for(lock, std::chrono::milliseconds(ms), ready);
+            }
+            else
+            {
+                _cv.wait(lock, ready);
+            }
+            _wake = false;
+        }
+        _sleeping.store(false, std::memory_order_relaxed);
+        if (!_stop.load())
+            CentralCache::GetInstance()->MaybeReleaseIdle();
+    }
+}
+
+/**
+ * @brief 处理一组节点：小对象逐批归还给CentralCache，大对象Span在一次加锁中归还给PageCache
+ */
+void DeferredFree::Reclaim(DeferredBatch *list)
+{
+    DeferredBatch *spans = nullptr;
+    while (list)
+    {
+        DeferredBatch *next = list->next;
+        if (list->span)
+        {
+            list->next = spans;
+            spans = list;
+        }
+        else
+        {
+            CentralCache::GetInstance()->ReleaseListToSpan(list->start, list->size);
+            _pendingBytes.fetch_sub(list->bytes, std::memory_order_relaxed);
+            _batchPool.Delete(list);
+            _reclaimed.fetch_add(1, std::memory_order_release);
+        }
+        list = next;
+    }
+
+    if (spans)
+    {
+        HCMP_LOCK_SITE(LOCK_SITE_LARGE_FREE);
+        PageCache::GetInstance()->GetMutex().lock();
+        for (DeferredBatch *batch = spans; batch; batch = batch->next)
+            PageCache::GetInstance()->ReleaseSpanToPageCache(batch->span);
+        PageCache::GetInstance()->GetMutex().unlock();
+
+        while (spans)
+        {
+            DeferredBatch *next = spans->next;
+            _pendingBytes.fetch_sub(spans->bytes, std::memory_order_relaxed);
+            _batchPool.Delete(spans);
+            _reclaimed.fetch_add(1, std::memory_order_release);
+            spans = next;
+        }
+    }
+}
+
+void DeferredFree::Flush()
+{
+    size_t target = _submitted.load(std::memory_order_relaxed);
+    while (_reclaimed.load(std::memory_order_acquire) < target)
+    {
+        _cv.notify_one();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+DeferredFreeStats DeferredFree::GetStats() const
+{
+    DeferredFreeStats stats;
+    stats.deferredBatches = _deferredBatches.load(std::memory_order_relaxed);
+    stats.deferredSpans = _deferredSpans.load(std::memory_order_relaxed);
+    stats.rejected = _rejected.load(std::memory_order_relaxed);
+    stats.reclaimed = _reclaimed.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,312 @@
+/**
+ * @file LatencyProfiler.cpp
+ * @brief 分层延迟直方图的实现
+ * @details 每线程直方图的登记与退出时合并、分桶、TSC频率校准和报告输出
+ */
+
+#include "LatencyProfiler.h"
+
+#ifdef HCMP_LATENCY_PROFILE
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+
+static const size_t LATENCY_SUB_BITS = 2;                              // 每个2的幂区间的子桶位数
+static const size_t LATENCY_SUB_COUNT = (size_t)1 << LATENCY_SUB_BITS;
+static const size_t LATENCY_BUCKETS = 64 * LATENCY_SUB_COUNT;
+
+static const char *const LATENCY_PATH_NAMES[LAT_PATH_COUNT] = {
+    "ThreadCache::Allocate hit",
+    "FetchFromCentralCache",
+    "GetOneSpan refill",
+    "PageCache::NewSpan",
+    "SystemAlloc",
+    "ThreadCache::Deallocate hit",
+    "ListTooLong",
+    "ReleaseListToSpan",
+    "ReleaseSpanToPageCache",
+    "SystemFree",
+};
+
+static const bool LATENCY_PATH_SAMPLED[LAT_PATH_COUNT] = {
+    true, false, false, false, false, true, false, false, false, false,
+};
+
+/**
+ * @struct LatencyThreadData
+ * @brief 一个线程的直方图
+ * @details 只有所属线程写入，报告线程并发读取，用relaxed原子读写避免数据竞争
+ */
+struct LatencyThreadData
+{
+    std::atomic<uint64_t> hist[LAT_PATH_COUNT][LATENCY_BUCKETS];
+    std::atomic<uint64_t> max[LAT_PATH_COUNT];
+    LatencyThreadData *next = nullptr;   // 全局登记链表
+    LatencyThreadData *prev = nullptr;
+
+    LatencyThreadData()
+    {
+        Clear();
+    }
+
+    void Clear()
+    {
+        for (size_t p = 0; p < LAT_PATH_COUNT; p++)
+        {
+            for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+                hist[p][b].store(0, std::memory_order_relaxed);
+            max[p].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// 全局登记链表与已退出线程的合计，均为常量初始化，不受静态对象构造顺序影响
+static LatencyThreadData *gThreadList = nullptr;
+static uint64_t gRetiredHist[LAT_PATH_COUNT][LATENCY_BUCKETS];
+static uint64_t gRetiredMax[LAT_PATH_COUNT];
+
+static thread_local LatencyThreadData *tlsLatencyData = nullptr;
+static thread_local bool tlsLatencyExited = false;
+
+static std::mutex &RegistryMutex()
+{
+    static std::mutex mtx;
+    return mtx;
+}
+
+/**
+ * @class LatencyThreadReaper
+ * @brief 线程退出时把本线程的直方图并入已退出合计并注销
+ */
+class LatencyThreadReaper
+{
+public:
+    ~LatencyThreadReaper()
+    {
+        LatencyThreadData *d = tlsLatencyData;
+        tlsLatencyData = nullptr;
+        tlsLatencyExited = true;   // 之后的线程退出阶段不再记录
+        if (!d)
+            return;
+
+        std::lock_guard<std::mutex> guard(RegistryMutex());
+        for (size_t p = 0; p < LAT_PATH_COUNT; p++)
+        {
+            for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+                gRetiredHist[p][b] += d->hist[p][b].load(std::memory_order_relaxed);
+            gRetiredMax[p] = std::max(gRetiredMax[p], d->max[p].load(std::memory_order_relaxed));
+        }
+        if (d->prev)
+            d->prev->next = d->next;
+        else
+            gThreadList = d->next;
+        if (d->next)
+            d->next->prev = d->prev;
+        delete d;
+    }
+};
+
+/**
+ * @brief 获取当前线程的直方图，首次调用时创建并登记
+ * @return 线程已进入退出阶段时返回nullptr
+ */
+static LatencyThreadData *ThreadData()
+{
+    LatencyThreadData *d = tlsLatencyData;
+    if (d || tlsLatencyExited)
+        return d;
+
+    static thread_local LatencyThreadReaper reaper;
+    (void)reaper;
+    d = new LatencyThreadData;
+    {
+        std::lock_guard<std::mutex> guard(RegistryMutex());
+        d->next = gThreadList;
+        if (gThreadList)
+            gThreadList->prev = d;
+        gThreadList = d;
+    }
+    tlsLatencyData = d;
+    return d;
+}
+
+/**
+ * @brief 耗时对应的桶：小于4的值各占一桶，之后每个2的幂区间按最高两位之后的2位再分4桶
+ */
+static inline size_t LatencyBucket(uint64_t ticks)
+{
+    if (ticks < LATENCY_SUB_COUNT)
+        return (size_t)ticks;
+    size_t e = 63 - __builtin_clzll(ticks);
+    size_t sub = (size_t)(ticks >> (e - LATENCY_SUB_BITS)) & (LATENCY_SUB_COUNT - 1);
+    return (e - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT + sub;
+}
+
+/**
+ * @brief 桶的上界（不含）
+ */
+static inline uint64_t LatencyBucketUpper(size_t bucket)
+{
+    size_t next = bucket + 1;
+    if (next < LATENCY_SUB_COUNT)
+        return next;
+    size_t e = next / LATENCY_SUB_COUNT + LATENCY_SUB_BITS - 1;
+    size_t sub = next % LATENCY_SUB_COUNT;
+    return (uint64_t)(LATENCY_SUB_COUNT + sub) << (e - LATENCY_SUB_BITS);
+}
+
+void LatencyRecord(LatencyPath path, uint64_t ticks)
+{
+    LatencyThreadData *d = ThreadData();
+    if (!d)
+        return;
+
+    // 只有本线程写，读改写不需要原子指令
+    std::atomic<uint64_t> &slot = d->hist[path][LatencyBucket(ticks)];
+    slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (ticks > d->max[path].load(std::memory_order_relaxed))
+        d->max[path].store(ticks, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 每纳秒的计时单位数，首次调用时用steady_clock校准TSC
+ */
+static double TicksPerNs()
+{
+#ifdef HCMP_LATENCY_RDTSC
+    static double ratio = []() {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = LatencyTicks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto t1 = std::chrono::steady_clock::now();
+        uint64_t c1 = LatencyTicks();
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        return (double)(c1 - c0) / ns;
+    }();
+    return ratio;
+#else
+    return 1.0;
+#endif
+}
+
+/**
+ * @brief 合并一条路径在所有线程上的直方图
+ */
+static void MergePath(LatencyPath path, uint64_t *hist, uint64_t &max)
+{
+    std::lock_guard<std::mutex> guard(RegistryMutex());
+    for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+        hist[b] = gRetiredHist[path][b];
+    max = gRetiredMax[path];
+    for (LatencyThreadData *d = gThreadList; d; d = d->next)
+    {
+        for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+            hist[b] += d->hist[path][b].load(std::memory_order_relaxed);
+        max = std::max(max, d->max[path].load(std::memory_order_relaxed));
+    }
+}
+
+static double HistPercentile(const uint64_t *hist, uint64_t total, double q)
+{
+    uint64_t target = (uint64_t)(total * q);
+    uint64_t seen = 0;
+    for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += hist[b];
+        if (seen > target)
+            return LatencyBucketUpper(b) / TicksPerNs();
+    }
+    return LatencyBucketUpper(LATENCY_BUCKETS - 1) / TicksPerNs();
+}
+
+LatencySummary LatencyProfileGet(LatencyPath path)
+{
+    uint64_t hist[LATENCY_BUCKETS];
+    uint64_t max = 0;
+    MergePath(path, hist, max);
+
+    LatencySummary sum;
+    for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+        sum.count += hist[b];
+    if (sum.count == 0)
+        return sum;
+    // 桶上界可能超过实际最大值，分位数不超过最大值
+    sum.max = max / TicksPerNs();
+    sum.p50 = std::min(HistPercentile(hist, sum.count, 0.5), sum.max);
+    sum.p99 = std::min(HistPercentile(hist, sum.count, 0.99), sum.max);
+    sum.p999 = std::min(HistPercentile(hist, sum.count, 0.999), sum.max);
+    return sum;
+}
+
+/**
+ * @brief 估计一次计时本身的开销（纳秒），取多次连续读计时器的最小差值
+ */
+static double TimerOverheadNs()
+{
+    uint64_t best = ~(uint64_t)0;
+    for (int i = 0; i < 1000; i++)
+    {
+        uint64_t t0 = LatencyTicks();
+        uint64_t t1 = LatencyTicks();
+        best = std::min(best, t1 - t0);
+    }
+    return best / TicksPerNs();
+}
+
+void LatencyProfileReport(std::ostream &os)
+{
+    char line[256];
+    os << "==== 分层延迟报告（ns，分位数为所在桶的上界） ====" << std::endl;
+    snprintf(line, sizeof(line), "快路径采样率 1/%d，计时开销约 %.1f ns",
+             HCMP_LATENCY_SAMPLE_RATE, TimerOverheadNs());
+    os << line << std::endl;
+    snprintf(line, sizeof(line), "  %-28s %12s %10s %10s %10s %12s",
+             "path", "count", "p50", "p99", "p99.9", "max");
+    os << line << std::endl;
+    for (size_t p = 0; p < LAT_PATH_COUNT; p++)
+    {
+        LatencySummary s = LatencyProfileGet((LatencyPath)p);
+        if (s.count == 0)
+            continue;
+        snprintf(line, sizeof(line), "  %-28s %12llu %10.0f %10.0f %10.0f %12.0f%s",
+                 LATENCY_PATH_NAMES[p], (unsigned long long)s.count,
+                 s.p50, s.p99, s.p999, s.max, LATENCY_PATH_SAMPLED[p] ? "  (采样)" : "");
+        os << line << std::endl;
+    }
+}
+
+void LatencyProfileReset()
+{
+    std::lock_guard<std::mutex> guard(RegistryMutex());
+    for (size_t p = 0; p < LAT_PATH_COUNT; p++)
+    {
+        for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+            gRetiredHist[p][b] = 0;
+        gRetiredMax[p] = 0;
+    }
+    for (LatencyThreadData *d = gThreadList; d; d = d->next)
+        d->Clear();
+}
+
+#else
+
+void LatencyProfileReport(std::ostream &os)
+{
+    os << "分层延迟统计未开启，请以 -DHCMP_LATENCY_PROFILE 重新编译" << std::endl;
+}
+
+LatencySummary LatencyProfileGet(LatencyPath path)
+{
+    (void)path;
+    return LatencySummary();
+}
+
+void LatencyProfileReset()
+{
+}
+
+#endif
@@ -0,0 +1,265 @@
+/**
+ * @file LockProfiler.cpp
+ * @brief 锁竞争分析器的实现
+ * @details 计时、直方图记录、全局登记和报告输出
+ */
+
+#include "LockProfiler.h"
+
+#ifdef HCMP_LOCK_PROFILE
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+static thread_local LockSite tlsLockSite = LOCK_SITE_OTHER;   // 当前线程的加锁路径
+
+static const char *const LOCK_SITE_NAMES[LOCK_SITE_COUNT] = {
+    "other",
+    "FetchRangeObj",
+    "GetOneSpan refill",
+    "ReleaseListToSpan",
+    "large alloc",
+    "large free",
+    "free lookup",
+    "arena",
+};
+
+// 全局登记链表，头指针常量初始化，不受静态对象构造顺序影响
+static ProfiledMutex *gMutexList = nullptr;
+
+static std::mutex &RegistryMutex()
+{
+    static std::mutex mtx;
+    return mtx;
+}
+
+static inline uint64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 纳秒数对应的直方图桶
+ */
+static inline size_t HistBucket(uint64_t ns)
+{
+    size_t b = ns ? 63 - __builtin_clzll(ns) : 0;
+    return b < LOCK_HIST_BUCKETS ? b : LOCK_HIST_BUCKETS - 1;
+}
+
+LockSiteScope::LockSiteScope(LockSite site)
+    : _saved(tlsLockSite)
+{
+    tlsLockSite = site;
+}
+
+LockSiteScope::~LockSiteScope()
+{
+    tlsLockSite = _saved;
+}
+
+ProfiledMutex::ProfiledMutex()
+{
+    std::lock_guard<std::mutex> guard(RegistryMutex());
+    _nextMutex = gMutexList;
+    if (gMutexList)
+        gMutexList->_prevMutex = this;
+    gMutexList = this;
+}
+
+ProfiledMutex::~ProfiledMutex()
+{
+    std::lock_guard<std::mutex> guard(RegistryMutex());
+    if (_prevMutex)
+        _prevMutex->_nextMutex = _nextMutex;
+    else
+        gMutexList = _nextMutex;
+    if (_nextMutex)
+        _nextMutex->_prevMutex = _prevMutex;
+}
+
+void ProfiledMutex::lock()
+{
+    if (_mtx.try_lock())
+    {
+        OnAcquired(0, false);
+        return;
+    }
+
+    uint64_t t0 = NowNs();
+    _mtx.lock();
+    OnAcquired(NowNs() - t0, true);
+}
+
+bool ProfiledMutex::try_lock()
+{
+    if (!_mtx.try_lock())
+        return false;
+    OnAcquired(0, false);
+    return true;
+}
+
+void ProfiledMutex::unlock()
+{
+    uint64_t hold = NowNs() - _holdStart;
+    LockSiteStats &st = _stats[_holdSite];
+    st.holdNs += hold;
+    ++st.holdHist[HistBucket(hold)];
+    _mtx.unlock();
+}
+
+/**
+ * @brief 获得锁之后记录统计，此时已持有锁，直接写入
+ */
+void ProfiledMutex::OnAcquired(uint64_t waitNs, bool contended)
+{
+    _holdSite = tlsLockSite;
+    LockSiteStats &st = _stats[_holdSite];
+    ++st.acquires;
+    if (contended)
+    {
+        ++st.contended;
+        st.waitNs += waitNs;
+        ++st.waitHist[HistBucket(waitNs)];
+    }
+    _holdStart = NowNs();
+}
+
+/**
+ * @brief 从直方图估算分位数，返回所在桶的上界（纳秒）
+ */
+static uint64_t HistPercentile(const uint64_t *hist, double q)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < LOCK_HIST_BUCKETS; i++)
+        total += hist[i];
+    if (total == 0)
+        return 0;
+
+    uint64_t target = (uint64_t)(total * q);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LOCK_HIST_BUCKETS; i++)
+    {
+        seen += hist[i];
+        if (seen > target)
+            return (uint64_t)2 << i;
+    }
+    return (uint64_t)2 << (LOCK_HIST_BUCKETS - 1);
+}
+
+/**
+ * @struct LockSummary
+ * @brief 报告用的单把锁汇总
+ */
+struct LockSummary
+{
+    const ProfiledMutex *mtx;
+    const char *name;
+    int index;
+    LockSiteStats total;
+    const LockSiteStats *sites;
+};
+
+void LockProfileReport(std::ostream &os, size_t topN)
+{
+    std::vector<LockSummary> locks;
+    {
+        std::lock_guard<std::mutex> guard(RegistryMutex());
+        for (ProfiledMutex *m = gMutexList; m; m = m->_nextMutex)
+        {
+            LockSummary sum;
+            sum.mtx = m;
+            sum.name = m->_name;
+            sum.index = m->_index;
+            sum.sites = m->_stats;
+            for (size_t s = 0; s < LOCK_SITE_COUNT; s++)
+            {
+                const LockSiteStats &st = m->_stats[s];
+                sum.total.acquires += st.acquires;
+                sum.total.contended += st.contended;
+                sum.total.waitNs += st.waitNs;
+                sum.total.holdNs += st.holdNs;
+                for (size_t b = 0; b < LOCK_HIST_BUCKETS; b++)
+                {
+                    sum.total.waitHist[b] += st.waitHist[b];
+                    sum.total.holdHist[b] += st.holdHist[b];
+                }
+            }
+            if (sum.total.acquires > 0)
+                locks.push_back(sum);
+        }
+    }
+
+    std::sort(locks.begin(), locks.end(), [](const LockSummary &a, const LockSummary &b) {
+        return a.total.waitNs > b.total.waitNs;
+    });
+    if (locks.size() > topN)
+        locks.resize(topN);
+
+    char line[256];
+    os << "==== 锁竞争报告（按总等待时间排序，前" << locks.size() << "把） ====" << std::endl;
+    for (const LockSummary &l : locks)
+    {
+        const LockSiteStats &t = l.total;
+        if (l.index >= 0)
+            snprintf(line, sizeof(line), "%s[%d]", l.name, l.index);
+        else
+            snprintf(line, sizeof(line), "%s", l.name);
+        os << line << std::endl;
+
+        snprintf(line, sizeof(line),
+                 "  获取 %llu 次, 竞争 %llu 次 (%.2f%%), 总等待 %.3f ms, 总持有 %.3f ms",
+                 (unsigned long long)t.acquires, (unsigned long long)t.contended,
+                 t.acquires ? 100.0 * t.contended / t.acquires : 0.0,
+                 t.waitNs / 1e6, t.holdNs / 1e6);
+        os << line << std::endl;
+        snprintf(line, sizeof(line),
+                 "  等待 p50 <%llu ns, p99 <%llu ns; 持有 p50 <%llu ns, p99 <%llu ns",
+                 (unsigned long long)HistPercentile(t.waitHist, 0.5),
+                 (unsigned long long)HistPercentile(t.waitHist, 0.99),
+                 (unsigned long long)HistPercentile(t.holdHist, 0.5),
+                 (unsigned long long)HistPercentile(t.holdHist, 0.99));
+        os << line << std::endl;
+
+        for (size_t s = 0; s < LOCK_SITE_COUNT; s++)
+        {
+            const LockSiteStats &st = l.sites[s];
+            if (st.acquires == 0)
+                continue;
+            snprintf(line, sizeof(line),
+                     "    %-18s 获取 %-10llu 竞争 %-8llu 等待 %9.3f ms  等待p99 <%-9llu 持有p99 <%llu ns",
+                     LOCK_SITE_NAMES[s], (unsigned long long)st.acquires,
+                     (unsigned long long)st.contended, st.waitNs / 1e6,
+                     (unsigned long long)HistPercentile(st.waitHist, 0.99),
+                     (unsigned long long)HistPercentile(st.holdHist, 0.99));
+            os << line << std::endl;
+        }
+    }
+}
+
+void LockProfileReset()
+{
+    std::lock_guard<std::mutex> guard(RegistryMutex());
+    for (ProfiledMutex *m = gMutexList; m; m = m->_nextMutex)
+    {
+        for (size_t s = 0; s < LOCK_SITE_COUNT; s++)
+            m->_stats[s] = LockSiteStats();
+    }
+}
+
+#else
+
+void LockProfileReport(std::ostream &os, size_t topN)
+{
+    (void)topN;
+    os << "锁竞争分析未开启，请以 -DHCMP_LOCK_PROFILE 重新编译" << std::endl;
+}
+
+void LockProfileReset()
+{
+}
+
+#endif
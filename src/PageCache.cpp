@@ -1,111 +1,149 @@
 /**
  * @file PageCache.cpp
- * @brief PageCacheʵ
- * @details ʵҳڴ䡢պҳϲ
+ * @brief PageCache类的实现
+ * @details 实现页缓存的内存分配、回收和页合并功能
  */
 
 #include "PageCache.h"
+#include <chrono>
 
-// 
+// 单例对象定义
 PageCache PageCache::_sInst;
 
 /**
- * @brief kҳڴ
- * @param k Ҫҳ
- * @return Spanָ
- * @details ԣ
- *          1. kҳֱӴϵͳ
- *          2. ӦͰSpanֱӷ
- *          3. ûУӸͰз
- *          4. ûУϵͳڴݹ
+ * @brief 单调时钟的毫秒数，用于空闲超大Span的年龄
+ */
+static uint64_t NowMs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 分配k页的连续内存
+ * @param k 需要分配的页数
+ * @return 分配的Span指针
+ * @details 分配策略：
+ *          1. 先归还超龄的空闲超大Span
+ *          2. k不超过128页时，通过非空桶位图找到第一个不小于k的非空桶，都为空时退到最佳适配树
+ *          3. k超过128页时，在最佳适配树中找不小于k页的最小空闲Span
+ *          4. 都没有则向系统申请：不超过128页时申请128页，否则恰好申请k页，新申请的页记为全零
+ *          5. 从找到的Span头部切出k页，剩余部分挂回桶或树
  */
 Span *PageCache::NewSpan(size_t k)
 {
+    HCMP_LATENCY_SCOPE(LAT_NEW_SPAN);
     assert(k > 0);
+    ++_stats.spanAllocs;
+    if (_largeTree.Count())
+        TrimLargeSpans();
+
+    Span *span = nullptr;
+    if (k <= MAX_PAGESIZE - 1)
+    {
+        // 优先从桶中取；小对象Span释放后会合并成超过128页的区域，桶中没有时切分它而不是向系统申请
+        size_t idx = _pageBitmap.FindFirst(k);
+        if (idx != _pageBitmap.npos)
+        {
+            span = PopSpan(idx);
+        }
+        else
+        {
+            span = _largeTree.BestFit(k);
+            if (span)
+                EraseSpan(span);
+        }
+    }
+    else
+    {
+        // 超大Span从已释放的超大区域中最佳适配
+        span = _largeTree.BestFit(k);
+        if (span)
+        {
+            EraseSpan(span);
+            ++_stats.largeCacheHits;
+        }
+    }
 
-    // ڴ룬ֱӴϵͳ
-    if (k > MAX_PAGESIZE - 1)
+    // 没有可用的空闲页，向系统申请
+    if (!span)
     {
-        void *ptr = SystemAlloc(k);
+        size_t npage = k > MAX_PAGESIZE - 1 ? k : MAX_PAGESIZE - 1;
+        void *ptr = SystemAlloc(npage);
+        ++_stats.systemAllocs;
+        _stats.systemBytes += npage << PAGE_SHIFT;
         // Span* span = new Span;
-        Span *span = _spanPool.New();
+        span = _spanPool.New();
         span->_pageId = (PAGE_ID)ptr >> PAGE_SHIFT;
-        span->_n = k;
-        _idSpanMap.insert(span->_pageId, span);
-
-        return span;
+        span->_n = npage;
+        span->_zeroed = true;
     }
 
-    // ӦͰǷпõSpan
-    if (!_pageList[k].empty())
+    Span *partSpan = CarveSpan(span, k);
+    if (k <= MAX_PAGESIZE - 1)
     {
-        Span *partSpan = _pageList[k].pop_front();
-
-        // ҳŵSpanӳϵںĵַ
+        // 建立页号到Span的映射关系，小块内存释放时按任意页号查找
         for (PAGE_ID i = 0; i < partSpan->_n; i++)
         {
             _idSpanMap.insert(partSpan->_pageId + i, partSpan);
         }
-        return partSpan;
     }
-
-    // ǰͰΪգӸͰзSpan
-    for (size_t i = k + 1; i < MAX_PAGESIZE; i++)
+    else
     {
-        if (!_pageList[i].empty())
-        {
-            // ӴSpanзֳkҳ
-            Span *span = _pageList[i].pop_front();
-            // Span* partSpan = new Span;
-            Span *partSpan = _spanPool.New();
-            // SpanǰkҳָpartSpan
-            partSpan->_pageId = span->_pageId;
-            partSpan->_n = k;
-            // ԭSpanϢʣಿ֣
-            span->_pageId += k;
-            span->_n -= k;
-
-            // ʣSpanŻضӦͰ
-            _pageList[span->_n].push_front(span);
-
-            // 洢ʣSpanβҳŵӳУϲ
-            _idSpanMap.insert(span->_pageId, span);
-            _idSpanMap.insert(span->_pageId + span->_n - 1, span);
-
-            // ·Spanҳӳϵ
-            for (PAGE_ID i = 0; i < partSpan->_n; i++)
-            {
-                _idSpanMap.insert(partSpan->_pageId + i, partSpan);
-            }
-
-            return partSpan;
-        }
+        // 超大Span只按首页释放，记录首尾页号供相邻Span合并时判断
+        _idSpanMap.insert(partSpan->_pageId, partSpan);
+        _idSpanMap.insert(partSpan->_pageId + partSpan->_n - 1, partSpan);
     }
+    return partSpan;
+}
+
+/**
+ * @brief 从空闲Span的头部切出k页
+ * @param span 空闲Span
+ * @param k 需要的页数
+ * @return 切出的Span
+ * @details 超大申请切剩不超过128页时整块交出，不把零头留在小桶里长期占用内存
+ */
+Span *PageCache::CarveSpan(Span *span, size_t k)
+{
+    assert(span->_n >= k);
+    if (span->_n == k)
+        return span;
+    if (k > MAX_PAGESIZE - 1 && span->_n - k <= MAX_PAGESIZE - 1)
+        return span;
 
-    // ͰΪգϵͳڴ
-    // Span* bigSpan = new Span;
-    Span *bigSpan = _spanPool.New();
+    // Span* partSpan = new Span;
+    Span *partSpan = _spanPool.New();
+    // 将大Span的前k页分给partSpan
+    partSpan->_pageId = span->_pageId;
+    partSpan->_n = k;
+    partSpan->_zeroed = span->_zeroed;
+    // 更新原Span的信息（剩余部分）
+    span->_pageId += k;
+    span->_n -= k;
 
-    void *ptr = SystemAlloc(MAX_PAGESIZE - 1); // 128ҳ
-    bigSpan->_pageId = (PAGE_ID)ptr >> PAGE_SHIFT;
-    bigSpan->_n = MAX_PAGESIZE - 1;
-    _pageList[bigSpan->_n].push_front(bigSpan);
+    // 将剩余的Span放回对应的桶或树中
+    PushSpan(span);
+    span->_isUse = false;
 
-    // ݹԼʱ϶ܳɹ
-    return NewSpan(k);
+    // 存储剩余Span的首尾页号到映射表中，方便后续合并查找
+    _idSpanMap.insert(span->_pageId, span);
+    _idSpanMap.insert(span->_pageId + span->_n - 1, span);
+
+    return partSpan;
 }
 
 /**
- * @brief ڴַӳ䵽ӦSpan
- * @param obj ڴָ
- * @return ӦSpanָ
- * @details ͨҳӳвҶӦSpan
- *          ڴʱȷSpanĹؼ
+ * @brief 根据内存地址映射到对应的Span
+ * @param obj 内存对象指针
+ * @return 对应的Span指针
+ * @details 通过页号在映射表中查找对应的Span，
+ *          这是内存回收时确定归属Span的关键方法
  */
 Span *PageCache::MapObjectToSpan(void *obj)
 {
     PAGE_ID id = (PAGE_ID)obj >> PAGE_SHIFT;
-    std::lock_guard<std::mutex> guard(_pageMtx);
+    std::lock_guard<PoolMutex> guard(_pageMtx);
     
     Span* span = _idSpanMap.lookup(id);
     if (span)
@@ -114,89 +152,234 @@ Span *PageCache::MapObjectToSpan(void *obj)
     }
     else
     {
-        assert(false); // ӦҲӦSpan
+        assert(false); // 不应该找不到对应的Span
         return nullptr;
     }
 }
 
+bool PageCache::OwnsPage(const void *ptr)
+{
+    std::lock_guard<PoolMutex> guard(_pageMtx);
+    Span *span = _idSpanMap.lookup((PAGE_ID)ptr >> PAGE_SHIFT);
+    return span && span->_isUse;
+}
+
+void PageCache::SetSpanClass(Span *span)
+{
+    size_t size = span->_objSize;
+    if (size == 0 || size > MAX_MEMORYSIZE || SizeClass::RoundUp(size) != size)
+        return;
+    size_t index = SizeClass::Index(size);
+    if (SizeClass::RoundUp(SizeClass::ClassSize(index)) != size)
+        return;
+    _classMap.Set(span->_pageId, span->_n, (uint8_t)(index + 1));
+}
+
+Span *PageCache::MapObjectToSpanLocked(void *obj)
+{
+    Span *span = _idSpanMap.lookup((PAGE_ID)obj >> PAGE_SHIFT);
+    assert(span); // 不应该找不到对应的Span
+    return span;
+}
+
 /**
- * @brief ͷSpanPageCacheԺϲҳ
- * @param span ҪͷŵSpanָ
- * @details ͷ̣
- *          1. ǳSpanֱͷŸϵͳ
- *          2. ǰϲڵĿҳ
- *          3. ϲڵĿҳ
- *          4. ϲSpanӦͰ
- *          5. ҳӳ
+ * @brief 释放Span回PageCache，并尝试合并相邻页
+ * @param span 要释放的Span指针
+ * @details 释放流程：
+ *          1. 尝试向前合并相邻的空闲页
+ *          2. 尝试向后合并相邻的空闲页，合并没有页数上限；交出过的页不再是全零，合并后也不是
+ *          3. 将合并后的Span放入对应的桶中，超过128页的放入最佳适配树
+ *          4. 更新页号映射表
+ *          5. 空闲超大Span超龄或超过上限时归还系统
  */
 void PageCache::ReleaseSpanToPageCache(Span *span)
 {
+    HCMP_LATENCY_SCOPE(LAT_RELEASE_SPAN);
     assert(span);
-    
-    // SpanֱͷŸϵͳ
-    if (span->_n > MAX_PAGESIZE - 1)
-    {
-        void *ptr = (void *)(span->_pageId << PAGE_SHIFT);
-        SystemFree(ptr);
-        _spanPool.Delete(span);
-        return;
-    }
+    span->_isArena = false; // 归还后不再属于任何Arena
+    span->_zeroed = false;  // 页已交出过，内容未知
+
+    // 小对象Span的页不再属于任何尺寸类
+    if (_classMap.Get(span->_pageId))
+        _classMap.Clear(span->_pageId, span->_n);
 
-    // ǰϲڵĿҳڴƬ
+    // 向前合并相邻的空闲页，减少内存碎片
     while (1)
     {
         PAGE_ID prevId = span->_pageId - 1;
         Span *prevSpan = _idSpanMap.lookup(prevId);
 
         if (!prevSpan)
-            break; // ûҵǰһҳϲ
+            break; // 没有找到前一个页，结束合并
         if (prevSpan->_isUse)
-            break; // ǰһҳʹУܺϲ
-        if (prevSpan->_n + span->_n > MAX_PAGESIZE - 1)
-            break; // ϲᳬҳ
+            break; // 前一个页正在使用中，不能合并
 
-        // ִǰϲ
+        // 从对应桶或树中移除被合并的Span
+        EraseSpan(prevSpan);
+
+        // 执行向前合并
         span->_pageId = prevSpan->_pageId;
         span->_n += prevSpan->_n;
 
-        // ӻɾϲSpanӳ
+        // 从基数树中删除被合并Span的映射
         _idSpanMap.remove(prevSpan->_pageId);
         _idSpanMap.remove(prevSpan->_pageId + prevSpan->_n - 1);
 
-        // ӶӦͰƳϲSpan
-        _pageList[prevSpan->_n].erase(prevSpan);
         _spanPool.Delete(prevSpan);
     }
 
-    // ϲڵĿҳ
+    // 向后合并相邻的空闲页
     while (1)
     {
         PAGE_ID nextId = span->_pageId + span->_n;
         Span *nextSpan = _idSpanMap.lookup(nextId);
         if (!nextSpan)
-            break; // ûҵһҳϲ
+            break; // 没有找到后一个页，结束合并
         if (nextSpan->_isUse)
-            break; // һҳʹУܺϲ
-        if (nextSpan->_n + span->_n > MAX_PAGESIZE - 1)
-            break; // ϲᳬҳ
+            break; // 后一个页正在使用中，不能合并
+
+        // 从对应桶或树中移除被合并的Span
+        EraseSpan(nextSpan);
 
-        // ִϲ
+        // 执行向后合并
         span->_n += nextSpan->_n;
         
-        // ӻɾϲSpanӳ
+        // 从基数树中删除被合并Span的映射
         _idSpanMap.remove(nextSpan->_pageId);
         _idSpanMap.remove(nextSpan->_pageId + nextSpan->_n - 1);
-        
-        // ӶӦͰƳϲSpan
-        _pageList[nextSpan->_n].erase(nextSpan);
+
         _spanPool.Delete(nextSpan);
     }
 
-    // ϲSpanӦͰ
-    _pageList[span->_n].push_front(span);
-    span->_isUse = false; // Ϊδʹ״̬
+    // 将合并后的Span放入对应的桶或树中
+    PushSpan(span);
+    span->_isUse = false; // 标记为未使用状态
     
-    // ҳӳֻҪ洢βҳţ
+    // 更新页号映射表（只需要存储首尾页号）
     _idSpanMap.insert(span->_pageId, span);
     _idSpanMap.insert(span->_pageId + span->_n - 1, span);
+
+    if (_largeTree.Count())
+        TrimLargeSpans();
+}
+
+/**
+ * @brief 将空闲Span归还系统
+ * @param span 要归还的Span
+ * @details 清除该区间内所有页号映射，避免相邻Span合并时查到已释放的Span；
+ *          释放区间可能跨越多次SystemAlloc的边界，由SystemFree按页处理
+ */
+void PageCache::ReleaseSpanToSystem(Span *span)
+{
+    for (PAGE_ID i = 0; i < span->_n; i++)
+    {
+        _idSpanMap.remove(span->_pageId + i);
+    }
+
+    void *ptr = (void *)(span->_pageId << PAGE_SHIFT);
+    SystemFree(ptr, span->_n);
+    ++_stats.systemFrees;
+    _stats.systemBytes -= span->_n << PAGE_SHIFT;
+    _spanPool.Delete(span);
+}
+
+/**
+ * @brief 归还超龄的空闲超大Span，超过字节上限时再从最小的开始归还系统
+ * @details 挂入树后LARGE_CACHE_MAX_AGE_MS内未被复用的Span归还系统，空闲的进程不会一直占着上限内的内存；
+ *          _largeExpire未到时不遍历树。超出上限时小的空闲区间最难满足后续的超大申请，优先归还；
+ *          大的保留下来供最佳适配切分
+ */
+void PageCache::TrimLargeSpans()
+{
+    uint64_t now = NowMs();
+    if (now >= _largeExpire)
+    {
+        Span *oldest = _largeTree.Oldest();
+        while (oldest && now - oldest->_freeTime >= LARGE_CACHE_MAX_AGE_MS)
+        {
+            EraseSpan(oldest);
+            ReleaseSpanToSystem(oldest);
+            oldest = _largeTree.Oldest();
+        }
+        _largeExpire = oldest ? oldest->_freeTime + LARGE_CACHE_MAX_AGE_MS : UINT64_MAX;
+    }
+
+    while (_largeTree.Bytes() > _largeLimit)
+    {
+        Span *victim = _largeTree.BestFit(0);
+        EraseSpan(victim);
+        ReleaseSpanToSystem(victim);
+    }
+}
+
+/**
+ * @brief 设置空闲超大Span保留的总字节上限
+ * @param bytes 字节数，0表示不保留
+ * @details 调小上限时立即归还超出的部分
+ */
+void PageCache::SetLargeCacheLimit(size_t bytes)
+{
+    std::lock_guard<PoolMutex> guard(_pageMtx);
+    _largeLimit = bytes;
+    TuneSet(TUNE_LARGE_CACHE_BYTES, bytes);
+    TrimLargeSpans();
+}
+
+/**
+ * @brief 获取与系统交互的统计信息
+ * @return 统计信息的拷贝
+ */
+PageCacheStats PageCache::GetStats()
+{
+    std::lock_guard<PoolMutex> guard(_pageMtx);
+    PageCacheStats stats = _stats;
+    stats.largeCacheBytes = _largeTree.Bytes();
+    return stats;
+}
+
+/**
+ * @brief 将空闲Span挂入与其页数对应的桶并置位位图，超过128页的放入最佳适配树
+ * @param span 要挂入的Span
+ * @details 放入树时记下时间，切分后挂回的剩余部分也重新计时
+ */
+void PageCache::PushSpan(Span *span)
+{
+    if (span->_n > MAX_PAGESIZE - 1)
+    {
+        span->_freeTime = NowMs();
+        _largeExpire = std::min(_largeExpire, span->_freeTime + LARGE_CACHE_MAX_AGE_MS);
+        _largeTree.Insert(span);
+        return;
+    }
+    _pageList[span->_n].push_front(span);
+    _pageBitmap.Set(span->_n);
+}
+
+/**
+ * @brief 从k号桶弹出一个Span，桶变空时清位
+ * @param k 桶下标（页数）
+ * @return 弹出的Span
+ */
+Span *PageCache::PopSpan(size_t k)
+{
+    Span *span = _pageList[k].pop_front();
+    if (_pageList[k].empty())
+        _pageBitmap.Clear(k);
+    return span;
+}
+
+/**
+ * @brief 将空闲Span从其所在的桶（桶变空时清位）或最佳适配树中摘除
+ * @param span 要摘除的Span
+ */
+void PageCache::EraseSpan(Span *span)
+{
+    if (span->_n > MAX_PAGESIZE - 1)
+    {
+        _largeTree.Erase(span);
+        return;
+    }
+    _pageList[span->_n].erase(span);
+    if (_pageList[span->_n].empty())
+        _pageBitmap.Clear(span->_n);
 }
\ No newline at end of file
@@ -1,105 +1,239 @@
 /**
  * @file ThreadCache.cpp
- * @brief ThreadCacheʵ
- * @details ʵ̱߳ڴ滺ķ䡢ͷź뻺Ľ
+ * @brief ThreadCache类的实现
+ * @details 实现线程本地内存缓存的分配、释放和与中央缓存的交互
  */
 
 #include "ThreadCache.h"
 #include "CentralCache.h"
+#include "DeferredFree.h"
 
 /**
- * @brief CentralCacheȡڴ
- * @param index Ͱ
- * @param size С
- * @return ȡڴָ
- * @details ʹ㷨̬ȡ
- *          ڴЧʲ
+ * @brief 从CentralCache中批量获取内存对象
+ * @param index 桶索引
+ * @param size 对象大小
+ * @return 获取到的内存对象指针
+ * @details 使用慢启动反馈调节算法动态调整批量获取数量，
+ *          提高内存分配效率并减少锁竞争
  */
 void *ThreadCache::FetchFromCentralCache(size_t index, size_t size)
 {
-	// 㷨̬ȡ
-	size_t batchNum = std::min(SizeClass::NumMoveSize(size), _freeList[index].maxSize());
-	if (_freeList[index].maxSize() == batchNum)
-		_freeList[index].maxSize() += 2; // 
+	return FetchFromCentralCache(index, size, SizeClass::NumMoveSize(size));
+}
+
+/**
+ * @brief 从CentralCache中批量获取内存对象
+ * @param index 桶索引
+ * @param size 对象大小
+ * @param numMove 一次最多获取的对象数量
+ * @return 获取到的内存对象指针
+ */
+void *ThreadCache::FetchFromCentralCache(size_t index, size_t size, size_t numMove)
+{
+	HCMP_LATENCY_SCOPE(LAT_TC_FETCH);
+
+	// 只有桶为空时才会来取，此时剩余容量等于慢启动上限，可以直接调整上限：
+	// 第一次获取时提高到slow_start_init，调小批量上限后收回到新的批量附近
+	size_t step = TuneGet(TUNE_SLOW_START_STEP);
+	size_t init = TuneGet(TUNE_SLOW_START_INIT);
+	size_t cap = std::max(numMove + step, init);
+	if (_maxSize[index] < init || _maxSize[index] > cap)
+	{
+		size_t target = _maxSize[index] < init ? init : cap;
+		if (_maxSize[index] > target)
+			_grownBytes -= std::min(_grownBytes, (_maxSize[index] - target) * size);
+		_maxSize[index] = (uint32_t)target;
+		_room[index] = (uint32_t)target;
+	}
 
+	// 慢启动反馈调节算法：动态调整批量获取数量，设置了线程缓存预算时增长总量不超过预算
+	size_t batchNum = std::min(numMove, (size_t)_maxSize[index]);
+	size_t budget = TuneGet(TUNE_THREAD_CACHE_BYTES);
+	if (_maxSize[index] == batchNum && (budget == 0 || _grownBytes + step * size <= budget))
+	{
+		_maxSize[index] += (uint32_t)step; // 逐步增加批量数量
+		_room[index] += (uint32_t)step;
+		_grownBytes += step * size;
+	}
+
+#ifdef HCMP_MAGAZINE
+	// magazine按本桶慢启动上限的最大值一次分配好，批次缓存中的批次也可能多出两个对象
+	size_t need = std::max((size_t)_maxSize[index], batchNum + 2);
+	if (need > _capacity[index])
+		GrowMagazine(index, std::max(need, numMove + step));
+
+	// 取到的对象直接放进magazine，返回最后一个，其余留在桶中
+	assert(_lengths[index] == 0);
+	CentralCache *cc = CentralCache::GetInstance();
+	size_t actualNum = cc->FetchRangeObj(_mags[index], batchNum, size);
+	assert(actualNum > 0 && actualNum <= _capacity[index]);
+	if (actualNum > _room[index])
+	{
+		// 批次缓存中的批次可能来自参数调整之前，放不下的对象还给Span
+		cc->ReleaseArrayToSpan(_mags[index] + _room[index], actualNum - _room[index], size);
+		actualNum = _room[index];
+	}
+	_lengths[index] = (uint32_t)(actualNum - 1);
+	_room[index] -= (uint32_t)(actualNum - 1);
+	return _mags[index][actualNum - 1];
+#else
 	void *start = nullptr, *end = nullptr;
-	size_t actualNum = CentralCache::GetInstance()->FetchRangeObj(start, end, batchNum, size);
+	CentralCache *cc = CentralCache::GetInstance();
+	size_t actualNum = cc->FetchRangeObj(start, end, batchNum, size);
 	assert(actualNum > 0);
+	if (actualNum > _room[index])
+	{
+		// 批次缓存中的批次可能来自参数调整之前，放不下的对象还给Span
+		end = start;
+		for (size_t i = 1; i < _room[index]; i++)
+			end = NextObj(end);
+		void *rest = NextObj(end);
+		NextObj(end) = nullptr;
+		cc->ReleaseListToSpan(rest, size);
+		actualNum = _room[index];
+	}
 
 	if (actualNum == 1)
 	{
-		// ֻȡһֱӷ
+		// 只获取到一个对象，直接返回
 		assert(start == end);
 		return start;
 	}
 	else
 	{
-		// ȡ󣬽һ
-		_freeList[index].PushRange(NextObj(start), end, actualNum - 1);
+		// 获取到多个对象，将除第一个外的其他对象加入自由链表
+		// 只有链表为空时才会来取，取到的对象数不超过上限，剩余容量不会减到0
+		assert(_heads[index] == nullptr && _room[index] > actualNum - 1);
+		NextObj(end) = nullptr;
+		_heads[index] = NextObj(start);
+		_room[index] -= (uint32_t)(actualNum - 1);
 		return start;
 	}
+#endif
 }
 
+#ifdef HCMP_MAGAZINE
+// 每次为magazine申请的内存块页数
+static const size_t MAGAZINE_CHUNK_PAGES = 8;
+
+/**
+ * @brief 为桶分配magazine
+ * @param index 桶索引
+ * @param capacity magazine能容纳的指针数
+ * @details magazine从SystemAlloc得到的内存块中顺序切出，不经过内存池自身，避免递归；
+ *          ThreadCache常驻，magazine也不归还
+ */
+void ThreadCache::GrowMagazine(size_t index, size_t capacity)
+{
+	assert(_lengths[index] == 0);
+	size_t bytes = capacity * sizeof(void *);
+	if (bytes > _magLeft)
+	{
+		size_t kpage = std::max(MAGAZINE_CHUNK_PAGES, (bytes >> PAGE_SHIFT) + 1);
+		_magMemory = (char *)SystemAlloc(kpage);
+		_magLeft = kpage << PAGE_SHIFT;
+	}
+	_mags[index] = (void **)_magMemory;
+	_magMemory += bytes;
+	_magLeft -= bytes;
+	_capacity[index] = (uint32_t)capacity;
+}
+#endif
+
 /**
- * @brief ָ̻߳Сڴ
- * @param size ҪڴС
- * @return ڴָ
- * @details ̣
- *          1. С϶뵽ʵı߽
- *          2. ӦͰ
- *          3. Ͱпжֱӷ
- *          4. CentralCacheȡ
+ * @brief 从线程缓存分配指定大小的内存
+ * @param size 需要分配的内存大小
+ * @return 分配的内存指针
+ * @details 分配流程：
+ *          1. 将大小向上对齐到合适的边界
+ *          2. 计算对应的桶索引
+ *          3. 如果桶中有空闲对象则直接返回
+ *          4. 否则从CentralCache批量获取对象
  */
 void *ThreadCache::Allocate(size_t size)
 {
-	assert(size < MAX_MEMORYSIZE);
+	assert(size <= MAX_MEMORYSIZE);
 	size_t alignSize = SizeClass::RoundUp(size);
 	size_t freeListPos = SizeClass::Index(size);
 	
-	if (!_freeList[freeListPos].isEmpty())
+	// 桶中有空闲对象，直接分配
+	void *obj = PopLocal(freeListPos);
+	if (obj)
 	{
-		// Ͱпжֱӷ
-		return _freeList[freeListPos].pop();
+		return obj;
 	}
 	else
 	{
-		// ͰΪգCentralCacheȡ
+		// 桶为空，从CentralCache获取对象
 		return FetchFromCentralCache(freeListPos, alignSize);
 	}
 }
 
 /**
- * @brief 黹ڴ浽̻߳
- * @param ptr Ҫ黹ڴָ
- * @param size ڴС
- * @details 黹̣
- *          1. ӦͰ
- *          2. ڴӦ
- *          3. ȣ黹ָCentralCache
+ * @brief 归还内存到线程缓存
+ * @param ptr 要归还的内存指针
+ * @param size 内存块大小
+ * @details 归还流程：
+ *          1. 计算对应的桶索引
+ *          2. 将内存块加入对应的自由链表
+ *          3. 检查链表长度，如果过长则归还部分给CentralCache
  */
 void ThreadCache::Deallocate(void *ptr, size_t size)
 {
-	assert(size < MAX_MEMORYSIZE);
+	assert(size <= MAX_MEMORYSIZE);
 	size_t freeListPos = SizeClass::Index(size);
-	_freeList[freeListPos].push(ptr);
 
-	// ȴﵽֵʱ黹һCentralCache
-	// Աⵥ߳ռùڴ棬ڴ̼߳ƽֲ
-	if (_freeList[freeListPos].size() >= _freeList[freeListPos].maxSize())
+	// 当链表长度达到批量传输阈值时，归还一批给CentralCache
+	// 这样可以避免单个线程占用过多内存，保持内存在线程间的平衡分布
+	if (PushLocal(freeListPos, ptr))
 	{
-		ListTooLong(_freeList[freeListPos], size);
+		ListTooLong(freeListPos, size);
 	}
 }
 
 /**
- * @brief 
- * @param list 
- * @param size С
- * @details һ黹CentralCacheThreadCacheڴռ
+ * @brief 处理自由链表过长的情况
+ * @param index 过长的自由链表所在的桶索引
+ * @param size 对象大小
+ * @details 链表长度达到慢启动上限时，整条链表作为一批归还给CentralCache，减少ThreadCache的内存占用；
+ *          开启延迟释放时，无锁批次缓存放不下的批次交给回收线程，不在当前线程加锁
  */
-void ThreadCache::ListTooLong(FreeList &list, size_t size)
+void ThreadCache::ListTooLong(size_t index, size_t size)
 {
-	void *start = nullptr, *end = nullptr;
-	list.PopRange(start, end, list.maxSize());
-	CentralCache::GetInstance()->ReleaseListToSpan(start, size);
+	HCMP_LATENCY_SCOPE(LAT_LIST_TOO_LONG);
+	size_t n = _maxSize[index];
+	_room[index] = _maxSize[index];
+	CentralCache *cc = CentralCache::GetInstance();
+
+#ifdef HCMP_MAGAZINE
+	// 整个magazine作为一批交出，不需要沿链表寻找批次尾
+	void **objs = _mags[index];
+	assert(_lengths[index] == n);
+	_lengths[index] = 0;
+	if (!_deferFree)
+	{
+		cc->InsertRange(objs, n, size);
+		return;
+	}
+
+	// 批次缓存和回收队列保存的是链表
+	void *start = LinkObjects(objs, n);
+	void *end = objs[n - 1];
+#else
+	void *start = _heads[index];
+	void *end = start;
+	for (size_t i = 0; i < n - 1; i++)
+		end = NextObj(end);
+	assert(NextObj(end) == nullptr);
+	_heads[index] = nullptr;
+	if (!_deferFree)
+	{
+		cc->InsertRange(start, end, n, size);
+		return;
+	}
+#endif
+
+	if (cc->InsertTransfer(start, end, n, size) || DeferredFree::GetInstance()->PushList(start, n, size))
+		return;
+	cc->ReleaseListToSpan(start, size); // 回收队列超过上限，同步归还
 }
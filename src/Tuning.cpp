@@ -0,0 +1,173 @@
+/**
+ * @file Tuning.cpp
+ * @brief 运行参数的实现
+ * @details 参数表、环境变量解析、范围检查和报告输出
+ */
+
+#include "Tuning.h"
+#include "PageCache.h"
+#include "DeferredFree.h"
+#include "TransferCache.h"
+#include <cerrno>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const size_t TUNE_BATCH_LIMIT = 4096;   // 批量与慢启动参数的上限，magazine按此规模分配
+
+static constexpr TuneInfo TUNE_TABLE[TUNE_COUNT] = {
+    {"batch_min", "HCMP_BATCH_MIN", 2, 1, TUNE_BATCH_LIMIT, true,
+     "一批对象数的下限"},
+    {"batch_max", "HCMP_BATCH_MAX", 512, 1, TUNE_BATCH_LIMIT, true,
+     "一批对象数的上限"},
+    {"slow_start_init", "HCMP_SLOW_START_INIT", 1, 1, TUNE_BATCH_LIMIT, true,
+     "新线程各桶慢启动上限的初始值"},
+    {"slow_start_step", "HCMP_SLOW_START_STEP", 2, 1, TUNE_BATCH_LIMIT, true,
+     "慢启动上限每次的增量"},
+    {"thread_cache_bytes", "HCMP_THREAD_CACHE_BYTES", 0, 0, SIZE_MAX, true,
+     "每线程慢启动扩容的字节预算，0为不限"},
+    {"large_cache_bytes", "HCMP_LARGE_CACHE_BYTES", LARGE_CACHE_MAX_BYTES, 0, SIZE_MAX, true,
+     "空闲超大Span保留的字节上限"},
+    {"deferred_free_bytes", "HCMP_DEFERRED_FREE_BYTES", DEFERRED_FREE_MAX_BYTES, 0, SIZE_MAX, true,
+     "延迟释放待回收字节数的上限"},
+    {"transfer_cache", "HCMP_TRANSFER_CACHE", 1, 0, 1, true,
+     "是否开启无锁批次缓存"},
+    {"transfer_cache_bytes", "HCMP_TRANSFER_CACHE_BYTES", TRANSFER_MAX_BYTES, 0, SIZE_MAX, true,
+     "每个尺寸类批次缓存的字节上限"},
+    {"empty_span_max", "HCMP_EMPTY_SPAN_MAX", 8, 0, 64, true,
+     "每个尺寸类最多保留的空Span数，0为不保留"},
+    {"empty_span_idle_ms", "HCMP_EMPTY_SPAN_IDLE_MS", 1000, 1, 3600 * 1000, true,
+     "尺寸类空闲多久后归还保留的空Span（毫秒）"},
+    {"empty_span_bytes", "HCMP_EMPTY_SPAN_BYTES", 16 * 1024 * 1024, 0, SIZE_MAX, true,
+     "所有尺寸类保留的空Span合计的字节上限，0为不保留"},
+    {"calloc_decommit_bytes", "HCMP_CALLOC_DECOMMIT_BYTES", 32 * 1024 * 1024, 0, SIZE_MAX, true,
+     "清零的旧页不少于该字节数时丢弃页内容代替memset"},
+};
+
+std::atomic<size_t> gTuneValues[TUNE_COUNT] = {
+    {TUNE_TABLE[TUNE_BATCH_MIN].def},
+    {TUNE_TABLE[TUNE_BATCH_MAX].def},
+    {TUNE_TABLE[TUNE_SLOW_START_INIT].def},
+    {TUNE_TABLE[TUNE_SLOW_START_STEP].def},
+    {TUNE_TABLE[TUNE_THREAD_CACHE_BYTES].def},
+    {TUNE_TABLE[TUNE_LARGE_CACHE_BYTES].def},
+    {TUNE_TABLE[TUNE_DEFERRED_FREE_BYTES].def},
+    {TUNE_TABLE[TUNE_TRANSFER_CACHE].def},
+    {TUNE_TABLE[TUNE_TRANSFER_CACHE_BYTES].def},
+    {TUNE_TABLE[TUNE_EMPTY_SPAN_MAX].def},
+    {TUNE_TABLE[TUNE_EMPTY_SPAN_IDLE_MS].def},
+    {TUNE_TABLE[TUNE_EMPTY_SPAN_BYTES].def},
+    {TUNE_TABLE[TUNE_CALLOC_DECOMMIT_BYTES].def},
+};
+
+/**
+ * @brief 解析十进制数，可带K/M/G后缀（按1024进位）
+ * @return 格式错误或溢出时返回false
+ */
+static bool ParseSize(const char *str, size_t &value)
+{
+    if (!isdigit((unsigned char)str[0]))
+        return false;
+    errno = 0;
+    char *end = nullptr;
+    unsigned long long v = strtoull(str, &end, 10);
+    if (errno != 0)
+        return false;
+
+    unsigned shift = 0;
+    switch (*end)
+    {
+    case 'k': case 'K': shift = 10; ++end; break;
+    case 'm': case 'M': shift = 20; ++end; break;
+    case 'g': case 'G': shift = 30; ++end; break;
+    default: break;
+    }
+    if (*end != '\0' || (shift && (v >> (64 - shift)) != 0))
+        return false;
+    value = (size_t)(v << shift);
+    return true;
+}
+
+static bool InRange(TuneParam param, size_t value)
+{
+    return value >= TUNE_TABLE[param].min && value <= TUNE_TABLE[param].max;
+}
+
+static bool LoadEnv()
+{
+    for (size_t i = 0; i < TUNE_COUNT; i++)
+    {
+        const TuneInfo &info = TUNE_TABLE[i];
+        const char *str = getenv(info.env);
+        if (str == nullptr)
+            continue;
+        size_t value = 0;
+        if (!ParseSize(str, value) || !InRange((TuneParam)i, value))
+        {
+            fprintf(stderr, "hcmp: 忽略无效的 %s=%s（范围 %zu~%zu）\n", info.env, str, info.min, info.max);
+            continue;
+        }
+        gTuneValues[i].store(value, std::memory_order_relaxed);
+    }
+
+    if (TuneGet(TUNE_BATCH_MIN) > TuneGet(TUNE_BATCH_MAX))
+    {
+        fprintf(stderr, "hcmp: %s 大于 %s，两者恢复默认值\n",
+                TUNE_TABLE[TUNE_BATCH_MIN].env, TUNE_TABLE[TUNE_BATCH_MAX].env);
+        gTuneValues[TUNE_BATCH_MIN].store(TUNE_TABLE[TUNE_BATCH_MIN].def, std::memory_order_relaxed);
+        gTuneValues[TUNE_BATCH_MAX].store(TUNE_TABLE[TUNE_BATCH_MAX].def, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void TuneInit()
+{
+    static bool loaded = LoadEnv();
+    (void)loaded;
+}
+
+const TuneInfo &TuneDescribe(TuneParam param)
+{
+    return TUNE_TABLE[param];
+}
+
+TuneParam TuneFind(const char *name)
+{
+    for (size_t i = 0; i < TUNE_COUNT; i++)
+    {
+        if (strcmp(TUNE_TABLE[i].name, name) == 0)
+            return (TuneParam)i;
+    }
+    return TUNE_COUNT;
+}
+
+int TuneSet(TuneParam param, size_t value)
+{
+    if (!TUNE_TABLE[param].writable)
+        return EPERM;
+    if (!InRange(param, value))
+        return EINVAL;
+    if (param == TUNE_BATCH_MIN && value > TuneGet(TUNE_BATCH_MAX))
+        return EINVAL;
+    if (param == TUNE_BATCH_MAX && value < TuneGet(TUNE_BATCH_MIN))
+        return EINVAL;
+    gTuneValues[param].store(value, std::memory_order_relaxed);
+    return 0;
+}
+
+void TuneReport(std::ostream &os)
+{
+    TuneInit();
+    char line[256];
+    os << "==== 运行参数 ====" << std::endl;
+    snprintf(line, sizeof(line), "  %-22s %14s %14s  %-26s %s", "name", "value", "default", "env", "");
+    os << line << std::endl;
+    for (size_t i = 0; i < TUNE_COUNT; i++)
+    {
+        const TuneInfo &info = TUNE_TABLE[i];
+        snprintf(line, sizeof(line), "  %-22s %14zu %14zu  %-26s %s", info.name, TuneGet((TuneParam)i),
+                 info.def, info.env, info.desc);
+        os << line << std::endl;
+    }
+}
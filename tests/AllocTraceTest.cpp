@@ -0,0 +1,385 @@
+/**
+ * @file AllocTraceTest.cpp
+ * @brief 申请/释放轨迹记录测试程序
+ * @details 以-DHCMP_TRACE编译。验证轨迹文件的文件头、记录条数、槽位分配与复用、跨线程释放的配对、
+ *          线程内的时间顺序，以及开始记录前申请的对象的释放被丢弃；测量开启记录时每对申请/释放的额外开销，
+ *          最后录制一段多线程负载写到build/alloc_trace.bin，供tests/TraceReplay.cpp重放
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cassert>
+#include <cstdio>
+
+using namespace std;
+using namespace std::chrono;
+
+static const char* TMP_TRACE = "/tmp/hcmp_alloc_trace_test.bin";
+static const char* SAMPLE_TRACE = "build/alloc_trace.bin";
+
+/**
+ * @brief 读回轨迹文件
+ */
+static bool ReadTrace(const char* path, TraceFileHeader& header, vector<TraceRecord>& records) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1;
+    if (ok) {
+        records.resize(header.records);
+        ok = header.records == 0 || fread(records.data(), sizeof(TraceRecord), records.size(), fp) == records.size();
+    }
+    fclose(fp);
+    return ok;
+}
+
+/**
+ * @brief 通用检查：文件头有效，槽位和线程号在范围内，同一槽位申请与释放交替且大小一致，线程内时间不减
+ */
+static void CheckTrace(const TraceFileHeader& header, const vector<TraceRecord>& records) {
+    assert(memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) == 0);
+    assert(header.version == TRACE_VERSION);
+    assert(header.records == records.size());
+
+    vector<uint64_t> slotSize(header.slots, 0);
+    vector<bool> slotLive(header.slots, false);
+    vector<uint64_t> lastTime(header.threads, 0);
+    uint64_t prevTime = 0;
+    for (const TraceRecord& r : records) {
+        assert(r.slot < header.slots);
+        assert(r.thread < header.threads);
+        assert(r.time >= prevTime);
+        assert(r.time >= lastTime[r.thread]);
+        prevTime = r.time;
+        lastTime[r.thread] = r.time;
+        if (r.op == TRACE_ALLOC) {
+            assert(!slotLive[r.slot]);
+            slotLive[r.slot] = true;
+            slotSize[r.slot] = r.size;
+        } else {
+            assert(r.op == TRACE_FREE);
+            assert(slotLive[r.slot]);
+            assert(slotSize[r.slot] == r.size);
+            slotLive[r.slot] = false;
+        }
+    }
+}
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 单线程：各种大小的申请与释放全部记录，停止记录后不再增加
+ */
+void testSingleThread() {
+    cout << "=== 单线程记录测试 ===" << endl;
+
+    size_t sizes[] = {24, 100, 5000, 300000};
+    const size_t n = sizeof(sizes) / sizeof(sizes[0]);
+    thread t([&]() {
+        AllocTraceStart();
+        void* ptrs[n];
+        for (size_t i = 0; i < n; i++) {
+            ptrs[i] = ConcurrencyAlloc(sizes[i]);
+        }
+        ConcurrencyFree(ptrs[0]);
+        ConcurrencyFree(ptrs[1], sizes[1]);
+        ConcurrencyFree(ptrs[2]);
+        ConcurrencyFree(ptrs[3], sizes[3]);
+        void* fixed = ConcurrencyAllocFixed<64>();
+        ConcurrencyFreeFixed<64>(fixed);
+        AllocTraceStop();
+        assert(AllocTraceCount() == 2 * n + 2);
+
+        // 停止后不再记录
+        ConcurrencyFree(ConcurrencyAlloc(64));
+        assert(AllocTraceCount() == 2 * n + 2);
+    });
+    t.join();
+
+    assert(AllocTraceDump(TMP_TRACE));
+    TraceFileHeader header;
+    vector<TraceRecord> records;
+    assert(ReadTrace(TMP_TRACE, header, records));
+    CheckTrace(header, records);
+    assert(header.threads == 1);
+    assert(header.records == 2 * n + 2);
+    assert(header.slots == n);
+    for (size_t i = 0; i < n; i++) {
+        assert(records[i].op == TRACE_ALLOC && records[i].slot == i && records[i].size == sizes[i]);
+        assert(records[n + i].op == TRACE_FREE && records[n + i].slot == i && records[n + i].size == sizes[i]);
+    }
+    // 所有对象释放后，定长对象复用最小的槽位
+    assert(records[2 * n].op == TRACE_ALLOC && records[2 * n].slot == 0 && records[2 * n].size == 64);
+    assert(records[2 * n + 1].op == TRACE_FREE && records[2 * n + 1].slot == 0);
+
+    cout << "单线程记录测试通过！" << endl;
+}
+
+/**
+ * @brief 多线程：生产者申请、消费者释放，线程号连续，所有释放都能配对到对应的申请
+ */
+void testCrossThread() {
+    cout << "=== 跨线程释放记录测试 ===" << endl;
+
+    const int producers = 4;
+    const size_t perThread = 20000;
+    vector<vector<void*>> objs(producers);
+
+    AllocTraceStart();
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            mt19937 rng(p);
+            for (size_t i = 0; i < perThread; i++) {
+                size_t size = 8 + rng() % 2048;
+                objs[p].push_back(ConcurrencyAlloc(size));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    threads.clear();
+    // 消费者释放下一个生产者的对象
+    for (int c = 0; c < producers; c++) {
+        threads.emplace_back([&, c]() {
+            for (void* ptr : objs[(c + 1) % producers]) {
+                ConcurrencyFree(ptr);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    AllocTraceStop();
+    assert(AllocTraceCount() == 2 * producers * perThread);
+
+    assert(AllocTraceDump(TMP_TRACE));
+    TraceFileHeader header;
+    vector<TraceRecord> records;
+    assert(ReadTrace(TMP_TRACE, header, records));
+    CheckTrace(header, records);
+    assert(header.threads == 2 * producers);
+    assert(header.records == 2 * producers * perThread);
+    assert(header.slots == producers * perThread);
+
+    // 生产者的线程号为0~3，只有申请；消费者为4~7，只有释放，且释放的都是其他线程申请的对象
+    vector<uint16_t> allocThread(header.slots);
+    for (const TraceRecord& r : records) {
+        if (r.op == TRACE_ALLOC) {
+            assert(r.thread < producers);
+            allocThread[r.slot] = r.thread;
+        } else {
+            assert(r.thread >= producers);
+            assert(allocThread[r.slot] != r.thread);
+        }
+    }
+
+    cout << "跨线程释放记录测试通过！" << endl;
+}
+
+/**
+ * @brief 开始记录前申请的对象，其释放记录在写出时被丢弃；重新开始记录会清空旧记录
+ */
+void testPreexisting() {
+    cout << "=== 记录前已存在对象测试 ===" << endl;
+
+    thread t([]() {
+        void* before = ConcurrencyAlloc(128);
+        AllocTraceStart();
+        assert(AllocTraceCount() == 0);
+        void* after = ConcurrencyAlloc(256);
+        ConcurrencyFree(before);
+        ConcurrencyFree(after);
+        AllocTraceStop();
+        assert(AllocTraceCount() == 3);
+    });
+    t.join();
+
+    assert(AllocTraceDump(TMP_TRACE));
+    TraceFileHeader header;
+    vector<TraceRecord> records;
+    assert(ReadTrace(TMP_TRACE, header, records));
+    CheckTrace(header, records);
+    assert(header.records == 2);
+    assert(header.slots == 1);
+    assert(records[0].op == TRACE_ALLOC && records[0].size == 256);
+    assert(records[1].op == TRACE_FREE && records[1].size == 256);
+
+    AllocTraceStart();
+    AllocTraceStop();
+    assert(AllocTraceCount() == 0);
+    assert(AllocTraceDump(TMP_TRACE));
+    assert(ReadTrace(TMP_TRACE, header, records));
+    assert(header.records == 0 && header.threads == 0 && header.slots == 0);
+
+    // 写不了的路径返回false
+    assert(!AllocTraceDump("/nonexistent-dir/trace.bin"));
+
+    remove(TMP_TRACE);
+    cout << "记录前已存在对象测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 单线程申请/释放count对，返回每对的纳秒数
+ */
+static double PairCost(size_t count, size_t size) {
+    vector<void*> ptrs(256);
+    auto t0 = steady_clock::now();
+    for (size_t i = 0; i < count; i += ptrs.size()) {
+        for (auto& p : ptrs) {
+            p = ConcurrencyAlloc(size);
+        }
+        for (auto& p : ptrs) {
+            ConcurrencyFree(p);
+        }
+    }
+    auto t1 = steady_clock::now();
+    return (double)duration_cast<nanoseconds>(t1 - t0).count() / count;
+}
+
+void benchmarkOverhead() {
+    cout << "=== 记录开销（ns/每对申请+释放） ===" << endl;
+
+    const size_t count = 1 << 20;
+    printf("  %-10s %10s %10s\n", "大小", "关闭", "开启");
+    size_t sizes[] = {16, 128, 1024};
+    for (size_t size : sizes) {
+        PairCost(count, size);   // 预热
+        double best[2] = {1e30, 1e30};
+        for (int r = 0; r < 3; r++) {
+            best[0] = min(best[0], PairCost(count, size));
+            AllocTraceStart();
+            best[1] = min(best[1], PairCost(count, size));
+            AllocTraceStop();
+        }
+        printf("  %-10zu %10.1f %10.1f\n", size, best[0], best[1]);
+    }
+
+    auto t0 = steady_clock::now();
+    bool ok = AllocTraceDump(TMP_TRACE);
+    auto t1 = steady_clock::now();
+    assert(ok);
+    printf("  写出%zu条记录耗时 %.1f ms\n", AllocTraceCount(), duration_cast<microseconds>(t1 - t0).count() / 1000.0);
+    remove(TMP_TRACE);
+}
+
+// ================================ 示例轨迹 ================================
+
+/**
+ * @brief 录制一段多线程负载：大小混合分布，存活对象窗口随机替换，约四分之一的对象交给下一个线程释放
+ */
+void recordSample() {
+    cout << "=== 录制示例轨迹 ===" << endl;
+
+    const int nthreads = 4;
+    const size_t ops = 100000;
+    const size_t window = 4096;
+    vector<mutex> inboxMtx(nthreads);
+    vector<vector<void*>> inbox(nthreads);
+
+    AllocTraceStart();
+    vector<thread> threads;
+    for (int t = 0; t < nthreads; t++) {
+        threads.emplace_back([&, t]() {
+            mt19937 rng(100 + t);
+            vector<void*> live(window, nullptr);
+            vector<void*> handoff;
+            for (size_t i = 0; i < ops; i++) {
+                unsigned r = rng() % 100;
+                size_t size;
+                if (r < 70) {
+                    size = 16 + rng() % 240;
+                } else if (r < 95) {
+                    size = 256 + rng() % 8000;
+                } else {
+                    size = 8192 + rng() % (256 * 1024);
+                }
+                void*& slot = live[rng() % window];
+                if (slot) {
+                    if (rng() % 4 == 0) {
+                        handoff.push_back(slot);
+                    } else {
+                        ConcurrencyFree(slot);
+                    }
+                }
+                slot = ConcurrencyAlloc(size);
+
+                if (handoff.size() == 64) {
+                    lock_guard<mutex> guard(inboxMtx[(t + 1) % nthreads]);
+                    auto& box = inbox[(t + 1) % nthreads];
+                    box.insert(box.end(), handoff.begin(), handoff.end());
+                    handoff.clear();
+                }
+                if (i % 256 == 0) {
+                    vector<void*> mine;
+                    {
+                        lock_guard<mutex> guard(inboxMtx[t]);
+                        mine.swap(inbox[t]);
+                    }
+                    for (void* p : mine) {
+                        ConcurrencyFree(p);
+                    }
+                }
+            }
+            for (void* p : live) {
+                if (p) {
+                    ConcurrencyFree(p);
+                }
+            }
+            for (void* p : handoff) {
+                ConcurrencyFree(p);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (auto& box : inbox) {
+        for (void* p : box) {
+            ConcurrencyFree(p);
+        }
+    }
+    AllocTraceStop();
+
+    if (AllocTraceDump(SAMPLE_TRACE)) {
+        TraceFileHeader header;
+        vector<TraceRecord> records;
+        assert(ReadTrace(SAMPLE_TRACE, header, records));
+        CheckTrace(header, records);
+        printf("  %s: %llu条记录, %u个线程, %llu个槽位\n", SAMPLE_TRACE, (unsigned long long)header.records,
+               header.threads, (unsigned long long)header.slots);
+        printf("  重放: ./build/replay %s\n", SAMPLE_TRACE);
+    } else {
+        printf("  无法写入%s（请在仓库根目录运行），跳过\n", SAMPLE_TRACE);
+    }
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "申请/释放轨迹记录测试开始..." << endl << endl;
+
+    testSingleThread();
+    cout << endl;
+
+    testCrossThread();
+    cout << endl;
+
+    testPreexisting();
+    cout << endl;
+
+    benchmarkOverhead();
+    cout << endl;
+
+    recordSample();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file AllocatorTest.cpp
+ * @brief 标准库分配器适配的测试程序
+ * @details 验证ConcurrencyAllocator、ConcurrencyMemoryResource的正确性，
+ *          并对比std::map/std::unordered_map在不同分配器下插入删除的性能
+ *          需要C++17（std::pmr）
+ */
+
+#include "ConcurrencyAllocator.h"
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 容器与智能指针基本功能测试
+ */
+void testAdapters() {
+    cout << "=== 适配器功能测试 ===" << endl;
+
+    vector<int, ConcurrencyAllocator<int>> v;
+    for (int i = 0; i < 100000; i++) {
+        v.push_back(i);
+    }
+    for (int i = 0; i < 100000; i++) {
+        assert(v[i] == i);
+    }
+
+    map<int, string, less<int>, ConcurrencyAllocator<pair<const int, string>>> m;
+    for (int i = 0; i < 1000; i++) {
+        m[i] = to_string(i);
+    }
+    assert(m.size() == 1000 && m[500] == "500");
+
+    auto up = ConcurrencyMakeUnique<pair<int, double>>(7, 3.5);
+    assert(up->first == 7 && up->second == 3.5);
+
+    auto sp = ConcurrencyMakeShared<string>(100, 'x');
+    assert(sp->size() == 100);
+
+    // pmr容器与对齐
+    pmr::vector<pmr::string> strs(GetConcurrencyResource());
+    for (int i = 0; i < 1000; i++) {
+        strs.emplace_back(to_string(i) + string(64, 'a'));
+    }
+    assert(strs[999].substr(0, 3) == "999");
+
+    for (size_t align = 8; align <= 4096; align <<= 1) {
+        void* p = GetConcurrencyResource()->allocate(24, align);
+        assert(((size_t)p & (align - 1)) == 0);
+        GetConcurrencyResource()->deallocate(p, 24, align);
+    }
+
+    cout << "适配器功能测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 插入删除交替的容器负载
+ * @param container 被测试的容器
+ * @param keys 键序列
+ * @param rounds 轮次
+ * @return 耗时（毫秒）
+ */
+template<class Container>
+long long churn(Container& container, const vector<int>& keys, size_t rounds) {
+    auto begin = high_resolution_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (int k : keys) {
+            container.emplace(k, k);
+        }
+        // 删除一半，再插回，模拟持续的节点分配和释放
+        for (size_t i = 0; i < keys.size(); i += 2) {
+            container.erase(keys[i]);
+        }
+        for (size_t i = 0; i < keys.size(); i += 2) {
+            container.emplace(keys[i], keys[i]);
+        }
+        container.clear();
+    }
+    auto end = high_resolution_clock::now();
+    return duration_cast<milliseconds>(end - begin).count();
+}
+
+/**
+ * @brief std::map / std::unordered_map在不同分配器下的性能对比
+ */
+void benchmarkContainers() {
+    cout << "=== 容器插入删除性能对比 ===" << endl;
+
+    const size_t N = 100000;
+    const size_t ROUNDS = 20;
+    vector<int> keys(N);
+    for (size_t i = 0; i < N; i++) {
+        keys[i] = (int)i;
+    }
+    shuffle(keys.begin(), keys.end(), mt19937(12345));
+
+    typedef pair<const int, int> Value;
+
+    {
+        map<int, int> m;
+        cout << "std::map + std::allocator:                  " << churn(m, keys, ROUNDS) << " ms" << endl;
+    }
+    {
+        map<int, int, less<int>, ConcurrencyAllocator<Value>> m;
+        cout << "std::map + ConcurrencyAllocator:            " << churn(m, keys, ROUNDS) << " ms" << endl;
+    }
+    {
+        pmr::unsynchronized_pool_resource pool;
+        pmr::map<int, int> m(&pool);
+        cout << "pmr::map + unsynchronized_pool_resource:    " << churn(m, keys, ROUNDS) << " ms" << endl;
+    }
+    {
+        pmr::map<int, int> m(GetConcurrencyResource());
+        cout << "pmr::map + ConcurrencyMemoryResource:       " << churn(m, keys, ROUNDS) << " ms" << endl;
+    }
+
+    {
+        unordered_map<int, int> m;
+        cout << "std::unordered_map + std::allocator:        " << churn(m, keys, ROUNDS) << " ms" << endl;
+    }
+    {
+        unordered_map<int, int, hash<int>, equal_to<int>, ConcurrencyAllocator<Value>> m;
+        cout << "std::unordered_map + ConcurrencyAllocator:  " << churn(m, keys, ROUNDS) << " ms" << endl;
+    }
+    {
+        pmr::unsynchronized_pool_resource pool;
+        pmr::unordered_map<int, int> m(&pool);
+        cout << "pmr::unordered_map + unsynchronized_pool:   " << churn(m, keys, ROUNDS) << " ms" << endl;
+    }
+    {
+        pmr::unordered_map<int, int> m(GetConcurrencyResource());
+        cout << "pmr::unordered_map + ConcurrencyResource:   " << churn(m, keys, ROUNDS) << " ms" << endl;
+    }
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "标准库分配器适配测试开始..." << endl << endl;
+
+    testAdapters();
+    cout << endl;
+
+    benchmarkContainers();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file ArenaTest.cpp
+ * @brief Arena测试程序
+ * @details 测试Arena的正确性，并与逐个ConcurrencyFree的释放方式进行性能对比
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 基本分配与对齐测试
+ */
+void testBasicAllocate() {
+    cout << "=== 基本分配测试 ===" << endl;
+
+    Arena arena;
+    char* prev = nullptr;
+    for (size_t i = 1; i <= 1000; i++) {
+        char* p = (char*)arena.Allocate(i % 100 + 1, 16);
+        assert(p);
+        assert(((size_t)p & 15) == 0);
+        memset(p, 0xAB, i % 100 + 1);
+        assert(p != prev);
+        prev = p;
+    }
+    assert(arena.SpanCount() >= 1);
+
+    // 超过标准Span大小的请求使用专用Span
+    size_t bigSize = (ARENA_SPAN_PAGES << PAGE_SHIFT) + 1;
+    char* big = (char*)arena.Allocate(bigSize);
+    memset(big, 0xCD, bigSize);
+    // 专用Span不影响当前Span的继续分配
+    char* small = (char*)arena.Allocate(8);
+    assert(small && (small < big || small >= big + bigSize));
+
+    cout << "基本分配测试通过！" << endl;
+}
+
+/**
+ * @brief Reset保留与归还测试
+ */
+void testResetRetain() {
+    cout << "=== Reset保留测试 ===" << endl;
+
+    Arena arena(2 * ARENA_SPAN_PAGES);
+    const size_t chunk = ARENA_SPAN_PAGES << PAGE_SHIFT;
+    for (int i = 0; i < 5; i++) {
+        arena.Allocate(chunk - 64);
+    }
+    assert(arena.SpanCount() == 5);
+
+    arena.Reset();
+    assert(arena.SpanCount() == 2);  // 只保留阈值内的两个Span
+    assert(arena.BytesAllocated() == 0);
+
+    // 保留的Span被直接复用，不再向PageCache申请
+    arena.Allocate(chunk - 64);
+    arena.Allocate(chunk - 64);
+    assert(arena.SpanCount() == 2);
+
+    Arena noRetain(0);
+    noRetain.Allocate(100);
+    noRetain.Reset();
+    assert(noRetain.SpanCount() == 0);
+
+    cout << "Reset保留测试通过！" << endl;
+}
+
+/**
+ * @brief Arena内存能被MapObjectToSpan识别
+ */
+void testSpanMapping() {
+    cout << "=== Span映射测试 ===" << endl;
+
+    Arena arena;
+    void* p = arena.Allocate(256);
+    Span* span = PageCache::GetInstance()->MapObjectToSpan(p);
+    assert(span && span->_isArena && span->_isUse);
+
+    // 普通分配的Span不带Arena标记
+    void* q = ConcurrencyAlloc(256);
+    assert(!PageCache::GetInstance()->MapObjectToSpan(q)->_isArena);
+    ConcurrencyFree(q);
+
+    cout << "Span映射测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 请求级别数据的释放开销对比：逐个ConcurrencyFree vs Arena::Reset
+ * @param nworks 线程数
+ * @param requests 每个线程处理的请求数
+ * @param objs 每个请求分配的对象数
+ */
+void benchmarkRequestScoped(size_t nworks, size_t requests, size_t objs) {
+    cout << "=== 请求级别释放性能对比 ===" << endl;
+
+    atomic<long long> poolTime(0), arenaTime(0);
+    vector<thread> threads;
+
+    for (size_t k = 0; k < nworks; k++) {
+        threads.emplace_back([&]() {
+            vector<void*> v;
+            v.reserve(objs);
+
+            auto begin = high_resolution_clock::now();
+            for (size_t r = 0; r < requests; r++) {
+                for (size_t i = 0; i < objs; i++) {
+                    v.push_back(ConcurrencyAlloc((16 + i) % 512 + 1));
+                }
+                for (size_t i = 0; i < objs; i++) {
+                    ConcurrencyFree(v[i]);
+                }
+                v.clear();
+            }
+            auto end = high_resolution_clock::now();
+            poolTime += duration_cast<microseconds>(end - begin).count();
+
+            Arena arena;
+            begin = high_resolution_clock::now();
+            for (size_t r = 0; r < requests; r++) {
+                for (size_t i = 0; i < objs; i++) {
+                    arena.Allocate((16 + i) % 512 + 1);
+                }
+                arena.Reset();
+            }
+            end = high_resolution_clock::now();
+            arenaTime += duration_cast<microseconds>(end - begin).count();
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    cout << nworks << "个线程，每线程" << requests << "个请求，每请求" << objs << "个对象:" << endl;
+    cout << "  ConcurrencyAlloc + 逐个ConcurrencyFree: " << poolTime.load() / 1000 << " ms" << endl;
+    cout << "  Arena::Allocate + Arena::Reset:         " << arenaTime.load() / 1000 << " ms" << endl;
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "Arena测试开始..." << endl << endl;
+
+    testBasicAllocate();
+    cout << endl;
+
+    testResetRetain();
+    cout << endl;
+
+    testSpanMapping();
+    cout << endl;
+
+    benchmarkRequestScoped(4, 2000, 1000);
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
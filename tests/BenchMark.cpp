@@ -38,12 +38,12 @@ void BenchmarkMalloc(size_t ntimes, size_t nworks, size_t rounds)
         t.join();
     }
 
-    printf("%uִ̲߳%uִΣÿִmalloc %u: ѣ%u ms\n", nworks, rounds, ntimes, malloc_costtime.load());
-    printf("%uִ̲߳%uִΣÿִfree %u: ѣ%u ms\n", nworks, rounds, ntimes, free_costtime.load());
-    printf("%u̲߳malloc&free %u Σܼƻѣ%u ms\n", nworks, nworks * rounds * ntimes, malloc_costtime + free_costtime);
+    printf("%u个线程并发执行%u轮次，每轮次malloc %u次: 花费：%u ms\n", nworks, rounds, ntimes, malloc_costtime.load());
+    printf("%u个线程并发执行%u轮次，每轮次free %u次: 花费：%u ms\n", nworks, rounds, ntimes, free_costtime.load());
+    printf("%u个线程并发malloc&free %u 次，总计花费：%u ms\n", nworks, nworks * rounds * ntimes, malloc_costtime + free_costtime);
 }
 
-// ִͷŴ ߳ ִ
+// 单轮次申请释放次数 线程数 轮次
 void BenchmarkConcurrentMalloc(size_t ntimes, size_t nworks, size_t rounds)
 {
     std::vector<std::thread> vthread(nworks);
@@ -80,9 +80,9 @@ void BenchmarkConcurrentMalloc(size_t ntimes, size_t nworks, size_t rounds)
         t.join();
     }
 
-    printf("%uִ̲߳%uִΣÿִConcurrencyAlloc %u: ѣ%u ms\n", nworks, rounds, ntimes, malloc_costtime.load());
-    printf("%uִ̲߳%uִΣÿִConcurrencyFree %u: ѣ%u ms\n", nworks, rounds, ntimes, free_costtime.load());
-    printf("%u̲߳ concurrent alloc&dealloc %u Σܼƻѣ%u ms\n", nworks, nworks * rounds * ntimes, malloc_costtime + free_costtime);
+    printf("%u个线程并发执行%u轮次，每轮次ConcurrencyAlloc %u次: 花费：%u ms\n", nworks, rounds, ntimes, malloc_costtime.load());
+    printf("%u个线程并发执行%u轮次，每轮次ConcurrencyFree %u次: 花费：%u ms\n", nworks, rounds, ntimes, free_costtime.load());
+    printf("%u个线程并发 concurrent alloc&dealloc %u 次，总计花费：%u ms\n", nworks, nworks * rounds * ntimes, malloc_costtime + free_costtime);
 }
 
 int main()
@@ -0,0 +1,233 @@
+/**
+ * @file BitmapTest.cpp
+ * @brief 非空桶位图测试程序
+ * @details 验证Bitmap的置位/清位/查找，并在PageCache碎片化的情况下
+ *          统计NewSpan的延迟分布，对比位图查找与逐桶empty()扫描的开销
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "Bitmap.h"
+#include <random>
+#include <chrono>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 位图基本操作测试，覆盖字边界
+ */
+void testBitmapBasic() {
+    cout << "=== 位图基本操作测试 ===" << endl;
+
+    Bitmap<MAX_PAGESIZE> bm;
+    assert(bm.FindFirst(0) == bm.npos);
+
+    size_t bits[] = {0, 1, 63, 64, 65, 127, 128};
+    for (size_t b : bits) {
+        bm.Set(b);
+        assert(bm.Test(b));
+    }
+
+    assert(bm.FindFirst(0) == 0);
+    assert(bm.FindFirst(2) == 63);
+    assert(bm.FindFirst(64) == 64);
+    assert(bm.FindFirst(66) == 127);
+    assert(bm.FindFirst(128) == 128);
+    assert(bm.FindFirst(129) == bm.npos);
+
+    bm.Clear(127);
+    bm.Clear(128);
+    assert(bm.FindFirst(66) == bm.npos);
+    bm.Clear(63);
+    assert(bm.FindFirst(2) == 64);
+
+    cout << "位图基本操作测试通过！" << endl;
+}
+
+/**
+ * @brief 与逐桶线性扫描逐一比对，验证随机操作下查找结果一致
+ */
+void testBitmapRandom() {
+    cout << "=== 位图随机比对测试 ===" << endl;
+
+    Bitmap<MAX_PAGESIZE> bm;
+    bool ref[MAX_PAGESIZE] = {false};
+    mt19937 gen(7);
+    uniform_int_distribution<size_t> dis(0, MAX_PAGESIZE - 1);
+
+    for (int round = 0; round < 100000; round++) {
+        size_t i = dis(gen);
+        if (gen() & 1) {
+            bm.Set(i);
+            ref[i] = true;
+        } else {
+            bm.Clear(i);
+            ref[i] = false;
+        }
+
+        size_t from = dis(gen);
+        size_t expect = bm.npos;
+        for (size_t j = from; j < MAX_PAGESIZE; j++) {
+            if (ref[j]) {
+                expect = j;
+                break;
+            }
+        }
+        assert(bm.FindFirst(from) == expect);
+    }
+
+    cout << "位图随机比对测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 持锁向PageCache申请k页Span并标记为使用中
+ */
+static Span* AcquireSpan(size_t k) {
+    PageCache* pc = PageCache::GetInstance();
+    pc->GetMutex().lock();
+    Span* span = pc->NewSpan(k);
+    span->_isUse = true;
+    pc->GetMutex().unlock();
+    return span;
+}
+
+/**
+ * @brief 持锁将Span归还PageCache
+ */
+static void ReleaseSpan(Span* span) {
+    PageCache* pc = PageCache::GetInstance();
+    pc->GetMutex().lock();
+    pc->ReleaseSpanToPageCache(span);
+    pc->GetMutex().unlock();
+}
+
+/**
+ * @brief 碎片化情况下NewSpan的延迟分布
+ * @details 先申请大量1~8页的Span并随机释放一半，使各小号桶散布着空洞，
+ *          再以随机页数反复申请/释放，统计单次NewSpan（持锁部分）的延迟
+ */
+void benchmarkFragmentedNewSpan() {
+    cout << "=== 碎片化下NewSpan延迟 ===" << endl;
+
+    PageCache* pc = PageCache::GetInstance();
+    mt19937 gen(42);
+
+    // 制造碎片：申请后随机释放一半，相邻空洞只有部分能合并
+    vector<Span*> pinned;
+    {
+        uniform_int_distribution<size_t> small(1, 8);
+        vector<Span*> all;
+        for (int i = 0; i < 20000; i++) {
+            all.push_back(AcquireSpan(small(gen)));
+        }
+        for (Span* s : all) {
+            if (gen() & 1) {
+                ReleaseSpan(s);
+            } else {
+                pinned.push_back(s);
+            }
+        }
+    }
+
+    const size_t N = 200000;
+    const size_t LIVE = 256;
+    uniform_int_distribution<size_t> dis(1, 32);
+    vector<Span*> live(LIVE, nullptr);
+    vector<long long> lat;
+    lat.reserve(N);
+
+    for (size_t i = 0; i < N; i++) {
+        size_t slot = i % LIVE;
+        if (live[slot]) {
+            ReleaseSpan(live[slot]);
+        }
+
+        size_t k = dis(gen);
+        pc->GetMutex().lock();
+        auto t0 = high_resolution_clock::now();
+        Span* span = pc->NewSpan(k);
+        auto t1 = high_resolution_clock::now();
+        span->_isUse = true;
+        pc->GetMutex().unlock();
+
+        live[slot] = span;
+        lat.push_back(duration_cast<nanoseconds>(t1 - t0).count());
+    }
+
+    for (Span* s : live) {
+        ReleaseSpan(s);
+    }
+    for (Span* s : pinned) {
+        ReleaseSpan(s);
+    }
+
+    sort(lat.begin(), lat.end());
+    cout << "  NewSpan延迟 p50: " << lat[N / 2] << " ns, p99: " << lat[N * 99 / 100]
+         << " ns, p99.9: " << lat[N * 999 / 1000] << " ns, max: " << lat[N - 1] << " ns" << endl;
+}
+
+/**
+ * @brief 查找下一个非空桶：位图ctz与逐桶empty()扫描对比
+ * @details 只有高号桶非空时线性扫描要走过一百多个桶，这正是碎片化后
+ *          小桶耗尽、只能从大Span切分时的情形
+ */
+void benchmarkFindFirst() {
+    cout << "=== 查找非空桶开销对比 ===" << endl;
+
+    static SpanList lists[MAX_PAGESIZE];
+    static Span dummy;
+    Bitmap<MAX_PAGESIZE> bm;
+    lists[MAX_PAGESIZE - 1].push_front(&dummy);
+    bm.Set(MAX_PAGESIZE - 1);
+
+    const size_t N = 1000000;
+    volatile size_t sink = 0;
+
+    auto t0 = high_resolution_clock::now();
+    for (size_t n = 0; n < N; n++) {
+        size_t k = n % 8 + 1;
+        size_t i = k;
+        while (i < MAX_PAGESIZE && lists[i].empty()) {
+            i++;
+        }
+        sink = sink + i;
+    }
+    auto t1 = high_resolution_clock::now();
+    for (size_t n = 0; n < N; n++) {
+        size_t k = n % 8 + 1;
+        sink = sink + bm.FindFirst(k);
+    }
+    auto t2 = high_resolution_clock::now();
+
+    lists[MAX_PAGESIZE - 1].erase(&dummy);
+    (void)sink;
+
+    cout << "  逐桶扫描: " << duration_cast<nanoseconds>(t1 - t0).count() / N << " ns/次" << endl;
+    cout << "  位图查找: " << duration_cast<nanoseconds>(t2 - t1).count() / N << " ns/次" << endl;
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "非空桶位图测试开始..." << endl << endl;
+
+    testBitmapBasic();
+    cout << endl;
+
+    testBitmapRandom();
+    cout << endl;
+
+    benchmarkFragmentedNewSpan();
+    cout << endl;
+
+    benchmarkFindFirst();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
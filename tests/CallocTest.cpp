@@ -0,0 +1,380 @@
+/**
+ * @file CallocTest.cpp
+ * @brief ConcurrencyCalloc测试程序
+ * @details 验证元素个数与大小相乘溢出时返回nullptr、向量化清零内核与标量实现一致且不越界、
+ *          回收的小对象和大对象清零后整个可用大小为零、新申请的页被识别为全零而跳过清零、
+ *          旧页按calloc_decommit_bytes丢弃内容或清零；并对比大块calloc在各实现下的吞吐
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+static void Write(const char* name, size_t value) {
+    int err = ConcurrencyControl(name, nullptr, &value);
+    assert(err == 0);
+    (void)err;
+}
+
+/**
+ * @brief 常驻内存字节数，来自/proc/self/statm
+ */
+static size_t RssBytes() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+    unsigned long total = 0, resident = 0;
+    int got = fscanf(f, "%lu %lu", &total, &resident);
+    fclose(f);
+    return got == 2 ? resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+}
+
+/**
+ * @brief 检查一段内存全部为零
+ */
+static bool AllZero(const void* ptr, size_t bytes) {
+    const unsigned char* p = (const unsigned char*)ptr;
+    for (size_t i = 0; i < bytes; i++) {
+        if (p[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 大对象所在Span的页是否记为全零
+ */
+static bool SpanZeroed(void* ptr) {
+    return PageCache::GetInstance()->MapObjectToSpan(ptr)->_zeroed;
+}
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 乘法溢出与零大小
+ */
+void testOverflow() {
+    cout << "=== 溢出检查测试 ===" << endl;
+
+    errno = 0;
+    assert(ConcurrencyCalloc(SIZE_MAX / 2 + 1, 2) == nullptr);
+    assert(errno == ENOMEM);
+    errno = 0;
+    assert(ConcurrencyCalloc(SIZE_MAX, SIZE_MAX) == nullptr);
+    assert(errno == ENOMEM);
+    errno = 0;
+    assert(ConcurrencyCalloc((SIZE_MAX >> 20) + 1, 1 << 20) == nullptr);
+    assert(errno == ENOMEM);
+
+    // 不溢出的边界
+    void* p = ConcurrencyCalloc(SIZE_MAX / 2, 0);
+    assert(p != nullptr);
+    ConcurrencyFree(p);
+    p = ConcurrencyCalloc(0, 16);
+    assert(p != nullptr);
+    ConcurrencyFree(p);
+    p = ConcurrencyCalloc(1000, 1000);
+    assert(p != nullptr && AllZero(p, 1000 * 1000));
+    ConcurrencyFree(p);
+
+    cout << "溢出检查测试通过" << endl;
+}
+
+/**
+ * @brief 清零内核在各种长度和对齐下只清零指定范围
+ */
+void testClearKernel() {
+    cout << "=== 清零内核测试 ===" << endl;
+    cout << "使用的实现: " << CarveKernelName() << endl;
+
+    const size_t MAX = CLEAR_NT_BYTES + 4096;
+    vector<uint64_t> buf(MAX / 8 + 16);
+    char* base = (char*)(((uintptr_t)buf.data() + 63) & ~(uintptr_t)63);
+
+    size_t lengths[] = {0, 8, 16, 24, 40, 64, 120, 128, 136, 248, 1024, 4096 + 8,
+                        CARVE_NT_BYTES + 72, CLEAR_NT_BYTES - 8, CLEAR_NT_BYTES, CLEAR_NT_BYTES + 72};
+    for (size_t offset = 0; offset < 64; offset += 8) {
+        for (size_t len : lengths) {
+            for (int impl = 0; impl < 2; impl++) {
+                memset(base, 0xA5, MAX + 64);
+                char* p = base + offset;
+                if (impl == 0) {
+                    ClearObject(p, len);
+                } else {
+                    ClearObjectScalar(p, len);
+                }
+                assert(AllZero(p, len));
+                for (size_t i = 0; i < offset; i++) {
+                    assert((unsigned char)base[i] == 0xA5);
+                }
+                for (size_t i = 0; i < 64; i++) {
+                    assert((unsigned char)p[len + i] == 0xA5);
+                }
+            }
+        }
+    }
+
+    cout << "清零内核测试通过" << endl;
+}
+
+/**
+ * @brief 回收的小对象清零后整个尺寸类大小为零
+ */
+void testSmallRecycled() {
+    cout << "=== 小对象清零测试 ===" << endl;
+    const size_t sizes[] = {1, 8, 24, 200, 1000, 5000, 64 * 1024, MAX_MEMORYSIZE};
+    const int COUNT = 200;
+
+    for (size_t size : sizes) {
+        vector<void*> ptrs;
+        for (int i = 0; i < COUNT; i++) {
+            void* p = ConcurrencyAlloc(size);
+            memset(p, 0xCD, ConcurrencyUsableSize(p));
+            ptrs.push_back(p);
+        }
+        for (void* p : ptrs) {
+            ConcurrencyFree(p);
+        }
+        ptrs.clear();
+
+        // 逆序申请取回刚释放的对象
+        for (int i = 0; i < COUNT; i++) {
+            void* p = ConcurrencyCalloc(1, size);
+            assert(AllZero(p, ConcurrencyUsableSize(p)));
+            ptrs.push_back(p);
+        }
+        for (void* p : ptrs) {
+            ConcurrencyFree(p);
+        }
+    }
+
+    // 以元素个数与大小的形式申请
+    int* arr = (int*)ConcurrencyCalloc(1000, sizeof(int));
+    for (int i = 0; i < 1000; i++) {
+        assert(arr[i] == 0);
+        arr[i] = i;
+    }
+    ConcurrencyFree(arr);
+    arr = (int*)ConcurrencyCalloc(1000, sizeof(int));
+    assert(AllZero(arr, 1000 * sizeof(int)));
+    ConcurrencyFree(arr);
+
+    cout << "小对象清零测试通过" << endl;
+}
+
+/**
+ * @brief 大对象：新申请的页跳过清零，旧页按阈值丢弃内容或清零
+ */
+void testLargeZeroed() {
+    cout << "=== 大对象清零测试 ===" << endl;
+    const size_t BIG = 32 * 1024 * 1024;
+    const size_t MID = 300 * 1024;
+    PageCache* pc = PageCache::GetInstance();
+
+    // 清空超大Span缓存，下一次申请来自系统
+    Write("large_cache_bytes", 0);
+    Write("large_cache_bytes", LARGE_CACHE_MAX_BYTES);
+    char* p = (char*)ConcurrencyCalloc(1, BIG);
+    assert(SpanZeroed(p));
+    assert(AllZero(p, ConcurrencyUsableSize(p)));
+    memset(p, 0x77, BIG);
+    ConcurrencyFree(p);
+
+    // 再次申请命中缓存中的旧页：丢弃内容，常驻内存随之下降
+    size_t hits = pc->GetStats().largeCacheHits;
+    size_t rssBefore = RssBytes();
+    p = (char*)ConcurrencyCalloc(BIG / 4096, 4096);
+    size_t rssAfter = RssBytes();
+    assert(pc->GetStats().largeCacheHits == hits + 1);
+    assert(!SpanZeroed(p));
+    cout << "丢弃旧页: 常驻内存 " << rssBefore / 1024 / 1024 << "MB -> " << rssAfter / 1024 / 1024 << "MB" << endl;
+    if (rssBefore > 0) {
+        assert(rssAfter + BIG / 2 < rssBefore);
+    }
+    assert(AllZero(p, ConcurrencyUsableSize(p)));
+    memset(p, 0x66, BIG);
+    ConcurrencyFree(p);
+
+    // 关闭丢弃后用清零内核
+    Write("calloc_decommit_bytes", SIZE_MAX);
+    p = (char*)ConcurrencyCalloc(1, BIG);
+    assert(!SpanZeroed(p));
+    assert(AllZero(p, ConcurrencyUsableSize(p)));
+    memset(p, 0x55, BIG);
+    ConcurrencyFree(p);
+    Write("calloc_decommit_bytes", TuneDescribe(TUNE_CALLOC_DECOMMIT_BYTES).def);
+
+    // 不足阈值的大对象：来自合并后的旧页时清零
+    vector<char*> mids;
+    for (int i = 0; i < 16; i++) {
+        char* q = (char*)ConcurrencyAlloc(MID);
+        memset(q, 0x44, ConcurrencyUsableSize(q));
+        mids.push_back(q);
+    }
+    for (char* q : mids) {
+        ConcurrencyFree(q);
+    }
+    mids.clear();
+    for (int i = 0; i < 16; i++) {
+        char* q = (char*)ConcurrencyCalloc(MID, 1);
+        assert(AllZero(q, ConcurrencyUsableSize(q)));
+        mids.push_back(q);
+    }
+    for (char* q : mids) {
+        ConcurrencyFree(q);
+    }
+
+    cout << "大对象清零测试通过" << endl;
+}
+
+/**
+ * @brief 页状态随切分继承、归还后失效
+ */
+void testPristineTracking() {
+    cout << "=== 全零页跟踪测试 ===" << endl;
+    PageCache* pc = PageCache::GetInstance();
+
+    // 清空超大Span缓存后从系统新申请的Span记为全零
+    Write("large_cache_bytes", 0);
+    Write("large_cache_bytes", LARGE_CACHE_MAX_BYTES);
+    const size_t BIG = 16 * 1024 * 1024;
+    char* a = (char*)ConcurrencyAlloc(BIG);
+    assert(SpanZeroed(a));
+    ConcurrencyFree(a);
+
+    // 归还后的页再交出时不再是全零
+    {
+        std::lock_guard<PoolMutex> guard(pc->GetMutex());
+        Span* s = pc->NewSpan(BIG >> PAGE_SHIFT);
+        assert(!s->_zeroed);
+        s->_isUse = true;
+        pc->ReleaseSpanToPageCache(s);
+    }
+
+    // 128页的Span：桶中已有的空闲Span先被取走，之后的一个来自系统
+    auto newSpan = [pc](size_t k) {
+        std::lock_guard<PoolMutex> guard(pc->GetMutex());
+        Span* s = pc->NewSpan(k);
+        s->_isUse = true;
+        return s;
+    };
+    vector<Span*> held;
+    size_t before = pc->GetStats().systemAllocs;
+    while (pc->GetStats().systemAllocs == before) {
+        held.push_back(newSpan(MAX_PAGESIZE - 1));
+    }
+    assert(held.back()->_zeroed);
+    // 再申请32页直到又向系统申请两次：最后一个来自第三次申请，在它之前的4个切自第二次申请的区域
+    while (pc->GetStats().systemAllocs < before + 3) {
+        held.push_back(newSpan(32));
+    }
+    for (size_t i = held.size() - 5; i < held.size(); i++) {
+        assert(held[i]->_zeroed);
+    }
+    {
+        std::lock_guard<PoolMutex> guard(pc->GetMutex());
+        for (Span* s : held) {
+            pc->ReleaseSpanToPageCache(s);
+        }
+    }
+    held.clear();
+    Span* again = newSpan(MAX_PAGESIZE - 1);
+    assert(!again->_zeroed);
+    std::lock_guard<PoolMutex> guard(pc->GetMutex());
+    pc->ReleaseSpanToPageCache(again);
+
+    cout << "全零页跟踪测试通过" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 按给定方式申请、写每个4K页后释放，返回吞吐（GB/s）
+ * @param mode 0: std::calloc  1: ConcurrencyAlloc+memset  2: ConcurrencyCalloc
+ */
+static double RunCalloc(int mode, size_t size, size_t iters, bool touchAll) {
+    auto start = high_resolution_clock::now();
+    for (size_t it = 0; it < iters; it++) {
+        char* p;
+        if (mode == 0) {
+            p = (char*)calloc(1, size);
+        } else if (mode == 1) {
+            p = (char*)ConcurrencyAlloc(size);
+            memset(p, 0, size);
+        } else {
+            p = (char*)ConcurrencyCalloc(1, size);
+        }
+        size_t limit = touchAll ? size : min(size, (size_t)64 * 1024);
+        for (size_t off = 0; off < limit; off += 4096) {
+            p[off] = (char)it;
+        }
+        if (mode == 0) {
+            free(p);
+        } else {
+            ConcurrencyFree(p);
+        }
+    }
+    double sec = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1e9;
+    return (double)size * iters / sec / 1e9;
+}
+
+/**
+ * @brief 对比大块calloc的吞吐：glibc、申请后memset、丢弃旧页、清零内核
+ */
+void benchmarkLargeCalloc() {
+    cout << "=== 大块calloc吞吐测试 ===" << endl;
+    const size_t TOTAL = 2048ull * 1024 * 1024;
+    const size_t sizes[] = {512 * 1024, 2 * 1024 * 1024, 8 * 1024 * 1024, 32 * 1024 * 1024, 64 * 1024 * 1024};
+
+    for (int touch = 1; touch >= 0; touch--) {
+        cout << (touch ? "写满每一页:" : "只写前64KB:") << endl;
+        printf("  %10s %12s %14s %14s %14s\n", "size", "glibc", "alloc+memset", "calloc", "calloc_clear");
+        for (size_t size : sizes) {
+            size_t iters = max(TOTAL / size, (size_t)16);
+            double glibc = RunCalloc(0, size, iters, touch);
+            double memsetRate = RunCalloc(1, size, iters, touch);
+            double callocRate = RunCalloc(2, size, iters, touch);
+            Write("calloc_decommit_bytes", SIZE_MAX);
+            double clearRate = RunCalloc(2, size, iters, touch);
+            Write("calloc_decommit_bytes", TuneDescribe(TUNE_CALLOC_DECOMMIT_BYTES).def);
+            printf("  %9zuK %10.2fGB/s %12.2fGB/s %12.2fGB/s %12.2fGB/s\n", size / 1024, glibc, memsetRate,
+                   callocRate, clearRate);
+        }
+    }
+    cout << "calloc: 旧页不少于calloc_decommit_bytes时丢弃内容；calloc_clear: 关闭丢弃，旧页用清零内核" << endl;
+}
+
+int main() {
+    cout << "calloc测试开始..." << endl << endl;
+
+    testOverflow();
+    cout << endl;
+
+    testClearKernel();
+    cout << endl;
+
+    testSmallRecycled();
+    cout << endl;
+
+    testLargeZeroed();
+    cout << endl;
+
+    testPristineTracking();
+    cout << endl;
+
+    benchmarkLargeCalloc();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file CarveKernelTest.cpp
+ * @brief 对象切分内核测试程序
+ * @details 验证向量化切分与标量实现生成的链表完全一致，
+ *          并按尺寸类对比两者在一批对象和整块Span上的切分吞吐
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "CarveKernel.h"
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 遍历链表，检查每个对象都指向下一个对象，最后一个为空
+ */
+static void CheckChain(char* start, size_t size, size_t n, void* last) {
+    char* obj = start;
+    for (size_t i = 0; i + 1 < n; i++) {
+        assert(NextObj(obj) == obj + size);
+        obj += size;
+    }
+    assert(obj == last);
+    assert(NextObj(obj) == nullptr);
+}
+
+/**
+ * @brief 各种大小、个数、起始偏移下与标量实现逐一比对
+ */
+void testCarveMatchesScalar() {
+    cout << "=== 切分结果比对测试（当前实现: " << CarveKernelName() << "） ===" << endl;
+
+    size_t sizes[] = {8, 16, 24, 128, 1024, 8192};
+    size_t counts[] = {1, 2, 3, 4, 5, 7, 8, 9, 31, 64, 513};
+    size_t bufBytes = 2 * CARVE_NT_BYTES + 8192 * 600;
+    char* buf = (char*)SystemAlloc(bufBytes >> PAGE_SHIFT);
+
+    for (size_t size : sizes) {
+        for (size_t n : counts) {
+            for (size_t offset = 0; offset < 64; offset += 8) {
+                char* start = buf + offset;
+                CheckChain(start, size, n, CarveObjects(start, size, n));
+            }
+        }
+        // 超过非临时存储阈值的整块切分
+        size_t big = (CARVE_NT_BYTES / size) + 3;
+        if (big * size + 64 <= bufBytes) {
+            CheckChain(buf + 8, size, big, CarveObjects(buf + 8, size, big));
+            CheckChain(buf, size, big, CarveObjects(buf, size, big));
+        }
+    }
+
+    SystemFree(buf, bufBytes >> PAGE_SHIFT);
+    cout << "切分结果比对测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 测量一种实现切分n个size大小对象的平均耗时
+ * @return 每个对象的纳秒数
+ */
+static double MeasureCarve(void* (*carve)(char*, size_t, size_t), char* buf, size_t size, size_t n, size_t rounds) {
+    auto t0 = high_resolution_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        carve(buf, size, n);
+    }
+    auto t1 = high_resolution_clock::now();
+    return (double)duration_cast<nanoseconds>(t1 - t0).count() / (rounds * n);
+}
+
+/**
+ * @brief 按尺寸类对比切分吞吐
+ * @details 一批：FetchRangeObj一次最多切出NumMoveSize个对象，数据在缓存中；
+ *          整块：把1MB的Span一次串完，超过阈值时向量实现使用非临时存储
+ */
+void benchmarkCarve() {
+    cout << "=== 切分吞吐（ns/对象） ===" << endl;
+
+    const size_t SPAN_BYTES = 1024 * 1024;
+    char* buf = (char*)SystemAlloc(SPAN_BYTES >> PAGE_SHIFT);
+    memset(buf, 0, SPAN_BYTES);
+
+    size_t sizes[] = {8, 16, 128, 1024};
+    printf("  %-6s %-8s %-10s %-10s %-10s %-10s\n", "size", "batch", "批-标量", "批-向量", "整块-标量", "整块-向量");
+    for (size_t size : sizes) {
+        size_t batch = SizeClass::NumMoveSize(size);
+        size_t spanObjs = SPAN_BYTES / size;
+        size_t batchRounds = 20000000 / batch;
+        size_t spanRounds = 20000000 / spanObjs;
+
+        double bs = MeasureCarve(CarveObjectsScalar, buf, size, batch, batchRounds);
+        double bv = MeasureCarve(CarveObjects, buf, size, batch, batchRounds);
+        double ss = MeasureCarve(CarveObjectsScalar, buf, size, spanObjs, spanRounds);
+        double sv = MeasureCarve(CarveObjects, buf, size, spanObjs, spanRounds);
+        printf("  %-6zu %-8zu %-10.3f %-10.3f %-10.3f %-10.3f\n", size, batch, bs, bv, ss, sv);
+    }
+
+    SystemFree(buf, SPAN_BYTES >> PAGE_SHIFT);
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "对象切分内核测试开始..." << endl << endl;
+
+    testCarveMatchesScalar();
+    cout << endl;
+
+    benchmarkCarve();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
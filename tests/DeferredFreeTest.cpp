@@ -0,0 +1,298 @@
+/**
+ * @file DeferredFreeTest.cpp
+ * @brief 异步延迟释放测试程序
+ * @details 验证开启延迟释放后小对象批次和大对象Span由回收线程归还、反压时改为同步归还、
+ *          多线程下数据完整、无事可做时回收线程不再定时醒来，并对比开启前后单次ConcurrencyFree的延迟分位数
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "CentralCache.h"
+#include <chrono>
+#include <atomic>
+#include <cstring>
+#include <cassert>
+#include <fstream>
+#include <dirent.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 大量释放小对象，溢出批次缓存的部分经回收线程归还后可以再次分配
+ */
+void testDeferredSmall() {
+    cout << "=== 小对象延迟释放测试 ===" << endl;
+
+    DeferredFreeStats before = DeferredFree::GetInstance()->GetStats();
+    thread t([]() {
+        ConcurrencySetDeferredFree(true);
+        vector<void*> ptrs;
+        for (int i = 0; i < 200000; i++) {
+            void* p = ConcurrencyAlloc(128);
+            memset(p, 0x5A, 128);
+            ptrs.push_back(p);
+        }
+        for (void* p : ptrs) {
+            ConcurrencyFree(p);
+        }
+    });
+    t.join();
+
+    DeferredFree::GetInstance()->Flush();
+    DeferredFreeStats after = DeferredFree::GetInstance()->GetStats();
+    assert(after.deferredBatches > before.deferredBatches);
+    assert(after.reclaimed > before.reclaimed);
+    assert(DeferredFree::GetInstance()->PendingBytes() == 0);
+
+    vector<void*> again;
+    for (int i = 0; i < 200000; i++) {
+        void* p = ConcurrencyAlloc(128);
+        memset(p, 0xA5, 128);
+        again.push_back(p);
+    }
+    for (void* p : again) {
+        ConcurrencyFree(p);
+    }
+
+    cout << "延迟释放批次: " << after.deferredBatches - before.deferredBatches << endl;
+    cout << "小对象延迟释放测试通过！" << endl;
+}
+
+/**
+ * @brief 大对象Span交给回收线程归还，归还后的页可以被复用
+ */
+void testDeferredLarge() {
+    cout << "=== 大对象延迟释放测试 ===" << endl;
+
+    DeferredFreeStats before = DeferredFree::GetInstance()->GetStats();
+    thread t([]() {
+        ConcurrencySetDeferredFree(true);
+        for (int i = 0; i < 100; i++) {
+            void* p = ConcurrencyAlloc(1024 * 1024);
+            memset(p, 0x11, 1024 * 1024);
+            ConcurrencyFree(p);
+        }
+    });
+    t.join();
+
+    DeferredFree::GetInstance()->Flush();
+    DeferredFreeStats after = DeferredFree::GetInstance()->GetStats();
+    assert(after.deferredSpans >= before.deferredSpans + 100);
+    assert(DeferredFree::GetInstance()->PendingBytes() == 0);
+
+    // 回收后的Span已回到页堆，再申请不需要向系统要内存
+    size_t allocs = PageCache::GetInstance()->GetStats().systemAllocs;
+    void* p = ConcurrencyAlloc(1024 * 1024);
+    assert(PageCache::GetInstance()->GetStats().systemAllocs == allocs);
+    ConcurrencyFree(p);
+
+    cout << "大对象延迟释放测试通过！" << endl;
+}
+
+/**
+ * @brief 上限为0时所有归还都被拒绝，由当前线程同步完成
+ */
+void testBackPressure() {
+    cout << "=== 反压测试 ===" << endl;
+
+    DeferredFree::GetInstance()->SetLimit(0);
+    DeferredFreeStats before = DeferredFree::GetInstance()->GetStats();
+    thread t([]() {
+        ConcurrencySetDeferredFree(true);
+        for (int i = 0; i < 20; i++) {
+            ConcurrencyFree(ConcurrencyAlloc(1024 * 1024));
+        }
+    });
+    t.join();
+    DeferredFreeStats after = DeferredFree::GetInstance()->GetStats();
+    assert(after.deferredSpans == before.deferredSpans);
+    assert(after.rejected >= before.rejected + 20);
+    DeferredFree::GetInstance()->SetLimit(DEFERRED_FREE_MAX_BYTES);
+
+    cout << "反压测试通过！" << endl;
+}
+
+/**
+ * @brief 多个开启延迟释放的线程交叉申请释放，数据不被破坏
+ */
+void testConcurrent() {
+    cout << "=== 多线程延迟释放测试 ===" << endl;
+
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([t]() {
+            ConcurrencySetDeferredFree(t % 2 == 0);
+            vector<pair<size_t*, size_t>> ptrs;
+            for (int round = 0; round < 10; round++) {
+                for (size_t i = 0; i < 5000; i++) {
+                    size_t size = (i % 7 == 0) ? 300 * 1024 : 16 + (i * 24) % 4000;
+                    size_t* p = (size_t*)ConcurrencyAlloc(size);
+                    p[0] = (size_t)t;
+                    p[size / sizeof(size_t) - 1] = i;
+                    ptrs.push_back(make_pair(p, size));
+                }
+                for (size_t i = 0; i < ptrs.size(); i++) {
+                    size_t* p = ptrs[i].first;
+                    assert(p[0] == (size_t)t && p[ptrs[i].second / sizeof(size_t) - 1] == i);
+                    ConcurrencyFree(p);
+                }
+                ptrs.clear();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    DeferredFree::GetInstance()->Flush();
+    assert(DeferredFree::GetInstance()->PendingBytes() == 0);
+
+    cout << "多线程延迟释放测试通过！" << endl;
+}
+
+/**
+ * @brief 本进程所有线程的主动上下文切换次数之和
+ */
+static size_t VoluntarySwitches() {
+    size_t total = 0;
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return 0;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        ifstream status(string("/proc/self/task/") + entry->d_name + "/status");
+        string line;
+        while (getline(status, line)) {
+            if (line.compare(0, 24, "voluntary_ctxt_switches:") == 0) {
+                total += stoul(line.substr(24));
+            }
+        }
+    }
+    closedir(dir);
+    return total;
+}
+
+/**
+ * @brief 队列为空、也没有空Span或批次可清理时，回收线程无限期休眠
+ */
+void testIdleSleep() {
+    cout << "=== 回收线程休眠测试 ===" << endl;
+
+    DeferredFree::GetInstance()->Flush();
+    CentralCache::GetInstance()->ReleaseEmptySpans();
+    assert(!CentralCache::GetInstance()->IdleWorkPending());
+    DeferredFree::GetInstance()->Wake(true);   // 结束当前的定时等待，按现状重新选择
+    this_thread::sleep_for(milliseconds(20));
+
+    size_t before = VoluntarySwitches();
+    this_thread::sleep_for(milliseconds(300));
+    size_t switches = VoluntarySwitches() - before;
+    cout << "300ms内的主动切换: " << switches << endl;
+    assert(switches <= 3);   // 主线程自己的休眠占一次
+
+    // 入队后照常被唤醒处理
+    thread t([]() {
+        ConcurrencySetDeferredFree(true);
+        ConcurrencyFree(ConcurrencyAlloc(1024 * 1024));
+    });
+    t.join();
+    DeferredFree::GetInstance()->Flush();
+    assert(DeferredFree::GetInstance()->PendingBytes() == 0);
+
+    cout << "回收线程休眠测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 多线程混合大小申请后逐个释放，记录每次ConcurrencyFree的耗时
+ * @return 所有线程的释放耗时（纳秒），已排序
+ */
+static vector<long long> MeasureFreeLatency(size_t nthreads, bool deferred) {
+    const size_t ROUNDS = 20;
+    const size_t PER_ROUND = 20000;
+    vector<vector<long long>> samples(nthreads);
+    vector<thread> threads;
+    for (size_t t = 0; t < nthreads; t++) {
+        threads.emplace_back([&, t]() {
+            ConcurrencySetDeferredFree(deferred);
+            vector<void*> ptrs(PER_ROUND);
+            samples[t].reserve(ROUNDS * PER_ROUND);
+            for (size_t r = 0; r < ROUNDS; r++) {
+                for (size_t i = 0; i < PER_ROUND; i++) {
+                    size_t size = (i % 1000 == 0) ? 512 * 1024 : 16 + (i * 40) % 2000;
+                    ptrs[i] = ConcurrencyAlloc(size);
+                }
+                for (size_t i = 0; i < PER_ROUND; i++) {
+                    auto t0 = steady_clock::now();
+                    ConcurrencyFree(ptrs[i]);
+                    auto t1 = steady_clock::now();
+                    samples[t].push_back(duration_cast<nanoseconds>(t1 - t0).count());
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    DeferredFree::GetInstance()->Flush();
+
+    vector<long long> all;
+    for (auto& s : samples) {
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    sort(all.begin(), all.end());
+    return all;
+}
+
+static long long Percentile(const vector<long long>& sorted, double q) {
+    return sorted[(size_t)(q * (sorted.size() - 1))];
+}
+
+void benchmarkFreeLatency() {
+    cout << "=== ConcurrencyFree延迟分位数（ns） ===" << endl;
+
+    MeasureFreeLatency(4, false);   // 预热
+    printf("  %-10s %-8s %-8s %-8s %-10s %-10s\n", "模式", "p50", "p99", "p99.9", "p99.99", "max");
+    for (int mode = 0; mode < 2; mode++) {
+        bool deferred = mode == 1;
+        vector<long long> lat = MeasureFreeLatency(4, deferred);
+        printf("  %-10s %-8lld %-8lld %-8lld %-10lld %-10lld\n", deferred ? "延迟释放" : "同步释放",
+               Percentile(lat, 0.5), Percentile(lat, 0.99), Percentile(lat, 0.999),
+               Percentile(lat, 0.9999), lat.back());
+    }
+    DeferredFreeStats stats = DeferredFree::GetInstance()->GetStats();
+    cout << "  入队批次: " << stats.deferredBatches << ", 入队Span: " << stats.deferredSpans
+         << ", 反压: " << stats.rejected << endl;
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "异步延迟释放测试开始..." << endl << endl;
+
+    testDeferredSmall();
+    cout << endl;
+
+    testDeferredLarge();
+    cout << endl;
+
+    testBackPressure();
+    cout << endl;
+
+    testConcurrent();
+    cout << endl;
+
+    testIdleSleep();
+    cout << endl;
+
+    benchmarkFreeLatency();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
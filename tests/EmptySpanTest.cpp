@@ -0,0 +1,403 @@
+/**
+ * @file EmptySpanTest.cpp
+ * @brief CentralCache空Span保留测试程序
+ * @details 验证对象全部归还的Span按尺寸类保留并被下一次申请直接复用、保留上限随突发负载自适应增长、
+ *          empty_span_max限制保留数且为0时关闭保留、empty_span_bytes限制所有尺寸类合计的字节数、
+ *          空闲的尺寸类按轮次和按时间归还保留的Span、静止的进程不调用任何清理接口也能归还到零，
+ *          以及ReleaseEmptySpans和统计项；并对比开启与关闭保留时突发负载的Span申请次数和耗时
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+static const size_t IDLE_NEVER_MS = 3600 * 1000;   // 测试期间不按时间清理
+
+static size_t Read(const char* name) {
+    size_t value = 0;
+    int err = ConcurrencyControl(name, &value);
+    assert(err == 0);
+    (void)err;
+    return value;
+}
+
+static void Write(const char* name, size_t value) {
+    int err = ConcurrencyControl(name, nullptr, &value);
+    assert(err == 0);
+    (void)err;
+}
+
+/**
+ * @brief 一个Span能切出的对象数
+ */
+static size_t ObjsPerSpan(size_t size) {
+    return (SizeClass::NumMovePage(size) << PAGE_SHIFT) / size;
+}
+
+/**
+ * @brief 直接从CentralCache取出spans个Span的全部对象
+ * @details 每次取的个数不等于NumMoveSize，绕过无锁批次缓存；调用前该尺寸类不能有部分使用的Span
+ */
+static void FetchSpans(size_t size, size_t spans, vector<void*>& objs) {
+    size_t total = spans * ObjsPerSpan(size);
+    void* batch[16];
+    while (objs.size() < total) {
+        size_t want = min(total - objs.size(), (size_t)15);
+        size_t n = CentralCache::GetInstance()->FetchRangeObj(batch, want, size);
+        objs.insert(objs.end(), batch, batch + n);
+    }
+}
+
+/**
+ * @brief 把对象全部归还给Span
+ */
+static void ReleaseAll(size_t size, vector<void*>& objs) {
+    CentralCache::GetInstance()->ReleaseArrayToSpan(objs.data(), objs.size(), size);
+    objs.clear();
+}
+
+/**
+ * @brief 一次突发：取出spans个Span的对象后全部归还
+ * @return 本次突发向PageCache申请Span的次数
+ */
+static size_t Burst(size_t size, size_t spans) {
+    size_t before = Read("stats.new_spans");
+    vector<void*> objs;
+    FetchSpans(size, spans, objs);
+    size_t allocs = Read("stats.new_spans") - before;
+    ReleaseAll(size, objs);
+    return allocs;
+}
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 变空的Span被保留，下一次申请直接复用
+ */
+void testReuse() {
+    cout << "=== 空Span复用测试 ===" << endl;
+    const size_t SIZE = 256;
+    CentralCache* cc = CentralCache::GetInstance();
+
+    assert(Burst(SIZE, 1) == 1);
+    assert(cc->SpanCount(SIZE) == 0);
+    assert(cc->EmptySpanCount(SIZE) == 1);
+    assert(Read("stats.empty_spans") >= 1);
+
+    // 复用保留的Span，不再向PageCache申请；已切分过的对象原样取回
+    size_t before = Read("stats.new_spans");
+    vector<void*> objs;
+    FetchSpans(SIZE, 1, objs);
+    assert(Read("stats.new_spans") == before);
+    assert(cc->EmptySpanCount(SIZE) == 0);
+    assert(cc->SpanCount(SIZE) == 1);
+    for (void* p : objs) {
+        memset(p, 0x5A, SIZE);
+    }
+    ReleaseAll(SIZE, objs);
+    assert(cc->EmptySpanCount(SIZE) == 1);
+
+    cout << "每个Span " << ObjsPerSpan(SIZE) << " 个对象，第二次取出未申请新Span" << endl;
+    cout << "空Span复用测试通过" << endl;
+}
+
+/**
+ * @brief 上限从1开始，突发负载反复超出时逐次加一，直到一次突发不再申请新Span
+ */
+void testAdaptiveLimit() {
+    cout << "=== 自适应上限测试 ===" << endl;
+    const size_t SIZE = 512;
+    const size_t SPANS = 4;
+    CentralCache* cc = CentralCache::GetInstance();
+
+    // 上限依次为1、2、3、4，第五次突发全部复用
+    size_t expectKeep[] = {1, 2, 3, 4, 4};
+    size_t expectNew[] = {4, 3, 2, 1, 0};
+    for (size_t round = 0; round < 5; round++) {
+        size_t allocs = Burst(SIZE, SPANS);
+        cout << "第" << round + 1 << "次突发: 新申请 " << allocs << " 个Span，保留 "
+             << cc->EmptySpanCount(SIZE) << " 个" << endl;
+        assert(allocs == expectNew[round]);
+        assert(cc->EmptySpanCount(SIZE) == expectKeep[round]);
+    }
+
+    // empty_span_max限制上限，调小时归还已保留的Span
+    Write("empty_span_max", 2);
+    assert(cc->EmptySpanCount(SIZE) == 0);
+    for (int round = 0; round < 4; round++) {
+        Burst(SIZE, SPANS);
+        assert(cc->EmptySpanCount(SIZE) <= 2);
+    }
+    assert(cc->EmptySpanCount(SIZE) == 2);
+    Write("empty_span_max", TuneDescribe(TUNE_EMPTY_SPAN_MAX).def);
+
+    cout << "自适应上限测试通过" << endl;
+}
+
+/**
+ * @brief empty_span_max为0时不保留，每次突发都向PageCache申请
+ */
+void testDisabled() {
+    cout << "=== 关闭保留测试 ===" << endl;
+    const size_t SIZE = 1024;
+    CentralCache* cc = CentralCache::GetInstance();
+
+    Write("empty_span_max", 0);
+    assert(Read("stats.empty_spans") == 0);
+    for (int round = 0; round < 3; round++) {
+        assert(Burst(SIZE, 3) == 3);
+        assert(cc->EmptySpanCount(SIZE) == 0);
+        assert(cc->SpanCount(SIZE) == 0);
+    }
+    Write("empty_span_max", TuneDescribe(TUNE_EMPTY_SPAN_MAX).def);
+
+    cout << "关闭保留测试通过" << endl;
+}
+
+/**
+ * @brief empty_span_bytes限制所有尺寸类保留的空Span合计字节数，调小时归还已保留的Span
+ */
+void testByteCap() {
+    cout << "=== 合计字节上限测试 ===" << endl;
+    CentralCache* cc = CentralCache::GetInstance();
+    const size_t sizes[] = {64, 128, 256, 512, 1024, 2048};
+
+    // 上限只够两个最大的Span
+    size_t spanBytes = 0;
+    for (size_t size : sizes) {
+        spanBytes = max(spanBytes, SizeClass::NumMovePage(size) << PAGE_SHIFT);
+    }
+    size_t cap = 2 * spanBytes;
+    Write("empty_span_bytes", cap);
+    assert(cc->EmptySpanBytes() == 0);
+
+    size_t kept = 0;
+    for (size_t size : sizes) {
+        Burst(size, 1);
+        kept += cc->EmptySpanCount(size);
+        assert(cc->EmptySpanBytes() <= cap);
+    }
+    assert(kept >= 2 && kept < sizeof(sizes) / sizeof(sizes[0]));
+    assert(Read("stats.empty_span_bytes") == cc->EmptySpanBytes());
+
+    // 第一个尺寸类保留的Span被复用后不再占用额度
+    assert(cc->EmptySpanCount(sizes[0]) == 1);
+    size_t before = cc->EmptySpanBytes();
+    vector<void*> objs;
+    FetchSpans(sizes[0], 1, objs);
+    assert(cc->EmptySpanBytes() == before - (SizeClass::NumMovePage(sizes[0]) << PAGE_SHIFT));
+    ReleaseAll(sizes[0], objs);
+
+    // 为0时不保留
+    Write("empty_span_bytes", 0);
+    assert(cc->EmptySpanTotal() == 0 && cc->EmptySpanBytes() == 0);
+    assert(Burst(sizes[2], 2) == 2);
+    assert(cc->EmptySpanCount(sizes[2]) == 0);
+    Write("empty_span_bytes", TuneDescribe(TUNE_EMPTY_SPAN_BYTES).def);
+
+    cout << "上限 " << cap << " 字节时 " << sizeof(sizes) / sizeof(sizes[0]) << " 个尺寸类共保留 "
+         << kept << " 个Span" << endl;
+    cout << "合计字节上限测试通过" << endl;
+}
+
+/**
+ * @brief 连续三轮清理未用到的尺寸类归还保留的Span，上限减半；用到的尺寸类保持不变
+ */
+void testIdleRelease() {
+    cout << "=== 空闲归还测试 ===" << endl;
+    const size_t IDLE = 2048;
+    const size_t BUSY = 4096;
+    CentralCache* cc = CentralCache::GetInstance();
+
+    // 把IDLE的上限推到4
+    for (int round = 0; round < 5; round++) {
+        Burst(IDLE, 4);
+    }
+    assert(cc->EmptySpanCount(IDLE) == 4);
+    Burst(BUSY, 1);
+    assert(cc->EmptySpanCount(BUSY) == 1);
+
+    // 两轮内仍保留
+    cc->ReleaseIdleSpans();
+    cc->ReleaseIdleSpans();
+    assert(cc->EmptySpanCount(IDLE) == 4);
+
+    // BUSY每轮之间都被用到
+    for (int round = 0; round < 4; round++) {
+        Burst(BUSY, 1);
+        cc->ReleaseIdleSpans();
+    }
+    assert(cc->EmptySpanCount(IDLE) == 0);
+    assert(cc->EmptySpanCount(BUSY) == 1);
+
+    // 上限减半为2：一次突发4个Span后只留2个
+    assert(Burst(IDLE, 4) == 4);
+    assert(cc->EmptySpanCount(IDLE) == 2);
+
+    // 按时间清理：由慢路径或后台回收线程触发
+    Write("empty_span_idle_ms", 20);
+    auto deadline = steady_clock::now() + seconds(5);
+    while (cc->EmptySpanCount(IDLE) > 0 && steady_clock::now() < deadline) {
+        this_thread::sleep_for(milliseconds(5));
+        cc->MaybeReleaseIdle();
+    }
+    assert(cc->EmptySpanCount(IDLE) == 0);
+    assert(cc->EmptySpanCount(BUSY) == 0);
+    assert(Read("stats.empty_spans") == 0);
+    Write("empty_span_idle_ms", IDLE_NEVER_MS);
+
+    cout << "空闲归还测试通过" << endl;
+}
+
+/**
+ * @brief ReleaseEmptySpans归还所有尺寸类保留的Span，Span回到PageCache后可被其他尺寸类使用
+ */
+void testReleaseAll() {
+    cout << "=== 全部归还测试 ===" << endl;
+    CentralCache* cc = CentralCache::GetInstance();
+    const size_t sizes[] = {64, 256, 1024};
+
+    for (size_t size : sizes) {
+        Burst(size, 1);
+        assert(cc->EmptySpanCount(size) == 1);
+    }
+    assert(Read("stats.empty_spans") >= 3);
+    assert(cc->EmptySpanTotal() == Read("stats.empty_spans"));
+
+    cc->ReleaseEmptySpans();
+    assert(Read("stats.empty_spans") == 0);
+    for (size_t size : sizes) {
+        assert(cc->EmptySpanCount(size) == 0);
+        assert(cc->SpanCount(size) == 0);
+    }
+
+    // 通过公开接口申请释放后数据完整
+    vector<char*> ptrs;
+    for (int i = 0; i < 5000; i++) {
+        char* p = (char*)ConcurrencyAlloc(200);
+        memset(p, i & 0xFF, 200);
+        ptrs.push_back(p);
+    }
+    for (int i = 0; i < 5000; i++) {
+        assert((unsigned char)ptrs[i][199] == (i & 0xFF));
+        ConcurrencyFree(ptrs[i]);
+    }
+
+    cout << "全部归还测试通过" << endl;
+}
+
+/**
+ * @brief 业务线程全部静止、不调用任何清理接口时，后台回收线程把保留的Span和批次全部归还
+ */
+void testIdleProcess() {
+    cout << "=== 静止进程归还测试 ===" << endl;
+    const size_t SIZE = 2048;
+    CentralCache* cc = CentralCache::GetInstance();
+
+    Burst(SIZE, 2);
+    Burst(8192, 1);
+    vector<void*> objs;
+    FetchSpans(SIZE, 1, objs);
+    size_t half = objs.size() / 2;
+    cc->InsertRange(objs.data(), half, SIZE);   // 一半作为一批放进批次缓存，其余归还给Span
+    assert(cc->TransferBatchCount(SIZE) == 1);
+    objs.erase(objs.begin(), objs.begin() + half);
+    ReleaseAll(SIZE, objs);
+    assert(Read("stats.empty_spans") > 0);
+
+    Write("empty_span_idle_ms", 20);
+    auto deadline = steady_clock::now() + seconds(5);
+    while ((Read("stats.empty_spans") > 0 || cc->TransferBatchCount(SIZE) > 0) &&
+           steady_clock::now() < deadline) {
+        this_thread::sleep_for(milliseconds(10));
+    }
+    assert(cc->TransferBatchCount(SIZE) == 0);
+    assert(Read("stats.empty_spans") == 0);
+    assert(Read("stats.empty_span_bytes") == 0);
+    assert(!cc->IdleWorkPending());
+    Write("empty_span_idle_ms", IDLE_NEVER_MS);
+
+    cout << "静止进程归还测试通过" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 反复突发取出并归还若干Span
+ * @return 耗时（毫秒）
+ */
+static double RunBursts(size_t size, size_t spans, int rounds, size_t& newSpans) {
+    size_t before = Read("stats.new_spans");
+    auto start = high_resolution_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        Burst(size, spans);
+    }
+    auto end = high_resolution_clock::now();
+    newSpans = Read("stats.new_spans") - before;
+    return duration_cast<microseconds>(end - start).count() / 1000.0;
+}
+
+/**
+ * @brief 对比开启与关闭空Span保留时突发负载的Span申请次数和耗时
+ */
+void benchmarkBursts() {
+    cout << "=== 突发负载性能测试 ===" << endl;
+    const size_t SPANS = 8;
+    const int ROUNDS = 2000;
+    const size_t sizes[] = {128, 8192};
+
+    for (size_t size : sizes) {
+        size_t offSpans = 0, onSpans = 0;
+        Write("empty_span_max", 0);
+        double offMs = RunBursts(size, SPANS, ROUNDS, offSpans);
+        Write("empty_span_max", TuneDescribe(TUNE_EMPTY_SPAN_MAX).def);
+        double onMs = RunBursts(size, SPANS, ROUNDS, onSpans);
+        CentralCache::GetInstance()->ReleaseEmptySpans();
+
+        cout << "对象 " << size << " 字节，每次突发 " << SPANS << " 个Span，" << ROUNDS << " 次:" << endl;
+        cout << "  不保留: 申请Span " << offSpans << " 次，耗时 " << offMs << " ms" << endl;
+        cout << "  保留:   申请Span " << onSpans << " 次，耗时 " << onMs << " ms" << endl;
+        assert(offSpans == SPANS * ROUNDS);
+        assert(onSpans < SPANS * ROUNDS / 10);
+    }
+}
+
+int main() {
+    cout << "空Span保留测试开始..." << endl << endl;
+
+    // 按轮次计时的断言不能被后台清理打乱
+    Write("empty_span_idle_ms", IDLE_NEVER_MS);
+
+    testReuse();
+    cout << endl;
+
+    testAdaptiveLimit();
+    cout << endl;
+
+    testDisabled();
+    cout << endl;
+
+    testByteCap();
+    cout << endl;
+
+    testIdleRelease();
+    cout << endl;
+
+    testIdleProcess();
+    cout << endl;
+
+    testReleaseAll();
+    cout << endl;
+
+    benchmarkBursts();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
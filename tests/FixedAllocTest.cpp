@@ -0,0 +1,243 @@
+/**
+ * @file FixedAllocTest.cpp
+ * @brief 编译期定长分配接口测试程序
+ * @details 验证编译期的对齐、桶索引计算与运行期一致，ConcurrencyAllocFixed与
+ *          ConcurrencyAlloc/ConcurrencyFree可以混用，TypedPool正确转发构造参数，
+ *          并对比定长接口与运行期大小接口的申请/释放耗时
+ */
+
+#include "ConcurrencyAllocator.h"
+#include <chrono>
+#include <string>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+// 编译期检查几个典型大小
+static_assert(SizeClass::RoundUpConst(1) == 8, "RoundUpConst(1)");
+static_assert(SizeClass::RoundUpConst(24) == 128, "RoundUpConst(24)");
+static_assert(SizeClass::IndexConst(128) == 15, "IndexConst(128)");
+static_assert(SizeClass::IndexConst(MAX_MEMORYSIZE) == MAX_BUCKETSIZE - 1, "IndexConst(MAX)");
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 所有大小上编译期版本与运行期版本结果相同
+ */
+void testConstMatchesRuntime() {
+    cout << "=== 编译期计算一致性测试 ===" << endl;
+
+    for (size_t size = 1; size <= MAX_MEMORYSIZE; size++) {
+        assert(SizeClass::RoundUpConst(size) == SizeClass::RoundUp(size));
+        assert(SizeClass::IndexConst(size) == SizeClass::Index(size));
+    }
+
+    cout << "编译期计算一致性测试通过！" << endl;
+}
+
+/**
+ * @brief 分配N字节，写满后按三种方式释放
+ */
+template<size_t N>
+static void CheckFixed() {
+    vector<void*> ptrs;
+    for (int i = 0; i < 2000; i++) {
+        void* p = ConcurrencyAllocFixed<N>();
+        assert(p);
+        memset(p, i & 0xFF, N);
+        ptrs.push_back(p);
+    }
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        unsigned char* bytes = (unsigned char*)ptrs[i];
+        assert(bytes[0] == (i & 0xFF) && bytes[N - 1] == (i & 0xFF));
+        if (i % 3 == 0) {
+            ConcurrencyFreeFixed<N>(ptrs[i]);
+        } else if (i % 3 == 1) {
+            ConcurrencyFree(ptrs[i]);
+        } else {
+            ConcurrencyFree(ptrs[i], N);
+        }
+    }
+
+    // 运行期接口分配的内存也能用定长接口释放
+    void* p = ConcurrencyAlloc(N);
+    ConcurrencyFreeFixed<N>(p);
+}
+
+void testFixedAlloc() {
+    cout << "=== 定长分配测试 ===" << endl;
+
+    CheckFixed<1>();
+    CheckFixed<8>();
+    CheckFixed<16>();
+    CheckFixed<24>();
+    CheckFixed<128>();
+    CheckFixed<1000>();
+    CheckFixed<4096>();
+    CheckFixed<70000>();
+    CheckFixed<MAX_MEMORYSIZE>();
+    CheckFixed<MAX_MEMORYSIZE + 1>();
+
+    // 释放后同一线程再次分配会复用刚释放的对象
+    void* a = ConcurrencyAllocFixed<64>();
+    ConcurrencyFreeFixed<64>(a);
+    void* b = ConcurrencyAllocFixed<64>();
+    assert(a == b);
+    ConcurrencyFreeFixed<64>(b);
+
+    cout << "定长分配测试通过！" << endl;
+}
+
+/**
+ * @brief 记录构造和析构次数的测试类型
+ */
+struct Tracked {
+    static int alive;
+    string name;
+    unique_ptr<int> value;
+
+    Tracked(string n, unique_ptr<int> v) : name(std::move(n)), value(std::move(v)) {
+        if (name == "throw") {
+            throw runtime_error("ctor failed");
+        }
+        ++alive;
+    }
+    ~Tracked() { --alive; }
+};
+int Tracked::alive = 0;
+
+void testTypedPool() {
+    cout << "=== TypedPool测试 ===" << endl;
+
+    TypedPool<Tracked> pool;
+    vector<Tracked*> objs;
+    for (int i = 0; i < 1000; i++) {
+        // unique_ptr只能移动，验证参数被完美转发
+        objs.push_back(pool.New("obj" + to_string(i), unique_ptr<int>(new int(i))));
+    }
+    assert(Tracked::alive == 1000);
+    for (int i = 0; i < 1000; i++) {
+        assert(objs[i]->name == "obj" + to_string(i));
+        assert(*objs[i]->value == i);
+    }
+
+    bool thrown = false;
+    try {
+        pool.New("throw", unique_ptr<int>());
+    } catch (const runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown && Tracked::alive == 1000);
+
+    TypedPool<Tracked> other;
+    for (Tracked* obj : objs) {
+        other.Delete(obj);
+    }
+    other.Delete(nullptr);
+    assert(Tracked::alive == 0);
+
+    cout << "TypedPool测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+struct Node64 {
+    char data[64];
+};
+
+/**
+ * @brief 对比N字节对象在三种接口下每次申请+释放的耗时
+ */
+template<size_t N>
+static void BenchmarkSize() {
+    const size_t BATCH = 256;
+    const size_t ROUNDS = 20000;
+    void* ptrs[BATCH];
+    volatile size_t runtimeSize = N;   // 防止运行期路径被常量折叠
+
+    auto t0 = high_resolution_clock::now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < BATCH; i++) {
+            ptrs[i] = ConcurrencyAlloc(runtimeSize);
+        }
+        for (size_t i = 0; i < BATCH; i++) {
+            ConcurrencyFree(ptrs[i]);
+        }
+    }
+    auto t1 = high_resolution_clock::now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < BATCH; i++) {
+            ptrs[i] = ConcurrencyAlloc(runtimeSize);
+        }
+        for (size_t i = 0; i < BATCH; i++) {
+            ConcurrencyFree(ptrs[i], runtimeSize);
+        }
+    }
+    auto t2 = high_resolution_clock::now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < BATCH; i++) {
+            ptrs[i] = ConcurrencyAllocFixed<N>();
+        }
+        for (size_t i = 0; i < BATCH; i++) {
+            ConcurrencyFreeFixed<N>(ptrs[i]);
+        }
+    }
+    auto t3 = high_resolution_clock::now();
+
+    double ops = (double)BATCH * ROUNDS;
+    printf("  %-8zu %-14.2f %-14.2f %-14.2f\n", N,
+           duration_cast<nanoseconds>(t1 - t0).count() / ops,
+           duration_cast<nanoseconds>(t2 - t1).count() / ops,
+           duration_cast<nanoseconds>(t3 - t2).count() / ops);
+}
+
+void benchmarkFixed() {
+    cout << "=== 申请+释放耗时（ns/次） ===" << endl;
+    printf("  %-8s %-14s %-14s %-14s\n", "size", "运行期", "运行期+大小", "定长");
+    BenchmarkSize<8>();
+    BenchmarkSize<16>();
+    BenchmarkSize<64>();
+    BenchmarkSize<512>();
+    BenchmarkSize<4096>();
+
+    const size_t N = 5000000;
+    TypedPool<Node64> pool;
+    auto t0 = high_resolution_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        Node64* node = pool.New();
+        node->data[0] = (char)i;
+        pool.Delete(node);
+    }
+    auto t1 = high_resolution_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        ConcurrencyUniquePtr<Node64> node = ConcurrencyMakeUnique<Node64>();
+        node->data[0] = (char)i;
+    }
+    auto t2 = high_resolution_clock::now();
+    printf("  TypedPool<Node64> New/Delete:     %.2f ns/次\n", duration_cast<nanoseconds>(t1 - t0).count() / (double)N);
+    printf("  ConcurrencyMakeUnique<Node64>:    %.2f ns/次\n", duration_cast<nanoseconds>(t2 - t1).count() / (double)N);
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "编译期定长分配测试开始..." << endl << endl;
+
+    testConstMatchesRuntime();
+    cout << endl;
+
+    testFixedAlloc();
+    cout << endl;
+
+    testTypedPool();
+    cout << endl;
+
+    benchmarkFixed();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,357 @@
+/**
+ * @file LargeAllocTest.cpp
+ * @brief 超大内存缓存测试程序
+ * @details 验证已释放超大区域的切分复用、按年龄与上限归还，并对比开启/关闭保留时
+ *          1~8MB缓冲区反复申请释放的系统调用次数和延迟
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+static const size_t MB = 1024 * 1024;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 释放的超大Span被同等大小的申请复用
+ */
+void testReuse() {
+    cout << "=== 超大Span复用测试 ===" << endl;
+
+    PageCache* pc = PageCache::GetInstance();
+    pc->SetLargeCacheLimit(LARGE_CACHE_MAX_BYTES);
+
+    void* p = ConcurrencyAlloc(4 * MB);
+    memset(p, 1, 4 * MB);
+    ConcurrencyFree(p);
+    PageCacheStats before = pc->GetStats();
+    assert(before.largeCacheBytes >= 4 * MB);
+
+    // 稍小的请求最佳适配到同一块内存
+    void* q = ConcurrencyAlloc(4 * MB - 100 * 1024);
+    PageCacheStats after = pc->GetStats();
+    assert(q == p);
+    assert(after.largeCacheHits == before.largeCacheHits + 1);
+    assert(after.systemAllocs == before.systemAllocs);
+    ConcurrencyFree(q);
+
+    // 更小的请求从同一块空闲区域头部切分，剩余部分留在树中
+    before = pc->GetStats();
+    void* r = ConcurrencyAlloc(2 * MB);
+    void* t = ConcurrencyAlloc(1536 * 1024);
+    after = pc->GetStats();
+    assert(r == p);
+    assert((char*)t == (char*)r + 2 * MB);
+    assert(after.systemAllocs == before.systemAllocs);
+    ConcurrencyFree(r);
+    ConcurrencyFree(t);
+
+    // 释放后与相邻空闲页合并，超过128页的区域也能再次整块复用
+    void* u = ConcurrencyAlloc(4 * MB);
+    assert(u == p);
+    ConcurrencyFree(u);
+
+    cout << "超大Span复用测试通过！" << endl;
+}
+
+/**
+ * @brief 桶中没有合适的Span时，不超过128页的申请切分最佳适配树中的空闲区域
+ */
+void testSmallFromTree() {
+    cout << "=== 小Span切分超大区域测试 ===" << endl;
+
+    PageCache* pc = PageCache::GetInstance();
+    void* p = ConcurrencyAlloc(4 * MB);
+    ConcurrencyFree(p);
+
+    // 128页的桶只在整块128页空闲时非空
+    PageCacheStats before = pc->GetStats();
+    Span* span = nullptr;
+    {
+        std::lock_guard<PoolMutex> guard(pc->GetMutex());
+        span = pc->NewSpan(MAX_PAGESIZE - 1);
+        span->_isUse = true;
+    }
+    PageCacheStats after = pc->GetStats();
+    char* start = (char*)(span->_pageId << PAGE_SHIFT);
+    assert(after.systemAllocs == before.systemAllocs);
+    assert(start >= (char*)p && start < (char*)p + 4 * MB);
+    {
+        std::lock_guard<PoolMutex> guard(pc->GetMutex());
+        pc->ReleaseSpanToPageCache(span);
+    }
+
+    cout << "小Span切分超大区域测试通过！" << endl;
+}
+
+/**
+ * @brief 空闲超大Span超过LARGE_CACHE_MAX_AGE_MS未被复用时归还系统
+ */
+void testAge() {
+    cout << "=== 超龄归还测试 ===" << endl;
+
+    PageCache* pc = PageCache::GetInstance();
+    pc->SetLargeCacheLimit(LARGE_CACHE_MAX_BYTES);
+    void* p = ConcurrencyAlloc(4 * MB);
+    ConcurrencyFree(p);
+    PageCacheStats before = pc->GetStats();
+    assert(before.largeCacheBytes >= 4 * MB);
+
+    this_thread::sleep_for(milliseconds(LARGE_CACHE_MAX_AGE_MS + 100));
+
+    // 下一次向PageCache申请时先归还超龄的区域，申请只能向系统要
+    void* q = ConcurrencyAlloc(2 * MB);
+    PageCacheStats after = pc->GetStats();
+    assert(after.systemFrees > before.systemFrees);
+    assert(after.largeCacheBytes == 0);
+    assert(after.largeCacheHits == before.largeCacheHits);
+    ConcurrencyFree(q);
+
+    cout << "空闲 " << before.largeCacheBytes / MB << " MB 超龄后归还系统" << endl;
+    cout << "超龄归还测试通过！" << endl;
+}
+
+/**
+ * @brief 最佳适配树与有序集合逐一比对，挂入时间最早的Span与线性查找一致
+ */
+void testSpanTree() {
+    cout << "=== 最佳适配树测试 ===" << endl;
+
+    SpanTree tree;
+    vector<Span> spans(2000);
+    vector<bool> inTree(spans.size(), false);
+    mt19937 gen(11);
+    for (size_t i = 0; i < spans.size(); i++) {
+        spans[i]._pageId = i * 4096;
+        spans[i]._n = 129 + gen() % 300;
+        spans[i]._freeTime = gen() % 100000;
+    }
+
+    for (int round = 0; round < 20000; round++) {
+        size_t i = gen() % spans.size();
+        if (inTree[i]) {
+            tree.Erase(&spans[i]);
+        } else {
+            tree.Insert(&spans[i]);
+        }
+        inTree[i] = !inTree[i];
+
+        size_t k = 129 + gen() % 320;
+        Span* expect = nullptr;
+        for (size_t j = 0; j < spans.size(); j++) {
+            if (!inTree[j] || spans[j]._n < k) continue;
+            if (!expect || spans[j]._n < expect->_n ||
+                (spans[j]._n == expect->_n && spans[j]._pageId < expect->_pageId)) {
+                expect = &spans[j];
+            }
+        }
+        assert(tree.BestFit(k) == expect);
+
+        Span* oldest = nullptr;
+        for (size_t j = 0; j < spans.size(); j++) {
+            if (inTree[j] && (!oldest || spans[j]._freeTime < oldest->_freeTime)) {
+                oldest = &spans[j];
+            }
+        }
+        assert(oldest ? tree.Oldest()->_freeTime == oldest->_freeTime : tree.Oldest() == nullptr);
+    }
+
+    cout << "最佳适配树测试通过！" << endl;
+}
+
+/**
+ * @brief 缓存总字节上限生效，超出部分归还系统
+ */
+void testLimit() {
+    cout << "=== 缓存上限测试 ===" << endl;
+
+    PageCache* pc = PageCache::GetInstance();
+    pc->SetLargeCacheLimit(8 * MB);
+
+    vector<void*> v;
+    for (int i = 0; i < 8; i++) {
+        v.push_back(ConcurrencyAlloc(3 * MB));
+    }
+    for (void* p : v) {
+        ConcurrencyFree(p);
+    }
+    assert(pc->GetStats().largeCacheBytes <= 8 * MB);
+
+    pc->SetLargeCacheLimit(0);
+    assert(pc->GetStats().largeCacheBytes == 0);
+
+    cout << "缓存上限测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 1~8MB缓冲区的申请释放负载
+ * @param cacheLimit 缓存上限，0表示关闭缓存
+ * @param label 输出标签
+ */
+void benchmarkChurn(size_t cacheLimit, const char* label) {
+    PageCache* pc = PageCache::GetInstance();
+    pc->SetLargeCacheLimit(cacheLimit);
+    PageCacheStats before = pc->GetStats();
+
+    const size_t N = 20000;
+    const size_t LIVE = 4;  // 同时存活的缓冲区数量
+    mt19937 gen(42);
+    uniform_int_distribution<size_t> dis(1, 8);
+
+    vector<void*> live(LIVE, nullptr);
+    vector<long long> lat;
+    lat.reserve(N);
+
+    auto begin = high_resolution_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        size_t slot = i % LIVE;
+        auto t0 = high_resolution_clock::now();
+        if (live[slot]) {
+            ConcurrencyFree(live[slot]);
+        }
+        size_t size = dis(gen) * MB;
+        live[slot] = ConcurrencyAlloc(size);
+        auto t1 = high_resolution_clock::now();
+        lat.push_back(duration_cast<nanoseconds>(t1 - t0).count());
+
+        // 模拟I/O写入首尾页
+        ((char*)live[slot])[0] = 1;
+        ((char*)live[slot])[size - 1] = 1;
+    }
+    for (void* p : live) {
+        ConcurrencyFree(p);
+    }
+    auto end = high_resolution_clock::now();
+
+    PageCacheStats after = pc->GetStats();
+    sort(lat.begin(), lat.end());
+    cout << label << ":" << endl;
+    cout << "  总耗时: " << duration_cast<milliseconds>(end - begin).count() << " ms" << endl;
+    cout << "  SystemAlloc(mmap)次数: " << after.systemAllocs - before.systemAllocs
+         << ", SystemFree(munmap)次数: " << after.systemFrees - before.systemFrees
+         << ", 缓存命中: " << after.largeCacheHits - before.largeCacheHits << endl;
+    cout << "  释放+申请延迟 p50: " << lat[N / 2] << " ns, p99: " << lat[N * 99 / 100]
+         << " ns, max: " << lat[N - 1] << " ns" << endl;
+}
+
+/**
+ * @brief 读取当前进程的常驻内存（RSS）
+ * @return 字节数
+ */
+static size_t CurrentRSS() {
+    size_t pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%zu %zu", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return resident * 4096;
+}
+
+/**
+ * @brief 大小对象混合负载下的RSS与mmap次数
+ * @details 64个300KB~6MB的大缓冲区与两万个16B~4KB的小对象随机替换，
+ *          大对象释放后的区域可以被其他大小的大对象或小对象的Span切分复用
+ */
+void benchmarkMixed() {
+    PageCache* pc = PageCache::GetInstance();
+    pc->SetLargeCacheLimit(LARGE_CACHE_MAX_BYTES);
+    PageCacheStats before = pc->GetStats();
+
+    const size_t N = 100000;
+    const size_t LARGE_LIVE = 64;
+    const size_t SMALL_LIVE = 20000;
+    mt19937 gen(2024);
+    uniform_int_distribution<size_t> largeSize(300 * 1024, 6 * MB);
+    uniform_int_distribution<size_t> smallSize(16, 4096);
+
+    vector<void*> large(LARGE_LIVE, nullptr);
+    vector<void*> small(SMALL_LIVE, nullptr);
+    size_t peakRSS = 0;
+
+    auto begin = high_resolution_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        if (i % 16 == 0) {
+            size_t slot = gen() % LARGE_LIVE;
+            if (large[slot]) {
+                ConcurrencyFree(large[slot]);
+            }
+            size_t size = largeSize(gen);
+            large[slot] = ConcurrencyAlloc(size);
+            // 逐页写入，模拟缓冲区被填满
+            for (size_t off = 0; off < size; off += 4096) {
+                ((char*)large[slot])[off] = 1;
+            }
+        } else {
+            size_t slot = gen() % SMALL_LIVE;
+            if (small[slot]) {
+                ConcurrencyFree(small[slot]);
+            }
+            small[slot] = ConcurrencyAlloc(smallSize(gen));
+            *(char*)small[slot] = 1;
+        }
+        if (i % 4096 == 0) {
+            peakRSS = max(peakRSS, CurrentRSS());
+        }
+    }
+    auto end = high_resolution_clock::now();
+    size_t endRSS = CurrentRSS();
+
+    for (void* p : large) {
+        if (p) ConcurrencyFree(p);
+    }
+    for (void* p : small) {
+        if (p) ConcurrencyFree(p);
+    }
+
+    PageCacheStats after = pc->GetStats();
+    cout << "  总耗时: " << duration_cast<milliseconds>(end - begin).count() << " ms" << endl;
+    cout << "  SystemAlloc(mmap)次数: " << after.systemAllocs - before.systemAllocs
+         << ", SystemFree(munmap)次数: " << after.systemFrees - before.systemFrees << endl;
+    cout << "  RSS峰值: " << peakRSS / MB << " MB, 结束时RSS: " << endRSS / MB << " MB" << endl;
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "超大内存缓存测试开始..." << endl << endl;
+
+    testSpanTree();
+    cout << endl;
+
+    testReuse();
+    cout << endl;
+
+    testSmallFromTree();
+    cout << endl;
+
+    testAge();
+    cout << endl;
+
+    testLimit();
+    cout << endl;
+
+    cout << "=== 大小对象混合负载 ===" << endl;
+    benchmarkMixed();
+    cout << endl;
+
+    cout << "=== 1~8MB缓冲区申请释放性能对比 ===" << endl;
+    benchmarkChurn(0, "关闭缓存（每次mmap/munmap）");
+    benchmarkChurn(LARGE_CACHE_MAX_BYTES, "开启缓存（上限64MB）");
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
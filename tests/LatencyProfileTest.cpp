@@ -0,0 +1,204 @@
+/**
+ * @file LatencyProfileTest.cpp
+ * @brief 分层延迟直方图测试程序
+ * @details 以-DHCMP_LATENCY_PROFILE编译，验证申请/释放两侧每条路径都被记录、快路径按1/N采样、
+ *          存活线程与已退出线程的直方图在读取时合并，打印多线程混合负载下的分层延迟报告，
+ *          并测量计时本身的开销
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "CentralCache.h"
+#include <sstream>
+#include <chrono>
+#include <atomic>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 小对象、大对象各走一遍，申请与释放两侧的所有路径都有记录
+ */
+void testCoverage() {
+    cout << "=== 路径覆盖测试 ===" << endl;
+
+    // 关闭无锁批次缓存，保证整批归还一定经过ReleaseListToSpan；不保留空闲超大Span，释放时归还系统
+    CentralCache::GetInstance()->SetTransferCacheEnabled(false);
+    PageCache::GetInstance()->SetLargeCacheLimit(0);
+    LatencyProfileReset();
+
+    thread t([]() {
+        vector<void*> ptrs;
+        for (int i = 0; i < 100000; i++) {
+            ptrs.push_back(ConcurrencyAlloc(8 + (i % 64) * 16));
+        }
+        for (void* p : ptrs) {
+            ConcurrencyFree(p);
+        }
+        ConcurrencyFree(ConcurrencyAlloc(4 * 1024 * 1024));
+    });
+    t.join();
+
+    for (size_t p = 0; p < LAT_PATH_COUNT; p++) {
+        LatencySummary s = LatencyProfileGet((LatencyPath)p);
+        assert(s.count > 0);
+        assert(s.p50 <= s.p99 && s.p99 <= s.p999);
+    }
+
+    ostringstream os;
+    LatencyProfileReport(os);
+    string report = os.str();
+    assert(report.find("GetOneSpan refill") != string::npos);
+    assert(report.find("ReleaseSpanToPageCache") != string::npos);
+    assert(report.find("SystemFree") != string::npos);
+
+    CentralCache::GetInstance()->SetTransferCacheEnabled(true);
+    PageCache::GetInstance()->SetLargeCacheLimit(LARGE_CACHE_MAX_BYTES);
+    cout << "路径覆盖测试通过！" << endl;
+}
+
+/**
+ * @brief ThreadCache命中按1/HCMP_LATENCY_SAMPLE_RATE采样
+ */
+void testSampling() {
+    cout << "=== 快路径采样测试 ===" << endl;
+
+    const size_t N = 64 * 10000;
+    LatencyProfileReset();
+    thread t([]() {
+        void* warm = ConcurrencyAlloc(16);
+        ConcurrencyFree(warm);
+        LatencyProfileReset();
+        for (size_t i = 0; i < N; i++) {
+            ConcurrencyFree(ConcurrencyAlloc(16));
+        }
+    });
+    t.join();
+
+    // 同一个对象反复申请释放，除第一次外全部命中
+    uint64_t allocs = LatencyProfileGet(LAT_TC_ALLOC).count;
+    uint64_t frees = LatencyProfileGet(LAT_TC_FREE).count;
+    assert(allocs + 1 >= N / HCMP_LATENCY_SAMPLE_RATE && allocs <= N / HCMP_LATENCY_SAMPLE_RATE + 1);
+    assert(frees + 1 >= N / HCMP_LATENCY_SAMPLE_RATE && frees <= N / HCMP_LATENCY_SAMPLE_RATE + 1);
+
+    cout << "采样次数: 申请 " << allocs << ", 释放 " << frees << endl;
+    cout << "快路径采样测试通过！" << endl;
+}
+
+/**
+ * @brief 已退出线程与仍存活线程的记录都能读到，分位数落在对应的桶
+ */
+void testMerge() {
+    cout << "=== 跨线程合并测试 ===" << endl;
+
+    LatencyProfileReset();
+    thread exited([]() {
+        for (int i = 0; i < 990; i++) {
+            LatencyRecord(LAT_SYSTEM_FREE, 100);
+        }
+    });
+    exited.join();
+
+    atomic<bool> recorded(false), done(false);
+    thread alive([&]() {
+        for (int i = 0; i < 10; i++) {
+            LatencyRecord(LAT_SYSTEM_FREE, 1000000);
+        }
+        recorded = true;
+        while (!done) {
+            this_thread::yield();
+        }
+    });
+    while (!recorded) {
+        this_thread::yield();
+    }
+
+    LatencySummary s = LatencyProfileGet(LAT_SYSTEM_FREE);
+    done = true;
+    alive.join();
+
+    assert(s.count == 1000);
+    // p50落在100个计时单位的桶，p99.9落在1000000个计时单位的桶
+    assert(s.p50 < s.p999);
+    assert(s.max >= s.p999 * 0.8);
+
+    cout << "跨线程合并测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 4个线程跑混合大小负载，打印分层延迟报告
+ */
+void benchmarkReport() {
+    cout << "=== 4线程混合负载分层延迟 ===" << endl;
+
+    LatencyProfileReset();
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t]() {
+            vector<void*> ptrs;
+            for (int round = 0; round < 20; round++) {
+                for (size_t i = 0; i < 20000; i++) {
+                    size_t size = (i % 500 == 0) ? 300 * 1024 : 8 + ((i + t) * 40) % 4000;
+                    ptrs.push_back(ConcurrencyAlloc(size));
+                }
+                for (void* p : ptrs) {
+                    ConcurrencyFree(p);
+                }
+                ptrs.clear();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    LatencyProfileReport();
+}
+
+/**
+ * @brief 计时作用域本身的开销
+ */
+void benchmarkOverhead() {
+    cout << "=== 计时开销 ===" << endl;
+
+    const size_t N = 10000000;
+    auto t0 = high_resolution_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        HCMP_LATENCY_SAMPLED(LAT_TC_ALLOC);
+    }
+    auto t1 = high_resolution_clock::now();
+    for (size_t i = 0; i < N / 10; i++) {
+        HCMP_LATENCY_SCOPE(LAT_NEW_SPAN);
+    }
+    auto t2 = high_resolution_clock::now();
+
+    printf("  采样作用域: %.2f ns/次\n", duration_cast<nanoseconds>(t1 - t0).count() / (double)N);
+    printf("  计时作用域: %.2f ns/次\n", duration_cast<nanoseconds>(t2 - t1).count() / (double)(N / 10));
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "分层延迟直方图测试开始..." << endl << endl;
+
+    testCoverage();
+    cout << endl;
+
+    testSampling();
+    cout << endl;
+
+    testMerge();
+    cout << endl;
+
+    benchmarkReport();
+    cout << endl;
+
+    benchmarkOverhead();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file MagazineTest.cpp
+ * @brief magazine线程缓存测试程序
+ * @details 同一份源码分别以-DHCMP_MAGAZINE（指针数组）和默认（对象内嵌自由链表）编译，
+ *          验证两种桶表示下跨线程释放、慢启动上限、延迟释放与定长接口的正确性，
+ *          并对比对象已不在缓存中时申请、整批归还的耗时以及热路径的耗时
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "CentralCache.h"
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+#ifdef HCMP_MAGAZINE
+static const char* MODE_NAME = "magazine";
+#else
+static const char* MODE_NAME = "自由链表";
+#endif
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 一个线程申请、另一个线程释放，释放线程的桶此前从未向CentralCache取过对象
+ */
+void testCrossThreadFree() {
+    cout << "=== 跨线程释放测试 ===" << endl;
+
+    const size_t N = 100000;
+    vector<size_t*> ptrs;
+    thread producer([&]() {
+        for (size_t i = 0; i < N; i++) {
+            size_t size = 16 + (i % 97) * 24;
+            size_t* p = (size_t*)ConcurrencyAlloc(size);
+            p[0] = i;
+            p[size / sizeof(size_t) - 1] = size;
+            ptrs.push_back(p);
+        }
+    });
+    producer.join();
+
+    thread consumer([&]() {
+        for (size_t i = 0; i < N; i++) {
+            size_t size = 16 + (i % 97) * 24;
+            assert(ptrs[i][0] == i && ptrs[i][size / sizeof(size_t) - 1] == size);
+            ConcurrencyFree(ptrs[i]);
+            size_t index = SizeClass::Index(SizeClass::RoundUp(size));
+            assert(pTLSThreadCache->ListLength(index) < pTLSThreadCache->MaxSize(index));
+        }
+    });
+    consumer.join();
+
+    cout << "跨线程释放测试通过！" << endl;
+}
+
+/**
+ * @brief 慢启动上限增长到最大后，桶中对象数始终小于上限，反复申请释放不丢失对象
+ */
+void testFullBatches() {
+    cout << "=== 整批交换测试 ===" << endl;
+
+    thread t([]() {
+        const size_t SIZE = 128;
+        size_t index = SizeClass::Index(SIZE);
+        vector<void*> ptrs;
+        for (int round = 0; round < 20; round++) {
+            for (int i = 0; i < 5000; i++) {
+                void* p = ConcurrencyAlloc(SIZE);
+                memset(p, round, SIZE);
+                ptrs.push_back(p);
+            }
+            for (void* p : ptrs) {
+                assert(*(unsigned char*)p == (unsigned char)round);
+                ConcurrencyFree(p);
+                assert(pTLSThreadCache->ListLength(index) < pTLSThreadCache->MaxSize(index));
+            }
+            ptrs.clear();
+        }
+        assert(pTLSThreadCache->MaxSize(index) >= SizeClass::NumMoveSize(SIZE));
+    });
+    t.join();
+
+    cout << "整批交换测试通过！" << endl;
+}
+
+/**
+ * @brief 开启延迟释放，以及关闭无锁批次缓存时，整批归还的对象都能再次分配
+ */
+void testHandoffPaths() {
+    cout << "=== 归还路径测试 ===" << endl;
+
+    for (int mode = 0; mode < 3; mode++) {
+        CentralCache::GetInstance()->SetTransferCacheEnabled(mode != 2);
+        thread t([mode]() {
+            ConcurrencySetDeferredFree(mode == 1);
+            vector<void*> ptrs;
+            for (int i = 0; i < 50000; i++) {
+                void* p = ConcurrencyAlloc(256);
+                memset(p, 0x3C, 256);
+                ptrs.push_back(p);
+            }
+            for (void* p : ptrs) {
+                ConcurrencyFree(p);
+            }
+        });
+        t.join();
+        DeferredFree::GetInstance()->Flush();
+    }
+    CentralCache::GetInstance()->SetTransferCacheEnabled(true);
+
+    // 关闭批次缓存时全部对象已归还给Span
+    assert(CentralCache::GetInstance()->SpanCount(256) == 0);
+
+    cout << "归还路径测试通过！" << endl;
+}
+
+/**
+ * @brief 定长接口与按大小接口共用同一个桶
+ */
+void testFixedApi() {
+    cout << "=== 定长接口测试 ===" << endl;
+
+    thread t([]() {
+        vector<void*> ptrs;
+        for (int i = 0; i < 10000; i++) {
+            ptrs.push_back(i % 2 ? ConcurrencyAllocFixed<48>() : ConcurrencyAlloc(48));
+        }
+        for (size_t i = 0; i < ptrs.size(); i++) {
+            if (i % 3) {
+                ConcurrencyFreeFixed<48>(ptrs[i]);
+            } else {
+                ConcurrencyFree(ptrs[i]);
+            }
+        }
+    });
+    t.join();
+
+    cout << "定长接口测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 写一遍大缓冲区，把之前访问过的对象挤出缓存
+ */
+static void EvictCaches() {
+    static vector<char> buffer(32 * 1024 * 1024);
+    static char value = 0;
+    value++;
+    for (size_t i = 0; i < buffer.size(); i += 64) {
+        buffer[i] = value;
+    }
+}
+
+/**
+ * @brief 桶中缓存的对象已不在CPU缓存中时，从ThreadCache申请的单次耗时
+ * @details 每轮先把桶中对象数调整到固定值，申请释放K个对象都不会与CentralCache交换，
+ *          只测量桶本身的弹出
+ */
+static double MeasureColdPop() {
+    const size_t SIZE = 128;
+    const size_t ALIGN = SizeClass::RoundUp(SIZE);
+    const size_t K = 128;
+    const size_t ROUNDS = 200;
+    double total = 0;
+    thread t([&]() {
+        ThreadCache* tc = GetThreadCache();
+        size_t index = SizeClass::Index(SIZE);
+        vector<void*> ptrs(K);
+        vector<void*> keep;
+
+        // 先把慢启动上限升到最大
+        size_t maxSize = SizeClass::NumMoveSize(ALIGN);
+        while (tc->MaxSize(index) <= maxSize) {
+            keep.push_back(tc->Allocate(SIZE));
+        }
+        // 桶中对象数调整为上限的一半：减到0时会整批取回，随后再逐个取出
+        size_t target = tc->MaxSize(index) / 2;
+        while (tc->ListLength(index) != target) {
+            keep.push_back(tc->Allocate(SIZE));
+        }
+
+        long long ns = 0;
+        for (size_t r = 0; r < ROUNDS; r++) {
+            EvictCaches();
+            auto t0 = steady_clock::now();
+            for (size_t i = 0; i < K; i++) {
+                ptrs[i] = tc->Allocate(SIZE);
+            }
+            auto t1 = steady_clock::now();
+            ns += duration_cast<nanoseconds>(t1 - t0).count();
+            for (size_t i = 0; i < K; i++) {
+                tc->Deallocate(ptrs[i], ALIGN);
+            }
+            assert(tc->ListLength(index) == target);
+        }
+        total = (double)ns / (ROUNDS * K);
+        for (void* p : keep) {
+            tc->Deallocate(p, ALIGN);
+        }
+    });
+    t.join();
+    return total;
+}
+
+/**
+ * @brief 对象已不在CPU缓存中时逐个释放，包含ListTooLong整批交给CentralCache的耗时
+ */
+static double MeasureColdRelease() {
+    const size_t SIZE = 128;
+    const size_t ALIGN = SizeClass::RoundUp(SIZE);
+    const size_t N = 64 * 1024;
+    const size_t ROUNDS = 20;
+    double total = 0;
+    thread t([&]() {
+        ThreadCache* tc = GetThreadCache();
+        vector<void*> ptrs(N);
+        long long ns = 0;
+        for (size_t r = 0; r < ROUNDS; r++) {
+            for (size_t i = 0; i < N; i++) {
+                ptrs[i] = tc->Allocate(SIZE);
+            }
+            EvictCaches();
+            auto t0 = steady_clock::now();
+            for (size_t i = 0; i < N; i++) {
+                tc->Deallocate(ptrs[i], ALIGN);
+            }
+            auto t1 = steady_clock::now();
+            ns += duration_cast<nanoseconds>(t1 - t0).count();
+        }
+        total = (double)ns / (ROUNDS * N);
+    });
+    t.join();
+    return total;
+}
+
+// 对齐后的大小，申请与释放落在同一个桶
+static const size_t HOT_SIZES[] = {8, 16, 128, 1024};
+
+/**
+ * @brief 热路径：同一批对象反复申请释放
+ */
+static double MeasureHot() {
+    const size_t K = 64;
+    const size_t ROUNDS = 100000;
+    double total = 0;
+    thread t([&]() {
+        ThreadCache* tc = GetThreadCache();
+        void* ptrs[K];
+        for (size_t r = 0; r < 1000; r++) {
+            for (size_t i = 0; i < K; i++) {
+                ptrs[i] = tc->Allocate(HOT_SIZES[i % 4]);
+            }
+            for (size_t i = 0; i < K; i++) {
+                tc->Deallocate(ptrs[i], HOT_SIZES[i % 4]);
+            }
+        }
+        auto t0 = steady_clock::now();
+        for (size_t r = 0; r < ROUNDS; r++) {
+            for (size_t i = 0; i < K; i++) {
+                ptrs[i] = tc->Allocate(HOT_SIZES[i % 4]);
+            }
+            for (size_t i = 0; i < K; i++) {
+                tc->Deallocate(ptrs[i], HOT_SIZES[i % 4]);
+            }
+        }
+        auto t1 = steady_clock::now();
+        total = (double)duration_cast<nanoseconds>(t1 - t0).count() / (ROUNDS * K);
+    });
+    t.join();
+    return total;
+}
+
+void benchmarkMagazine() {
+    cout << "=== " << MODE_NAME << "：单次操作耗时（ns） ===" << endl;
+    cout << "  直接调用ThreadCache::Allocate/Deallocate，不含页号到Span的查找" << endl;
+
+    printf("  %-28s %.2f\n", "冷对象申请", MeasureColdPop());
+    printf("  %-28s %.2f\n", "冷对象释放（含整批归还）", MeasureColdRelease());
+    printf("  %-28s %.2f\n", "热路径申请+释放", MeasureHot());
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "magazine线程缓存测试开始（" << MODE_NAME << "）..." << endl << endl;
+
+    testCrossThreadFree();
+    cout << endl;
+
+    testFullBatches();
+    cout << endl;
+
+    testHandoffPaths();
+    cout << endl;
+
+    testFixedApi();
+    cout << endl;
+
+    benchmarkMagazine();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
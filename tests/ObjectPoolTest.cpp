@@ -0,0 +1,192 @@
+/**
+ * @file ObjectPoolTest.cpp
+ * @brief 对象池测试程序
+ * @details 验证ConcurrentObjectPool多线程下对象不重复、跨线程释放可复用、
+ *          完全空闲的内存块可归还给系统，并运行多线程性能对比
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <atomic>
+#include <set>
+#include <cassert>
+
+using namespace std;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 单线程：对象已构造、互不重叠、释放后可复用
+ */
+void testBasic() {
+    cout << "=== 基本功能测试 ===" << endl;
+
+    ConcurrentObjectPool<TreeNode> pool;
+    vector<TreeNode*> nodes;
+    set<TreeNode*> unique;
+    for (int i = 0; i < 100000; i++) {
+        TreeNode* node = pool.New();
+        assert(node->_val == 0 && node->_left == nullptr && node->_right == nullptr);
+        node->_val = i;
+        nodes.push_back(node);
+        unique.insert(node);
+    }
+    assert(unique.size() == nodes.size());
+    for (int i = 0; i < 100000; i++) {
+        assert(nodes[i]->_val == i);
+    }
+
+    size_t blocks = pool.BlockCount();
+    for (TreeNode* node : nodes) {
+        pool.Delete(node);
+    }
+    for (int i = 0; i < 100000; i++) {
+        nodes[i] = pool.New();
+    }
+    assert(pool.BlockCount() == blocks);   // 全部复用，没有申请新内存块
+    for (TreeNode* node : nodes) {
+        pool.Delete(node);
+    }
+
+    cout << "基本功能测试通过！" << endl;
+}
+
+/**
+ * @brief 多线程：一半线程申请，另一半线程释放，活跃对象互不重复
+ */
+void testCrossThread() {
+    cout << "=== 跨线程释放测试 ===" << endl;
+
+    ConcurrentObjectPool<TreeNode> pool;
+    const int PAIRS = 4;
+    const int N = 200000;
+
+    vector<vector<TreeNode*>> handoff(PAIRS, vector<TreeNode*>(N));
+    vector<atomic<int>> ready(PAIRS);
+    for (auto& r : ready) {
+        r = 0;
+    }
+
+    vector<thread> threads;
+    for (int p = 0; p < PAIRS; p++) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < N; i++) {
+                TreeNode* node = pool.New();
+                node->_val = p * N + i;
+                handoff[p][i] = node;
+                ready[p].store(i + 1, memory_order_release);
+            }
+        });
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < N; i++) {
+                while (ready[p].load(memory_order_acquire) <= i) {
+                    this_thread::yield();
+                }
+                TreeNode* node = handoff[p][i];
+                assert(node->_val == p * N + i);
+                pool.Delete(node);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // 对象全部归还，线程退出时magazine也已放回共享链表
+    assert(pool.ReleaseFreeBlocks() > 0);
+    assert(pool.BlockCount() == 0);
+
+    cout << "跨线程释放测试通过！" << endl;
+}
+
+/**
+ * @brief 仍有对象存活的内存块不会被归还
+ */
+void testReleaseFreeBlocks() {
+    cout << "=== 空闲内存块归还测试 ===" << endl;
+
+    ConcurrentObjectPool<TreeNode> pool;
+    vector<TreeNode*> nodes;
+    for (int i = 0; i < 100000; i++) {
+        nodes.push_back(pool.New());
+    }
+    size_t blocks = pool.BlockCount();
+    assert(blocks > 2);
+
+    TreeNode* keep = nodes[0];
+    for (size_t i = 1; i < nodes.size(); i++) {
+        pool.Delete(nodes[i]);
+    }
+    assert(pool.ReleaseFreeBlocks() == blocks - 1);
+    assert(pool.BlockCount() == 1);
+
+    // 剩下的内存块仍可正常使用
+    keep->_val = 42;
+    TreeNode* other = pool.New();
+    assert(other != keep && keep->_val == 42);
+    pool.Delete(other);
+    pool.Delete(keep);
+    assert(pool.ReleaseFreeBlocks() == 1);
+    assert(pool.BlockCount() == 0);
+
+    // 归还后还能继续申请
+    TreeNode* again = pool.New();
+    assert(pool.BlockCount() == 1);
+    pool.Delete(again);
+
+    cout << "空闲内存块归还测试通过！" << endl;
+}
+
+/**
+ * @brief 多线程首次分配同时创建ThreadCache
+ */
+void testThreadCacheCreation() {
+    cout << "=== ThreadCache并发创建测试 ===" << endl;
+
+    vector<thread> threads;
+    for (int t = 0; t < 32; t++) {
+        threads.emplace_back([]() {
+            void* p = ConcurrencyAlloc(64);
+            *(int*)p = 1;
+            ConcurrencyFree(p);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    cout << "ThreadCache并发创建测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+void benchmarkObjectPool() {
+    cout << "=== 对象池多线程性能 ===" << endl;
+    size_t threadCounts[] = {1, 4, 16};
+    for (size_t n : threadCounts) {
+        TestObjectPool(n);
+    }
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "对象池测试开始..." << endl << endl;
+
+    testBasic();
+    cout << endl;
+
+    testCrossThread();
+    cout << endl;
+
+    testReleaseFreeBlocks();
+    cout << endl;
+
+    testThreadCacheCreation();
+    cout << endl;
+
+    benchmarkObjectPool();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
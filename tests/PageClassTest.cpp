@@ -0,0 +1,255 @@
+/**
+ * @file PageClassTest.cpp
+ * @brief 页号到尺寸类映射与线程页号缓存测试程序
+ * @details 验证小对象Span的页记录尺寸类、Span归还后映射被清除且纪元推进、页被其他尺寸类复用后
+ *          线程缓存不会给出过期的大小、多线程乱序释放数据完整，并测量乱序释放时每次ConcurrencyFree的周期数
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "CentralCache.h"
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cassert>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PAGE_CLASS_TEST_RDTSC
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+static PAGE_ID PageOf(void* p) {
+    return (PAGE_ID)p >> PAGE_SHIFT;
+}
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 小对象所在页能查到对齐后的大小，大对象与Span归还后的页查不到
+ */
+void testClassMap() {
+    cout << "=== 尺寸类映射测试 ===" << endl;
+
+    CentralCache::GetInstance()->SetTransferCacheEnabled(false);
+    PageCache* pc = PageCache::GetInstance();
+
+    thread t([pc]() {
+        size_t sizes[] = {8, 16, 100, 128, 1000, 5000, 8192, 100 * 1024, MAX_MEMORYSIZE};
+        for (size_t size : sizes) {
+            vector<void*> ptrs;
+            for (int i = 0; i < 2000; i++) {
+                ptrs.push_back(ConcurrencyAlloc(size));
+            }
+            for (void* p : ptrs) {
+                assert(pc->PageObjectSize(PageOf(p)) == SizeClass::RoundUp(size));
+            }
+            for (void* p : ptrs) {
+                ConcurrencyFree(p);
+            }
+        }
+
+        void* big = ConcurrencyAlloc(MAX_MEMORYSIZE + 1);
+        assert(pc->PageObjectSize(PageOf(big)) == 0);
+        ConcurrencyFree(big);
+    });
+    t.join();
+
+    // 以非对齐大小直接从CentralCache取出的对象不记录尺寸类
+    void* start = nullptr;
+    void* end = nullptr;
+    size_t n = CentralCache::GetInstance()->FetchRangeObj(start, end, 4, 48);
+    assert(n > 0 && pc->PageObjectSize(PageOf(start)) == 0);
+    CentralCache::GetInstance()->ReleaseListToSpan(start, 48);
+
+    CentralCache::GetInstance()->SetTransferCacheEnabled(true);
+    cout << "尺寸类映射测试通过！" << endl;
+}
+
+/**
+ * @brief Span整体归还后映射被清除、纪元推进；同一页被另一个尺寸类复用后，
+ *        曾在该页释放过对象的线程按新的大小放回
+ */
+void testPageReuse() {
+    cout << "=== 页复用测试 ===" << endl;
+
+    CentralCache::GetInstance()->SetTransferCacheEnabled(false);
+    PageCache* pc = PageCache::GetInstance();
+
+    thread t([pc]() {
+        ThreadCache* tc = GetThreadCache();
+        const size_t SMALL = 128;
+        const size_t OTHER = 1024;
+
+        vector<void*> ptrs;
+        for (int i = 0; i < 20000; i++) {
+            ptrs.push_back(ConcurrencyAlloc(SMALL));
+        }
+        void* probe = ptrs[ptrs.size() / 2];
+        PAGE_ID page = PageOf(probe);
+        uint64_t epoch = pc->ClassEpoch();
+
+        // 释放后本线程缓存了该页的大小
+        for (void* p : ptrs) {
+            ConcurrencyFree(p);
+        }
+        ptrs.clear();
+        // 链表过长时整批归还后仍有一部分留在本线程，取出后直接归还，Span变空后映射被清除
+        while (tc->ListLength(SizeClass::Index(SMALL)) > 0) {
+            void* p = tc->Allocate(SMALL);
+            NextObj(p) = nullptr;
+            CentralCache::GetInstance()->ReleaseListToSpan(p, SMALL);
+        }
+        // 变空的Span可能被CentralCache保留，主动归还
+        CentralCache::GetInstance()->ReleaseEmptySpans();
+        assert(CentralCache::GetInstance()->SpanCount(SMALL) == 0);
+        assert(pc->PageObjectSize(page) == 0);
+        assert(pc->ClassEpoch() > epoch);
+
+        // 以另一个大小申请，直到拿到该页上的对象
+        void* hit = nullptr;
+        for (int i = 0; i < 200000 && !hit; i++) {
+            void* p = ConcurrencyAlloc(OTHER);
+            if (PageOf(p) == page) {
+                hit = p;
+            } else {
+                ptrs.push_back(p);
+            }
+        }
+        assert(hit);
+        assert(pc->PageObjectSize(page) == OTHER);
+
+        size_t before = tc->ListLength(SizeClass::Index(OTHER));
+        size_t maxSize = tc->MaxSize(SizeClass::Index(OTHER));
+        ConcurrencyFree(hit);
+        size_t after = tc->ListLength(SizeClass::Index(OTHER));
+        assert(after == before + 1 || (before + 1 == maxSize && after == 0));
+
+        for (void* p : ptrs) {
+            ConcurrencyFree(p);
+        }
+    });
+    t.join();
+
+    CentralCache::GetInstance()->SetTransferCacheEnabled(true);
+    cout << "页复用测试通过！" << endl;
+}
+
+/**
+ * @brief 多线程乱序释放混合大小对象，对象内容不被破坏
+ */
+void testConcurrentFree() {
+    cout << "=== 多线程乱序释放测试 ===" << endl;
+
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([t]() {
+            mt19937 rng(t);
+            for (int round = 0; round < 10; round++) {
+                vector<pair<unsigned char*, size_t>> ptrs;
+                for (int i = 0; i < 5000; i++) {
+                    size_t size = (i % 50 == 0) ? 300 * 1024 : 2 + rng() % 4000;
+                    unsigned char* p = (unsigned char*)ConcurrencyAlloc(size);
+                    p[0] = (unsigned char)t;
+                    p[size - 1] = (unsigned char)round;
+                    ptrs.push_back(make_pair(p, size));
+                }
+                shuffle(ptrs.begin(), ptrs.end(), rng);
+                for (auto& e : ptrs) {
+                    assert(e.first[0] == (unsigned char)t && e.first[e.second - 1] == (unsigned char)round);
+                    ConcurrencyFree(e.first);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    cout << "多线程乱序释放测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+static inline uint64_t Ticks() {
+#ifdef PAGE_CLASS_TEST_RDTSC
+    return __rdtsc();
+#else
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief 申请n个对象后打乱顺序逐个释放
+ * @param n 每轮对象数，决定释放涉及的页数
+ * @param mixed 为true时大小在[8, 4096]内随机，否则都是128字节
+ * @param ns 输出每次释放的纳秒数
+ * @return 每次释放的计时单位数（x86上为TSC周期）
+ */
+static double MeasureRandomFree(size_t n, bool mixed, double& ns) {
+    const size_t TOTAL = 2000000;
+    double ticks = 0;
+    thread t([&]() {
+        mt19937 rng(99);
+        vector<void*> ptrs(n);
+        uint64_t sumTicks = 0;
+        long long sumNs = 0;
+        for (size_t done = 0; done < TOTAL; done += n) {
+            for (size_t i = 0; i < n; i++) {
+                ptrs[i] = ConcurrencyAlloc(mixed ? 8 + rng() % 4089 : 128);
+            }
+            shuffle(ptrs.begin(), ptrs.end(), rng);
+            auto t0 = steady_clock::now();
+            uint64_t c0 = Ticks();
+            for (size_t i = 0; i < n; i++) {
+                ConcurrencyFree(ptrs[i]);
+            }
+            uint64_t c1 = Ticks();
+            auto t1 = steady_clock::now();
+            sumTicks += c1 - c0;
+            sumNs += duration_cast<nanoseconds>(t1 - t0).count();
+        }
+        size_t frees = (TOTAL + n - 1) / n * n;
+        ticks = (double)sumTicks / frees;
+        ns = (double)sumNs / frees;
+    });
+    t.join();
+    return ticks;
+}
+
+void benchmarkRandomFree() {
+    cout << "=== 乱序释放：每次ConcurrencyFree的开销 ===" << endl;
+
+    double ns = 0;
+    MeasureRandomFree(4096, true, ns);   // 预热
+    printf("  %-10s %-8s %-10s %-10s\n", "对象数", "大小", "周期", "ns");
+    size_t counts[] = {1024, 16384, 131072};
+    for (size_t n : counts) {
+        for (int mixed = 0; mixed < 2; mixed++) {
+            double cycles = MeasureRandomFree(n, mixed == 1, ns);
+            printf("  %-10zu %-8s %-10.1f %-10.1f\n", n, mixed ? "混合" : "128", cycles, ns);
+        }
+    }
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "页号到尺寸类映射测试开始..." << endl << endl;
+
+    // 页复用测试要求两个大小的桶都未被其他线程占用，放在最前
+    testPageReuse();
+    cout << endl;
+
+    testClassMap();
+    cout << endl;
+
+    testConcurrentFree();
+    cout << endl;
+
+    benchmarkRandomFree();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,301 @@
+/**
+ * @file ReserveTest.cpp
+ * @brief 预留地址空间测试程序
+ * @details 同一份源码分别以-DHCMP_RESERVE（预留区域、平坦页号映射）和默认（逐次mmap、基数树）编译，
+ *          验证ConcurrencyOwns能区分本内存池与外来指针；预留模式下额外验证所有内存都在区域内、
+ *          释放的地址区间被合并与复用、区域用尽时抛出异常。对比两种模式下归属判断与页号映射查找的耗时
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "CentralCache.h"
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+#ifdef HCMP_RESERVE
+static const char* MODE_NAME = "预留区域";
+#else
+static const char* MODE_NAME = "逐次mmap";
+#endif
+
+static int gStaticVar = 0;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 小对象、大对象和Arena内存都判为本内存池，malloc、栈和静态区的指针不是
+ */
+void testOwnership() {
+    cout << "=== 归属判断测试 ===" << endl;
+
+    vector<void*> ptrs;
+    size_t sizes[] = {8, 16, 100, 1024, 5000, 64 * 1024, MAX_MEMORYSIZE, MAX_MEMORYSIZE + 1, 4 * 1024 * 1024};
+    for (size_t size : sizes) {
+        for (int i = 0; i < 100; i++) {
+            ptrs.push_back(ConcurrencyAlloc(size));
+        }
+    }
+    Arena arena;
+    void* fromArena = arena.Allocate(4096);
+    ptrs.push_back(fromArena);
+
+    for (void* p : ptrs) {
+        assert(ConcurrencyOwns(p));
+#ifdef HCMP_RESERVE
+        assert((uintptr_t)p >= gReserveBegin.load() && (uintptr_t)p < gReserveEnd.load());
+#endif
+    }
+
+    int local = 0;
+    void* foreign = malloc(64);
+    void* foreignBig = malloc(8 * 1024 * 1024);
+    assert(!ConcurrencyOwns(&local));
+    assert(!ConcurrencyOwns(&gStaticVar));
+    assert(!ConcurrencyOwns(foreign));
+    assert(!ConcurrencyOwns(foreignBig));
+    assert(!ConcurrencyOwns(nullptr));
+    free(foreign);
+    free(foreignBig);
+
+    ptrs.pop_back();
+    for (void* p : ptrs) {
+        ConcurrencyFree(p);
+    }
+
+    cout << "归属判断测试通过！" << endl;
+}
+
+#ifdef HCMP_RESERVE
+
+/**
+ * @brief 释放的地址区间与相邻区间合并，紧邻尾部时退回，再次申请时复用且内容为0
+ */
+void testExtentReuse() {
+    cout << "=== 地址区间复用测试 ===" << endl;
+
+    ReserveStats before = ReserveGetStats();
+    char* a = (char*)ReserveAlloc(4);
+    char* b = (char*)ReserveAlloc(4);
+    char* c = (char*)ReserveAlloc(4);
+    assert(b == a + (4 << PAGE_SHIFT) && c == b + (4 << PAGE_SHIFT));
+    memset(a, 0xAB, 12 << PAGE_SHIFT);
+    assert(ReserveGetStats().committedBytes == before.committedBytes + (12 << PAGE_SHIFT));
+
+    // a单独成为一个区间；c紧邻尾部直接退回；b与a合并后紧邻尾部，一并退回
+    ReserveFree(a, 4);
+    assert(ReserveGetStats().freeExtents == before.freeExtents + 1);
+    ReserveFree(c, 4);
+    assert(ReserveGetStats().freeExtents == before.freeExtents + 1);
+    ReserveFree(b, 4);
+    ReserveStats after = ReserveGetStats();
+    assert(after.freeExtents == before.freeExtents);
+    assert(after.topBytes == before.topBytes);
+    assert(after.committedBytes == before.committedBytes);
+
+    // 中间的空洞被首次适配复用，解除提交后重新提交的页内容为0
+    a = (char*)ReserveAlloc(4);
+    b = (char*)ReserveAlloc(4);
+    c = (char*)ReserveAlloc(4);
+    memset(b, 0xCD, 4 << PAGE_SHIFT);
+    ReserveFree(b, 4);
+    char* again = (char*)ReserveAlloc(2);
+    assert(again == b);
+    assert(again[0] == 0 && again[(2 << PAGE_SHIFT) - 1] == 0);
+    ReserveFree(again, 2);
+    ReserveFree(a, 4);
+    ReserveFree(c, 4);
+    after = ReserveGetStats();
+    assert(after.topBytes == before.topBytes && after.freeExtents == before.freeExtents);
+
+    cout << "地址区间复用测试通过！" << endl;
+}
+
+/**
+ * @brief 超大对象反复申请释放，区域不会持续增长
+ */
+void testLargeChurn() {
+    cout << "=== 超大对象反复申请释放测试 ===" << endl;
+
+    PageCache::GetInstance()->SetLargeCacheLimit(0);
+    void* warm = ConcurrencyAlloc(16 * 1024 * 1024);
+    ConcurrencyFree(warm);
+    ReserveStats before = ReserveGetStats();
+    for (int i = 0; i < 200; i++) {
+        size_t size = (size_t)(1 + i % 16) * 1024 * 1024;
+        char* p = (char*)ConcurrencyAlloc(size);
+        p[0] = 1;
+        p[size - 1] = 1;
+        ConcurrencyFree(p);
+    }
+    ReserveStats after = ReserveGetStats();
+    assert(after.topBytes == before.topBytes);
+    assert(after.committedBytes <= before.committedBytes);
+    PageCache::GetInstance()->SetLargeCacheLimit(LARGE_CACHE_MAX_BYTES);
+
+    cout << "区域使用: " << after.topBytes / 1024 / 1024 << "MB, 已提交: "
+         << after.committedBytes / 1024 / 1024 << "MB, 空闲区间: " << after.freeExtents << endl;
+    cout << "超大对象反复申请释放测试通过！" << endl;
+}
+
+/**
+ * @brief 区域剩余空间不足时抛出std::bad_alloc，不回退到区域外申请
+ */
+void testExhaustion() {
+    cout << "=== 区域用尽测试 ===" << endl;
+
+    bool thrown = false;
+    try {
+        ReserveAlloc(ReserveRegionBytes() >> PAGE_SHIFT);
+    } catch (const std::bad_alloc&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    cout << "区域用尽测试通过！" << endl;
+}
+
+#endif
+
+/**
+ * @brief 多线程混合申请释放，对象都判为本内存池且内容不被破坏
+ */
+void testConcurrent() {
+    cout << "=== 多线程测试 ===" << endl;
+
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([t]() {
+            mt19937 rng(t);
+            for (int round = 0; round < 10; round++) {
+                vector<pair<unsigned char*, size_t>> ptrs;
+                for (int i = 0; i < 3000; i++) {
+                    size_t size = (i % 100 == 0) ? 512 * 1024 + rng() % (2 * 1024 * 1024) : 2 + rng() % 8000;
+                    unsigned char* p = (unsigned char*)ConcurrencyAlloc(size);
+                    assert(ConcurrencyOwns(p));
+                    p[0] = (unsigned char)t;
+                    p[size - 1] = (unsigned char)round;
+                    ptrs.push_back(make_pair(p, size));
+                }
+                shuffle(ptrs.begin(), ptrs.end(), rng);
+                for (auto& e : ptrs) {
+                    assert(e.first[0] == (unsigned char)t && e.first[e.second - 1] == (unsigned char)round);
+                    ConcurrencyFree(e.first);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    cout << "多线程测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 一半本内存池、一半malloc的指针打乱后逐个判断归属
+ */
+void benchmarkOwns() {
+    cout << "=== ConcurrencyOwns耗时（" << MODE_NAME << "） ===" << endl;
+
+    const size_t N = 100000;
+    const int ROUNDS = 20;
+    vector<void*> ours, foreign, mixed;
+    for (size_t i = 0; i < N; i++) {
+        ours.push_back(ConcurrencyAlloc(16 + (i % 64) * 16));
+        foreign.push_back(malloc(16 + (i % 64) * 16));
+    }
+    mixed = ours;
+    mixed.insert(mixed.end(), foreign.begin(), foreign.end());
+    mt19937 rng(7);
+    shuffle(mixed.begin(), mixed.end(), rng);
+
+    size_t owned = 0;
+    auto t0 = steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (void* p : mixed) {
+            owned += ConcurrencyOwns(p);
+        }
+    }
+    auto t1 = steady_clock::now();
+    assert(owned == N * ROUNDS);
+    printf("  %.2f ns/次\n", duration_cast<nanoseconds>(t1 - t0).count() / (double)(mixed.size() * ROUNDS));
+
+    for (size_t i = 0; i < N; i++) {
+        ConcurrencyFree(ours[i]);
+        free(foreign[i]);
+    }
+}
+
+/**
+ * @brief 打乱顺序查找对象所在的Span，测量页号映射本身的查找耗时
+ */
+void benchmarkPageMap() {
+    cout << "=== 页号映射查找耗时（" << MODE_NAME << "） ===" << endl;
+
+    const size_t N = 200000;
+    const int ROUNDS = 20;
+    vector<void*> ptrs;
+    for (size_t i = 0; i < N; i++) {
+        ptrs.push_back(ConcurrencyAlloc(1024));
+    }
+    mt19937 rng(11);
+    shuffle(ptrs.begin(), ptrs.end(), rng);
+
+    PageCache* pc = PageCache::GetInstance();
+    size_t sum = 0;
+    pc->GetMutex().lock();
+    auto t0 = steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (void* p : ptrs) {
+            sum += pc->MapObjectToSpanLocked(p)->_objSize;
+        }
+    }
+    auto t1 = steady_clock::now();
+    pc->GetMutex().unlock();
+    assert(sum == N * ROUNDS * 1024);
+    printf("  %.2f ns/次\n", duration_cast<nanoseconds>(t1 - t0).count() / (double)(N * ROUNDS));
+
+    for (void* p : ptrs) {
+        ConcurrencyFree(p);
+    }
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "预留地址空间测试开始（" << MODE_NAME << "）..." << endl << endl;
+
+    testOwnership();
+    cout << endl;
+
+#ifdef HCMP_RESERVE
+    testExtentReuse();
+    cout << endl;
+
+    testLargeChurn();
+    cout << endl;
+
+    testExhaustion();
+    cout << endl;
+#endif
+
+    testConcurrent();
+    cout << endl;
+
+    benchmarkOwns();
+    cout << endl;
+
+    benchmarkPageMap();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
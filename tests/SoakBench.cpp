@@ -0,0 +1,450 @@
+/**
+ * @file SoakBench.cpp
+ * @brief 长时间运行的碎片与RSS曲线基准
+ * @details 4个工作线程按阶段变化的负载持续申请释放：小对象爬升、小对象稳态、尺寸分布逐渐转向中大对象、
+ *          混合稳态、负载下降到一成、低负载冷却。采样线程每100ms记录常驻内存（/proc/self/statm）、
+ *          程序存活字节、分配器视角的存活字节（malloc_usable_size/ConcurrencyUsableSize之和）和
+ *          分配器向系统申请的字节数（mallinfo2/stats.system_bytes）。
+ *          glibc与本内存池在同一次运行中各用一个子进程执行同一负载，报告各阶段的碎片率、峰值与稳态内存之比、
+ *          负载下降后内存回落的速度，并打印两者的RSS曲线。
+ *          用法：soak_bench [每个分配器的秒数]，默认20秒
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <chrono>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 负载定义 ================================
+
+static const int THREADS = 4;
+static const size_t PEAK_BYTES_PER_THREAD = 16 * 1024 * 1024;   // 满负载时每个线程的存活字节数
+static const int SAMPLE_MS = 100;
+static const int OPS_PER_TICK = 256;                             // 每个线程每毫秒最多的操作数
+
+enum SizeDist {
+    DIST_SMALL,   // 8B~1KB为主，少量到4KB
+    DIST_MIXED    // 1KB~16KB为主，夹杂到128KB和超过256KB的大对象
+};
+
+/**
+ * @struct Phase
+ * @brief 一个阶段：时长占比、新申请对象的尺寸分布，以及阶段结束时的目标存活量（相对满负载）
+ * @details 阶段内目标存活量从上一阶段的目标线性变化到本阶段的目标
+ */
+struct Phase {
+    const char* name;
+    double share;
+    SizeDist dist;
+    double target;
+};
+
+static const Phase PHASES[] = {
+    {"ramp_up", 0.15, DIST_SMALL, 1.0},
+    {"steady_small", 0.15, DIST_SMALL, 1.0},
+    {"shift", 0.20, DIST_MIXED, 1.0},
+    {"steady_mixed", 0.15, DIST_MIXED, 1.0},
+    {"ramp_down", 0.10, DIST_MIXED, 0.1},
+    {"cooldown", 0.25, DIST_SMALL, 0.1},
+};
+static const int PHASE_COUNT = sizeof(PHASES) / sizeof(PHASES[0]);
+
+static size_t NextSize(uint64_t& x, SizeDist dist) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    uint32_t r = (uint32_t)(x >> 32);
+    if (dist == DIST_SMALL) {
+        return (r % 10 == 0) ? 1024 + r % 3072 : 8 + r % 1016;
+    }
+    uint32_t pick = r % 100;
+    if (pick < 70) {
+        return 1024 + r % (15 * 1024);
+    }
+    if (pick < 97) {
+        return 16 * 1024 + r % (112 * 1024);
+    }
+    return 256 * 1024 + r % (768 * 1024);
+}
+
+// ================================ 采样数据 ================================
+
+struct SoakSample {
+    float t;          // 秒
+    int phase;
+    size_t live;      // 程序存活字节（申请大小之和）
+    size_t usable;    // 分配器视角的存活字节
+    size_t mapped;    // 分配器向系统申请的字节
+    size_t rss;       // 常驻内存（减去开始前的基线）
+};
+
+/**
+ * @struct SoakReport
+ * @brief 子进程写入、父进程读取的结果，放在fork前创建的共享映射中
+ */
+struct SoakReport {
+    size_t ops;
+    size_t samples;
+    SoakSample data[1];   // 实际长度见SoakReportBytes
+};
+
+static size_t SoakReportBytes(size_t maxSamples) {
+    return sizeof(SoakReport) + maxSamples * sizeof(SoakSample);
+}
+
+/**
+ * @brief 当前进程的常驻内存字节数
+ */
+static size_t CurrentRss() {
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (!fp) {
+        return 0;
+    }
+    long pages = 0, resident = 0;
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(fp);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// ================================ 分配器接口 ================================
+
+struct SoakAllocator {
+    const char* name;
+    void* (*alloc)(size_t);
+    void (*release)(void*);
+    size_t (*usable)(void*);
+    size_t (*mapped)();
+};
+
+static void* PoolAlloc(size_t size) { return ConcurrencyAlloc(size); }
+static void PoolFree(void* ptr) { ConcurrencyFree(ptr); }
+static size_t PoolUsable(void* ptr) { return ConcurrencyUsableSize(ptr); }
+static size_t PoolMapped() {
+    size_t bytes = 0;
+    ConcurrencyControl("stats.system_bytes", &bytes);
+    return bytes;
+}
+
+static size_t GlibcUsable(void* ptr) { return malloc_usable_size(ptr); }
+static size_t GlibcMapped() {
+    struct mallinfo2 info = mallinfo2();
+    return info.arena + info.hblkhd;
+}
+
+// ================================ 执行负载 ================================
+
+/**
+ * @struct WorkerState
+ * @brief 主线程设置的目标和工作线程报告的存活量，各占一个缓存行
+ */
+struct alignas(64) WorkerState {
+    atomic<size_t> live{0};
+    atomic<size_t> usable{0};
+    atomic<size_t> ops{0};
+};
+
+struct Obj {
+    void* ptr;
+    size_t size;
+    size_t usable;
+};
+
+static atomic<size_t> gTarget{0};
+static atomic<int> gDist{DIST_SMALL};
+static atomic<bool> gStop{false};
+
+static void Worker(const SoakAllocator& a, WorkerState& state, uint64_t seed) {
+    vector<Obj> objs;
+    size_t live = 0, usable = 0, ops = 0;
+    uint64_t x = seed;
+
+    auto allocOne = [&]() {
+        size_t size = NextSize(x, (SizeDist)gDist.load(memory_order_relaxed));
+        char* p = (char*)a.alloc(size);
+        // 每4KB写一个字节，模拟使用，使RSS反映实际占用
+        for (size_t off = 0; off < size; off += 4096) {
+            p[off] = 1;
+        }
+        p[size - 1] = 1;
+        size_t u = a.usable(p);
+        objs.push_back({p, size, u});
+        live += size;
+        usable += u;
+    };
+    auto freeOne = [&]() {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        size_t i = (size_t)(x % objs.size());
+        Obj o = objs[i];
+        objs[i] = objs.back();
+        objs.pop_back();
+        a.release(o.ptr);
+        live -= o.size;
+        usable -= o.usable;
+    };
+
+    while (!gStop.load(memory_order_relaxed)) {
+        size_t target = gTarget.load(memory_order_relaxed);
+        for (int i = 0; i < OPS_PER_TICK; i++) {
+            if (live < target) {
+                allocOne();
+            } else if (live > target + 1024 * 1024 && !objs.empty()) {
+                freeOne();
+            } else if (!objs.empty()) {
+                // 稳定时释放一个、申请一个，尺寸分布变化后旧对象逐渐被替换
+                freeOne();
+                allocOne();
+            }
+            ops++;
+        }
+        state.live.store(live, memory_order_relaxed);
+        state.usable.store(usable, memory_order_relaxed);
+        state.ops.store(ops, memory_order_relaxed);
+        this_thread::sleep_for(milliseconds(1));
+    }
+
+    for (const Obj& o : objs) {
+        a.release(o.ptr);
+    }
+}
+
+/**
+ * @brief 在当前（子）进程中执行完整负载并采样
+ */
+static void RunSoak(const SoakAllocator& a, double seconds, SoakReport* report, size_t maxSamples) {
+    WorkerState states[THREADS];
+    size_t base = CurrentRss();
+    gTarget.store(0);
+    gDist.store(DIST_SMALL);
+    gStop.store(false);
+
+    vector<thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back(Worker, cref(a), ref(states[t]), 0x9E3779B97F4A7C15ull * (t + 1));
+    }
+
+    auto t0 = steady_clock::now();
+    double phaseStart = 0, lastTarget = 0;
+    report->samples = 0;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const Phase& ph = PHASES[p];
+        double len = ph.share * seconds;
+        gDist.store(ph.dist, memory_order_relaxed);
+        while (true) {
+            double now = duration_cast<duration<double>>(steady_clock::now() - t0).count();
+            if (now >= phaseStart + len) {
+                break;
+            }
+            double frac = lastTarget + (ph.target - lastTarget) * (now - phaseStart) / len;
+            gTarget.store((size_t)(frac * PEAK_BYTES_PER_THREAD), memory_order_relaxed);
+
+            if (report->samples < maxSamples) {
+                SoakSample& s = report->data[report->samples++];
+                s.t = (float)now;
+                s.phase = p;
+                s.live = s.usable = 0;
+                for (const WorkerState& st : states) {
+                    s.live += st.live.load(memory_order_relaxed);
+                    s.usable += st.usable.load(memory_order_relaxed);
+                }
+                s.mapped = a.mapped();
+                size_t rss = CurrentRss();
+                s.rss = rss > base ? rss - base : 0;
+            }
+            this_thread::sleep_for(milliseconds(SAMPLE_MS));
+        }
+        phaseStart += len;
+        lastTarget = ph.target;
+    }
+
+    gStop.store(true);
+    for (auto& th : threads) {
+        th.join();
+    }
+    report->ops = 0;
+    for (const WorkerState& st : states) {
+        report->ops += st.ops.load(memory_order_relaxed);
+    }
+}
+
+// ================================ 结果分析 ================================
+
+/**
+ * @struct SoakSummary
+ * @brief 由采样得到的汇总指标
+ */
+struct SoakSummary {
+    double phaseLive[PHASE_COUNT];
+    double phaseUsable[PHASE_COUNT];
+    double phaseMapped[PHASE_COUNT];
+    double phaseRss[PHASE_COUNT];
+    double phaseFrag[PHASE_COUNT];   // 阶段内RSS/存活字节的平均值
+    size_t peakRss;
+    double steadyRss;                // steady_mixed阶段的平均RSS
+    double dropRss;                  // 负载开始下降时的RSS
+    double endRss;                   // 结束时的RSS
+    double returned;                 // 负载下降后归还的比例：(dropRss-endRss)/(dropRss-结束时存活字节)
+    double halfTime;                 // 可归还部分回落一半所用的秒数，未回落为-1
+    double endFrag;                  // 结束时RSS/存活字节
+};
+
+static const int DROP_PHASE = 4;   // ramp_down
+
+static SoakSummary Summarize(const SoakReport* r) {
+    SoakSummary s;
+    memset(&s, 0, sizeof(s));
+    size_t counts[PHASE_COUNT] = {0};
+    size_t drop = r->samples;
+    for (size_t i = 0; i < r->samples; i++) {
+        const SoakSample& x = r->data[i];
+        counts[x.phase]++;
+        s.phaseLive[x.phase] += x.live;
+        s.phaseUsable[x.phase] += x.usable;
+        s.phaseMapped[x.phase] += x.mapped;
+        s.phaseRss[x.phase] += x.rss;
+        s.phaseFrag[x.phase] += x.live ? (double)x.rss / x.live : 0;
+        s.peakRss = max(s.peakRss, x.rss);
+        if (x.phase >= DROP_PHASE && drop == r->samples) {
+            drop = i;
+        }
+    }
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        if (counts[p]) {
+            s.phaseLive[p] /= counts[p];
+            s.phaseUsable[p] /= counts[p];
+            s.phaseMapped[p] /= counts[p];
+            s.phaseRss[p] /= counts[p];
+            s.phaseFrag[p] /= counts[p];
+        }
+    }
+    s.steadyRss = s.phaseRss[3];
+
+    // 负载下降后理想情况下RSS回落到剩余存活字节附近，以此衡量归还了多少、用了多久
+    s.halfTime = -1;
+    if (drop < r->samples) {
+        const SoakSample& last = r->data[r->samples - 1];
+        s.dropRss = (double)r->data[drop].rss;
+        s.endRss = (double)last.rss;
+        s.endFrag = last.live ? (double)last.rss / last.live : 0;
+        double returnable = s.dropRss - (double)last.live;
+        s.returned = returnable > 0 ? max(0.0, (s.dropRss - s.endRss) / returnable) : 0;
+        for (size_t i = drop; i < r->samples && returnable > 0; i++) {
+            if (r->data[i].rss <= s.dropRss - returnable / 2) {
+                s.halfTime = r->data[i].t - r->data[drop].t;
+                break;
+            }
+        }
+    }
+    return s;
+}
+
+static double MB(double bytes) { return bytes / 1048576.0; }
+
+static void PrintPhases(const char* name, const SoakReport* r, const SoakSummary& s) {
+    printf("--- %s（%zu次操作）---\n", name, r->ops);
+    printf("  %-14s %10s %10s %10s %10s %10s\n", "phase", "live", "usable", "mapped", "rss", "rss/live");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        printf("  %-14s %10.1f %10.1f %10.1f %10.1f %10.2f\n", PHASES[p].name, MB(s.phaseLive[p]),
+               MB(s.phaseUsable[p]), MB(s.phaseMapped[p]), MB(s.phaseRss[p]), s.phaseFrag[p]);
+    }
+}
+
+// ================================ 主函数 ================================
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 20.0;
+    if (seconds < 2) {
+        seconds = 2;
+    }
+    cout << "长时间运行碎片与RSS基准开始..." << endl << endl;
+    printf("%d个线程，满负载每线程存活%zuMB，每个分配器运行%.0f秒\n\n", THREADS, PEAK_BYTES_PER_THREAD >> 20,
+           seconds);
+
+    SoakAllocator allocators[] = {
+        {"glibc", malloc, free, GlibcUsable, GlibcMapped},
+        {"pool", PoolAlloc, PoolFree, PoolUsable, PoolMapped},
+    };
+    const int N = sizeof(allocators) / sizeof(allocators[0]);
+    size_t maxSamples = (size_t)(seconds * 1000 / SAMPLE_MS) + 64;
+    SoakReport* reports[N];
+    for (int i = 0; i < N; i++) {
+        // 子进程写入共享映射，父进程汇总比较；各自在子进程中运行，RSS互不影响
+        void* mem = mmap(nullptr, SoakReportBytes(maxSamples), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                         -1, 0);
+        assert(mem != MAP_FAILED);
+        reports[i] = (SoakReport*)mem;
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            RunSoak(allocators[i], seconds, reports[i], maxSamples);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        assert(reports[i]->samples > 0);
+    }
+
+    SoakSummary summaries[N];
+    for (int i = 0; i < N; i++) {
+        summaries[i] = Summarize(reports[i]);
+        PrintPhases(allocators[i].name, reports[i], summaries[i]);
+        cout << endl;
+    }
+
+    printf("=== 汇总（MB）===\n");
+    printf("  %-8s %10s %10s %12s %10s %10s %10s %10s\n", "alloc", "peak", "steady", "peak/steady", "end",
+           "returned", "half_time", "end_frag");
+    for (int i = 0; i < N; i++) {
+        const SoakSummary& s = summaries[i];
+        char half[32];
+        if (s.halfTime >= 0) {
+            snprintf(half, sizeof(half), "%.1fs", s.halfTime);
+        } else {
+            snprintf(half, sizeof(half), "never");
+        }
+        printf("  %-8s %10.1f %10.1f %12.2f %10.1f %9.0f%% %10s %10.2f\n", allocators[i].name,
+               MB((double)s.peakRss), MB(s.steadyRss), s.steadyRss > 0 ? s.peakRss / s.steadyRss : 0.0,
+               MB(s.endRss), s.returned * 100, half, s.endFrag);
+    }
+    printf("  live/usable：程序与分配器视角的存活字节；mapped：分配器向系统申请的字节；rss：常驻内存增量\n");
+    printf("  returned：负载下降后RSS超出剩余存活字节的部分中已归还的比例；half_time：归还一半所用时间\n");
+    cout << endl;
+
+    printf("=== RSS曲线（MB，每秒一点）===\n");
+    printf("  %6s %-14s", "t(s)", "phase");
+    for (int i = 0; i < N; i++) {
+        printf(" %8s_live %9s_rss", allocators[i].name, allocators[i].name);
+    }
+    printf("\n");
+    size_t step = 1000 / SAMPLE_MS;
+    size_t rows = reports[0]->samples;
+    for (int i = 1; i < N; i++) {
+        rows = min(rows, reports[i]->samples);
+    }
+    for (size_t k = 0; k < rows; k += step) {
+        const SoakSample& head = reports[0]->data[k];
+        printf("  %6.1f %-14s", head.t, PHASES[head.phase].name);
+        for (int i = 0; i < N; i++) {
+            const SoakSample& x = reports[i]->data[k];
+            printf(" %13.1f %13.1f", MB((double)x.live), MB((double)x.rss));
+        }
+        printf("\n");
+    }
+
+    cout << endl << "所有测试通过！" << endl;
+    return 0;
+}
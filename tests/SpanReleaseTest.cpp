@@ -0,0 +1,226 @@
+/**
+ * @file SpanReleaseTest.cpp
+ * @brief 按Span分组归还测试程序
+ * @details 验证ReleaseListToSpan把乱序、跨多个Span的对象链表正确归还，完全空闲的Span被归还给
+ *          PageCache，多线程并发归还同一个桶时计数不出错，并测量32~512个对象一批时每个对象的归还耗时
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "CentralCache.h"
+#include <chrono>
+#include <random>
+#include <set>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * @brief 从CentralCache取出n个size大小的对象
+ */
+static vector<void*> FetchObjects(size_t n, size_t size) {
+    vector<void*> objs;
+    size_t batch = SizeClass::NumMoveSize(size);
+    while (objs.size() < n) {
+        void* start = nullptr;
+        void* end = nullptr;
+        size_t got = CentralCache::GetInstance()->FetchRangeObj(start, end, min(batch, n - objs.size()), size);
+        for (size_t i = 0; i < got; i++) {
+            objs.push_back(start);
+            start = NextObj(start);
+        }
+    }
+    return objs;
+}
+
+/**
+ * @brief 把objs[begin, end)串成链表后整批归还
+ */
+static void ReleaseRange(const vector<void*>& objs, size_t begin, size_t end, size_t size) {
+    for (size_t i = begin; i + 1 < end; i++) {
+        NextObj(objs[i]) = objs[i + 1];
+    }
+    NextObj(objs[end - 1]) = nullptr;
+    CentralCache::GetInstance()->ReleaseListToSpan(objs[begin], size);
+}
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 乱序归还跨多个Span的对象，部分归还后Span仍在，全部归还后Span被释放
+ */
+void testGroupedRelease() {
+    cout << "=== 乱序分组归还测试 ===" << endl;
+
+    const size_t SIZE = 1024;
+    const size_t N = 20000;
+    assert(CentralCache::GetInstance()->SpanCount(SIZE) == 0);
+
+    vector<void*> objs = FetchObjects(N, SIZE);
+    set<void*> unique(objs.begin(), objs.end());
+    assert(unique.size() == N);
+    size_t spans = CentralCache::GetInstance()->SpanCount(SIZE);
+    assert(spans > 1);
+
+    for (size_t i = 0; i < N; i++) {
+        memset(objs[i], (int)(i & 0xFF), SIZE);
+    }
+    mt19937 rng(12345);
+    shuffle(objs.begin(), objs.end(), rng);
+
+    // 先归还一半，每个Span都还有对象在外，Span不会被释放
+    size_t half = N / 2;
+    for (size_t i = 0; i < half; i += 300) {
+        ReleaseRange(objs, i, min(i + 300, half), SIZE);
+    }
+    assert(CentralCache::GetInstance()->SpanCount(SIZE) == spans);
+
+    // 归还的对象可以再次取出，且与仍在使用的对象不重叠
+    vector<void*> again = FetchObjects(half, SIZE);
+    set<void*> live(objs.begin() + half, objs.end());
+    for (void* p : again) {
+        assert(live.count(p) == 0);
+        live.insert(p);
+    }
+    assert(live.size() == N);
+
+    // 全部归还后所有Span都归还给PageCache
+    vector<void*> all(live.begin(), live.end());
+    shuffle(all.begin(), all.end(), rng);
+    for (size_t i = 0; i < all.size(); i += 512) {
+        ReleaseRange(all, i, min(i + 512, all.size()), SIZE);
+    }
+    assert(CentralCache::GetInstance()->SpanCount(SIZE) == 0);
+
+    cout << "Span数: " << spans << endl;
+    cout << "乱序分组归还测试通过！" << endl;
+}
+
+/**
+ * @brief 单个对象、超过一组上限的长链表都能正确归还
+ */
+void testListLengths() {
+    cout << "=== 链表长度测试 ===" << endl;
+
+    const size_t SIZE = 96;
+    size_t lengths[] = {1, 2, 511, 512, 513, 5000};
+    for (size_t len : lengths) {
+        vector<void*> objs = FetchObjects(len, SIZE);
+        ReleaseRange(objs, 0, len, SIZE);
+        assert(CentralCache::GetInstance()->SpanCount(SIZE) == 0);
+    }
+
+    cout << "链表长度测试通过！" << endl;
+}
+
+/**
+ * @brief 多线程同时向同一个桶归还乱序对象，结束后Span全部释放
+ */
+void testConcurrentRelease() {
+    cout << "=== 多线程归还测试 ===" << endl;
+
+    const size_t SIZE = 48;
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([t]() {
+            mt19937 rng(t);
+            for (int round = 0; round < 20; round++) {
+                vector<void*> objs = FetchObjects(4096, SIZE);
+                for (void* p : objs) {
+                    memset(p, t, SIZE);
+                }
+                shuffle(objs.begin(), objs.end(), rng);
+                for (void* p : objs) {
+                    unsigned char* bytes = (unsigned char*)p;
+                    assert(bytes[1] == t && bytes[SIZE - 1] == t);
+                }
+                for (size_t i = 0; i < objs.size(); i += 128) {
+                    ReleaseRange(objs, i, min(i + 128, objs.size()), SIZE);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    assert(CentralCache::GetInstance()->SpanCount(SIZE) == 0);
+
+    cout << "多线程归还测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 测量每批batch个对象时ReleaseListToSpan的单对象耗时
+ * @param n 每轮取出并归还的对象数，决定对象是否还在缓存中
+ * @param shuffled 为true时对象顺序被打乱，一批对象分散在多个Span中
+ */
+static double MeasureRelease(size_t batch, size_t n, bool shuffled) {
+    const size_t SIZE = 64;
+    const size_t TOTAL = 640 * 1024;
+    mt19937 rng(42);
+    long long total = 0;
+    for (size_t done = 0; done < TOTAL; done += n) {
+        vector<void*> objs = FetchObjects(n, SIZE);
+        if (shuffled) {
+            shuffle(objs.begin(), objs.end(), rng);
+        }
+        // 先把各批串好，计时只包含归还本身
+        vector<void*> heads;
+        for (size_t i = 0; i < n; i += batch) {
+            size_t end = min(i + batch, n);
+            for (size_t j = i; j + 1 < end; j++) {
+                NextObj(objs[j]) = objs[j + 1];
+            }
+            NextObj(objs[end - 1]) = nullptr;
+            heads.push_back(objs[i]);
+        }
+        auto t0 = steady_clock::now();
+        for (void* head : heads) {
+            CentralCache::GetInstance()->ReleaseListToSpan(head, SIZE);
+        }
+        auto t1 = steady_clock::now();
+        total += duration_cast<nanoseconds>(t1 - t0).count();
+    }
+    return (double)total / TOTAL;
+}
+
+void benchmarkRelease() {
+    cout << "=== ReleaseListToSpan单对象耗时（ns） ===" << endl;
+    cout << "  热：每轮4096个对象（256KB，仍在缓存中）；冷：每轮128K个对象（8MB）" << endl;
+
+    const size_t HOT = 4096;
+    const size_t COLD = 128 * 1024;
+    MeasureRelease(128, COLD, true);   // 预热
+    printf("  %-8s %-12s %-12s %-12s\n", "batch", "顺序", "乱序(热)", "乱序(冷)");
+    size_t batches[] = {32, 64, 128, 256, 512};
+    for (size_t batch : batches) {
+        printf("  %-8zu %-12.2f %-12.2f %-12.2f\n", batch, MeasureRelease(batch, HOT, false),
+               MeasureRelease(batch, HOT, true), MeasureRelease(batch, COLD, true));
+    }
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "按Span分组归还测试开始..." << endl << endl;
+
+    // 直接调用ReleaseListToSpan，不经过无锁批次缓存
+    CentralCache::GetInstance()->SetTransferCacheEnabled(false);
+
+    testGroupedRelease();
+    cout << endl;
+
+    testListLengths();
+    cout << endl;
+
+    testConcurrentRelease();
+    cout << endl;
+
+    benchmarkRelease();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * @file ThreadCacheLayoutTest.cpp
+ * @brief ThreadCache冷热分离布局测试程序
+ * @details 验证ThreadCache按缓存行对齐、慢启动上限与链表长度在各桶上保持正确、
+ *          混合大小申请释放数据完整，并在混合大小负载下测量每次操作的耗时和L1数据缓存未命中数
+ *          （perf_event_open不可用时只报告耗时）
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cassert>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief ThreadCache对象按缓存行对齐
+ */
+void testAlignment() {
+    cout << "=== 对齐测试 ===" << endl;
+
+    assert(alignof(ThreadCache) == 64);
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([]() {
+            ConcurrencyFree(ConcurrencyAlloc(16));
+            assert((uintptr_t)pTLSThreadCache % 64 == 0);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    cout << "对齐测试通过！" << endl;
+}
+
+/**
+ * @brief 慢启动：每次从CentralCache取批次后上限加2，链表长度达到上限时整批归还
+ */
+void testSlowStart() {
+    cout << "=== 慢启动测试 ===" << endl;
+
+    thread t([]() {
+        const size_t SIZE = 200;
+        size_t index = SizeClass::Index(SIZE);
+        ThreadCache* tc = GetThreadCache();
+        assert(tc->ListLength(index) == 0 && tc->MaxSize(index) == 1);
+
+        vector<void*> ptrs;
+        for (int i = 0; i < 1000; i++) {
+            ptrs.push_back(ConcurrencyAlloc(SIZE));
+            assert(tc->ListLength(index) < tc->MaxSize(index));
+        }
+        size_t maxSize = tc->MaxSize(index);
+        assert(maxSize > 1 && maxSize <= SizeClass::NumMoveSize(SIZE) + 2);
+
+        for (void* p : ptrs) {
+            ConcurrencyFree(p);
+            assert(tc->ListLength(index) < tc->MaxSize(index));
+        }
+        assert(tc->MaxSize(index) == maxSize);
+
+        // 其他桶不受影响
+        size_t other = SizeClass::Index(4000);
+        assert(tc->ListLength(other) == 0 && tc->MaxSize(other) == 1);
+    });
+    t.join();
+
+    cout << "慢启动测试通过！" << endl;
+}
+
+/**
+ * @brief 所有桶交叉申请释放，数据不被破坏
+ */
+void testMixedSizes() {
+    cout << "=== 混合大小测试 ===" << endl;
+
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t]() {
+            mt19937 rng(t);
+            vector<pair<unsigned char*, size_t>> live;
+            for (int i = 0; i < 200000; i++) {
+                if (!live.empty() && rng() % 2 == 0) {
+                    size_t k = rng() % live.size();
+                    unsigned char* p = live[k].first;
+                    size_t size = live[k].second;
+                    assert(p[0] == (unsigned char)size && p[size - 1] == (unsigned char)t);
+                    ConcurrencyFree(p);
+                    live[k] = live.back();
+                    live.pop_back();
+                } else {
+                    size_t size = 2 + rng() % (rng() % 8 == 0 ? MAX_MEMORYSIZE - 1 : 2047);
+                    unsigned char* p = (unsigned char*)ConcurrencyAlloc(size);
+                    p[size - 1] = (unsigned char)t;
+                    p[0] = (unsigned char)size;
+                    live.push_back(make_pair(p, size));
+                }
+            }
+            for (auto& e : live) {
+                ConcurrencyFree(e.first);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    cout << "混合大小测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 打开当前线程用户态的L1数据缓存读未命中计数器
+ * @return 文件描述符，不可用时返回-1
+ */
+static int OpenL1MissCounter() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * @brief 混合大小负载：在固定数量的槽位上随机替换对象
+ * @param nsizes 参与的不同大小个数，决定ThreadCache中被访问的桶数
+ * @param ns 输出每次申请+释放的耗时（纳秒）
+ * @param misses 输出每次申请+释放的L1D读未命中数，计数器不可用时为-1
+ */
+static void MeasureMixed(size_t nsizes, double& ns, double& misses) {
+    const size_t SLOTS = 256;
+    const size_t OPS = 4000000;
+
+    thread t([&]() {
+        mt19937 rng(7);
+        vector<size_t> sizes(nsizes);
+        for (size_t i = 0; i < nsizes; i++) {
+            sizes[i] = 8 + (i * 2040 / nsizes) / 8 * 8;   // 分散到[8, 2048]内的不同桶
+        }
+        vector<uint32_t> picks(OPS);
+        for (size_t i = 0; i < OPS; i++) {
+            picks[i] = rng();
+        }
+        vector<void*> slots(SLOTS, nullptr);
+
+        // 预热：每个大小的链表都装满一批
+        for (size_t r = 0; r < 4; r++) {
+            for (size_t i = 0; i < OPS / 4; i++) {
+                uint32_t pick = picks[i];
+                void*& slot = slots[pick % SLOTS];
+                if (slot) {
+                    ConcurrencyFree(slot);
+                }
+                slot = ConcurrencyAlloc(sizes[(pick >> 8) % nsizes]);
+            }
+        }
+
+        int fd = OpenL1MissCounter();
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        auto t0 = steady_clock::now();
+        for (size_t i = 0; i < OPS; i++) {
+            uint32_t pick = picks[i];
+            void*& slot = slots[pick % SLOTS];
+            ConcurrencyFree(slot);
+            slot = ConcurrencyAlloc(sizes[(pick >> 8) % nsizes]);
+        }
+        auto t1 = steady_clock::now();
+        misses = -1;
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            long long count = 0;
+            if (read(fd, &count, sizeof(count)) == sizeof(count)) {
+                misses = (double)count / OPS;
+            }
+            close(fd);
+        }
+        ns = duration_cast<nanoseconds>(t1 - t0).count() / (double)OPS;
+
+        for (void* p : slots) {
+            ConcurrencyFree(p);
+        }
+    });
+    t.join();
+}
+
+void benchmarkMixed() {
+    cout << "=== 混合大小负载：每次申请+释放 ===" << endl;
+
+    double ns = 0, misses = 0;
+    MeasureMixed(64, ns, misses);   // 预热
+    printf("  %-10s %-12s %-12s\n", "大小个数", "耗时(ns)", "L1D未命中");
+    size_t counts[] = {4, 16, 64, 128};
+    for (size_t n : counts) {
+        MeasureMixed(n, ns, misses);
+        if (misses >= 0) {
+            printf("  %-10zu %-12.2f %-12.3f\n", n, ns, misses);
+        } else {
+            printf("  %-10zu %-12.2f %-12s\n", n, ns, "不可用");
+        }
+    }
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "ThreadCache冷热分离布局测试开始..." << endl << endl;
+
+    testAlignment();
+    cout << endl;
+
+    testSlowStart();
+    cout << endl;
+
+    testMixedSizes();
+    cout << endl;
+
+    benchmarkMixed();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,492 @@
+/**
+ * @file TierBench.cpp
+ * @brief 分层微基准
+ * @details 分别测量各层的单项操作：ThreadCache命中的申请释放、CentralCache整批获取（批次缓存与Span两条路径）、
+ *          ReleaseListToSpan、PageCache的NewSpan/ReleaseSpanToPageCache（切分与合并）、基数树与页号映射查找。
+ *          每项报告ns/op，并用perf_event_open统计每次操作的指令数、周期数、L1D/LLC未命中和dTLB未命中；
+ *          计数器不可用时（容器、虚拟机或perf_event_paranoid限制）对应字段为null，只报告耗时。
+ *          用法：tier_bench [json文件]，表格打印到标准输出，指定文件时另写一份JSON
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "RadixTree.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 硬件计数器 ================================
+
+enum PerfEvent {
+    EV_INSTRUCTIONS,
+    EV_CYCLES,
+    EV_L1D_MISSES,
+    EV_LLC_MISSES,
+    EV_DTLB_MISSES,
+    EV_COUNT
+};
+
+struct PerfEventDesc {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+static const PerfEventDesc PERF_EVENTS[EV_COUNT] = {
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"l1d_misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"dtlb_misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+};
+
+/**
+ * @class PerfCounters
+ * @brief 当前线程的一组计数器
+ * @details 每个事件单独打开而不组成事件组，某个事件不受支持时其余事件仍可使用；
+ *          计数器被内核轮换时按运行时间比例折算
+ */
+class PerfCounters {
+public:
+    PerfCounters() {
+        for (size_t i = 0; i < EV_COUNT; i++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_EVENTS[i].type;
+            attr.config = PERF_EVENTS[i].config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;   // 只统计用户态，perf_event_paranoid为2时也能打开
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            _fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+            _errors[i] = _fds[i] < 0 ? errno : 0;
+        }
+    }
+
+    ~PerfCounters() {
+        for (int fd : _fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    bool Available(size_t ev) const { return _fds[ev] >= 0; }
+    int Error(size_t ev) const { return _errors[ev]; }
+
+    void Start() {
+        for (int fd : _fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    /**
+     * @brief 停止计数并读出，不可用的事件为NAN
+     */
+    void Stop(double values[EV_COUNT]) {
+        for (size_t i = 0; i < EV_COUNT; i++) {
+            values[i] = NAN;
+            if (_fds[i] < 0) {
+                continue;
+            }
+            ioctl(_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t data[3] = {0, 0, 0};   // value, time_enabled, time_running
+            if (read(_fds[i], data, sizeof(data)) == (ssize_t)sizeof(data) && data[2] > 0) {
+                values[i] = (double)data[0] * data[1] / data[2];
+            }
+        }
+    }
+
+private:
+    int _fds[EV_COUNT];
+    int _errors[EV_COUNT];
+};
+
+static PerfCounters* gCounters = nullptr;
+
+// ================================ 测量框架 ================================
+
+/**
+ * @struct Sample
+ * @brief 一次测量：操作数、总耗时和各计数器总数
+ */
+struct Sample {
+    size_t ops = 0;
+    double ns = 0;
+    double counters[EV_COUNT];
+};
+
+/**
+ * @class Probe
+ * @brief 包住一段被测代码，同时记录耗时和计数器
+ */
+class Probe {
+public:
+    Probe() {
+        gCounters->Start();
+        _t0 = steady_clock::now();
+    }
+
+    Sample Stop(size_t ops) {
+        auto t1 = steady_clock::now();
+        Sample s;
+        gCounters->Stop(s.counters);
+        s.ops = ops;
+        s.ns = (double)duration_cast<nanoseconds>(t1 - _t0).count();
+        return s;
+    }
+
+private:
+    steady_clock::time_point _t0;
+};
+
+/**
+ * @struct TierResult
+ * @brief 一项的最好结果（每次操作耗时最短的一轮）
+ */
+struct TierResult {
+    const char* name;
+    const char* desc;
+    Sample best;
+
+    void Keep(const Sample& s) {
+        if (best.ops == 0 || s.ns / s.ops < best.ns / best.ops) {
+            best = s;
+        }
+    }
+};
+
+static const int REPEAT = 5;
+
+// 阻止编译器把被测操作优化掉
+template <typename T>
+static inline void DoNotOptimize(T value) {
+    asm volatile("" : : "r"(value) : "memory");
+}
+
+// ================================ 各层测试 ================================
+
+/**
+ * @brief ThreadCache命中：同一线程反复申请释放同一尺寸，对象始终在桶中
+ */
+static void BenchThreadCacheHit(vector<TierResult>& results) {
+    const size_t SIZE = 64;
+    const size_t N = 2000000;
+    TierResult r = {"thread_cache_hit", "ThreadCache::Allocate+Deallocate（64B，命中）", {}};
+    ThreadCache* tc = GetThreadCache();
+    tc->Deallocate(tc->Allocate(SIZE), SIZE);
+    for (int rep = 0; rep < REPEAT; rep++) {
+        Probe probe;
+        for (size_t i = 0; i < N; i++) {
+            void* p = tc->Allocate(SIZE);
+            DoNotOptimize(p);
+            tc->Deallocate(p, SIZE);
+        }
+        r.Keep(probe.Stop(N));
+    }
+    results.push_back(r);
+
+    TierResult api = {"alloc_free_api", "ConcurrencyAlloc+ConcurrencyFree（64B，不带大小释放）", {}};
+    for (int rep = 0; rep < REPEAT; rep++) {
+        Probe probe;
+        for (size_t i = 0; i < N; i++) {
+            void* p = ConcurrencyAlloc(SIZE);
+            DoNotOptimize(p);
+            ConcurrencyFree(p);
+        }
+        api.Keep(probe.Stop(N));
+    }
+    results.push_back(api);
+}
+
+/**
+ * @brief 无锁批次缓存：整批取出再整批放回，批次始终在批次缓存中
+ */
+static void BenchTransferCache(vector<TierResult>& results) {
+    const size_t SIZE = 64;
+    const size_t BATCH = SizeClass::NumMoveSize(SIZE);   // 批次缓存只收整批
+    const size_t N = 1000000;
+    TierResult r = {"transfer_cache_pair", "FetchRangeObj+InsertRange（批次缓存命中，一整批64B）", {}};
+    CentralCache* cc = CentralCache::GetInstance();
+    void *start = nullptr, *end = nullptr;
+    size_t n = cc->FetchRangeObj(start, end, BATCH, SIZE);
+    cc->InsertRange(start, end, n, SIZE);
+    for (int rep = 0; rep < REPEAT; rep++) {
+        Probe probe;
+        for (size_t i = 0; i < N; i++) {
+            n = cc->FetchRangeObj(start, end, BATCH, SIZE);
+            DoNotOptimize(start);
+            cc->InsertRange(start, end, n, SIZE);
+        }
+        r.Keep(probe.Stop(N));
+    }
+    results.push_back(r);
+}
+
+/**
+ * @brief 关闭批次缓存后的Span路径：ReleaseListToSpan与FetchFromCentralCache所用的FetchRangeObj
+ * @details 每个Span先留住一个对象，归还时Span不会变空，整批获取时也不会向PageCache申请新Span，
+ *          两项都只测CentralCache本层
+ */
+static void BenchCentralSpan(vector<TierResult>& results) {
+    const size_t SIZE = 64;
+    const size_t BATCH = 32;
+    const size_t BATCHES = 4096;
+    TierResult release = {"release_list_to_span", "CentralCache::ReleaseListToSpan（32个64B，Span不变空）", {}};
+    TierResult fetch = {"central_fetch_span", "CentralCache::FetchRangeObj（32个64B，关闭批次缓存，Span已有空闲对象）", {}};
+
+    CentralCache* cc = CentralCache::GetInstance();
+    PageCache* pc = PageCache::GetInstance();
+    cc->SetTransferCacheEnabled(false);
+    for (int rep = 0; rep < REPEAT; rep++) {
+        // 准备：取出对象，每个Span留一个，其余按32个一批串好
+        vector<void*> objs, pins;
+        objs.reserve(BATCHES * BATCH);
+        for (size_t b = 0; b < BATCHES; b++) {
+            void *start = nullptr, *end = nullptr;
+            cc->FetchRangeObj(start, end, BATCH, SIZE);
+            for (void* p = start; p != nullptr; p = NextObj(p)) {
+                objs.push_back(p);
+            }
+        }
+        vector<void*> lists;
+        Span* last = nullptr;
+        void* head = nullptr;
+        size_t len = 0;
+        for (void* p : objs) {
+            Span* span = pc->MapObjectToSpan(p);
+            if (span != last) {
+                last = span;
+                pins.push_back(p);
+                continue;
+            }
+            NextObj(p) = head;
+            head = p;
+            if (++len == BATCH) {
+                lists.push_back(head);
+                head = nullptr;
+                len = 0;
+            }
+        }
+        if (head) {
+            cc->ReleaseListToSpan(head, SIZE);   // 不足一批的尾巴不计入
+        }
+
+        Probe releaseProbe;
+        for (void* list : lists) {
+            cc->ReleaseListToSpan(list, SIZE);
+        }
+        release.Keep(releaseProbe.Stop(lists.size()));
+
+        vector<void*> fetched(lists.size());
+        Probe fetchProbe;
+        for (auto& list : fetched) {
+            void* end = nullptr;
+            cc->FetchRangeObj(list, end, BATCH, SIZE);
+        }
+        fetch.Keep(fetchProbe.Stop(fetched.size()));
+
+        for (void* list : fetched) {
+            cc->ReleaseListToSpan(list, SIZE);
+        }
+        head = nullptr;
+        for (void* p : pins) {
+            NextObj(p) = head;
+            head = p;
+        }
+        cc->ReleaseListToSpan(head, SIZE);
+    }
+    cc->SetTransferCacheEnabled(true);
+    results.push_back(release);
+    results.push_back(fetch);
+}
+
+/**
+ * @brief PageCache：NewSpan从更大的空闲Span中切出k页，ReleaseSpanToPageCache再与相邻空闲页合并
+ */
+static void BenchPageCache(vector<TierResult>& results) {
+    static const size_t PAGES[] = {1, 8, 64};
+    static const char* NAMES[] = {"page_cache_span_1", "page_cache_span_8", "page_cache_span_64"};
+    static const char* DESCS[] = {"NewSpan(1)+ReleaseSpanToPageCache（切分与合并，含加锁）",
+                                  "NewSpan(8)+ReleaseSpanToPageCache（切分与合并，含加锁）",
+                                  "NewSpan(64)+ReleaseSpanToPageCache（切分与合并，含加锁）"};
+    const size_t N = 200000;
+    PageCache* pc = PageCache::GetInstance();
+    for (size_t i = 0; i < sizeof(PAGES) / sizeof(PAGES[0]); i++) {
+        TierResult r = {NAMES[i], DESCS[i], {}};
+        for (int rep = 0; rep < REPEAT; rep++) {
+            Probe probe;
+            for (size_t j = 0; j < N; j++) {
+                pc->GetMutex().lock();
+                Span* span = pc->NewSpan(PAGES[i]);
+                span->_isUse = true;
+                pc->ReleaseSpanToPageCache(span);
+                pc->GetMutex().unlock();
+            }
+            r.Keep(probe.Stop(N));
+        }
+        results.push_back(r);
+    }
+}
+
+/**
+ * @brief 页号查找：独立的基数树随机查找，以及释放路径使用的PageCache::MapObjectToSpan
+ */
+static void BenchLookup(vector<TierResult>& results) {
+    const size_t KEYS = 65536;
+    const size_t N = 4000000;
+
+    // 键取自真实地址附近的连续页号，与PageCache中的分布相同
+    static Span spans[64];
+    RadixTree<Span> tree;
+    void* anchor = ConcurrencyAlloc(64);
+    PAGE_ID base = ((PAGE_ID)anchor >> PAGE_SHIFT) & ~(PAGE_ID)(KEYS - 1);
+    for (size_t i = 0; i < KEYS; i++) {
+        tree.insert(base + i, &spans[i % 64]);
+    }
+
+    TierResult radix = {"radix_lookup", "RadixTree::lookup（65536个连续页号中随机查找）", {}};
+    uint64_t x = 88172645463325252ull;
+    for (int rep = 0; rep < REPEAT; rep++) {
+        Probe probe;
+        for (size_t i = 0; i < N; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            DoNotOptimize(tree.lookup(base + (x & (KEYS - 1))));
+        }
+        radix.Keep(probe.Stop(N));
+    }
+    results.push_back(radix);
+
+    // 真实页号映射：对散布在许多Span中的对象查找，含页锁
+    const size_t OBJS = 65536;
+    vector<void*> objs(OBJS);
+    for (auto& p : objs) {
+        p = ConcurrencyAlloc(256);
+    }
+    TierResult map = {"map_object_to_span", "PageCache::MapObjectToSpan（256B对象随机查找，含加锁）", {}};
+    for (int rep = 0; rep < REPEAT; rep++) {
+        Probe probe;
+        for (size_t i = 0; i < N / 4; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            DoNotOptimize(PageCache::GetInstance()->MapObjectToSpan(objs[x & (OBJS - 1)]));
+        }
+        map.Keep(probe.Stop(N / 4));
+    }
+    results.push_back(map);
+
+    for (void* p : objs) {
+        ConcurrencyFree(p);
+    }
+    ConcurrencyFree(anchor);
+}
+
+// ================================ 输出 ================================
+
+static void PrintTable(const vector<TierResult>& results) {
+    printf("%-22s %10s %12s %10s %10s %10s %10s\n", "tier", "ns/op", "instructions", "cycles", "l1d_miss",
+           "llc_miss", "dtlb_miss");
+    for (const TierResult& r : results) {
+        const Sample& s = r.best;
+        printf("%-22s %10.1f", r.name, s.ns / s.ops);
+        for (size_t i = 0; i < EV_COUNT; i++) {
+            double v = s.counters[i] / s.ops;
+            if (std::isnan(v)) {
+                printf(" %*s", i == EV_INSTRUCTIONS ? 12 : 10, "-");
+            } else {
+                printf(" %*.1f", i == EV_INSTRUCTIONS ? 12 : 10, v);
+            }
+        }
+        printf("\n");
+    }
+}
+
+static void PrintJsonNumber(FILE* fp, double v) {
+    if (std::isnan(v)) {
+        fprintf(fp, "null");
+    } else {
+        fprintf(fp, "%.3f", v);
+    }
+}
+
+static bool WriteJson(const char* path, const vector<TierResult>& results) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "无法写入 %s\n", path);
+        return false;
+    }
+    fprintf(fp, "{\n  \"counters\": {");
+    for (size_t i = 0; i < EV_COUNT; i++) {
+        fprintf(fp, "%s\"%s\": %s", i ? ", " : "", PERF_EVENTS[i].name,
+                gCounters->Available(i) ? "true" : "false");
+    }
+    fprintf(fp, "},\n  \"tiers\": [\n");
+    for (size_t t = 0; t < results.size(); t++) {
+        const TierResult& r = results[t];
+        const Sample& s = r.best;
+        fprintf(fp, "    {\"name\": \"%s\", \"ops\": %zu, \"ns_per_op\": ", r.name, s.ops);
+        PrintJsonNumber(fp, s.ns / s.ops);
+        for (size_t i = 0; i < EV_COUNT; i++) {
+            fprintf(fp, ", \"%s\": ", PERF_EVENTS[i].name);
+            PrintJsonNumber(fp, s.counters[i] / s.ops);
+        }
+        fprintf(fp, "}%s\n", t + 1 < results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+    return true;
+}
+
+// ================================ 主函数 ================================
+
+int main(int argc, char** argv) {
+    cout << "分层微基准开始..." << endl << endl;
+
+    PerfCounters counters;
+    gCounters = &counters;
+    for (size_t i = 0; i < EV_COUNT; i++) {
+        if (!counters.Available(i)) {
+            printf("计数器 %s 不可用（%s），该项只报告耗时\n", PERF_EVENTS[i].name, strerror(counters.Error(i)));
+        }
+    }
+
+    vector<TierResult> results;
+    BenchThreadCacheHit(results);
+    BenchTransferCache(results);
+    BenchCentralSpan(results);
+    BenchPageCache(results);
+    BenchLookup(results);
+
+    printf("\n每次操作的平均值（%d轮中最快的一轮）：\n", REPEAT);
+    PrintTable(results);
+    for (const TierResult& r : results) {
+        printf("  %-22s %s\n", r.name, r.desc);
+    }
+
+    if (argc > 1) {
+        if (!WriteJson(argv[1], results)) {
+            return 1;
+        }
+        printf("\nJSON已写入 %s\n", argv[1]);
+    }
+
+    cout << endl << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file TraceReplay.cpp
+ * @brief 轨迹重放工具
+ * @details 读取AllocTraceDump写出的轨迹文件（mmap），按文件中的线程数启动同样多的线程，
+ *          每个线程按时间顺序执行自己的申请和释放；同一槽位上的操作按轨迹中的先后依次执行，
+ *          跨线程释放的对象等待申请方完成后再释放，复用槽位的申请等待上一个对象释放后再申请。
+ *          可选glibc（malloc/free）或本内存池（ConcurrencyAlloc/ConcurrencyFree），报告耗时、
+ *          峰值RSS以及峰值RSS与轨迹中存活字节峰值之比（碎片率）。
+ *          用法：replay <轨迹文件> [glibc|pool]，不指定时依次重放两种（各自在子进程中，峰值RSS互不影响）
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <chrono>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * @brief 当前进程的常驻内存字节数
+ */
+static size_t CurrentRss() {
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (!fp) {
+        return 0;
+    }
+    long pages = 0, resident = 0;
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(fp);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief 进程生命周期内的峰值常驻内存字节数
+ */
+static size_t PeakRss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (size_t)usage.ru_maxrss * 1024;
+}
+
+/**
+ * @struct Trace
+ * @brief 映射到内存的轨迹文件
+ */
+struct Trace {
+    const TraceFileHeader* header = nullptr;
+    const TraceRecord* records = nullptr;
+    size_t mapBytes = 0;
+};
+
+static bool OpenTrace(const char* path, Trace& trace) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "无法打开轨迹文件 %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TraceFileHeader)) {
+        fprintf(stderr, "轨迹文件 %s 不完整\n", path);
+        close(fd);
+        return false;
+    }
+    // 预先读入全部页，重放时不再因读取轨迹产生缺页，也不计入重放期间的RSS增长
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "无法映射轨迹文件 %s\n", path);
+        return false;
+    }
+
+    const TraceFileHeader* header = (const TraceFileHeader*)map;
+    const TraceRecord* records = (const TraceRecord*)(header + 1);
+    size_t body = st.st_size - sizeof(TraceFileHeader);
+    bool valid = memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) == 0 && header->version == TRACE_VERSION &&
+                 body % sizeof(TraceRecord) == 0 && header->records == body / sizeof(TraceRecord);
+    for (size_t i = 0; valid && i < header->records; i++) {
+        const TraceRecord& r = records[i];
+        valid = r.thread < header->threads && r.slot < header->slots && (r.op == TRACE_ALLOC || r.op == TRACE_FREE);
+    }
+    if (!valid) {
+        fprintf(stderr, "%s 不是有效的轨迹文件\n", path);
+        munmap(map, st.st_size);
+        return false;
+    }
+    trace.header = header;
+    trace.records = records;
+    trace.mapBytes = st.st_size;
+    return true;
+}
+
+/**
+ * @brief 分配器接口：glibc或本内存池
+ */
+struct ReplayAllocator {
+    const char* name;
+    void* (*alloc)(size_t);
+    void (*release)(void*);
+};
+
+static void* PoolAlloc(size_t size) { return ConcurrencyAlloc(size); }
+static void PoolFree(void* ptr) { ConcurrencyFree(ptr); }
+
+/**
+ * @brief 重放一次并打印结果
+ */
+static void Replay(const Trace& trace, const ReplayAllocator& allocator) {
+    const TraceFileHeader& h = *trace.header;
+
+    // 预处理：各线程的记录下标、每条记录是所在槽位上的第几个操作，以及轨迹中存活字节的峰值
+    vector<vector<size_t>> perThread(h.threads);
+    vector<uint32_t> seq(h.records);
+    vector<uint32_t> slotOps(h.slots, 0);
+    size_t live = 0, peakLive = 0;
+    for (size_t i = 0; i < h.records; i++) {
+        const TraceRecord& r = trace.records[i];
+        perThread[r.thread].push_back(i);
+        seq[i] = slotOps[r.slot]++;
+        if (r.op == TRACE_ALLOC) {
+            live += r.size;
+            peakLive = max(peakLive, live);
+        } else {
+            live -= r.size;
+        }
+    }
+    // 每个槽位已完成的操作数；第k个操作等到计数为k时执行，对象指针随计数发布
+    unique_ptr<atomic<uint32_t>[]> done(new atomic<uint32_t>[h.slots]);
+    vector<void*> ptrs(h.slots, nullptr);
+    for (size_t i = 0; i < h.slots; i++) {
+        done[i].store(0, memory_order_relaxed);
+    }
+
+    size_t rssBefore = CurrentRss();
+    auto t0 = steady_clock::now();
+    vector<thread> threads;
+    for (uint32_t t = 0; t < h.threads; t++) {
+        threads.emplace_back([&, t]() {
+            for (size_t idx : perThread[t]) {
+                const TraceRecord& r = trace.records[idx];
+                // 等待的都是轨迹中更早的操作，不会互相等待
+                while (done[r.slot].load(memory_order_acquire) != seq[idx]) {
+                    this_thread::yield();
+                }
+                if (r.op == TRACE_ALLOC) {
+                    char* p = (char*)allocator.alloc(r.size ? r.size : 1);
+                    // 每4KB写一个字节，模拟使用，使RSS反映实际占用
+                    for (size_t off = 0; off < r.size; off += 4096) {
+                        p[off] = 1;
+                    }
+                    ptrs[r.slot] = p;
+                } else {
+                    allocator.release(ptrs[r.slot]);
+                    ptrs[r.slot] = nullptr;
+                }
+                done[r.slot].store(seq[idx] + 1, memory_order_release);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    auto t1 = steady_clock::now();
+    size_t peakRss = PeakRss();
+    size_t heapPeak = peakRss > rssBefore ? peakRss - rssBefore : 0;
+
+    printf("  %-6s 耗时 %10.1f ms   峰值RSS %9.1f MB   存活峰值 %9.1f MB   碎片率 %6.2f\n", allocator.name,
+           duration_cast<microseconds>(t1 - t0).count() / 1000.0, heapPeak / 1048576.0, peakLive / 1048576.0,
+           peakLive ? (double)heapPeak / peakLive : 0.0);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "用法: %s <轨迹文件> [glibc|pool]\n", argv[0]);
+        return 2;
+    }
+    Trace trace;
+    if (!OpenTrace(argv[1], trace)) {
+        return 1;
+    }
+    printf("轨迹 %s: %llu条记录, %u个线程, 最多%llu个对象同时存活\n", argv[1],
+           (unsigned long long)trace.header->records, trace.header->threads,
+           (unsigned long long)trace.header->slots);
+    fflush(stdout);
+
+    ReplayAllocator allocators[] = {
+        {"glibc", malloc, free},
+        {"pool", PoolAlloc, PoolFree},
+    };
+    int status = 0;
+    for (const ReplayAllocator& a : allocators) {
+        if (argc >= 3 && strcmp(argv[2], a.name) != 0) {
+            continue;
+        }
+        if (argc >= 3) {
+            Replay(trace, a);
+            continue;
+        }
+        // 两种都重放时各用一个子进程，峰值RSS不受前一次影响
+        pid_t pid = fork();
+        if (pid == 0) {
+            Replay(trace, a);
+            _exit(0);
+        }
+        int childStatus = 0;
+        waitpid(pid, &childStatus, 0);
+        if (!WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,350 @@
+/**
+ * @file TransferCacheTest.cpp
+ * @brief 无锁批次缓存测试程序
+ * @details 验证批次栈的容量、后进先出和多线程下批次不丢失不重复，空闲尺寸类的批次在清理时归还，
+ *          运行中关闭批次缓存不丢失对象，并在单个热点尺寸类上对比开启/关闭批次缓存时16~64线程的吞吐
+ */
+
+#include "ConcurrencyAlloc.h"
+#include "CentralCache.h"
+#include <chrono>
+#include <atomic>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 把objs[from, from+n)串成一批
+ */
+static void MakeBatch(void** objs, size_t from, size_t n, void*& start, void*& end) {
+    for (size_t i = from; i + 1 < from + n; i++) {
+        NextObj(objs[i]) = objs[i + 1];
+    }
+    start = objs[from];
+    end = objs[from + n - 1];
+}
+
+/**
+ * @brief 单线程：容量上限、后进先出、空栈
+ */
+void testCapacity() {
+    cout << "=== 批次缓存容量测试 ===" << endl;
+
+    static TransferCache cache;   // TransferClass按缓存行对齐，不用new以免依赖C++17的对齐分配
+    TransferCache* tc = &cache;
+    const size_t index = 1;
+    size_t cap = tc->Capacity(index);
+    assert(cap >= 2 && cap <= TRANSFER_MAX_BATCHES);
+
+    vector<void*> objs(cap * 4 + 4);
+    for (auto& p : objs) {
+        p = malloc(16);
+    }
+
+    void* start = nullptr;
+    void* end = nullptr;
+    assert(tc->Remove(index, start, end) == 0);
+
+    for (size_t b = 0; b < cap; b++) {
+        MakeBatch(objs.data(), b * 4, 4, start, end);
+        assert(tc->Insert(index, start, end, 4));
+    }
+    MakeBatch(objs.data(), cap * 4, 4, start, end);
+    assert(!tc->Insert(index, start, end, 4));   // 已满
+
+    for (size_t b = cap; b > 0; b--) {
+        assert(tc->Remove(index, start, end) == 4);
+        assert(start == objs[(b - 1) * 4]);
+        assert(end == objs[(b - 1) * 4 + 3]);
+        assert(NextObj(end) == nullptr);
+    }
+    assert(tc->Remove(index, start, end) == 0);
+
+    tc->SetCapacity(index, 3);
+    assert(tc->Capacity(index) == 3);
+    for (size_t b = 0; b < 3; b++) {
+        MakeBatch(objs.data(), b * 4, 4, start, end);
+        assert(tc->Insert(index, start, end, 4));
+    }
+    assert(!tc->Insert(index, start, end, 4));
+
+    for (auto p : objs) {
+        free(p);
+    }
+    cout << "批次缓存容量测试通过！" << endl;
+}
+
+/**
+ * @brief 多线程反复取出/放回批次，结束时每个对象恰好出现一次
+ */
+void testConcurrentStack() {
+    cout << "=== 批次缓存并发测试 ===" << endl;
+
+    static TransferCache cache;
+    TransferCache* tc = &cache;
+    const size_t index = 0;
+    const size_t BATCHES = 32;
+    const size_t PER_BATCH = 8;
+    tc->SetCapacity(index, BATCHES);
+
+    vector<void*> objs(BATCHES * PER_BATCH);
+    for (auto& p : objs) {
+        p = malloc(16);
+    }
+    void* start = nullptr;
+    void* end = nullptr;
+    for (size_t b = 0; b < BATCHES; b++) {
+        MakeBatch(objs.data(), b * PER_BATCH, PER_BATCH, start, end);
+        assert(tc->Insert(index, start, end, PER_BATCH));
+    }
+
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([tc]() {
+            for (int i = 0; i < 200000; i++) {
+                void* s = nullptr;
+                void* e = nullptr;
+                size_t n = tc->Remove(index, s, e);
+                if (n == 0) {
+                    continue;
+                }
+                assert(n == PER_BATCH);
+                bool ok = tc->Insert(index, s, e, n);
+                assert(ok);
+                (void)ok;
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    vector<void*> seen;
+    size_t n;
+    while ((n = tc->Remove(index, start, end)) > 0) {
+        assert(n == PER_BATCH);
+        size_t cnt = 0;
+        for (void* p = start; p; p = NextObj(p)) {
+            seen.push_back(p);
+            ++cnt;
+        }
+        assert(cnt == PER_BATCH);
+    }
+    assert(seen.size() == objs.size());
+    sort(seen.begin(), seen.end());
+    sort(objs.begin(), objs.end());
+    assert(seen == objs);
+
+    for (auto p : objs) {
+        free(p);
+    }
+    cout << "批次缓存并发测试通过！" << endl;
+}
+
+/**
+ * @brief 经过批次缓存的对象可以正常读写并跨线程复用
+ */
+void testThroughAllocator() {
+    cout << "=== 分配器集成测试 ===" << endl;
+
+    assert(CentralCache::GetInstance()->TransferCacheEnabled());
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([t]() {
+            vector<size_t*> ptrs;
+            for (int round = 0; round < 20; round++) {
+                for (size_t i = 0; i < 3000; i++) {
+                    size_t* p = (size_t*)ConcurrencyAlloc(16);
+                    p[0] = (size_t)t;
+                    p[1] = i;
+                    ptrs.push_back(p);
+                }
+                for (size_t i = 0; i < ptrs.size(); i++) {
+                    assert(ptrs[i][0] == (size_t)t && ptrs[i][1] == i);
+                    ConcurrencyFree(ptrs[i]);
+                }
+                ptrs.clear();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    CentralCache::GetInstance()->SetTransferCacheEnabled(false);
+    CentralCache::GetInstance()->SetTransferCacheEnabled(true);
+    cout << "分配器集成测试通过！" << endl;
+}
+
+/**
+ * @brief 空闲的尺寸类在清理时归还批次，调小字节上限时多出的批次立即归还
+ */
+void testTrim() {
+    cout << "=== 批次缓存归还测试 ===" << endl;
+
+    CentralCache* cc = CentralCache::GetInstance();
+    const size_t size = SizeClass::RoundUp(3000);
+    const size_t batch = SizeClass::NumMoveSize(size) - 1;   // 不足整批，取对象时不经过批次缓存
+    auto insertBatches = [&](size_t count) {
+        for (size_t b = 0; b < count; b++) {
+            void* start = nullptr;
+            void* end = nullptr;
+            size_t n = cc->FetchRangeObj(start, end, batch, size);
+            cc->InsertRange(start, end, n, size);
+        }
+    };
+
+    // 连续EMPTY_SPAN_IDLE_GENS(3)轮清理没有存取才归还
+    insertBatches(2);
+    assert(cc->TransferBatchCount(size) == 2);
+    cc->ReleaseIdleSpans();
+    cc->ReleaseIdleSpans();
+    assert(cc->TransferBatchCount(size) == 2);
+    cc->ReleaseIdleSpans();
+    assert(cc->TransferBatchCount(size) == 0);
+
+    // 调小上限后多出的批次立即归还，新批次不再放入
+    insertBatches(2);
+    size_t value = 0;
+    assert(ConcurrencyControl("transfer_cache_bytes", nullptr, &value) == 0);
+    assert(cc->TransferBatchCount(size) == 0);
+    insertBatches(1);
+    assert(cc->TransferBatchCount(size) == 0);
+    value = TRANSFER_MAX_BYTES;
+    assert(ConcurrencyControl("transfer_cache_bytes", nullptr, &value) == 0);
+
+    // ReleaseEmptySpans同时清空批次缓存
+    insertBatches(2);
+    assert(cc->TransferBatchCount(size) == 2);
+    cc->ReleaseEmptySpans();
+    assert(cc->TransferBatchCount(size) == 0);
+    assert(cc->SpanCount(size) == 0 && cc->EmptySpanCount(size) == 0);
+    cout << "批次缓存归还测试通过！" << endl;
+}
+
+/**
+ * @brief 业务线程整批申请、归还的同时反复开关批次缓存，关闭后对象全部回到Span
+ */
+void testToggleUnderLoad() {
+    cout << "=== 运行中开关批次缓存测试 ===" << endl;
+
+    CentralCache* cc = CentralCache::GetInstance();
+    const size_t size = SizeClass::RoundUp(2000);
+    const size_t batch = SizeClass::NumMoveSize(size);
+    atomic<bool> done(false);
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+            while (!done.load()) {
+                void* start = nullptr;
+                void* end = nullptr;
+                size_t n = cc->FetchRangeObj(start, end, batch, size);
+                cc->InsertRange(start, end, n, size);
+            }
+        });
+    }
+    for (int i = 0; i < 200; i++) {
+        cc->SetTransferCacheEnabled(i % 2 != 0);
+        this_thread::sleep_for(microseconds(200));
+    }
+    cc->SetTransferCacheEnabled(false);
+    this_thread::sleep_for(milliseconds(5));
+    done.store(true);
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // 关闭期间压入的批次已被取走或清空，剩下的在一轮清理中归还
+    cc->ReleaseIdleSpans();
+    assert(cc->TransferBatchCount(size) == 0);
+    assert(cc->SpanCount(size) == 0);
+    cc->SetTransferCacheEnabled(true);
+    cout << "运行中开关批次缓存测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief nthreads个线程在同一尺寸类上反复整批申请、整批释放
+ * @return 每秒完成的申请+释放次数（百万）
+ */
+static double RunHotClass(size_t nthreads, size_t size) {
+    const size_t ROUNDS = 100;
+    const size_t BATCH = 2048;
+    atomic<bool> go(false);
+    vector<thread> threads;
+    for (size_t t = 0; t < nthreads; t++) {
+        threads.emplace_back([&]() {
+            vector<void*> ptrs(BATCH);
+            while (!go.load()) {
+            }
+            for (size_t r = 0; r < ROUNDS; r++) {
+                for (size_t i = 0; i < BATCH; i++) {
+                    ptrs[i] = ConcurrencyAlloc(size);
+                }
+                for (size_t i = 0; i < BATCH; i++) {
+                    ConcurrencyFree(ptrs[i]);
+                }
+            }
+        });
+    }
+    auto t0 = high_resolution_clock::now();
+    go.store(true);
+    for (auto& th : threads) {
+        th.join();
+    }
+    auto t1 = high_resolution_clock::now();
+    double sec = duration_cast<microseconds>(t1 - t0).count() / 1e6;
+    return nthreads * ROUNDS * BATCH * 2 / sec / 1e6;
+}
+
+/**
+ * @brief 开启/关闭批次缓存时热点尺寸类的吞吐对比
+ */
+void benchmarkHotClass() {
+    cout << "=== 热点尺寸类吞吐（百万次/秒） ===" << endl;
+    cout << "硬件线程数: " << thread::hardware_concurrency() << endl;
+
+    size_t sizes[] = {16, 1024};
+    size_t threadCounts[] = {16, 32, 64};
+    printf("  %-6s %-8s %-12s %-12s\n", "size", "线程", "桶锁", "批次缓存");
+    for (size_t size : sizes) {
+        for (size_t n : threadCounts) {
+            CentralCache::GetInstance()->SetTransferCacheEnabled(false);
+            double locked = RunHotClass(n, size);
+            CentralCache::GetInstance()->SetTransferCacheEnabled(true);
+            double lockFree = RunHotClass(n, size);
+            printf("  %-6zu %-8zu %-12.2f %-12.2f\n", size, n, locked, lockFree);
+        }
+    }
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "无锁批次缓存测试开始..." << endl << endl;
+
+    testCapacity();
+    cout << endl;
+
+    testConcurrentStack();
+    cout << endl;
+
+    testThroughAllocator();
+    cout << endl;
+
+    testTrim();
+    cout << endl;
+
+    testToggleUnderLoad();
+    cout << endl;
+
+    benchmarkHotClass();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,415 @@
+/**
+ * @file TuningTest.cpp
+ * @brief 运行参数与ConcurrencyControl测试程序
+ * @details 验证HCMP_*环境变量在启动时生效且非法值被忽略、ConcurrencyControl的读取/修改/错误码、
+ *          运行时调整批量上下限与慢启动参数后ThreadCache按新参数工作（包括参数调整前缓存的整批对象）、
+ *          线程缓存预算限制慢启动增长，以及需要立即生效的参数通知到对应模块；
+ *          并对比不同批量上限和慢启动增量下多线程申请释放的耗时
+ */
+
+#include "ConcurrencyAlloc.h"
+#include <chrono>
+#include <cstring>
+#include <cassert>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace std::chrono;
+
+static size_t Read(const char* name) {
+    size_t value = 0;
+    int err = ConcurrencyControl(name, &value);
+    assert(err == 0);
+    (void)err;
+    return value;
+}
+
+static void Write(const char* name, size_t value) {
+    int err = ConcurrencyControl(name, nullptr, &value);
+    assert(err == 0);
+    (void)err;
+}
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 默认值、读取、修改与错误码
+ */
+void testControl() {
+    cout << "=== ConcurrencyControl测试 ===" << endl;
+
+    for (size_t i = 0; i < TUNE_COUNT; i++) {
+        const TuneInfo& info = TuneDescribe((TuneParam)i);
+        assert(TuneFind(info.name) == (TuneParam)i);
+        assert(Read(info.name) == info.def);
+    }
+    assert(Read("batch_max") == 512 && Read("batch_min") == 2);
+    assert(Read("large_cache_bytes") == LARGE_CACHE_MAX_BYTES);
+
+    // 修改时返回修改前的值
+    size_t oldValue = 0, newValue = 300;
+    assert(ConcurrencyControl("batch_max", &oldValue, &newValue) == 0);
+    assert(oldValue == 512 && Read("batch_max") == 300);
+    assert(SizeClass::NumMoveSize(8) == 300);
+    Write("batch_max", 512);
+    assert(SizeClass::NumMoveSize(8) == 512);
+
+    // 错误码
+    size_t value = 1;
+    assert(ConcurrencyControl("no_such_param", &value) == ENOENT);
+    assert(ConcurrencyControl("stats.no_such_stat", &value) == ENOENT);
+    assert(ConcurrencyControl("stats.system_allocs", nullptr, &value) == EPERM);
+    value = 0;
+    assert(ConcurrencyControl("batch_max", nullptr, &value) == EINVAL);
+    value = 5000;
+    assert(ConcurrencyControl("slow_start_step", nullptr, &value) == EINVAL);
+    value = 2;
+    assert(ConcurrencyControl("transfer_cache", nullptr, &value) == EINVAL);
+    value = 600;
+    assert(ConcurrencyControl("batch_min", nullptr, &value) == EINVAL);   // 大于batch_max
+    Write("batch_min", 8);
+    value = 4;
+    assert(ConcurrencyControl("batch_max", nullptr, &value) == EINVAL);   // 小于batch_min
+    Write("batch_min", 2);
+    assert(Read("batch_max") == 512 && Read("batch_min") == 2);
+
+    // 统计项可读
+    void* p = ConcurrencyAlloc(100);
+    assert(Read("stats.system_allocs") > 0);
+    assert(Read("stats.system_bytes") > 0);
+    ConcurrencyFree(p);
+
+    cout << "ConcurrencyControl测试通过！" << endl;
+}
+
+/**
+ * @brief 在子进程中以给定的环境变量运行本程序的--env-child分支
+ */
+static void RunEnvChild(const vector<pair<string, string>>& env) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        for (const auto& kv : env) {
+            setenv(kv.first.c_str(), kv.second.c_str(), 1);
+        }
+        execl("/proc/self/exe", "tuning_test", "--env-child", (char*)nullptr);
+        _exit(127);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+/**
+ * @brief 子进程：检查环境变量设置的参数
+ */
+static int EnvChild() {
+    assert(Read("batch_max") == 64);
+    assert(Read("batch_min") == 4);
+    assert(Read("large_cache_bytes") == 128 * 1024 * 1024);
+    assert(Read("thread_cache_bytes") == 256 * 1024);
+    assert(Read("transfer_cache") == 0);
+    assert(Read("transfer_cache_bytes") == 2 * 1024 * 1024);
+    assert(!CentralCache::GetInstance()->TransferCacheEnabled());
+    assert(SizeClass::NumMoveSize(8) == 64);
+    assert(SizeClass::NumMoveSize(MAX_MEMORYSIZE) == 4);
+    // 非法值被忽略
+    assert(Read("slow_start_step") == 2);
+    assert(Read("slow_start_init") == 1);
+    assert(Read("deferred_free_bytes") == DEFERRED_FREE_MAX_BYTES);
+
+    // 按这些参数正常申请释放
+    vector<void*> ptrs;
+    for (int i = 0; i < 10000; i++) {
+        ptrs.push_back(ConcurrencyAlloc(8 + i % 3000));
+    }
+    for (void* p : ptrs) {
+        ConcurrencyFree(p);
+    }
+    return 0;
+}
+
+void testEnvironment() {
+    cout << "=== 环境变量测试 ===" << endl;
+
+    RunEnvChild({{"HCMP_BATCH_MAX", "64"},
+                 {"HCMP_BATCH_MIN", "4"},
+                 {"HCMP_LARGE_CACHE_BYTES", "128M"},
+                 {"HCMP_THREAD_CACHE_BYTES", "256k"},
+                 {"HCMP_TRANSFER_CACHE", "0"},
+                 {"HCMP_TRANSFER_CACHE_BYTES", "2M"},
+                 {"HCMP_SLOW_START_STEP", "abc"},
+                 {"HCMP_SLOW_START_INIT", "0"},
+                 {"HCMP_DEFERRED_FREE_BYTES", "-1"}});
+
+    cout << "环境变量测试通过！" << endl;
+}
+
+/**
+ * @brief 调小批量上限后，已长大的桶收回上限，参数调整前缓存的整批对象被截断后仍可正确使用
+ */
+void testBatchRuntime() {
+    cout << "=== 运行时调整批量上限测试 ===" << endl;
+
+    const size_t SIZE = 16;
+    const size_t N = 100000;
+    size_t index = SizeClass::Index(SIZE);
+
+    thread t([&]() {
+        ThreadCache* tc = GetThreadCache();
+        vector<void*> ptrs(N);
+
+        // 先按默认参数把桶养大，并让一些整批对象进入批次缓存
+        for (auto& p : ptrs) {
+            p = ConcurrencyAlloc(SIZE);
+        }
+        for (auto& p : ptrs) {
+            ConcurrencyFree(p);
+        }
+        assert(tc->MaxSize(index) > 500);
+
+        // 调小上限：桶中剩余对象用完后的下一次获取收回上限
+        Write("batch_max", 32);
+        for (int round = 0; round < 3; round++) {
+            for (size_t i = 0; i < N; i++) {
+                ptrs[i] = ConcurrencyAlloc(SIZE);
+                memset(ptrs[i], (int)i, SIZE);
+                assert(tc->ListLength(index) < tc->MaxSize(index));
+            }
+            assert(tc->MaxSize(index) <= 32 + 2);
+            for (size_t i = 0; i < N; i++) {
+                assert(*(unsigned char*)ptrs[i] == (unsigned char)i);
+                ConcurrencyFree(ptrs[i]);
+            }
+        }
+
+        // 调大上限：之后按新上限增长
+        Write("batch_max", 2048);
+        for (int round = 0; round < 2; round++) {
+            for (auto& p : ptrs) {
+                p = ConcurrencyAlloc(SIZE);
+            }
+            for (auto& p : ptrs) {
+                ConcurrencyFree(p);
+            }
+        }
+        assert(tc->MaxSize(index) > 512 && tc->MaxSize(index) <= 2048 + 2);
+    });
+    t.join();
+    Write("batch_max", 512);
+
+    cout << "运行时调整批量上限测试通过！" << endl;
+}
+
+/**
+ * @brief 慢启动初始值与增量在下一次获取时生效
+ */
+void testSlowStartParams() {
+    cout << "=== 慢启动参数测试 ===" << endl;
+
+    Write("slow_start_init", 64);
+    Write("slow_start_step", 16);
+    thread t([]() {
+        const size_t SIZE = 200;
+        size_t index = SizeClass::Index(SIZE);
+        ThreadCache* tc = GetThreadCache();
+        void* p = ConcurrencyAlloc(SIZE);
+        // 第一次获取取64个，之后上限加16
+        assert(tc->ListLength(index) == 63);
+        assert(tc->MaxSize(index) == 64 + 16);
+        vector<void*> ptrs;
+        for (int i = 0; i < 63; i++) {
+            ptrs.push_back(ConcurrencyAlloc(SIZE));
+        }
+        ptrs.push_back(ConcurrencyAlloc(SIZE));
+        assert(tc->MaxSize(index) == 64 + 32);
+        assert(tc->ListLength(index) == 64 + 16 - 1);
+        ConcurrencyFree(p);
+        for (void* q : ptrs) {
+            ConcurrencyFree(q);
+        }
+    });
+    t.join();
+    Write("slow_start_init", 1);
+    Write("slow_start_step", 2);
+
+    cout << "慢启动参数测试通过！" << endl;
+}
+
+/**
+ * @brief 线程缓存预算限制各桶慢启动上限的增长总量
+ */
+void testThreadCacheBudget() {
+    cout << "=== 线程缓存预算测试 ===" << endl;
+
+    const size_t budget = 64 * 1024;
+    Write("thread_cache_bytes", budget);
+    thread t([budget]() {
+        ThreadCache* tc = GetThreadCache();
+        vector<void*> ptrs;
+        for (int round = 0; round < 4; round++) {
+            for (size_t size = 8; size <= 16 * 1024; size *= 2) {
+                for (int i = 0; i < 2000; i++) {
+                    ptrs.push_back(ConcurrencyAlloc(size));
+                }
+            }
+            for (void* p : ptrs) {
+                ConcurrencyFree(p);
+            }
+            ptrs.clear();
+        }
+        size_t grown = 0;
+        for (size_t i = 0; i < MAX_BUCKETSIZE; i++) {
+            grown += (tc->MaxSize(i) - 1) * SizeClass::ClassSize(i);
+            assert(tc->ListLength(i) < tc->MaxSize(i));
+        }
+        assert(grown <= budget);
+    });
+    t.join();
+    Write("thread_cache_bytes", 0);
+
+    cout << "线程缓存预算测试通过！" << endl;
+}
+
+/**
+ * @brief 超大Span缓存、延迟释放上限与批次缓存开关立即生效，已有的设置接口与参数表保持一致
+ */
+void testImmediateParams() {
+    cout << "=== 立即生效参数测试 ===" << endl;
+
+    // 超大Span缓存上限调为0后，释放的超大对象立即归还系统
+    void* big = ConcurrencyAlloc(4 * 1024 * 1024);
+    ConcurrencyFree(big);
+    Write("large_cache_bytes", 0);
+    assert(Read("stats.large_cache_bytes") == 0);
+    PageCache::GetInstance()->SetLargeCacheLimit(LARGE_CACHE_MAX_BYTES);
+    assert(Read("large_cache_bytes") == LARGE_CACHE_MAX_BYTES);
+
+    Write("deferred_free_bytes", 1024 * 1024);
+    DeferredFree::GetInstance()->SetLimit(DEFERRED_FREE_MAX_BYTES);
+    assert(Read("deferred_free_bytes") == DEFERRED_FREE_MAX_BYTES);
+
+    Write("transfer_cache", 0);
+    assert(!CentralCache::GetInstance()->TransferCacheEnabled());
+    ConcurrencyFree(ConcurrencyAlloc(64));
+    CentralCache::GetInstance()->SetTransferCacheEnabled(true);
+    assert(Read("transfer_cache") == 1);
+
+    Write("transfer_cache_bytes", 0);
+    assert(CentralCache::GetInstance()->TransferBatchCount(64) == 0);
+    Write("transfer_cache_bytes", TRANSFER_MAX_BYTES);
+    assert(Read("transfer_cache_bytes") == TRANSFER_MAX_BYTES);
+
+    TuneReport(cout);
+    cout << "立即生效参数测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 4个线程各自反复申请、释放一组对象，返回每次操作的平均耗时（ns）
+ */
+static double Churn(size_t size, size_t count, int rounds) {
+    const int nthreads = 4;
+    vector<thread> threads;
+    auto t0 = steady_clock::now();
+    for (int t = 0; t < nthreads; t++) {
+        threads.emplace_back([=]() {
+            vector<void*> ptrs(count);
+            for (int r = 0; r < rounds; r++) {
+                for (auto& p : ptrs) {
+                    p = ConcurrencyAlloc(size);
+                }
+                for (auto& p : ptrs) {
+                    ConcurrencyFree(p, size);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    auto t1 = steady_clock::now();
+    return (double)duration_cast<nanoseconds>(t1 - t0).count() / (2.0 * nthreads * count * rounds);
+}
+
+void benchmarkParams() {
+    cout << "=== 批量上限与慢启动增量对比（4线程，ns/次） ===" << endl;
+
+    struct Setting {
+        const char* name;
+        size_t batchMax;
+        size_t step;
+    };
+    Setting settings[] = {
+        {"batch_max=16", 16, 2},
+        {"batch_max=64", 64, 2},
+        {"batch_max=512(默认)", 512, 2},
+        {"batch_max=2048", 2048, 2},
+        {"batch_max=512 step=32", 512, 32},
+    };
+    printf("  %-26s %12s %12s %12s\n", "参数", "16B x 4096", "256B x 4096", "4KB x 512");
+    Churn(16, 4096, 20);   // 预热
+    for (const Setting& s : settings) {
+        Write("batch_max", s.batchMax);
+        Write("slow_start_step", s.step);
+        double best[3] = {1e30, 1e30, 1e30};
+        for (int r = 0; r < 3; r++) {
+            best[0] = min(best[0], Churn(16, 4096, 20));
+            best[1] = min(best[1], Churn(256, 4096, 20));
+            best[2] = min(best[2], Churn(4096, 512, 40));
+        }
+        printf("  %-26s %12.1f %12.1f %12.1f\n", s.name, best[0], best[1], best[2]);
+    }
+    Write("batch_max", 512);
+    Write("slow_start_step", 2);
+
+    // 读取参数的开销
+    const size_t reads = 1000000;
+    size_t sum = 0;
+    auto t0 = steady_clock::now();
+    for (size_t i = 0; i < reads; i++) {
+        size_t v = 0;
+        ConcurrencyControl("slow_start_step", &v);
+        sum += v;
+    }
+    auto t1 = steady_clock::now();
+    printf("  ConcurrencyControl读取: %.1f ns/次 (%zu)\n",
+           (double)duration_cast<nanoseconds>(t1 - t0).count() / reads, sum / reads);
+}
+
+// ================================ 主测试函数 ================================
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--env-child") == 0) {
+        return EnvChild();
+    }
+
+    cout << "运行参数测试开始..." << endl << endl;
+
+    testControl();
+    cout << endl;
+
+    testEnvironment();
+    cout << endl;
+
+    testBatchRuntime();
+    cout << endl;
+
+    testSlowStartParams();
+    cout << endl;
+
+    testThreadCacheBudget();
+    cout << endl;
+
+    testImmediateParams();
+    cout << endl;
+
+    benchmarkParams();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}
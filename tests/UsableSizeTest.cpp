@@ -0,0 +1,239 @@
+/**
+ * @file UsableSizeTest.cpp
+ * @brief 可用大小查询与allocate_at_least测试程序
+ * @details 验证ConcurrencyUsableSize返回对齐后的尺寸类大小（大对象为整页大小）且可用字节都能写入、
+ *          ConcurrencyAllocAtLeast与STL分配器的allocate_at_least返回的大小可用、释放时传入申请或返回的大小均可，
+ *          并对比可增长缓冲区按申请个数和按实际个数设置容量时push_back的扩容次数与耗时
+ */
+
+#include "ConcurrencyAllocator.h"
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+using namespace std::chrono;
+
+// ================================ 正确性测试 ================================
+
+/**
+ * @brief 小对象的可用大小等于对齐后的大小，大对象为整页，可用字节全部写入后相邻对象不受影响
+ */
+void testUsableSize() {
+    cout << "=== 可用大小查询测试 ===" << endl;
+
+    thread t([]() {
+        for (size_t size = 1; size <= MAX_MEMORYSIZE + 64 * 1024; size += (size < 2048 ? 1 : 997)) {
+            unsigned char* a = (unsigned char*)ConcurrencyAlloc(size);
+            unsigned char* b = (unsigned char*)ConcurrencyAlloc(size);
+            size_t usable = ConcurrencyUsableSize(a);
+            assert(usable >= size);
+            assert(ConcurrencyUsableSize(b) == usable);
+            if (size <= MAX_MEMORYSIZE) {
+                assert(usable == SizeClass::RoundUp(size));
+            } else {
+                assert(usable % (1 << PAGE_SHIFT) == 0 && usable >= SizeClass::RoundUp(size));
+            }
+            memset(b, 0x5A, usable);
+            memset(a, 0xA5, usable);
+            assert(b[0] == 0x5A && b[usable - 1] == 0x5A);
+            ConcurrencyFree(a);
+            ConcurrencyFree(b, size);
+        }
+    });
+    t.join();
+
+    // 其他线程也能查询，Arena的内存返回0
+    void* p = ConcurrencyAlloc(100);
+    thread other([p]() {
+        assert(ConcurrencyUsableSize(p) == SizeClass::RoundUp(100));
+    });
+    other.join();
+    ConcurrencyFree(p);
+
+    Arena arena;
+    assert(ConcurrencyUsableSize(arena.Allocate(64)) == 0);
+
+    cout << "可用大小查询测试通过！" << endl;
+}
+
+/**
+ * @brief ConcurrencyAllocAtLeast返回的大小与查询结果一致，释放时传入申请或返回的大小均可
+ */
+void testAllocAtLeast() {
+    cout << "=== ConcurrencyAllocAtLeast测试 ===" << endl;
+
+    size_t sizes[] = {1, 7, 9, 17, 100, 129, 1000, 1025, 5000, 8193, 70000, MAX_MEMORYSIZE,
+                      MAX_MEMORYSIZE + 1, 1024 * 1024 + 1};
+    for (int round = 0; round < 100; round++) {
+        for (size_t size : sizes) {
+            ConcurrencyAllocResult r = ConcurrencyAllocAtLeast(size);
+            assert(r.size >= size);
+            assert(ConcurrencyUsableSize(r.ptr) == r.size);
+            memset(r.ptr, round, r.size);
+            if (round % 2) {
+                ConcurrencyFree(r.ptr, r.size);
+            } else {
+                ConcurrencyFree(r.ptr, size);
+            }
+        }
+    }
+
+    cout << "ConcurrencyAllocAtLeast测试通过！" << endl;
+}
+
+/**
+ * @brief STL分配器的allocate_at_least返回的个数可用，按返回的个数释放
+ */
+void testAllocatorAtLeast() {
+    cout << "=== 分配器allocate_at_least测试 ===" << endl;
+
+    ConcurrencyAllocator<int> alloc;
+    for (size_t n = 1; n < 5000; n += 3) {
+        auto r = alloc.allocate_at_least(n);
+        assert(r.count >= n);
+        assert(r.count == SizeClass::RoundUp(n * sizeof(int)) / sizeof(int));
+        for (size_t i = 0; i < r.count; i++) {
+            r.ptr[i] = (int)i;
+        }
+        assert(r.ptr[r.count - 1] == (int)(r.count - 1));
+        alloc.deallocate(r.ptr, r.count);
+    }
+
+    // 元素大小不整除尺寸类大小时向下取整
+    struct Triple { char c[24]; };
+    ConcurrencyAllocator<Triple> talloc;
+    auto r = talloc.allocate_at_least(1);
+    assert(r.count == SizeClass::RoundUp(sizeof(Triple)) / sizeof(Triple));
+    talloc.deallocate(r.ptr, r.count);
+
+    cout << "分配器allocate_at_least测试通过！" << endl;
+}
+
+// ================================ 性能测试 ================================
+
+/**
+ * @brief 最简单的可增长缓冲区，容量按2倍增长
+ * @tparam AtLeast 为true时用allocate_at_least并把容量设为返回的个数，否则用allocate
+ */
+template<class T, bool AtLeast>
+class GrowBuffer {
+public:
+    ~GrowBuffer() {
+        if (_data) {
+            _alloc.deallocate(_data, _cap);
+        }
+    }
+
+    void push_back(const T& v) {
+        if (_size == _cap) {
+            Grow();
+        }
+        _data[_size++] = v;
+    }
+
+    size_t size() const { return _size; }
+    static size_t& Reallocs() {
+        static size_t count = 0;
+        return count;
+    }
+
+private:
+    void Grow() {
+        size_t want = _cap ? _cap * 2 : 1;
+        T* data;
+        size_t cap;
+        if (AtLeast) {
+            auto r = _alloc.allocate_at_least(want);
+            data = r.ptr;
+            cap = r.count;
+        } else {
+            data = _alloc.allocate(want);
+            cap = want;
+        }
+        if (_data) {
+            memcpy(data, _data, _size * sizeof(T));
+            _alloc.deallocate(_data, _cap);
+        }
+        _data = data;
+        _cap = cap;
+        ++Reallocs();
+    }
+
+    ConcurrencyAllocator<T> _alloc;
+    T* _data = nullptr;
+    size_t _size = 0;
+    size_t _cap = 0;
+};
+
+/**
+ * @brief 建立count个缓冲区，每个push_back到lengths中给定的长度
+ * @return 总耗时（ms）
+ */
+template<class T, bool AtLeast>
+static double RunGrowth(const vector<size_t>& lengths, size_t& reallocs) {
+    GrowBuffer<T, AtLeast>::Reallocs() = 0;
+    auto t0 = steady_clock::now();
+    for (size_t len : lengths) {
+        GrowBuffer<T, AtLeast> buf;
+        for (size_t i = 0; i < len; i++) {
+            buf.push_back(T());
+        }
+    }
+    auto t1 = steady_clock::now();
+    reallocs = GrowBuffer<T, AtLeast>::Reallocs();
+    return duration_cast<microseconds>(t1 - t0).count() / 1000.0;
+}
+
+template<class T>
+static void CompareGrowth(const char* name, const vector<size_t>& lengths) {
+    size_t plain = 0, atLeast = 0;
+    RunGrowth<T, false>(lengths, plain);   // 预热
+    double best[2] = {1e30, 1e30};
+    for (int r = 0; r < 3; r++) {
+        best[0] = min(best[0], RunGrowth<T, false>(lengths, plain));
+        best[1] = min(best[1], RunGrowth<T, true>(lengths, atLeast));
+    }
+    printf("  %-24s %12zu %12zu %10.1f %10.1f\n", name, plain, atLeast, best[0], best[1]);
+}
+
+struct Elem24 { uint64_t a, b, c; };
+
+void benchmarkGrowth() {
+    cout << "=== push_back增长：扩容次数与耗时（ms） ===" << endl;
+
+    mt19937 rng(2024);
+    vector<size_t> smallLens(200000), midLens(2000), bigLens(4);
+    for (auto& n : smallLens) n = 1 + rng() % 64;
+    for (auto& n : midLens) n = 1 + rng() % 20000;
+    for (auto& n : bigLens) n = 1000000 + rng() % 1000000;
+
+    printf("  %-24s %12s %12s %10s %10s\n", "负载", "allocate", "at_least", "allocate", "at_least");
+    CompareGrowth<int>("int x 20万个(1~64)", smallLens);
+    CompareGrowth<Elem24>("24B x 20万个(1~64)", smallLens);
+    CompareGrowth<int>("int x 2000个(1~2万)", midLens);
+    CompareGrowth<Elem24>("24B x 2000个(1~2万)", midLens);
+    CompareGrowth<int>("int x 4个(100~200万)", bigLens);
+}
+
+// ================================ 主测试函数 ================================
+
+int main() {
+    cout << "可用大小与allocate_at_least测试开始..." << endl << endl;
+
+    testUsableSize();
+    cout << endl;
+
+    testAllocAtLeast();
+    cout << endl;
+
+    testAllocatorAtLeast();
+    cout << endl;
+
+    benchmarkGrowth();
+    cout << endl;
+
+    cout << "所有测试通过！" << endl;
+    return 0;
+}